@@ -0,0 +1,50 @@
+/*
+Copyright (c) 2018-2021 Christos Karamoustos
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef BINDLESS_MATERIALS_H_
+#define BINDLESS_MATERIALS_H_
+
+// Same layout as BindlessMaterials::MaterialData
+struct MaterialData {
+	vec4 baseColorFactor;
+	vec4 emissiveFactor;
+	float metallicFactor;
+	float roughnessFactor;
+	float alphaCutoff;
+	float occlusionlMetalRoughness;
+	float hasBones;
+	float dummy[3];
+	uint textures[5]; // BaseColor, MetallicRoughness, Normal, Occlusion, Emissive
+	uint dummy2[3];
+};
+
+layout(set = 1, binding = 0) uniform sampler2D textures[];
+
+layout(std430, set = 1, binding = 1) readonly buffer MaterialsBuffer {
+	MaterialData data[];
+} materials;
+
+layout(push_constant) uniform PushConstants {
+	uint materialIndex;
+} pushConstants;
+
+#endif
@@ -33,34 +33,53 @@ struct Light {
 	vec4 position;
 };
 
-//layout(constant_id = 0) const int NUM_LIGHTS = 1;
-#define NUM_LIGHTS 11 // one is for directional
+// a point or a spot light of the clustered shading
+struct LightData {
+	vec4 color; // .a is the intensity
+	vec4 position; // .w is the range
+	vec4 direction; // .w is the cosine of the spot cone, -1 for point lights
+};
 
 layout(set = 0, binding = 0) uniform sampler2D sampler_depth;
 layout(set = 0, binding = 1) uniform sampler2D sampler_normal;
 layout(set = 0, binding = 2) uniform sampler2D sampler_albedo;
 layout(set = 0, binding = 3) uniform sampler2D sampler_met_rough;
-layout(set = 0, binding = 4) uniform UBO { vec4 cam_pos; Light lights[NUM_LIGHTS]; } ubo;
+layout(set = 0, binding = 4) uniform UBO { vec4 cam_pos; Light sun; vec4 cluster_front; vec4 cluster_depth; uvec4 cluster_grid; } ubo;
 layout(set = 0, binding = 5) uniform sampler2D sampler_ssao_blur;
 layout(set = 0, binding = 6) uniform sampler2D sampler_ssr;
 layout(set = 0, binding = 7) uniform sampler2D sampler_emission;
 layout(set = 0, binding = 8) uniform sampler2D sampler_lut_IBL;
-layout(set = 0, binding = 9) uniform SS { mat4 invViewProj; vec4 effects0; vec4 effects1; vec4 effects2; vec4 effects3;} screenSpace;
+layout(set = 0, binding = 9) uniform SS { mat4 invViewProj; vec4 effects0; vec4 effects1; vec4 effects2; vec4 effects3; vec4 effects4;} screenSpace;
+layout(set = 0, binding = 10) readonly buffer Lights { LightData lights[]; };
+layout(set = 0, binding = 11) readonly buffer Clusters { uvec2 clusters[]; }; // offset and count in the light indices
+layout(set = 0, binding = 12) readonly buffer LightIndices { uint light_indices[]; };
 layout(set = 1, binding = 1) uniform sampler2DShadow sampler_shadow_map0;
 layout(set = 2, binding = 1) uniform sampler2DShadow sampler_shadow_map1;
 layout(set = 3, binding = 1) uniform sampler2DShadow sampler_shadow_map2;
 layout(set = 4, binding = 0) uniform samplerCube sampler_cube_map;
 
-vec3 compute_point_light(int lightIndex, Material material, vec3 world_pos, vec3 camera_pos, vec3 material_normal, float ssao)
+// the cluster of a pixel, screen tiles from the uv and exponential slices of the depth
+uint get_cluster(vec2 uv, vec3 world_pos)
 {
-	vec3 light_dir_full = world_pos - ubo.lights[lightIndex].position.xyz;
+	float depth = dot(world_pos - ubo.cam_pos.xyz, ubo.cluster_front.xyz);
+	uint slice = uint(clamp(log(depth / ubo.cluster_depth.x) * ubo.cluster_depth.z, 0.0, float(ubo.cluster_grid.z - 1)));
+	uvec2 tile = min(uvec2(clamp(uv, 0.0, 1.0) * vec2(ubo.cluster_grid.xy)), ubo.cluster_grid.xy - 1);
+	return tile.x + tile.y * ubo.cluster_grid.x + slice * ubo.cluster_grid.x * ubo.cluster_grid.y;
+}
+
+vec3 compute_light(LightData light, Material material, vec3 world_pos, vec3 camera_pos, vec3 material_normal, float ssao)
+{
+	vec3 light_dir_full = world_pos - light.position.xyz;
 	float light_dist = max(0.1, length(light_dir_full));
-	if (light_dist > screenSpace.effects2.z) // max range
+	if (light_dist > light.position.w) // range
 		return vec3(0.0);
 
 	vec3 light_dir = normalize(-light_dir_full);
+	if (dot(-light_dir, light.direction.xyz) < light.direction.w) // outside of the spot cone
+		return vec3(0.0);
+
 	float attenuation = 1 / (light_dist * light_dist);
-	vec3 point_color = ubo.lights[lightIndex].color.xyz * attenuation;
+	vec3 point_color = light.color.xyz * light.color.a * attenuation;
 	point_color *= screenSpace.effects2.y * ssao; // intensity
 
 	float roughness = material.roughness * 0.75 + 0.25;
@@ -40,7 +40,9 @@ vec3 directLight(Material material, vec3 world_pos, vec3 camera_pos, vec3 materi
 
 void main() 
 {
-	float depth = texture(sampler_depth, in_UV).x;
+	// screenSpace.effects4.xy -> dynamic resolution, the g-buffer covers this part of its targets
+	vec2 rt_UV = in_UV * screenSpace.effects4.xy;
+	float depth = texture(sampler_depth, rt_UV).x;
 
 	// if the depth is maximum it hits the skybox
 	if (depth == 0.0) {
@@ -75,15 +77,15 @@ void main()
 
 			// Volumetric light
 			if (screenSpace.effects1.y > 0.5)
-				outColor.xyz += VolumetricLighting(ubo.lights[0], frag_pos, in_UV, shadow_coords1, fogFactor);
+				outColor.xyz += VolumetricLighting(ubo.sun, frag_pos, in_UV, shadow_coords1, fogFactor);
 		}
 
 		return;
 	}
 	vec3 frag_pos = getPosFromUV(in_UV, depth, screenSpace.invViewProj);
-	vec3 normal = texture(sampler_normal, in_UV).xyz;
-	vec3 metRough = texture(sampler_met_rough, in_UV).xyz;
-	vec4 albedo = texture(sampler_albedo, in_UV);
+	vec3 normal = texture(sampler_normal, rt_UV).xyz;
+	vec3 metRough = texture(sampler_met_rough, rt_UV).xyz;
+	vec4 albedo = texture(sampler_albedo, rt_UV);
 	
 	Material material;
 	material.albedo = albedo.xyz;
@@ -92,8 +94,8 @@ void main()
 	material.F0 = mix(vec3(0.04f), material.albedo, material.metallic);
 
 	// Ambient
-	float factor_occlusion = screenSpace.effects0.x > 0.5 ? texture(sampler_ssao_blur, in_UV).x : 1.0;
-	float factor_sky_light = clamp(ubo.lights[0].color.a, 0.025f, 1.0f);
+	float factor_occlusion = screenSpace.effects0.x > 0.5 ? texture(sampler_ssao_blur, rt_UV).x : 1.0;
+	float factor_sky_light = clamp(ubo.sun.color.a, 0.025f, 1.0f);
 	factor_sky_light *= screenSpace.effects3.z > 0.5 ? 0.25 : 0.15;
 	float ambient_light = factor_sky_light * factor_occlusion;
 	vec3 fragColor = vec3(0.0);// 0.1 * material.albedo.xyz;
@@ -110,14 +112,18 @@ void main()
 	if (screenSpace.effects3.z > 0.5)
 		fragColor += directLight(material, frag_pos, ubo.cam_pos.xyz, normal, factor_occlusion);
 
-	for(int i = 1; i < NUM_LIGHTS; ++i)
-		fragColor += compute_point_light(i, material, frag_pos, ubo.cam_pos.xyz, normal, factor_occlusion);
+	// only the lights of the cluster
+	uvec2 cluster = clusters[get_cluster(in_UV, frag_pos)];
+	for (uint i = 0; i < cluster.y; ++i) {
+		LightData light = lights[light_indices[cluster.x + i]];
+		fragColor += compute_light(light, material, frag_pos, ubo.cam_pos.xyz, normal, factor_occlusion);
+	}
 
-	outColor = vec4(fragColor, albedo.a) + texture(sampler_emission, in_UV);
+	outColor = vec4(fragColor, albedo.a) + texture(sampler_emission, rt_UV);
 
 	// SSR
 	if (screenSpace.effects0.y > 0.5) {
-		vec3 ssr = texture(sampler_ssr, in_UV).xyz * ibl.reflectivity;
+		vec3 ssr = texture(sampler_ssr, rt_UV).xyz * ibl.reflectivity;
 		outColor += vec4(ssr, 0.0);// * (1.0 - material.roughness);
 	}
 	
@@ -151,7 +157,7 @@ void main()
 
 		// Volumetric light
 		if (screenSpace.effects1.y > 0.5)
-			outColor.xyz += VolumetricLighting(ubo.lights[0], frag_pos, in_UV, shadow_coords1, fogFactor);
+			outColor.xyz += VolumetricLighting(ubo.sun, frag_pos, in_UV, shadow_coords1, fogFactor);
 	}
 }
 
@@ -217,7 +223,7 @@ vec3 directLight(Material material, vec3 world_pos, vec3 camera_pos, vec3 materi
 	float roughness = material.roughness * 0.75 + 0.25;
 
 	// Compute directional light.
-	vec3 light_dir_full = ubo.lights[0].position.xyz;
+	vec3 light_dir_full = ubo.sun.position.xyz;
 	vec3 light_dir = normalize(light_dir_full);
 	vec3 L = light_dir;
 	vec3 V = normalize(camera_pos - world_pos);
@@ -231,12 +237,12 @@ vec3 directLight(Material material, vec3 world_pos, vec3 camera_pos, vec3 materi
 
 	vec3 F0 = compute_F0(material.albedo, material.metallic);
 	vec3 specular_fresnel = fresnel(F0, HoV);
-	vec3 specref = ubo.lights[0].color.xyz * NoL * lit * cook_torrance_specular(N, H, NoL, NoV, specular_fresnel, roughness);
-	vec3 diffref = ubo.lights[0].color.xyz * NoL * lit * (1.0 - specular_fresnel) * (1.0 / PI);
+	vec3 specref = ubo.sun.color.xyz * NoL * lit * cook_torrance_specular(N, H, NoL, NoV, specular_fresnel, roughness);
+	vec3 diffref = ubo.sun.color.xyz * NoL * lit * (1.0 - specular_fresnel) * (1.0 / PI);
 
 	vec3 reflected_light = specref;
 	vec3 diffuse_light = diffref * material.albedo * (1.0 - material.metallic);
 	vec3 lighting = reflected_light + diffuse_light;
 
-	return lighting * ubo.lights[0].color.a;
+	return lighting * ubo.sun.color.a;
 }
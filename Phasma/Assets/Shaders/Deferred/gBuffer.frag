@@ -22,14 +22,26 @@ SOFTWARE.
 
 #version 450
 #extension GL_GOOGLE_include_directive : require
+#ifdef BINDLESS_MATERIALS
+#extension GL_EXT_nonuniform_qualifier : require
+#endif
 
 #include "../Common/common.glsl"
 
+#ifdef BINDLESS_MATERIALS
+#include "BindlessMaterials.glsl"
+#define bcSampler textures[materials.data[pushConstants.materialIndex].textures[0]] // BaseColor
+#define mrSampler textures[materials.data[pushConstants.materialIndex].textures[1]] // MetallicRoughness
+#define nSampler textures[materials.data[pushConstants.materialIndex].textures[2]]  // Normal
+#define oSampler textures[materials.data[pushConstants.materialIndex].textures[3]]  // Occlusion
+#define eSampler textures[materials.data[pushConstants.materialIndex].textures[4]]  // Emissive
+#else
 layout (set = 1, binding = 0) uniform sampler2D bcSampler; // BaseColor
 layout (set = 1, binding = 1) uniform sampler2D mrSampler; // MetallicRoughness
 layout (set = 1, binding = 2) uniform sampler2D nSampler;  // Normal
 layout (set = 1, binding = 3) uniform sampler2D oSampler;  // Occlusion
 layout (set = 1, binding = 4) uniform sampler2D eSampler;  // Emissive
+#endif
 
 layout (location = 0) in vec2 inUV;
 layout (location = 1) in vec3 inNormal;
@@ -21,17 +21,28 @@ SOFTWARE.
 */
 
 #version 450
-
-const int MAX_NUM_JOINTS = 128;
+#extension GL_GOOGLE_include_directive : require
+#ifdef BINDLESS_MATERIALS
+#extension GL_EXT_nonuniform_qualifier : require
+#endif
 
 layout(set = 0, binding = 0) uniform UniformBufferObject {
 	mat4 matrix;
 	mat4 previousMatrix;
-	mat4 jointMatrix[MAX_NUM_JOINTS];
-	float jointCount;
-	float dummy[3];
+	uint jointOffset;
+	uint jointCount;
+	uvec2 dummy;
 } uboMesh;
 
+// computed by animations.comp for all the skinned meshes
+layout(std430, set = 0, binding = 1) readonly buffer JointMatrices {
+	mat4 jointMatrix[];
+} joints;
+
+#ifdef BINDLESS_MATERIALS
+#include "BindlessMaterials.glsl"
+#define uboPrimitive materials.data[pushConstants.materialIndex]
+#else
 layout(set = 1, binding = 5) uniform UniformBufferObject2 {
 	vec4 baseColorFactor;
 	vec4 emissiveFactor;
@@ -42,12 +53,19 @@ layout(set = 1, binding = 5) uniform UniformBufferObject2 {
 	float hasBones;
 	float dummy[3];
 } uboPrimitive;
+#endif
 
-layout(set = 2, binding = 0) uniform UniformBufferObject3 {
+struct ModelData {
 	mat4 matrix;
 	mat4 mvp;
 	mat4 previousMvp;
-} uboModel;
+};
+
+layout(std430, set = 2, binding = 0) readonly buffer ModelInstances {
+	ModelData data[];
+} models;
+
+#define uboModel models.data[gl_InstanceIndex]
 
 layout(location = 0) in vec3 inPosition;
 layout(location = 1) in vec2 inTexCoords;
@@ -69,12 +87,13 @@ layout (location = 8) out vec4 positionWS;
 void main() 
 {
 	mat4 boneTransform = mat4(1.0);
-	if (uboMesh.jointCount > 0.0){
+	if (uboMesh.jointCount > 0){
+		uint offset = uboMesh.jointOffset;
 		boneTransform  = 
-		inWeights[0] * uboMesh.jointMatrix[inJoint[0]] + 
-		inWeights[1] * uboMesh.jointMatrix[inJoint[1]] + 
-		inWeights[2] * uboMesh.jointMatrix[inJoint[2]] + 
-		inWeights[3] * uboMesh.jointMatrix[inJoint[3]]; 
+		inWeights[0] * joints.jointMatrix[offset + inJoint[0]] + 
+		inWeights[1] * joints.jointMatrix[offset + inJoint[1]] + 
+		inWeights[2] * joints.jointMatrix[offset + inJoint[2]] + 
+		inWeights[3] * joints.jointMatrix[offset + inJoint[3]]; 
 	}
 	
 	vec4 inPos = vec4(inPosition, 1.0f);
@@ -36,6 +36,6 @@ layout (location = 0) out vec4 outColor;
 
 void main() 
 {
-	outColor.xyz = depthOfField(sampler_color, sampler_depth, in_UV, constants.values.x, constants.values.y);
+	outColor.xyz = depthOfField(sampler_color, sampler_depth, in_UV, constants.values.x, constants.values.y, constants.values.zw);
 	outColor.w = texture(sampler_color, in_UV).w;
 }
\ No newline at end of file
@@ -50,9 +50,10 @@ float getBlurSize(float depth, float center_depth, float focus_scale, float blur
 	return clamp(coc, 0.0, blur_range);
 }
 
-vec3 depthOfField(sampler2D sampler_color, sampler2D sampler_depth, vec2 tex_coord, float focus_scale, float blur_range)
+// depth_scale is the part of the depth target that is rendered (dynamic resolution)
+vec3 depthOfField(sampler2D sampler_color, sampler2D sampler_depth, vec2 tex_coord, float focus_scale, float blur_range, vec2 depth_scale)
 {
-	float center_depth = depth_average_wide(sampler_depth, vec2(0.5, 0.5), 20.0);
+	float center_depth = depth_average_wide(sampler_depth, vec2(0.5, 0.5) * depth_scale, 20.0);
 	vec3 color = texture(sampler_color, tex_coord).rgb;
 	float tot = 1.0;
 	
@@ -65,7 +66,7 @@ vec3 depthOfField(sampler2D sampler_color, sampler2D sampler_depth, vec2 tex_coo
 		vec2 tc = tex_coord + vec2(cos(ang), sin(ang)) * pixel_size * radius;
 
 		vec3 sample_color = texture(sampler_color, tc).rgb;
-		float sample_depth = texture(sampler_depth, tc).r;
+		float sample_depth = texture(sampler_depth, tc * depth_scale).r;
 		float sample_size = getBlurSize(sample_depth, center_depth, focus_scale, blur_range);
 		
 		float m = smoothstep(radius-0.5, radius+0.5, sample_size);
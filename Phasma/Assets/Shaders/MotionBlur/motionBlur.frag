@@ -29,7 +29,7 @@ layout (set = 0, binding = 0) uniform sampler2D frameSampler;
 layout (set = 0, binding = 1) uniform sampler2D depthSampler;
 layout (set = 0, binding = 2) uniform sampler2D velocitySampler;
 layout (set = 0, binding = 3) uniform UniformBufferObject { mat4 projection; mat4 view; mat4 previousView; mat4 invViewProj; } ubo;
-layout(push_constant) uniform Constants { vec4 values; } pushConst;
+layout(push_constant) uniform Constants { vec4 values; vec4 values1; } pushConst; // values1.zw -> dynamic resolution scale of depth and velocity
 
 
 layout (location = 0) in vec2 inUV;
@@ -41,7 +41,7 @@ const int max_samples = 16;
 void main() 
 {
 	vec2 UV = inUV;
-	vec2 velocity = dilate_Depth3X3(velocitySampler, depthSampler, UV).xy;
+	vec2 velocity = dilate_Depth3X3(velocitySampler, depthSampler, UV * pushConst.values1.zw).xy;
 	velocity *= pushConst.values.z; // strength 
 	
 	if (length2(velocity) < FLT_EPS){
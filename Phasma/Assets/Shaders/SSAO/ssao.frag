@@ -29,7 +29,7 @@ layout (set = 0, binding = 0) uniform sampler2D samplerDepth;
 layout (set = 0, binding = 1) uniform sampler2D samplerNormal;
 layout (set = 0, binding = 2) uniform sampler2D samplerNoise;
 layout (set = 0, binding = 3) uniform UniformBufferObject { vec4 samples[16]; } kernel;
-layout (set = 0, binding = 4) uniform UniformBufferPVM { mat4 projection; mat4 view; mat4 invProjection; } pvm;
+layout (set = 0, binding = 4) uniform UniformBufferPVM { mat4 projection; mat4 view; mat4 invProjection; vec4 renderScale; } pvm;
 
 
 layout (location = 0) in vec2 inUV;
@@ -42,14 +42,17 @@ const float bias = -0.001;
 
 void main() 
 {
+	// Dynamic resolution renders in the top left part of the targets, the uvs are scaled to it when sampling
+	vec2 scale = pvm.renderScale.xy;
+
 	// Get G-Buffer values
-	vec3 fragPos = getPosFromUV(inUV, texture(samplerDepth, inUV).x, pvm.invProjection);
-	vec4 normal = pvm.view * texture(samplerNormal, inUV);
+	vec3 fragPos = getPosFromUV(inUV, texture(samplerDepth, inUV * scale).x, pvm.invProjection);
+	vec4 normal = pvm.view * texture(samplerNormal, inUV * scale);
 
 	// Get a random vector using a noise lookup
 	ivec2 texDim = textureSize(samplerDepth, 0); 
 	ivec2 noiseDim = textureSize(samplerNoise, 0);
-	const vec2 noiseUV = vec2(float(texDim.x)/float(noiseDim.x), float(texDim.y)/(noiseDim.y)) * inUV;  
+	const vec2 noiseUV = vec2(float(texDim.x)/float(noiseDim.x), float(texDim.y)/(noiseDim.y)) * inUV * scale;  
 	vec3 randomVec = texture(samplerNoise, noiseUV).xyz * 2.0 - 1.0;
 	
 	// Create TBN matrix
@@ -73,7 +76,7 @@ void main()
 		samplePosition.xy = samplePosition.xy * 0.5f + 0.5f;
 		
 		float currentDepth = newViewPos.z;
-		float sampledDepth = getPosFromUV(samplePosition.xy, texture(samplerDepth, samplePosition.xy).x, pvm.invProjection).z;
+		float sampledDepth = getPosFromUV(samplePosition.xy, texture(samplerDepth, samplePosition.xy * scale).x, pvm.invProjection).z;
 
 		// Range check
 
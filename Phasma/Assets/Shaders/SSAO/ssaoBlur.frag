@@ -23,6 +23,7 @@ SOFTWARE.
 #version 450
 
 layout (set = 0, binding = 0) uniform sampler2D samplerSSAO;
+layout (push_constant) uniform Constants { vec4 renderScale; } pushConst;
 
 layout (location = 0) in vec2 inUV;
 
@@ -31,13 +32,16 @@ layout (location = 0) out float outColor;
 void main() 
 {
 	vec2 texelSize = 1.0 / vec2(textureSize(samplerSSAO, 0));
+	// stay in the rendered part of the target
+	vec2 maxUV = pushConst.renderScale.xy - texelSize * 0.5;
+	vec2 UV = inUV * pushConst.renderScale.xy;
 	float result = 0.0;
 	for (int x = -2; x < 2; x++) 
 	{
 		for (int y = -2; y < 2; y++) 
 		{
 			vec2 offset = vec2(float(x), float(y)) * texelSize;
-			result += texture(samplerSSAO, inUV + offset).r;
+			result += texture(samplerSSAO, min(UV + offset, maxUV)).r;
 		}
 	}
 	outColor = result / 16.0;
@@ -34,7 +34,7 @@ layout (set = 0, binding = 4) uniform WorldCameraPos
 	vec4 camPos;
 	vec4 camFront;
 	vec4 size;
-	vec4 dummy1;
+	vec4 renderScale; // dynamic resolution, the g-buffer covers this part of its targets
 	mat4 projection;
 	mat4 view;
 	mat4 invProj;
@@ -48,8 +48,9 @@ vec3 ScreenSpaceReflections(vec3 position, vec3 normal);
 
 void main()
 {
-	vec3 position = getPosFromUV(inUV, texture(depthSampler, inUV).x, ubo.invProj);
-	vec4 normal = ubo.view * vec4(texture(normalSampler, inUV).xyz, 0.0);
+	vec2 UV = inUV * ubo.renderScale.xy;
+	vec3 position = getPosFromUV(inUV, texture(depthSampler, UV).x, ubo.invProj);
+	vec4 normal = ubo.view * vec4(texture(normalSampler, UV).xyz, 0.0);
 
 	outColor = vec4(ScreenSpaceReflections(position, normalize(normal.xyz)) , 1.0);
 }
@@ -80,7 +81,7 @@ vec3 ScreenSpaceReflections(vec3 position, vec3 normal)
 		}
 
 		float currentDepth = abs(newViewPos.z);
-		float sampledDepth = abs(getPosFromUV(samplePosition.xy, texture(depthSampler, samplePosition.xy).x, ubo.invProj).z);
+		float sampledDepth = abs(getPosFromUV(samplePosition.xy, texture(depthSampler, samplePosition.xy * ubo.renderScale.xy).x, ubo.invProj).z);
 
 		float delta = abs(currentDepth - sampledDepth);
 		if(delta < 0.01f)
@@ -89,7 +90,7 @@ vec3 ScreenSpaceReflections(vec3 position, vec3 normal)
 			fadeOnEdges = abs(fadeOnEdges);
 			float fadeAmount = min(1.0 - fadeOnEdges.x, 1.0 - fadeOnEdges.y);
 
-			return texture(albedoSampler, samplePosition.xy).xyz * fresnel * fadeAmount;
+			return texture(albedoSampler, samplePosition.xy * ubo.renderScale.xy).xyz * fresnel * fadeAmount;
 		}
 
 		step *= 1.0 - 0.5 * max(sign(currentDepth - sampledDepth), 0.0);
@@ -22,8 +22,6 @@ SOFTWARE.
 
 #version 450
 
-const int MAX_NUM_JOINTS = 128;
-
 layout(location = 0) in vec3 inPosition;
 layout(location = 1) in vec2 inTexCoords;
 layout(location = 2) in vec3 inNormal;
@@ -40,24 +38,37 @@ layout( set = 0, binding = 0 ) uniform UniformBuffer0 {
 layout( set = 1, binding = 0 ) uniform UniformBuffer1 {	
 	mat4 matrix;
 	mat4 previousMatrix;
-	mat4 jointMatrix[MAX_NUM_JOINTS];
-	float jointCount;
-	float dummy[3];
+	uint jointOffset;
+	uint jointCount;
+	uvec2 dummy;
 }mesh;
 
-layout( set = 2, binding = 0 ) uniform UniformBuffer2 {	
+// computed by animations.comp for all the skinned meshes
+layout( std430, set = 1, binding = 1 ) readonly buffer JointMatrices {
+	mat4 jointMatrix[];
+}joints;
+
+struct ModelData {
 	mat4 matrix;
-	mat4 dummy[3];
-}model;
+	mat4 mvp;
+	mat4 previousMvp;
+};
+
+layout( std430, set = 2, binding = 0 ) readonly buffer ModelInstances {
+	ModelData data[];
+}models;
+
+#define model models.data[gl_InstanceIndex]
 
 void main() {
 	mat4 boneTransform = mat4(1.0);
-	if (mesh.jointCount > 0.0){
+	if (mesh.jointCount > 0){
+		uint offset = mesh.jointOffset;
 		boneTransform  = 
-		inWeights[0] * mesh.jointMatrix[inJoint[0]] + 
-		inWeights[1] * mesh.jointMatrix[inJoint[1]] + 
-		inWeights[2] * mesh.jointMatrix[inJoint[2]] + 
-		inWeights[3] * mesh.jointMatrix[inJoint[3]]; 
+		inWeights[0] * joints.jointMatrix[offset + inJoint[0]] + 
+		inWeights[1] * joints.jointMatrix[offset + inJoint[1]] + 
+		inWeights[2] * joints.jointMatrix[offset + inJoint[2]] + 
+		inWeights[3] * joints.jointMatrix[offset + inJoint[3]]; 
 	}
 
 	gl_Position = ubo.projection * ubo.lightView * model.matrix * mesh.matrix * boneTransform * vec4(inPosition, 1.0);
@@ -29,7 +29,7 @@ layout(set = 0, binding = 0) uniform sampler2D previousFrame;
 layout(set = 0, binding = 1) uniform sampler2D currentFrame;
 layout(set = 0, binding = 2) uniform sampler2D depth;
 layout(set = 0, binding = 3) uniform sampler2D velocity;
-layout(set = 0, binding = 4) uniform UniformBufferObject { vec4 values; vec4 sharp_values; mat4 invProj; } ubo;
+layout(set = 0, binding = 4) uniform UniformBufferObject { vec4 values; vec4 sharp_values; mat4 invProj; vec4 renderScale; } ubo;
 
 layout (location = 0) in vec2 inUV;
 
@@ -48,5 +48,5 @@ float ComputeLuminance(vec3 color)
 
 void main()
 {
-	outTaa = ResolveTAA(inUV, previousFrame, currentFrame, velocity, depth, ubo.values.z, ubo.values.w, ubo.values.xy);
+	outTaa = ResolveTAA(inUV, previousFrame, currentFrame, velocity, depth, ubo.values.z, ubo.values.w, ubo.values.xy, ubo.renderScale.xy);
 }
\ No newline at end of file
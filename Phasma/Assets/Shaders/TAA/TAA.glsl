@@ -44,10 +44,11 @@ vec3 clip_aabb(vec3 aabb_min, vec3 aabb_max, vec3 p, vec3 q)
 	return p + r;
 }
 
-vec4 ResolveTAA(vec2 texCoord, sampler2D tex_history, sampler2D tex_current, sampler2D tex_velocity, sampler2D tex_depth, float g_blendMin, float g_blendMax, vec2 jitter)
+// render_scale is the part of the depth and velocity targets that is rendered (dynamic resolution)
+vec4 ResolveTAA(vec2 texCoord, sampler2D tex_history, sampler2D tex_current, sampler2D tex_velocity, sampler2D tex_depth, float g_blendMin, float g_blendMax, vec2 jitter, vec2 render_scale)
 {
 	// Reproject
-	vec2 velocity = dilate_Depth3X3(tex_velocity, tex_depth, texCoord).xy;
+	vec2 velocity = dilate_Depth3X3(tex_velocity, tex_depth, texCoord * render_scale).xy;
 	vec2 texCoord_history = texCoord - velocity;
 	
 	// Get current and history colors
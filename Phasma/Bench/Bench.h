@@ -0,0 +1,52 @@
+/*
+Copyright (c) 2018-2021 Christos Karamoustos
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace pe
+{
+	// A hot kernel of the engine, one call of run does ops operations on the state it captured
+	struct BenchKernel
+	{
+		std::string name;
+		uint32_t ops;
+		uint32_t samples;
+		std::function<void()> run;
+	};
+	
+	// the kernels of the cpu subsystems, created in Kernels.cpp, only the ones whose name contains filter
+	// are set up, an empty filter takes all
+	std::vector<BenchKernel> BenchKernels(const std::string& filter);
+	
+	// folds a result in a volatile sink, so the compiler can not drop the work that produced it
+	void BenchKeep(const void* data, size_t size);
+	
+	template<typename T>
+	void BenchKeep(const T& value)
+	{
+		BenchKeep(&value, sizeof(T));
+	}
+}
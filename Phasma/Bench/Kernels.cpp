@@ -0,0 +1,333 @@
+/*
+Copyright (c) 2018-2021 Christos Karamoustos
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "Bench.h"
+#include "Code/Core/Math.h"
+#include "Code/Core/Node.h"
+#include "Code/Core/Path.h"
+#include "Code/Camera/Camera.h"
+#include "Code/MemoryHash/MemoryHash.h"
+#include "Code/Model/Animation.h"
+#include "Code/Model/Model.h"
+#include "Code/Shader/Shader.h"
+#include "Code/GUI/GUI.h"
+#include <GLTFSDK/GLTFResourceReader.h>
+#include <initializer_list>
+#include <memory>
+#include <random>
+
+namespace pe
+{
+	// the same inputs on every run, so the timings can be compared between builds
+	static std::mt19937 s_random(7);
+	
+	// true when a kernel of a group passes the filter, then the inputs start over, so a group gets the same
+	// inputs whatever the filter skipped before it
+	static bool SetUp(const std::string& filter, std::initializer_list<const char*> names)
+	{
+		for (const char* name : names)
+		{
+			if (filter.empty() || std::string(name).find(filter) != std::string::npos)
+			{
+				s_random.seed(7);
+				return true;
+			}
+		}
+		return false;
+	}
+	
+	static float Random(float min, float max)
+	{
+		return std::uniform_real_distribution<float>(min, max)(s_random);
+	}
+	
+	static vec3 RandomVec3(float min, float max)
+	{
+		return vec3(Random(min, max), Random(min, max), Random(min, max));
+	}
+	
+	static quat RandomRotation()
+	{
+		return normalize(quat(RandomVec3(-3.14f, 3.14f)));
+	}
+	
+	static mat4 RandomTransform()
+	{
+		return transform(RandomRotation(), RandomVec3(0.5f, 2.f), RandomVec3(-10.f, 10.f));
+	}
+	
+	// a chain of nodes, each one the child of the previous, with the transformation type of a gltf node,
+	// deleted with the last kernel that holds them
+	static std::shared_ptr<std::vector<Node*>> CreateHierarchy(size_t count)
+	{
+		const auto deleter = [](std::vector<Node*>* nodes)
+		{
+			for (auto* node : *nodes)
+				delete node;
+			delete nodes;
+		};
+		std::shared_ptr<std::vector<Node*>> hierarchy(new std::vector<Node*>(count, nullptr), deleter);
+		
+		std::vector<Node*>& nodes = *hierarchy;
+		for (size_t i = 0; i < count; i++)
+		{
+			nodes[i] = new Node();
+			nodes[i]->parent = i > 0 ? nodes[i - 1] : nullptr;
+			nodes[i]->index = static_cast<uint32_t>(i);
+			nodes[i]->mesh = nullptr;
+			nodes[i]->skin = nullptr;
+			nodes[i]->translation = RandomVec3(-1.f, 1.f);
+			nodes[i]->rotation = RandomRotation();
+			nodes[i]->scale = vec3(1.f);
+			nodes[i]->transformationType = TRANSFORMATION_TRS;
+		}
+		return hierarchy;
+	}
+	
+	// a clip that moves and rotates every node, linear keys at 30 fps
+	static Animation CreateAnimation(const std::vector<Node*>& nodes, uint32_t keys)
+	{
+		Animation animation;
+		animation.start = 0.f;
+		animation.end = static_cast<float>(keys - 1) / 30.f;
+		for (auto* node : nodes)
+		{
+			for (auto path : {AnimationChannel::TRANSLATION, AnimationChannel::ROTATION})
+			{
+				AnimationSampler sampler;
+				sampler.interpolation = AnimationSampler::LINEAR;
+				std::vector<vec4> values(keys);
+				for (uint32_t i = 0; i < keys; i++)
+				{
+					sampler.inputs.push_back(static_cast<float>(i) / 30.f);
+					const quat q = RandomRotation();
+					values[i] = path == AnimationChannel::ROTATION ? vec4(q.x, q.y, q.z, q.w) :
+					            vec4(RandomVec3(-1.f, 1.f), 0.f);
+				}
+				sampler.setOutputs(values, path == AnimationChannel::ROTATION ? 4 : 3);
+				
+				AnimationChannel channel;
+				channel.path = path;
+				channel.node = node;
+				channel.target = node->index;
+				channel.samplerIndex = static_cast<int32_t>(animation.samplers.size());
+				animation.samplers.push_back(sampler);
+				animation.channels.push_back(channel);
+			}
+		}
+		return animation;
+	}
+	
+	std::vector<BenchKernel> BenchKernels(const std::string& filter)
+	{
+		std::vector<BenchKernel> kernels;
+		const uint32_t count = 1024;
+		
+		// MATH
+		if (SetUp(filter, {"mat4_multiply", "mat4_inverse"}))
+		{
+			auto a = std::make_shared<std::vector<mat4>>(count);
+			auto b = std::make_shared<std::vector<mat4>>(count);
+			auto result = std::make_shared<std::vector<mat4>>(count);
+			for (size_t i = 0; i < count; i++)
+			{
+				(*a)[i] = RandomTransform();
+				(*b)[i] = RandomTransform();
+			}
+			kernels.push_back(
+					{"mat4_multiply", count, 200, [a, b, result]()
+					{
+						for (size_t i = 0; i < a->size(); i++)
+							(*result)[i] = (*a)[i] * (*b)[i];
+						BenchKeep(result->back());
+					}}
+			);
+			kernels.push_back(
+					{"mat4_inverse", count, 200, [a, result]()
+					{
+						for (size_t i = 0; i < a->size(); i++)
+							(*result)[i] = inverse((*a)[i]);
+						BenchKeep(result->back());
+					}}
+			);
+		}
+		if (SetUp(filter, {"quat_slerp"}))
+		{
+			auto a = std::make_shared<std::vector<quat>>(count);
+			auto b = std::make_shared<std::vector<quat>>(count);
+			auto result = std::make_shared<std::vector<quat>>(count);
+			for (size_t i = 0; i < count; i++)
+			{
+				(*a)[i] = RandomRotation();
+				(*b)[i] = RandomRotation();
+			}
+			kernels.push_back(
+					{"quat_slerp", count, 200, [a, b, result]()
+					{
+						const float step = 1.f / static_cast<float>(a->size());
+						for (size_t i = 0; i < a->size(); i++)
+							(*result)[i] = slerp((*a)[i], (*b)[i], static_cast<float>(i) * step);
+						BenchKeep(result->back());
+					}}
+			);
+		}
+		
+		// MEMORY HASH, the size of a uniform buffer update and of a large upload
+		if (SetUp(filter, {"memory_hash_256b", "memory_hash_64kb"}))
+		{
+			auto data = std::make_shared<std::vector<uint8_t>>(64 * 1024);
+			for (auto& byte : *data)
+				byte = static_cast<uint8_t>(s_random());
+			kernels.push_back(
+					{"memory_hash_256b", 256, 200, [data]()
+					{
+						size_t hash = 0;
+						for (size_t i = 0; i < 256; i++)
+							hash ^= MemoryHash(data->data() + i * 256, 256).getHash();
+						BenchKeep(hash);
+					}}
+			);
+			kernels.push_back(
+					{"memory_hash_64kb", 1, 200, [data]()
+					{
+						BenchKeep(MemoryHash(data->data(), data->size()).getHash());
+					}}
+			);
+		}
+		
+		// FRUSTUM CULLING
+		if (SetUp(filter, {"frustum_culling", "camera_update"}))
+		{
+			GUI::winSize = ImVec2(1920.f, 1080.f);
+			auto camera = std::make_shared<Camera>();
+			camera->position = vec3(0.f, 0.f, -20.f);
+			camera->Update();
+			auto spheres = std::make_shared<std::vector<vec4>>(count * 4);
+			for (auto& sphere : *spheres)
+				sphere = vec4(RandomVec3(-100.f, 100.f), Random(0.1f, 5.f));
+			kernels.push_back(
+					{"frustum_culling", static_cast<uint32_t>(spheres->size()), 200, [camera, spheres]()
+					{
+						uint32_t visible = 0;
+						for (auto& sphere : *spheres)
+							visible += camera->SphereInFrustum(sphere);
+						BenchKeep(visible);
+					}}
+			);
+			kernels.push_back(
+					{"camera_update", 1, 200, [camera]()
+					{
+						camera->Update();
+						BenchKeep(camera->frustum[0]);
+					}}
+			);
+		}
+		
+		// NODE MATRICES, a skeleton deep enough for the parent walk to matter
+		if (SetUp(filter, {"node_get_matrix", "joint_matrices", "update_animation"}))
+		{
+			auto nodes = CreateHierarchy(64);
+			auto inverseBind = std::make_shared<std::vector<mat4>>(nodes->size());
+			for (auto& m : *inverseBind)
+				m = RandomTransform();
+			auto result = std::make_shared<std::vector<mat4>>(nodes->size());
+			kernels.push_back(
+					{"node_get_matrix", static_cast<uint32_t>(nodes->size()), 200, [nodes, result]()
+					{
+						for (size_t i = 0; i < nodes->size(); i++)
+							(*result)[i] = (*nodes)[i]->getMatrix();
+						BenchKeep(result->back());
+					}}
+			);
+			// the reference of the AnimationCompute shader, the joints relative to the skinned node
+			kernels.push_back(
+					{"joint_matrices", static_cast<uint32_t>(nodes->size()), 200, [nodes, inverseBind, result]()
+					{
+						const mat4 inverseNode = inverse(nodes->front()->getMatrix());
+						for (size_t i = 0; i < nodes->size(); i++)
+							(*result)[i] = inverseNode * (*nodes)[i]->getMatrix() * (*inverseBind)[i];
+						BenchKeep(result->back());
+					}}
+			);
+			
+			auto animations = std::make_shared<std::vector<Animation>>();
+			animations->push_back(CreateAnimation(*nodes, 90));
+			animations->push_back(CreateAnimation(*nodes, 60));
+			auto animator = std::make_shared<Animator>();
+			animator->play(*animations, 0, 1.f);
+			animator->play(*animations, 1, 0.5f);
+			kernels.push_back(
+					{"update_animation", 1, 200, [nodes, animations, animator]()
+					{
+						animator->update(*animations, *nodes, 1.f / 60.f);
+						BenchKeep(nodes->back()->rotation);
+					}}
+			);
+		}
+		
+		// GLTF ACCESSOR DECODE, the attributes of every primitive of a sample model
+		if (SetUp(filter, {"gltf_accessor_decode"}))
+		{
+			auto model = std::make_shared<Model>();
+			model->readGltf(Path::Assets + "Objects/DamagedHelmet/glTF/DamagedHelmet.gltf");
+			auto accessors = std::make_shared<std::vector<std::string>>();
+			for (auto& mesh : model->document->meshes.Elements())
+			{
+				for (auto& primitive : mesh.primitives)
+				{
+					for (const char* attribute : {"POSITION", "NORMAL", "TEXCOORD_0", "TANGENT"})
+					{
+						std::string accessorId;
+						if (primitive.TryGetAttributeAccessorId(attribute, accessorId))
+							accessors->push_back(accessorId);
+					}
+				}
+			}
+			kernels.push_back(
+					{"gltf_accessor_decode", static_cast<uint32_t>(accessors->size()), 50, [model, accessors]()
+					{
+						size_t floats = 0;
+						for (auto& accessorId : *accessors)
+						{
+							const auto& accessor = model->document->accessors.Get(accessorId);
+							floats += model->resourceReader->ReadBinaryData<float>(*model->document, accessor).size();
+						}
+						BenchKeep(floats);
+					}}
+			);
+		}
+		
+		// SHADER COMPILATION, online with the includes, as a recompile from the gui does it
+		if (SetUp(filter, {"shader_compile"}))
+		{
+			kernels.push_back(
+					{"shader_compile", 1, 10, []()
+					{
+						Shader shader("Shaders/Deferred/gBuffer.frag", ShaderType::Fragment, true);
+						BenchKeep(shader.byte_size());
+					}}
+			);
+		}
+		
+		return kernels;
+	}
+}
@@ -0,0 +1,125 @@
+/*
+Copyright (c) 2018-2021 Christos Karamoustos
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "Bench.h"
+#include "Code/Core/Timer.h"
+#include "Code/Core/FrameHistory.h"
+#include "Code/Renderer/RenderApi.h"
+#include "rapidjson/prettywriter.h"
+#include "rapidjson/stringbuffer.h"
+#include <fstream>
+#include <iostream>
+
+using namespace pe;
+
+static volatile uint8_t s_sink = 0;
+
+void pe::BenchKeep(const void* data, size_t size)
+{
+	const auto* bytes = static_cast<const uint8_t*>(data);
+	uint8_t value = 0;
+	for (size_t i = 0; i < size; i++)
+		value ^= bytes[i];
+	s_sink = s_sink ^ value;
+}
+
+// Runs the microbenchmarks of the cpu subsystems and writes their timings per operation as json.
+// Options: --output <file>, --filter <part of a kernel name>
+int main(int argc, char* argv[])
+{
+	std::string output = "bench.json";
+	std::string filter {};
+	for (int i = 1; i < argc; i++)
+	{
+		const std::string arg(argv[i]);
+		const bool hasValue = i + 1 < argc;
+		if (arg == "--output" && hasValue)
+			output = argv[++i];
+		else if (arg == "--filter" && hasValue)
+			filter = argv[++i];
+	}
+	
+	// no device, the kernels that touch the render api take its cpu path
+	g_Api = RenderApi::Null;
+	
+	rapidjson::StringBuffer buffer;
+	rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(buffer);
+	writer.StartObject();
+	writer.Key("unit");
+	writer.String("ns");
+	writer.Key("kernels");
+	writer.StartObject();
+	
+	for (auto& kernel : BenchKernels(filter))
+	{
+		// a group is set up for all its kernels when one of them passes
+		if (!filter.empty() && kernel.name.find(filter) == std::string::npos)
+			continue;
+		
+		// the first call fills the caches and the lazy state
+		kernel.run();
+		
+		std::vector<double> times(kernel.samples);
+		Timer timer;
+		for (auto& time : times)
+		{
+			timer.Start();
+			kernel.run();
+			time = SECONDS_TO_NANOSECONDS<double>(timer.Count()) / static_cast<double>(kernel.ops);
+		}
+		const TimingStatistics statistics = TimingStatistics::Compute(times);
+		
+		writer.Key(kernel.name.c_str());
+		writer.StartObject();
+		writer.Key("ops");
+		writer.Uint(kernel.ops);
+		writer.Key("samples");
+		writer.Uint(kernel.samples);
+		writer.Key("min");
+		writer.Double(statistics.min);
+		writer.Key("mean");
+		writer.Double(statistics.mean);
+		writer.Key("p50");
+		writer.Double(statistics.p50);
+		writer.Key("p95");
+		writer.Double(statistics.p95);
+		writer.Key("p99");
+		writer.Double(statistics.p99);
+		writer.Key("max");
+		writer.Double(statistics.max);
+		writer.EndObject();
+		
+		std::cout << kernel.name << ": " << statistics.p50 << " ns (p95 " << statistics.p95 << ")" << std::endl;
+	}
+	
+	writer.EndObject();
+	writer.EndObject();
+	
+	std::ofstream file(output);
+	if (!file)
+	{
+		std::cerr << "Bench output could not be written: " << output << std::endl;
+		return 1;
+	}
+	file << buffer.GetString() << std::endl;
+	return 0;
+}
@@ -22,6 +22,7 @@ SOFTWARE.
 
 #include "Camera.h"
 #include "../GUI/GUI.h"
+#include "../Renderer/RenderApi.h"
 
 namespace pe
 {
@@ -72,7 +73,8 @@ namespace pe
         
         frustum.resize(6);
         
-        frustumCompute = Compute::Create("Shaders/Compute/frustum.comp", 64, 96);
+        if DYNAMIC_CONSTEXPR (PE_VULKAN)
+            frustumCompute = Compute::Create("Shaders/Compute/frustum.comp", 64, 96);
         
         renderArea.Update(vec2(GUI::winPos.x, GUI::winPos.y), vec2(GUI::winSize.x, GUI::winSize.y));
         
@@ -201,6 +203,24 @@ namespace pe
     
     void Camera::ExtractFrustum()
     {
+        // there are no computes in the null api, the planes are extracted on the cpu
+        if DYNAMIC_CONSTEXPR (PE_NULL)
+        {
+            // transpose just to make the calculations look simpler
+            mat4 pvm = transpose(viewProjection);
+            
+            // right, left, bottom, top, far, near
+            for (unsigned i = 0; i < 6; i++)
+            {
+                vec4 temp = i % 2 == 0 ? pvm[3] - pvm[i / 2] : pvm[3] + pvm[i / 2];
+                temp /= length(vec3(temp));
+                
+                frustum[i].normal = vec3(temp);
+                frustum[i].d = temp.w;
+            }
+            return;
+        }
+        
         // Just testing computes, the specific one is not speeding up any process
         frustumCompute.waitFence();
         frustum = frustumCompute.copyOutput<Plane, AUTO>();
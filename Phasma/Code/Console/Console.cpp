@@ -22,6 +22,9 @@ SOFTWARE.
 
 #include "Console.h"
 #include "../Core/Queue.h"  // for Queue, Queue::loadModel
+#include "../Model/Model.h"
+#include "../Renderer/MemoryStats.h"
+#include <fstream>
 
 namespace pe
 {
@@ -36,6 +39,8 @@ namespace pe
 		Commands.push_back("HISTORY");
 		Commands.push_back("CLEAR");
 		Commands.push_back("CLOSE");
+		Commands.push_back("ANIMATION BENCHMARK");
+		Commands.push_back("MEMORY REPORT");
 		AddLog("Welcome to Dear ImGui!");
 	}
 	
@@ -213,6 +218,45 @@ namespace pe
 		else if (Stricmp(command_line, "CLOSE") == 0)
 		{
 			close_app = true;
+		}
+		else if (Stricmp(command_line, "ANIMATION BENCHMARK") == 0)
+		{
+			// runs the cpu animation path of the first animated model for many instances
+			const uint32_t instances = 512;
+			const uint32_t frames = 120;
+			Model* animated = nullptr;
+			for (auto& model : Model::models)
+			{
+				if (!model.animations.empty())
+				{
+					animated = &model;
+					break;
+				}
+			}
+			if (animated)
+			{
+				const double ms = Animator::Benchmark(
+						animated->animations, animated->linearNodes.size(), instances, frames
+				);
+				AddLog("%u instances: %.3f ms per frame", instances, ms);
+			}
+			else
+			{
+				AddLog("No animated model is loaded");
+			}
+		}
+		else if (Stricmp(command_line, "MEMORY REPORT") == 0)
+		{
+			std::ofstream file("memory.json");
+			if (file)
+			{
+				file << MemoryStats::Report() << std::endl;
+				AddLog("Memory report written to memory.json");
+			}
+			else
+			{
+				AddLog("memory.json could not be written");
+			}
 		}
 			//else if (Stricmp(command_line, "LOAD MODEL SPONZA") == 0)
 			//{
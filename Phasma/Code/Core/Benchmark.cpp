@@ -0,0 +1,363 @@
+/*
+Copyright (c) 2018-2021 Christos Karamoustos
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "PhasmaPch.h"
+#include "Benchmark.h"
+#include "Timer.h"
+#include "FrameHistory.h"
+#include "Queue.h"
+#include "Path.h"
+#include "Profiler.h"
+#include "Recorder.h"
+#include "../Camera/Camera.h"
+#include "../GUI/GUI.h"
+#include "../Renderer/RenderApi.h"
+#include "../Renderer/MemoryStats.h"
+#include "../Model/Model.h"
+#include "rapidjson/prettywriter.h"
+#include "rapidjson/stringbuffer.h"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+
+namespace pe
+{
+	// the value of a frame count option, a value that is not a number fails like a path that can not be loaded
+	static int CountOption(const std::string& option, const char* value)
+	{
+		try
+		{
+			return std::stoi(value);
+		}
+		catch (const std::exception&)
+		{
+			throw std::runtime_error("Benchmark " + option + " is not a number: " + value);
+		}
+	}
+	
+	bool Benchmark::Parse(int argc, char* argv[])
+	{
+		for (int i = 1; i < argc; i++)
+		{
+			const std::string arg(argv[i]);
+			const bool hasValue = i + 1 < argc;
+			if (arg == "--benchmark")
+				enabled = true;
+			else if (arg == "--frames" && hasValue)
+				frames = std::max(CountOption(arg, argv[++i]), 1);
+			else if (arg == "--warmup" && hasValue)
+				warmupFrames = std::max(CountOption(arg, argv[++i]), 0);
+			else if (arg == "--scene" && hasValue)
+				scenes.emplace_back(argv[++i]);
+			else if (arg == "--output" && hasValue)
+				output = argv[++i];
+			else if (arg == "--trace" && hasValue)
+				trace = argv[++i];
+			else if (arg == "--path" && hasValue)
+			{
+				if (!LoadPath(argv[++i]))
+					throw std::runtime_error("Benchmark path could not be loaded");
+			}
+		}
+		
+		// the null api has no window or input, it can only run the script
+		if (PE_NULL)
+			enabled = true;
+		
+		if (!enabled)
+			return false;
+		
+		// a replay loads the models of the recording
+		if (scenes.empty() && !Recorder::replaying)
+			scenes = {"DamagedHelmet/glTF/DamagedHelmet.gltf", "Corset/glTF/Corset.gltf",
+			          "sketch_background_terrain/scene.gltf"};
+		
+		// the replay measures all its frames after the warmup
+		if (Recorder::replaying)
+			frames = std::max(Recorder::Frames(), warmupFrames + 1) - warmupFrames;
+		
+		// an orbit around the origin when there is no recorded path
+		if (path.empty() && !Recorder::replaying)
+		{
+			const uint32_t keys = 8;
+			for (uint32_t i = 0; i <= keys; i++)
+			{
+				const float angle = radians(360.f * static_cast<float>(i) / static_cast<float>(keys));
+				const float height = 1.5f + sin(2.f * angle);
+				path.push_back({vec3(6.f * sin(angle), height, 6.f * cos(angle)), -10.f, degrees(angle) + 180.f});
+			}
+		}
+		
+		// the scene renders at a fixed resolution
+		GUI::dynamic_resolution = false;
+		
+		cpuTimes.resize(StageCount);
+		gpuTimes.resize(RegionCount);
+		memoryPeaks.resize(static_cast<size_t>(MemoryCategory::Count) + 1, 0);
+		return true;
+	}
+	
+	bool Benchmark::LoadPath(const std::string& file)
+	{
+		std::ifstream stream(file);
+		if (!stream)
+			return false;
+		
+		// a key per line: x y z pitch yaw, the lines that start with # are comments
+		path.clear();
+		std::string line;
+		while (std::getline(stream, line))
+		{
+			if (line.empty() || line[0] == '#')
+				continue;
+			
+			std::istringstream values(line);
+			CameraKey key {};
+			if (values >> key.position.x >> key.position.y >> key.position.z >> key.pitch >> key.yaw)
+				path.push_back(key);
+		}
+		return path.size() >= 2;
+	}
+	
+	void Benchmark::LoadScenes()
+	{
+		for (auto& scene : scenes)
+		{
+			const size_t split = scene.find_last_of('/') + 1;
+			Queue::loadModel.emplace_back(Path::Assets + "Objects/" + scene.substr(0, split), scene.substr(split));
+		}
+	}
+	
+	bool Benchmark::Step(Camera& camera)
+	{
+		// the script starts after the scenes are loaded
+		if (loading)
+		{
+			if (!Queue::loadModel.empty() || !Queue::loadModelFutures.empty())
+				return true;
+			loading = false;
+		}
+		
+		if (frame >= warmupFrames + frames)
+			return false;
+		
+		// a replay places the camera itself, its frames that wait for a load are not measured
+		if (Recorder::replaying)
+		{
+			if (!Recorder::Step(camera))
+				return false;
+			if (Recorder::loading)
+				return true;
+		}
+
+#ifndef PE_NO_PROFILE
+		// the trace covers the measured frames
+		if (frame == warmupFrames && !trace.empty())
+			Profiler::Capture(frames, trace);
+#endif
+		
+		if (Recorder::replaying)
+		{
+			frame++;
+			return true;
+		}
+		
+		// the warmup frames stay at the start of the path
+		const float t = frame < warmupFrames ?
+		                0.f : static_cast<float>(frame - warmupFrames) / static_cast<float>(std::max(frames - 1, 1u));
+		const float position = t * static_cast<float>(path.size() - 1);
+		const size_t index = std::min(static_cast<size_t>(position), path.size() - 2);
+		const float f = position - static_cast<float>(index);
+		const CameraKey& a = path[index];
+		const CameraKey& b = path[index + 1];
+		
+		camera.position = a.position + (b.position - a.position) * f;
+		camera.euler = vec3(radians(mix(a.pitch, b.pitch, f)), radians(mix(a.yaw, b.yaw, f)), 0.f);
+		camera.orientation = quat(camera.euler);
+		
+		frame++;
+		return true;
+	}
+	
+	void Benchmark::Record(double frameTime)
+	{
+		// Step already counted the frame that ended
+		if (loading || Recorder::loading || frame <= warmupFrames)
+			return;
+		
+		// FrameHistory already counted the frame, the hitches are reported from the first measured one
+		if (frameTimes.empty())
+			firstFrame = FrameHistory::frame - 1;
+		frameTimes.push_back(SECONDS_TO_MILLISECONDS<double>(frameTime));
+		
+		const auto& timestamps = FrameTimer::Instance().timestamps;
+		for (size_t i = 0; i < StageCount; i++)
+			cpuTimes[i].push_back(SECONDS_TO_MILLISECONDS<double>(timestamps[i]));
+		
+		// a pass that did not run in the resolved frame reads 0 and is left out
+		for (size_t i = 0; i < RegionCount; i++)
+		{
+			if (GPUTimer::Name(static_cast<GPURegion>(i)) && GUI::metrics[i] > 0.f)
+				gpuTimes[i].push_back(static_cast<double>(GUI::metrics[i]));
+		}
+		
+		uint64_t total = 0;
+		for (size_t i = 0; i < static_cast<size_t>(MemoryCategory::Count); i++)
+		{
+			const uint64_t bytes = MemoryStats::Bytes(static_cast<MemoryCategory>(i));
+			memoryPeaks[i] = std::max(memoryPeaks[i], bytes);
+			total += bytes;
+		}
+		memoryPeaks.back() = std::max(memoryPeaks.back(), total);
+	}
+	
+	void Benchmark::Write()
+	{
+		rapidjson::StringBuffer buffer;
+		rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(buffer);
+		
+		const auto writeStatistics = [&writer](const char* name, const std::vector<double>& values)
+		{
+			const TimingStatistics statistics = TimingStatistics::Compute(values);
+			writer.Key(name);
+			writer.StartObject();
+			writer.Key("min");
+			writer.Double(statistics.min);
+			writer.Key("mean");
+			writer.Double(statistics.mean);
+			writer.Key("p50");
+			writer.Double(statistics.p50);
+			writer.Key("p95");
+			writer.Double(statistics.p95);
+			writer.Key("p99");
+			writer.Double(statistics.p99);
+			writer.Key("max");
+			writer.Double(statistics.max);
+			writer.EndObject();
+		};
+		
+		writer.StartObject();
+		writer.Key("device");
+		writer.String(PE_NULL ? "Null" : VulkanContext::Get()->gpuProperties->deviceName.data());
+		writer.Key("frames");
+		writer.Uint(static_cast<uint32_t>(frameTimes.size()));
+		writer.Key("scenes");
+		writer.StartArray();
+		for (auto& scene : scenes)
+			writer.String(scene.c_str());
+		writer.EndArray();
+		
+		writeStatistics("frame", frameTimes);
+		
+		// the hitches of the measured frames
+		writer.Key("hitches");
+		writer.StartArray();
+		for (auto& hitch : FrameHistory::hitches)
+		{
+			if (hitch.frame < firstFrame)
+				continue;
+			writer.StartObject();
+			writer.Key("frame");
+			writer.Uint64(hitch.frame - firstFrame);
+			writer.Key("ms");
+			writer.Double(hitch.ms);
+			writer.Key("median");
+			writer.Double(hitch.median);
+			writer.Key("subsystem");
+			writer.String(hitch.subsystem);
+			writer.EndObject();
+		}
+		writer.EndArray();
+		
+		writer.Key("cpu");
+		writer.StartObject();
+		for (size_t i = 0; i < StageCount; i++)
+			writeStatistics(FrameTimer::StageName(static_cast<FrameStage>(i)), cpuTimes[i]);
+		writer.EndObject();
+		
+		writer.Key("gpu");
+		writer.StartObject();
+		for (size_t i = 0; i < RegionCount; i++)
+		{
+			if (const char* name = GPUTimer::Name(static_cast<GPURegion>(i)))
+				writeStatistics(name, gpuTimes[i]);
+		}
+		writer.EndObject();
+		
+		// peak bytes
+		writer.Key("memory");
+		writer.StartObject();
+		for (size_t i = 0; i < static_cast<size_t>(MemoryCategory::Count); i++)
+		{
+			writer.Key(MemoryStats::Name(static_cast<MemoryCategory>(i)));
+			writer.Uint64(memoryPeaks[i]);
+		}
+		writer.Key("total");
+		writer.Uint64(memoryPeaks.back());
+		writer.EndObject();
+		
+		// ms per loaded model, named like --scene
+		const std::string objects = Path::Assets + "Objects/";
+		writer.Key("loads");
+		writer.StartObject();
+		for (auto& model : Model::models)
+		{
+			if (model.loadTime <= 0.0)
+				continue;
+			const bool underObjects = model.fullPathName.compare(0, objects.size(), objects) == 0;
+			writer.Key((underObjects ? model.fullPathName.substr(objects.size()) : model.fullPathName).c_str());
+			writer.Double(SECONDS_TO_MILLISECONDS<double>(model.loadTime));
+		}
+		writer.EndObject();
+		
+		// the calls the null command buffer counted in the last frame
+		if (PE_NULL)
+		{
+			const NullCommandCounts& counts = NullContext::Get()->lastFrame;
+			writer.Key("commands");
+			writer.StartObject();
+			writer.Key("draws");
+			writer.Uint(counts.draws);
+			writer.Key("indices");
+			writer.Uint64(counts.indices);
+			writer.Key("pipelineBinds");
+			writer.Uint(counts.pipelineBinds);
+			writer.Key("descriptorSetBinds");
+			writer.Uint(counts.descriptorSetBinds);
+			writer.Key("pushConstants");
+			writer.Uint(counts.pushConstants);
+			writer.Key("dispatches");
+			writer.Uint(counts.dispatches);
+			writer.Key("copies");
+			writer.Uint(counts.copies);
+			writer.EndObject();
+		}
+		writer.EndObject();
+		
+		std::ofstream file(output);
+		if (!file)
+			throw std::runtime_error("Benchmark output could not be written: " + output);
+		file << buffer.GetString() << std::endl;
+		std::cout << "Benchmark: " << frameTimes.size() << " frames written to " << output << std::endl;
+	}
+}
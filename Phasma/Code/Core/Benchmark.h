@@ -0,0 +1,89 @@
+/*
+Copyright (c) 2018-2021 Christos Karamoustos
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include "Math.h"
+#include "FrameHistory.h"
+#include <string>
+#include <vector>
+
+namespace pe
+{
+	class Camera;
+	
+	// A camera key of a benchmark path, position and pitch, yaw in degrees
+	struct CameraKey
+	{
+		vec3 position;
+		float pitch;
+		float yaw;
+	};
+	
+	// Runs a deterministic frame script when the executable starts with --benchmark.
+	// The scenes are loaded, the camera flies the path for a fixed number of frames with a fixed time step
+	// and an uncapped frame rate, then the cpu stage and gpu pass timings, the hitches, the device memory peaks
+	// and the model load times are written as json, PhasmaCompare checks two of these files for regressions.
+	// Options: --frames N, --warmup N, --scene <folder/file under Assets/Objects>, --path <file>, --output <file>,
+	// --trace <file> for a chrome trace of the measured frames, --replay <file> to fly a Recorder session instead
+	// With the null api (--null) the script always runs and the counted draw calls are written too
+	class Benchmark
+	{
+	public:
+		// false when the command line does not ask for a benchmark
+		static bool Parse(int argc, char* argv[]);
+		
+		static void LoadScenes();
+		
+		// places the camera for the next frame, false after the last frame of the script
+		static bool Step(Camera& camera);
+		
+		// the time step of the script, the updates do not depend on the frame rate
+		static double Delta()
+		{ return 1.0 / 60.0; }
+		
+		// gathers the timings of the frame that just ended
+		static void Record(double frameTime);
+		
+		static void Write();
+		
+		inline static bool enabled = false;
+	
+	private:
+		static bool LoadPath(const std::string& file);
+		
+		inline static uint32_t frames = 600;
+		inline static uint32_t warmupFrames = 60;
+		inline static uint32_t frame = 0;
+		inline static bool loading = true;
+		inline static std::string output = "benchmark.json";
+		inline static std::string trace {};
+		inline static std::vector<std::string> scenes {};
+		inline static std::vector<CameraKey> path {};
+		inline static uint64_t firstFrame = 0;
+		inline static std::vector<double> frameTimes {};
+		inline static std::vector<std::vector<double>> cpuTimes {};
+		inline static std::vector<std::vector<double>> gpuTimes {};
+		// the most device memory per MemoryCategory during the measured frames, and of all of them together
+		inline static std::vector<uint64_t> memoryPeaks {};
+	};
+}
@@ -0,0 +1,110 @@
+/*
+Copyright (c) 2018-2021 Christos Karamoustos
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "PhasmaPch.h"
+#include "FrameHistory.h"
+#include "Timer.h"
+#include <algorithm>
+#include <cmath>
+
+namespace pe
+{
+	TimingStatistics TimingStatistics::Compute(std::vector<double> values)
+	{
+		TimingStatistics statistics;
+		if (values.empty())
+			return statistics;
+		
+		std::sort(values.begin(), values.end());
+		double sum = 0.0;
+		for (double value : values)
+			sum += value;
+		statistics.mean = sum / static_cast<double>(values.size());
+		statistics.min = values.front();
+		statistics.max = values.back();
+		
+		// nearest rank
+		const auto percentile = [&values](double p)
+		{
+			const size_t rank = static_cast<size_t>(std::ceil(p * static_cast<double>(values.size())));
+			return values[std::clamp<size_t>(rank, 1, values.size()) - 1];
+		};
+		statistics.p50 = percentile(0.50);
+		statistics.p95 = percentile(0.95);
+		statistics.p99 = percentile(0.99);
+		return statistics;
+	}
+	
+	void FrameHistory::Mark(const char* subsystem) noexcept
+	{
+		if (!marked)
+			marked = subsystem;
+	}
+	
+	void FrameHistory::Push(double delta)
+	{
+		const double ms = SECONDS_TO_MILLISECONDS<double>(delta);
+		
+		// the median of the frames before this one, so a long hitch does not raise its own bar
+		if (count >= MIN_FRAMES)
+		{
+			const size_t size = std::min(count, HISTORY);
+			std::vector<double> sorted(times.begin(), times.begin() + size);
+			std::nth_element(sorted.begin(), sorted.begin() + size / 2, sorted.end());
+			const double median = sorted[size / 2];
+			
+			if (median > 0.0 && ms > median * hitchThreshold)
+			{
+				const char* subsystem = marked;
+				if (!subsystem)
+				{
+					const auto& timestamps = FrameTimer::Instance().timestamps;
+					const auto slowest = std::max_element(timestamps.begin(), timestamps.begin() + StageLatencySleep);
+					subsystem = FrameTimer::StageName(static_cast<FrameStage>(slowest - timestamps.begin()));
+				}
+				
+				hitches.push_back({frame, ms, median, subsystem});
+				if (hitches.size() > MAX_HITCHES)
+					hitches.pop_front();
+			}
+		}
+		
+		times[count % HISTORY] = ms;
+		count++;
+		frame++;
+		marked = nullptr;
+	}
+	
+	TimingStatistics FrameHistory::Statistics()
+	{
+		return TimingStatistics::Compute(std::vector<double>(times.begin(), times.begin() + std::min(count, HISTORY)));
+	}
+	
+	std::vector<float> FrameHistory::Times()
+	{
+		const size_t size = std::min(count, HISTORY);
+		std::vector<float> result(size);
+		for (size_t i = 0; i < size; i++)
+			result[i] = static_cast<float>(times[(count - size + i) % HISTORY]);
+		return result;
+	}
+}
@@ -0,0 +1,86 @@
+/*
+Copyright (c) 2018-2021 Christos Karamoustos
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <array>
+#include <deque>
+#include <vector>
+
+namespace pe
+{
+	// min, mean, percentiles and max of a series of timings in ms
+	struct TimingStatistics
+	{
+		double min = 0.0;
+		double mean = 0.0;
+		double p50 = 0.0;
+		double p95 = 0.0;
+		double p99 = 0.0;
+		double max = 0.0;
+		
+		static TimingStatistics Compute(std::vector<double> values);
+	};
+	
+	// a frame slower than FrameHistory::hitchThreshold times the median frame
+	struct Hitch
+	{
+		uint64_t frame;
+		double ms;
+		double median;
+		// the subsystem marked in the frame, or the slowest cpu stage when nothing was marked
+		const char* subsystem;
+	};
+	
+	// The times of the last frames and the hitches among them.
+	// The subsystems that can stall a frame (loads, resizes, shader compiles) mark it from the main thread,
+	// so every hitch names what was active.
+	class FrameHistory
+	{
+	public:
+		static constexpr size_t HISTORY = 512;
+		static constexpr size_t MAX_HITCHES = 64;
+		
+		// tags the current frame, the first mark of a frame wins
+		static void Mark(const char* subsystem) noexcept;
+		
+		// adds the frame that just ended, in seconds
+		static void Push(double delta);
+		
+		static TimingStatistics Statistics();
+		
+		// the frame times in ms, oldest first
+		static std::vector<float> Times();
+		
+		inline static double hitchThreshold = 2.0;
+		inline static uint64_t frame = 0;
+		inline static std::deque<Hitch> hitches {};
+	
+	private:
+		// frames needed before the median is trusted
+		static constexpr size_t MIN_FRAMES = 60;
+		
+		inline static std::array<double, HISTORY> times {};
+		inline static size_t count = 0;
+		inline static const char* marked = nullptr;
+	};
+}
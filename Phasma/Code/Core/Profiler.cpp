@@ -0,0 +1,218 @@
+/*
+Copyright (c) 2018-2021 Christos Karamoustos
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "PhasmaPch.h"
+#include "Profiler.h"
+#include "rapidjson/writer.h"
+#include "rapidjson/stringbuffer.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+
+namespace pe
+{
+	static const auto s_epoch = std::chrono::steady_clock::now();
+	
+	// only taken when a thread gets or gives back a lane and once per frame, never for an event
+	static std::mutex s_lanes_mutex {};
+	static std::vector<std::unique_ptr<ProfileLane>> s_lanes {};
+	static std::vector<ProfileLane*> s_free_lanes {};
+	
+	struct LaneOwner
+	{
+		ProfileLane* lane;
+		
+		LaneOwner()
+		{
+			std::lock_guard<std::mutex> guard(s_lanes_mutex);
+			if (s_free_lanes.empty())
+			{
+				s_lanes.push_back(std::make_unique<ProfileLane>());
+				lane = s_lanes.back().get();
+			}
+			else
+			{
+				lane = s_free_lanes.back();
+				s_free_lanes.pop_back();
+			}
+		}
+		
+		~LaneOwner()
+		{
+			lane->name.store(nullptr, std::memory_order_relaxed);
+			lane->depth = 0;
+			std::lock_guard<std::mutex> guard(s_lanes_mutex);
+			s_free_lanes.push_back(lane);
+		}
+	};
+	
+	ProfileZone::ProfileZone(const char* name) : m_lane(Profiler::Lane()), m_name(name), m_start(Profiler::Now())
+	{
+		m_depth = m_lane->depth++;
+	}
+	
+	ProfileZone::~ProfileZone()
+	{
+		m_lane->depth--;
+		m_lane->Push({m_name, m_start, Profiler::Now(), 0.0, m_depth, false});
+	}
+	
+	uint64_t Profiler::Now()
+	{
+		const auto elapsed = std::chrono::steady_clock::now() - s_epoch;
+		return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+	}
+	
+	ProfileLane* Profiler::Lane()
+	{
+		thread_local LaneOwner owner;
+		return owner.lane;
+	}
+	
+	void Profiler::SetThreadName(const char* name)
+	{
+		Lane()->name.store(name, std::memory_order_relaxed);
+	}
+	
+	void Profiler::Counter(const char* name, double value)
+	{
+		const uint64_t now = Now();
+		Lane()->Push({name, now, now, value, 0, true});
+	}
+	
+	void Profiler::BeginFrame()
+	{
+		const uint64_t now = Now();
+		
+		std::lock_guard<std::mutex> guard(s_lanes_mutex);
+		s_frame.start = s_frame.end > 0 ? s_frame.end : now;
+		s_frame.end = now;
+		s_frame.names.resize(s_lanes.size());
+		s_frame.lanes.resize(s_lanes.size());
+		for (size_t i = 0; i < s_lanes.size(); i++)
+		{
+			ProfileLane& lane = *s_lanes[i];
+			auto& events = s_frame.lanes[i];
+			events.clear();
+			
+			// the oldest events of a lane that wrapped since the last frame are lost
+			const uint64_t head = lane.m_head.load(std::memory_order_acquire);
+			const uint64_t oldest = head > ProfileLane::CAPACITY ? head - ProfileLane::CAPACITY : 0;
+			const uint64_t first = std::max(lane.m_read, oldest);
+			for (uint64_t e = first; e < head; e++)
+				events.push_back(lane.m_events[e % ProfileLane::CAPACITY]);
+			lane.m_read = head;
+			
+			const char* name = lane.name.load(std::memory_order_relaxed);
+			s_frame.names[i] = name ? name : "Worker " + std::to_string(i);
+		}
+		
+		if (s_captureFrames > 0)
+		{
+			s_capture.resize(s_frame.lanes.size());
+			for (size_t i = 0; i < s_frame.lanes.size(); i++)
+				s_capture[i].insert(s_capture[i].end(), s_frame.lanes[i].begin(), s_frame.lanes[i].end());
+			
+			if (--s_captureFrames == 0)
+				WriteCapture();
+		}
+	}
+	
+	void Profiler::Capture(uint32_t frames, const std::string& file)
+	{
+		s_capture.clear();
+		s_captureFile = file;
+		s_captureFrames = frames;
+	}
+	
+	void Profiler::WriteCapture()
+	{
+		rapidjson::StringBuffer buffer;
+		rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+		
+		writer.StartObject();
+		writer.Key("displayTimeUnit");
+		writer.String("ms");
+		writer.Key("traceEvents");
+		writer.StartArray();
+		for (size_t i = 0; i < s_capture.size(); i++)
+		{
+			const unsigned tid = static_cast<unsigned>(i);
+			writer.StartObject();
+			writer.Key("name");
+			writer.String("thread_name");
+			writer.Key("ph");
+			writer.String("M");
+			writer.Key("pid");
+			writer.Uint(0);
+			writer.Key("tid");
+			writer.Uint(tid);
+			writer.Key("args");
+			writer.StartObject();
+			writer.Key("name");
+			writer.String(s_frame.names[i].c_str());
+			writer.EndObject();
+			writer.EndObject();
+			
+			// the trace event times are in us
+			for (auto& event : s_capture[i])
+			{
+				writer.StartObject();
+				writer.Key("name");
+				writer.String(event.name);
+				writer.Key("ph");
+				writer.String(event.counter ? "C" : "X");
+				writer.Key("ts");
+				writer.Double(static_cast<double>(event.start) / 1000.0);
+				if (!event.counter)
+				{
+					writer.Key("dur");
+					writer.Double(static_cast<double>(event.end - event.start) / 1000.0);
+				}
+				writer.Key("pid");
+				writer.Uint(0);
+				writer.Key("tid");
+				writer.Uint(tid);
+				if (event.counter)
+				{
+					writer.Key("args");
+					writer.StartObject();
+					writer.Key("value");
+					writer.Double(event.value);
+					writer.EndObject();
+				}
+				writer.EndObject();
+			}
+		}
+		writer.EndArray();
+		writer.EndObject();
+		s_capture.clear();
+		
+		std::ofstream file(s_captureFile);
+		if (!file)
+			throw std::runtime_error("Profiler capture could not be written: " + s_captureFile);
+		file << buffer.GetString() << std::endl;
+		std::cout << "Profiler: capture written to " << s_captureFile << std::endl;
+	}
+}
@@ -0,0 +1,150 @@
+/*
+Copyright (c) 2018-2021 Christos Karamoustos
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// The zone, thread and counter names are kept as pointers, they must be string literals.
+// Building with PE_NO_PROFILE (PHASMA_PROFILE=OFF in cmake) compiles all of the instrumentation out.
+#ifndef PE_NO_PROFILE
+	#define PE_PROFILE_CONCAT_INNER(a, b) a##b
+	#define PE_PROFILE_CONCAT(a, b) PE_PROFILE_CONCAT_INNER(a, b)
+	#define PE_PROFILE_SCOPE(name) pe::ProfileZone PE_PROFILE_CONCAT(profileZone, __LINE__)(name)
+	#define PE_PROFILE_FUNCTION() PE_PROFILE_SCOPE(__func__)
+	#define PE_PROFILE_THREAD(name) pe::Profiler::SetThreadName(name)
+	#define PE_PROFILE_COUNTER(name, value) pe::Profiler::Counter(name, static_cast<double>(value))
+	#define PE_PROFILE_FRAME() pe::Profiler::BeginFrame()
+#else
+	#define PE_PROFILE_SCOPE(name) ((void)0)
+	#define PE_PROFILE_FUNCTION() ((void)0)
+	#define PE_PROFILE_THREAD(name) ((void)0)
+	#define PE_PROFILE_COUNTER(name, value) ((void)0)
+	#define PE_PROFILE_FRAME() ((void)0)
+#endif
+
+namespace pe
+{
+	// A zone or a counter sample, the times are in ns since the profiler started
+	struct ProfileEvent
+	{
+		const char* name;
+		uint64_t start;
+		uint64_t end;
+		double value; // counters only
+		uint32_t depth;
+		bool counter;
+	};
+	
+	// The events of one thread in a ring that only this thread writes to.
+	// The head is published after each event, the frame collection reads up to it without locks.
+	class ProfileLane
+	{
+	public:
+		static constexpr uint64_t CAPACITY = 1 << 14;
+		
+		ProfileLane() : m_events(new ProfileEvent[CAPACITY])
+		{}
+		
+		void Push(const ProfileEvent& event)
+		{
+			const uint64_t head = m_head.load(std::memory_order_relaxed);
+			m_events[head % CAPACITY] = event;
+			m_head.store(head + 1, std::memory_order_release);
+		}
+		
+		uint32_t depth = 0;
+		std::atomic<const char*> name {nullptr};
+	
+	private:
+		friend class Profiler;
+		
+		std::unique_ptr<ProfileEvent[]> m_events;
+		std::atomic<uint64_t> m_head {0};
+		uint64_t m_read = 0; // the collection's cursor
+	};
+	
+	class ProfileZone
+	{
+	public:
+		explicit ProfileZone(const char* name);
+		
+		~ProfileZone();
+		
+		ProfileZone(const ProfileZone&) = delete;
+		
+		ProfileZone& operator=(const ProfileZone&) = delete;
+	
+	private:
+		ProfileLane* m_lane;
+		const char* m_name;
+		uint64_t m_start;
+		uint32_t m_depth;
+	};
+	
+	// The events that finished during a frame, one list per lane
+	struct ProfileFrame
+	{
+		uint64_t start = 0;
+		uint64_t end = 0;
+		std::vector<std::string> names {};
+		std::vector<std::vector<ProfileEvent>> lanes {};
+	};
+	
+	// Collects the zones of all threads once per frame. Every thread gets a lane on its first event and gives it back
+	// when it exits, the short lived async threads of the updates share a few lanes instead of one each.
+	// A capture keeps the frames and writes them in the chrome trace event format (chrome://tracing, Perfetto).
+	class Profiler
+	{
+	public:
+		static uint64_t Now();
+		
+		static ProfileLane* Lane();
+		
+		static void SetThreadName(const char* name);
+		
+		static void Counter(const char* name, double value);
+		
+		// gathers the events of the frame that just ended, called by the main thread at the start of a frame
+		static void BeginFrame();
+		
+		static const ProfileFrame& LastFrame()
+		{ return s_frame; }
+		
+		static void Capture(uint32_t frames, const std::string& file);
+		
+		static bool Capturing()
+		{ return s_captureFrames > 0; }
+	
+	private:
+		static void WriteCapture();
+		
+		inline static ProfileFrame s_frame {};
+		inline static std::vector<std::vector<ProfileEvent>> s_capture {};
+		inline static uint32_t s_captureFrames = 0;
+		inline static std::string s_captureFile {};
+	};
+}
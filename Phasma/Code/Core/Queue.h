@@ -30,6 +30,7 @@ SOFTWARE.
 #include <mutex>
 #include "../Renderer/Buffer.h"
 #include "../MemoryHash/MemoryHash.h"
+#include "Profiler.h"
 
 namespace pe
 {
@@ -41,9 +42,11 @@ namespace pe
 		
 		void exec_mem_copy()
 		{
+			// per frame buffers are written in the slice of the current frame
+			const size_t frameOffset = buffer->FrameOffset();
 			buffer->Map();
 			for (auto& memory_range : memory_ranges)
-				buffer->CopyData(memory_range.data, memory_range.size, memory_range.offset);
+				buffer->CopyData(memory_range.data, memory_range.size, frameOffset + memory_range.offset);
 			buffer->Flush();
 			buffer->Unmap();
 		}
@@ -59,6 +62,25 @@ namespace pe
 		inline static std::deque<int> removeScript {};
 		inline static std::deque<int> compileScript {};
 		inline static std::deque<std::future<std::any>> loadModelFutures {};
+		
+		// the model requests of the user in order, kept for the Recorder while it records
+		// an unload has the model index and empty paths, a load has index -1
+		inline static bool logRequests = false;
+		inline static std::vector<std::tuple<int, std::string, std::string>> requestLog {};
+		
+		inline static void requestLoadModel(const std::string& folderPath, const std::string& modelName)
+		{
+			loadModel.emplace_back(folderPath, modelName);
+			if (logRequests)
+				requestLog.emplace_back(-1, folderPath, modelName);
+		}
+		
+		inline static void requestUnloadModel(int index)
+		{
+			unloadModel.push_back(index);
+			if (logRequests)
+				requestLog.emplace_back(index, std::string(), std::string());
+		}
 	private:
 		inline static std::vector<CopyRequest> m_async_copy_requests {};
 		inline static std::mutex m_mem_cpy_request_mutex {};
@@ -71,6 +93,8 @@ namespace pe
 		
 		inline static void exec_memcpyRequests()
 		{
+			PE_PROFILE_SCOPE("Queue::exec_memcpyRequests");
+			
 			std::vector<std::future<void>> futureNodes(m_async_copy_requests.size());
 			for (uint32_t i = 0; i < m_async_copy_requests.size(); i++)
 				futureNodes[i] = std::async(
@@ -0,0 +1,391 @@
+/*
+Copyright (c) 2018-2021 Christos Karamoustos
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#include "PhasmaPch.h"
+#include "Recorder.h"
+#include "Queue.h"
+#include "../Camera/Camera.h"
+#include "../GUI/GUI.h"
+#include "../Event/EventSystem.h"
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+namespace pe
+{
+	// file: magic, version, size of the settings, frame count, then per frame
+	// flags, camera position and euler, [events], [settings], [commands]
+	static const char s_magic[4] {'P', 'R', 'E', 'C'};
+	static constexpr uint32_t s_version = 1;
+	
+	enum RecordFlags : uint8_t
+	{
+		RecordEvents = 1,
+		RecordSettings = 2,
+		RecordCommands = 4
+	};
+
+#define PE_SETTING(x) {&GUI::x, sizeof(GUI::x)}
+	// the gui settings that change the rendered frames, dynamic resolution stays off in a replay
+	static const std::pair<void*, size_t> s_settings[] {
+			PE_SETTING(renderTargetsScale), PE_SETTING(use_IBL), PE_SETTING(use_Volumetric_lights),
+			PE_SETTING(volumetric_steps), PE_SETTING(volumetric_dither_strength), PE_SETTING(show_ssr),
+			PE_SETTING(show_ssao), PE_SETTING(ssao_async_compute), PE_SETTING(show_tonemapping),
+			PE_SETTING(exposure), PE_SETTING(use_AntiAliasing), PE_SETTING(use_FXAA), PE_SETTING(use_TAA),
+			PE_SETTING(TAA_jitter_scale), PE_SETTING(TAA_feedback_min), PE_SETTING(TAA_feedback_max),
+			PE_SETTING(TAA_sharp_strength), PE_SETTING(TAA_sharp_clamp), PE_SETTING(TAA_sharp_offset_bias),
+			PE_SETTING(use_DOF), PE_SETTING(DOF_focus_scale), PE_SETTING(DOF_blur_range), PE_SETTING(show_Bloom),
+			PE_SETTING(Bloom_Inv_brightness), PE_SETTING(Bloom_intensity), PE_SETTING(Bloom_range),
+			PE_SETTING(use_tonemap), PE_SETTING(use_compute), PE_SETTING(Bloom_exposure),
+			PE_SETTING(show_motionBlur), PE_SETTING(motionBlur_strength), PE_SETTING(fuse_DOF_motionBlur),
+			PE_SETTING(randomize_lights), PE_SETTING(lights_intensity), PE_SETTING(lights_range),
+			PE_SETTING(point_lights_count), PE_SETTING(spot_lights_count), PE_SETTING(use_fog),
+			PE_SETTING(fog_ground_thickness), PE_SETTING(fog_global_thickness), PE_SETTING(fog_max_height),
+			PE_SETTING(shadow_cast), PE_SETTING(sun_intensity), PE_SETTING(sun_position), PE_SETTING(depthBias),
+			PE_SETTING(clearColor), PE_SETTING(timeScale)
+	};
+#undef PE_SETTING
+	
+	static size_t SettingsSize()
+	{
+		size_t size = 0;
+		for (auto& setting : s_settings)
+			size += setting.second;
+		return size;
+	}
+	
+	template<class T>
+	static void Put(std::vector<char>& data, const T& value)
+	{
+		const char* bytes = reinterpret_cast<const char*>(&value);
+		data.insert(data.end(), bytes, bytes + sizeof(T));
+	}
+	
+	static void PutString(std::vector<char>& data, const std::string& value)
+	{
+		Put(data, static_cast<uint16_t>(value.size()));
+		data.insert(data.end(), value.begin(), value.end());
+	}
+	
+	template<class T>
+	static T Get(const std::vector<char>& data, size_t& cursor)
+	{
+		if (cursor + sizeof(T) > data.size())
+			throw std::runtime_error("Recording is truncated");
+		
+		T value;
+		memcpy(&value, data.data() + cursor, sizeof(T));
+		cursor += sizeof(T);
+		return value;
+	}
+	
+	static std::string GetString(const std::vector<char>& data, size_t& cursor)
+	{
+		const size_t size = Get<uint16_t>(data, cursor);
+		if (cursor + size > data.size())
+			throw std::runtime_error("Recording is truncated");
+		
+		std::string value(data.data() + cursor, size);
+		cursor += size;
+		return value;
+	}
+	
+	void Recorder::Parse(int argc, char* argv[])
+	{
+		for (int i = 1; i < argc; i++)
+		{
+			const std::string arg(argv[i]);
+			const bool hasValue = i + 1 < argc;
+			if (arg == "--record" && hasValue)
+			{
+				recording = true;
+				file = argv[++i];
+			}
+			else if (arg == "--replay" && hasValue)
+			{
+				replaying = true;
+				file = argv[++i];
+			}
+		}
+		
+		if (recording && replaying)
+			throw std::runtime_error("--record and --replay can not be combined");
+		
+		if (recording)
+			Queue::logRequests = true;
+		
+		if (!replaying)
+			return;
+		
+		std::ifstream stream(file, std::ios::binary);
+		if (!stream)
+			throw std::runtime_error("Recording could not be loaded: " + file);
+		data.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+		
+		char magic[4];
+		for (char& c : magic)
+			c = Get<char>(data, cursor);
+		if (memcmp(magic, s_magic, sizeof(magic)) != 0 || Get<uint32_t>(data, cursor) != s_version)
+			throw std::runtime_error("Not a recording of this version: " + file);
+		if (Get<uint32_t>(data, cursor) != SettingsSize())
+			throw std::runtime_error("Recording has other gui settings: " + file);
+		frames = Get<uint32_t>(data, cursor);
+		
+		// the resolution would follow the frame times and the frames would differ
+		GUI::dynamic_resolution = false;
+	}
+	
+	bool Recorder::IsInput(const SDL_Event& event)
+	{
+		switch (event.type)
+		{
+			case SDL_KEYDOWN:
+			case SDL_KEYUP:
+			case SDL_MOUSEBUTTONDOWN:
+			case SDL_MOUSEWHEEL:
+				return true;
+			default:
+				return false;
+		}
+	}
+	
+	bool Recorder::Event(const SDL_Event& event)
+	{
+		if (!IsInput(event))
+			return false;
+		
+		if (replaying)
+			return true;
+		
+		// escape opens the exit dialog, it is not replayed
+		const bool escape = (event.type == SDL_KEYDOWN || event.type == SDL_KEYUP) &&
+		                    event.key.keysym.scancode == SDL_SCANCODE_ESCAPE;
+		if (recording && !escape)
+			events.push_back(event);
+		return false;
+	}
+	
+	const std::vector<SDL_Event>& Recorder::Events()
+	{
+		static const std::vector<SDL_Event> none {};
+		return replaying ? events : none;
+	}
+	
+	void Recorder::ReadSettings(std::vector<char>& values)
+	{
+		values.resize(SettingsSize());
+		char* bytes = values.data();
+		for (auto& setting : s_settings)
+		{
+			memcpy(bytes, setting.first, setting.second);
+			bytes += setting.second;
+		}
+	}
+	
+	void Recorder::WriteSettings(const std::vector<char>& values)
+	{
+		const float scale = GUI::renderTargetsScale;
+		
+		const char* bytes = values.data();
+		for (auto& setting : s_settings)
+		{
+			memcpy(setting.first, bytes, setting.second);
+			bytes += setting.second;
+		}
+		
+		// like the Apply button of the gui
+		if (scale != GUI::renderTargetsScale)
+			EventSystem::Get()->PushEvent(EventType::ScaleRenderTargets);
+	}
+	
+	bool Recorder::Step(Camera& camera)
+	{
+		if (recording)
+		{
+			std::vector<char> current;
+			ReadSettings(current);
+			
+			// the first frame keeps all the settings
+			uint8_t flags = 0;
+			if (!events.empty())
+				flags |= RecordEvents;
+			if (frames == 0 || current != settings)
+				flags |= RecordSettings;
+			if (!Queue::requestLog.empty())
+				flags |= RecordCommands;
+			
+			Put(data, flags);
+			Put(data, camera.position);
+			Put(data, camera.euler);
+			
+			if (flags & RecordEvents)
+			{
+				Put(data, static_cast<uint16_t>(events.size()));
+				for (auto& event : events)
+				{
+					Put(data, event.type);
+					if (event.type == SDL_MOUSEWHEEL)
+					{
+						Put(data, event.wheel.x);
+						Put(data, event.wheel.y);
+					}
+					else if (event.type == SDL_MOUSEBUTTONDOWN)
+					{
+						Put(data, static_cast<int32_t>(event.button.button));
+						Put<int32_t>(data, 0);
+					}
+					else
+					{
+						Put(data, static_cast<int32_t>(event.key.keysym.scancode));
+						Put<int32_t>(data, 0);
+					}
+				}
+			}
+			
+			if (flags & RecordSettings)
+				data.insert(data.end(), current.begin(), current.end());
+			
+			if (flags & RecordCommands)
+			{
+				Put(data, static_cast<uint16_t>(Queue::requestLog.size()));
+				for (auto& [index, folderPath, modelName] : Queue::requestLog)
+				{
+					Put(data, static_cast<int32_t>(index));
+					PutString(data, folderPath);
+					PutString(data, modelName);
+				}
+			}
+			
+			settings = std::move(current);
+			events.clear();
+			Queue::requestLog.clear();
+			frames++;
+			return true;
+		}
+		
+		if (!replaying)
+			return true;
+		
+		const auto pushCommand = []()
+		{
+			auto [index, folderPath, modelName] = commands.front();
+			commands.erase(commands.begin());
+			if (index < 0)
+				Queue::loadModel.emplace_back(folderPath, modelName);
+			else
+				Queue::unloadModel.push_back(index);
+		};
+		
+		// the models load one at a time and the replay waits for them, so they end up in the same order
+		// and appear in the same frame
+		const bool busy = !Queue::loadModel.empty() || !Queue::loadModelFutures.empty();
+		if (busy || !commands.empty())
+		{
+			if (!busy)
+				pushCommand();
+			loading = true;
+			events.clear();
+			return true;
+		}
+		loading = false;
+		
+		if (frame >= frames)
+			return false;
+		
+		const uint8_t flags = Get<uint8_t>(data, cursor);
+		camera.position = Get<vec3>(data, cursor);
+		camera.euler = Get<vec3>(data, cursor);
+		camera.orientation = quat(camera.euler);
+		
+		// Window::ProcessEvents handles them in the next frame
+		events.clear();
+		if (flags & RecordEvents)
+		{
+			const uint16_t count = Get<uint16_t>(data, cursor);
+			for (uint16_t i = 0; i < count; i++)
+			{
+				SDL_Event event {};
+				event.type = Get<uint32_t>(data, cursor);
+				const int32_t a = Get<int32_t>(data, cursor);
+				const int32_t b = Get<int32_t>(data, cursor);
+				if (event.type == SDL_MOUSEWHEEL)
+				{
+					event.wheel.x = a;
+					event.wheel.y = b;
+				}
+				else if (event.type == SDL_MOUSEBUTTONDOWN)
+					event.button.button = static_cast<uint8_t>(a);
+				else
+					event.key.keysym.scancode = static_cast<SDL_Scancode>(a);
+				events.push_back(event);
+			}
+		}
+		
+		if (flags & RecordSettings)
+		{
+			if (cursor + SettingsSize() > data.size())
+				throw std::runtime_error("Recording is truncated");
+			settings.assign(data.begin() + cursor, data.begin() + cursor + SettingsSize());
+			cursor += SettingsSize();
+			WriteSettings(settings);
+		}
+		
+		if (flags & RecordCommands)
+		{
+			const uint16_t count = Get<uint16_t>(data, cursor);
+			for (uint16_t i = 0; i < count; i++)
+			{
+				const int32_t index = Get<int32_t>(data, cursor);
+				std::string folderPath = GetString(data, cursor);
+				std::string modelName = GetString(data, cursor);
+				commands.emplace_back(index, std::move(folderPath), std::move(modelName));
+			}
+			
+			// the first one starts in this frame, like in the recording
+			pushCommand();
+		}
+		
+		frame++;
+		return true;
+	}
+	
+	void Recorder::Write()
+	{
+		if (!recording)
+			return;
+		
+		std::vector<char> header;
+		header.insert(header.end(), std::begin(s_magic), std::end(s_magic));
+		Put(header, s_version);
+		Put(header, static_cast<uint32_t>(SettingsSize()));
+		Put(header, frames);
+		
+		std::ofstream stream(file, std::ios::binary);
+		if (!stream)
+			throw std::runtime_error("Recording could not be written: " + file);
+		stream.write(header.data(), static_cast<std::streamsize>(header.size()));
+		stream.write(data.data(), static_cast<std::streamsize>(data.size()));
+		std::cout << "Recorder: " << frames << " frames written to " << file << std::endl;
+	}
+}
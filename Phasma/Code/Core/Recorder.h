@@ -0,0 +1,80 @@
+/*
+Copyright (c) 2018-2021 Christos Karamoustos
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#pragma once
+
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace pe
+{
+	class Camera;
+	
+	// Records a session into a compact binary file with --record <file> and plays it back with --replay <file>.
+	// Every frame keeps the input events of Window::ProcessEvents, the camera, the gui settings that changed
+	// and the model loads and unloads of the Queue. The replay drives the engine with the fixed time step of the
+	// Benchmark and waits for each load to finish, so two replays render the same frames.
+	// With --benchmark the replay is the path of the benchmark and its frames are measured.
+	class Recorder
+	{
+	public:
+		static void Parse(int argc, char* argv[]);
+		
+		// recording: keeps an input event of this frame, replaying: true for the live input that is ignored
+		static bool Event(const SDL_Event& event);
+		
+		// the recorded input events of the replayed frame, none when not replaying
+		static const std::vector<SDL_Event>& Events();
+		
+		// recording: stores this frame, replaying: applies the next frame, false after the last one
+		static bool Step(Camera& camera);
+		
+		// writes the recording, when there is one
+		static void Write();
+		
+		static uint32_t Frames()
+		{ return frames; }
+		
+		inline static bool recording = false;
+		inline static bool replaying = false;
+		// the replay waits for a model load, the frame does not advance
+		inline static bool loading = false;
+	
+	private:
+		static bool IsInput(const SDL_Event& event);
+		
+		static void ReadSettings(std::vector<char>& values);
+		
+		static void WriteSettings(const std::vector<char>& values);
+		
+		inline static std::string file {};
+		inline static std::vector<char> data {};
+		inline static size_t cursor = 0;
+		inline static uint32_t frames = 0;
+		inline static uint32_t frame = 0;
+		inline static std::vector<SDL_Event> events {};
+		inline static std::vector<char> settings {};
+		inline static std::vector<std::tuple<int, std::string, std::string>> commands {};
+	};
+}
@@ -24,9 +24,15 @@ SOFTWARE.
 #include "Timer.h"
 #include "../Renderer/RenderApi.h"
 #include <thread>
+#include <algorithm>
 
 namespace pe
 {
+	// the names of the FrameStage timestamps
+	static const char* s_frameStages[StageCount] {
+			"fence_wait", "updates", "culling", "memcpy", "acquire", "recording", "submit", "latency_sleep"
+	};
+	
 	Timer::Timer() noexcept
 	{
 		m_start = {};
@@ -45,23 +51,49 @@ namespace pe
 	
 	FrameTimer::FrameTimer() : Timer()
 	{
-		system_delay = 0;
+		sleepOvershoot = 0.002;
 		m_duration = {};
 		delta = 0.0f;
 		time = 0.0f;
-		timestamps.resize(1);
+		timestamps.resize(StageCount, 0.0);
 	}
 	
 	void FrameTimer::Delay(double seconds)
 	{
-		const std::chrono::nanoseconds delay {SECONDS_TO_NANOSECONDS<size_t>(seconds) - system_delay};
+		using namespace std::chrono;
+		
+		if (seconds <= 0.0)
+			return;
+		
+		const auto deadline = high_resolution_clock::now() + duration<double>(seconds);
 		
-		timer.Start();
-		std::this_thread::sleep_for(delay);
-		system_delay = SECONDS_TO_NANOSECONDS<size_t>(timer.Count()) - delay.count();
+		// sleep in short steps while the deadline is further than the scheduler can oversleep
+		while (true)
+		{
+			const auto before = high_resolution_clock::now();
+			const duration<double> left = deadline - before;
+			if (left.count() <= sleepOvershoot + 0.001)
+				break;
+			
+			std::this_thread::sleep_for(milliseconds(1));
+			
+			// rise to a worse oversleep at once and decay slowly, clamped to [0.25, 4] ms
+			const double overshoot = duration<double>(high_resolution_clock::now() - before).count() - 0.001;
+			sleepOvershoot = overshoot > sleepOvershoot ? overshoot : sleepOvershoot * 0.99 + overshoot * 0.01;
+			sleepOvershoot = std::clamp(sleepOvershoot, 0.00025, 0.004);
+		}
+		
+		// spin the remaining time, yielding so the other threads can still run
+		while (high_resolution_clock::now() < deadline)
+			std::this_thread::yield();
 	}
 	
 	
+	const char* FrameTimer::StageName(FrameStage stage)
+	{
+		return s_frameStages[stage];
+	}
+	
 	void FrameTimer::Tick() noexcept
 	{
 		m_duration = std::chrono::high_resolution_clock::now() - m_start;
@@ -69,7 +101,13 @@ namespace pe
 		time += delta;
 	}
 	
-	GPUTimer::GPUTimer()
+	// the names of the GPURegion passes, the indices in between are not timed
+	static const char* s_gpuRegions[RegionCount] {
+			"deferred", nullptr, "gbuffer", "ssao", "ssr", "lighting", "aa", "bloom", "dof", "motion_blur", "gui",
+			"shadows_0", "shadows_1", "shadows_2", nullptr, nullptr, "post_fused", "post_separate", nullptr, nullptr
+	};
+	
+	void GPUTimer::init()
 	{
 		const auto gpuProps = VulkanContext::Get()->gpu->getProperties();
 		if (!gpuProps.limits.timestampComputeAndGraphics)
@@ -77,42 +115,114 @@ namespace pe
 		
 		timestampPeriod = gpuProps.limits.timestampPeriod;
 		
+		// a start and an end query per region
 		vk::QueryPoolCreateInfo qpci;
 		qpci.queryType = vk::QueryType::eTimestamp;
-		qpci.queryCount = 2;
-		
-		queryPool = std::make_unique<vk::QueryPool>(VulkanContext::Get()->device->createQueryPool(qpci));
+		qpci.queryCount = RegionCount * 2;
 		
-		queryTimes.resize(2, 0);
+		pools.resize(MAX_FRAMES_IN_FLIGHT);
+		for (auto& pool : pools)
+			pool = VulkanContext::Get()->device->createQueryPool(qpci);
+		recorded.resize(MAX_FRAMES_IN_FLIGHT, false);
 	}
 	
-	void GPUTimer::start(const vk::CommandBuffer* cmd) noexcept
+	void GPUTimer::reset(const vk::CommandBuffer& cmd)
 	{
-		_cmd = cmd;
-		_cmd->resetQueryPool(*queryPool, 0, 2);
-		_cmd->writeTimestamp(vk::PipelineStageFlagBits::eTopOfPipe, *queryPool, 0);
+		// the query commands of a queue run in submission order, the later command buffers write after the reset
+		const uint32_t frameIndex = VulkanContext::Get()->frameIndex;
+		cmd.resetQueryPool(pools[frameIndex], 0, RegionCount * 2);
+		recorded[frameIndex] = true;
 	}
 	
-	void GPUTimer::end(float* res)
+	void GPUTimer::begin(const vk::CommandBuffer& cmd, GPURegion region) const
 	{
-		_cmd->writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, *queryPool, 1);
-		if (res)
-			*res = getTime();
+		cmd.writeTimestamp(
+				vk::PipelineStageFlagBits::eTopOfPipe, pools[VulkanContext::Get()->frameIndex], region * 2
+		);
+	}
+	
+	void GPUTimer::end(const vk::CommandBuffer& cmd, GPURegion region) const
+	{
+		cmd.writeTimestamp(
+				vk::PipelineStageFlagBits::eBottomOfPipe, pools[VulkanContext::Get()->frameIndex], region * 2 + 1
+		);
 	}
 	
-	float GPUTimer::getTime()
+	void GPUTimer::resolve(uint32_t frameIndex)
 	{
-		const auto res = VulkanContext::Get()->device->getQueryPoolResults(
-				*queryPool, 0, 2, sizeof(uint64_t) * queryTimes.size(), queryTimes.data(), sizeof(uint64_t),
-				vk::QueryResultFlagBits::e64
+		// never reset yet, the queries are undefined
+		if (!recorded[frameIndex])
+			return;
+		
+		// a value and an availability word per query, the regions that did not run stay unavailable
+		std::array<uint64_t, RegionCount * 4> results {};
+		const vk::Result res = VulkanContext::Get()->device->getQueryPoolResults(
+				pools[frameIndex], 0, RegionCount * 2, sizeof(results), results.data(), sizeof(uint64_t) * 2,
+				vk::QueryResultFlagBits::e64 | vk::QueryResultFlagBits::eWithAvailability
 		);
-		if (res != vk::Result::eSuccess)
+		if (res != vk::Result::eSuccess && res != vk::Result::eNotReady)
+			return;
+		
+		for (size_t i = 0; i < RegionCount; i++)
+		{
+			Region& region = regions[i];
+			const uint64_t* query = &results[i * 4];
+			region.start = query[0];
+			region.end = query[2];
+			region.valid = query[1] && query[3] && region.end >= region.start;
+			if (region.valid)
+			{
+				region.history[region.samples % HISTORY] = time(static_cast<GPURegion>(i));
+				region.samples++;
+			}
+		}
+	}
+	
+	float GPUTimer::time(GPURegion region) const
+	{
+		const Region& r = regions[region];
+		if (!r.valid)
+			return 0.0f;
+		return static_cast<float>(r.end - r.start) * timestampPeriod * 1e-6f;
+	}
+	
+	float GPUTimer::average(GPURegion region) const
+	{
+		const Region& r = regions[region];
+		const uint32_t count = std::min(r.samples, HISTORY);
+		if (!count)
+			return 0.0f;
+		
+		float sum = 0.0f;
+		for (uint32_t i = 0; i < count; i++)
+			sum += r.history[i];
+		return sum / static_cast<float>(count);
+	}
+	
+	float GPUTimer::overlap(GPURegion region, GPURegion other) const
+	{
+		const Region& a = regions[region];
+		const Region& b = regions[other];
+		if (!a.valid || !b.valid)
+			return 0.0f;
+		
+		const uint64_t start = std::max(a.start, b.start);
+		const uint64_t end = std::min(a.end, b.end);
+		if (end <= start)
 			return 0.0f;
-		return static_cast<float>(queryTimes[1] - queryTimes[0]) * timestampPeriod * 1e-6f;
+		return static_cast<float>(end - start) * timestampPeriod * 1e-6f;
+	}
+	
+	const char* GPUTimer::Name(GPURegion region)
+	{
+		return s_gpuRegions[region];
 	}
 	
-	void GPUTimer::destroy() const noexcept
+	void GPUTimer::destroy()
 	{
-		VulkanContext::Get()->device->destroyQueryPool(*queryPool);
+		for (auto& pool : pools)
+			VulkanContext::Get()->device->destroyQueryPool(pool);
+		pools.clear();
+		recorded.clear();
 	}
 }
@@ -25,6 +25,7 @@ SOFTWARE.
 #include <chrono>
 #include <vector>
 #include <memory>
+#include <array>
 
 #define Arithmetic_Template(T1, T2) \
 template < \
@@ -44,6 +45,21 @@ Arithmetic_Template(Return_T, Param_T) constexpr Return_T SECONDS_TO_NANOSECONDS
 
 namespace pe
 {
+	// the cpu stages of a frame, indices of FrameTimer::timestamps which hold their last duration in seconds
+	enum FrameStage : size_t
+	{
+		StageFenceWait = 0,
+		StageUpdates,
+		StageCulling,
+		StageMemcpy,
+		StageAcquire,
+		StageRecording,
+		StageSubmit,
+		// the sleep of the low latency mode before the input, on purpose and not a stall
+		StageLatencySleep,
+		StageCount
+	};
+	
 	class Timer
 	{
 	public:
@@ -62,14 +78,17 @@ namespace pe
 	public:
 		void Tick() noexcept;
 		
+		// sleeps most of the time and spins the rest on the high resolution clock, to not overshoot by a quantum
 		void Delay(double seconds = 0.0f);
 		
+		static const char* StageName(FrameStage stage);
+		
 		double delta;
 		double time;
 		std::vector<double> timestamps {};
 	private:
-		Timer timer;
-		size_t system_delay;
+		// the worst recent oversleep of the scheduler, the delay spins for this long before its end
+		double sleepOvershoot;
 		std::chrono::duration<double> m_duration {};
 	
 	public:
@@ -97,23 +116,71 @@ namespace vk
 }
 namespace pe
 {
+	// the timed gpu passes, indices of GUI::metrics which hold their last resolved duration in ms
+	enum GPURegion : uint32_t
+	{
+		RegionDeferred = 0,
+		RegionGBuffer = 2,
+		RegionSSAO,
+		RegionSSR,
+		RegionLights,
+		RegionAntiAliasing,
+		RegionBloom,
+		RegionDOF,
+		RegionMotionBlur,
+		RegionGUI,
+		RegionShadows, // one per cascade
+		RegionPostFused = 16,
+		RegionPostSeparate,
+		RegionCount = 20
+	};
+	
+	// every frame in flight writes its timestamps to its own query pool, which is read after the fence of
+	// that frame is waited, so the results are a frame or more late but reading them never stalls
 	class GPUTimer
 	{
 	public:
-		GPUTimer();
+		// frames kept for the rolling averages
+		static constexpr uint32_t HISTORY = 64;
+		
+		void init();
 		
-		void start(const vk::CommandBuffer* cmd) noexcept;
+		// resets the pool of the current frame, recorded in the first command buffer submitted in the frame
+		void reset(const vk::CommandBuffer& cmd);
 		
-		void end(float* res = nullptr);
+		void begin(const vk::CommandBuffer& cmd, GPURegion region) const;
 		
-		float getTime();
+		void end(const vk::CommandBuffer& cmd, GPURegion region) const;
 		
-		void destroy() const noexcept;
+		// reads the pool of the frame index, the fence of its last submit must be signaled
+		void resolve(uint32_t frameIndex);
+		
+		// ms of the region in the last resolved frame, 0 if it did not run
+		float time(GPURegion region) const;
+		
+		// ms of the region averaged over the last frames it ran
+		float average(GPURegion region) const;
+		
+		// ms that two regions of the last resolved frame ran at the same time, e.g. on different queues
+		float overlap(GPURegion region, GPURegion other) const;
+		
+		static const char* Name(GPURegion region);
+		
+		void destroy();
 	
 	private:
-		std::unique_ptr<vk::QueryPool> queryPool;
-		std::vector<uint64_t> queryTimes {};
-		float timestampPeriod;
-		const vk::CommandBuffer* _cmd;
+		struct Region
+		{
+			uint64_t start = 0;
+			uint64_t end = 0;
+			bool valid = false;
+			std::array<float, HISTORY> history {};
+			uint32_t samples = 0;
+		};
+		
+		std::vector<vk::QueryPool> pools {};
+		std::vector<bool> recorded {};
+		std::array<Region, RegionCount> regions {};
+		float timestampPeriod = 1.f;
 	};
 }
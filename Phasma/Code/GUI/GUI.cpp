@@ -23,6 +23,8 @@ SOFTWARE.
 #include "PhasmaPch.h"
 #include "GUI.h"
 #include <filesystem>
+#include <algorithm>
+#include <string_view>
 #include "../Include/TinyFileDialogs/tinyfiledialogs.h"
 #include "../Core/Queue.h"
 #include "../Console/Console.h"
@@ -30,8 +32,14 @@ SOFTWARE.
 #include "../Renderer/Swapchain.h"
 #include "../Renderer/Surface.h"
 #include "../Shader/Shader.h"
+#include "../PostProcess/SSAO.h"
 #include "../Renderer/RenderApi.h"
+#include "../Renderer/UploadManager.h"
+#include "../Renderer/DynamicResolution.h"
 #include "../Core/Path.h"
+#include "../Core/Profiler.h"
+#include "../Core/FrameHistory.h"
+#include "../Renderer/MemoryStats.h"
 #include "../Event/EventSystem.h"
 
 namespace pe
@@ -203,7 +211,7 @@ namespace pe
 					const std::string path(result);
 					std::string folderPath = path.substr(0, path.find_last_of('\\') + 1);
 					std::string modelName = path.substr(path.find_last_of('\\') + 1);
-					Queue::loadModel.emplace_back(folderPath, modelName);
+					Queue::requestLoadModel(folderPath, modelName);
 				}
 				
 				const int exit = async_messageBox_ImGuiMenuItem("Exit", "Exit", "Are you sure you want to exit?");
@@ -233,6 +241,9 @@ namespace pe
 		ImGui::Text("Average %.3f ms (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
 		ImGui::InputFloat("FPS", &fps, 1.0f, 15.0f, 1);
 		fps = maximum(fps, 10.0f);
+		ImGui::Checkbox("Low Latency", &low_latency);
+		if (ImGui::IsItemHovered())
+			ImGui::SetTooltip("Samples the input just before the gpu can take the next frame");
 		ImGui::Separator();
 		ImGui::Separator();
 		
@@ -243,8 +254,16 @@ namespace pe
 		ImGui::Separator();
 		ImGui::Text(
 				"GPU Total: %.3f ms",
-				stats[0] + (shadow_cast ? stats[11] + stats[12] + stats[13] : 0.f) + (use_compute ? stats[14] : 0.f)
+				stats[0] + stats[2] + (shadow_cast ? stats[11] + stats[12] + stats[13] : 0.f) +
+				(use_compute ? stats[14] : 0.f)
 		);
+		if (dynamic_resolution)
+		{
+			const vk::Extent2D extent = DynamicResolution::Extent();
+			ImGui::Text(
+					"Render Scale: %.0f%% (%u x %u)", DynamicResolution::Scale() * 100.f, extent.width, extent.height
+			);
+		}
 		ImGui::Separator();
 		ImGui::Text("Render Passes:");
 		//if (use_compute) {
@@ -265,11 +284,20 @@ namespace pe
 			totalTime += stats[13];
 		}
 		ImGui::Text("GBuffer: %.3f ms", stats[2]);
+		ImGui::Indent(16.0f);
+		ImGui::Text("Draws: %u, Binds: %u, Saved: %u", drawCalls, bindsIssued, bindsSaved);
+		ImGui::Unindent(16.0f);
 		totalPasses++;
 		totalTime += stats[2];
 		if (show_ssao)
 		{
 			ImGui::Text("SSAO: %.3f ms", stats[3]);
+			if (ssao_async_compute && SSAO::ComputeSupported())
+			{
+				ImGui::Indent(16.0f);
+				ImGui::Text("Async compute, overlapped: %.3f ms", stats[15]);
+				ImGui::Unindent(16.0f);
+			}
 			totalPasses++;
 			totalTime += stats[3];
 		}
@@ -294,7 +322,8 @@ namespace pe
 			totalPasses++;
 			totalTime += stats[7];
 		}
-		if (use_DOF)
+		const bool fusedDOF = use_DOF && show_motionBlur && fuse_DOF_motionBlur;
+		if (use_DOF && !fusedDOF)
 		{
 			ImGui::Text("Depth of Field: %.3f ms", stats[8]);
 			totalPasses++;
@@ -302,10 +331,17 @@ namespace pe
 		}
 		if (show_motionBlur)
 		{
-			ImGui::Text("Motion Blur: %.3f ms", stats[9]);
+			ImGui::Text(fusedDOF ? "Depth of Field + Motion Blur: %.3f ms" : "Motion Blur: %.3f ms", stats[9]);
 			totalPasses++;
 			totalTime += stats[9];
 		}
+		ImGui::Text("Post Process: %.3f ms", stats[fusedDOF ? 16 : 17]);
+		if (use_DOF && show_motionBlur)
+		{
+			ImGui::Indent(16.0f);
+			ImGui::Text("Fused: %.3f ms, Separate: %.3f ms", stats[16], stats[17]);
+			ImGui::Unindent(16.0f);
+		}
 		
 		ImGui::Text("GUI: %.3f ms", stats[10]);
 		totalPasses++;
@@ -314,12 +350,159 @@ namespace pe
 		ImGui::Separator();
 		ImGui::Separator();
 		ImGui::Text("Total: %i (%.3f ms)", totalPasses, totalTime);
+		ImGui::Separator();
+		FrameTimes();
+		Memory();
+		FlameGraph();
 		
 		tlPanelPos = ImGui::GetWindowPos();
 		tlPanelSize = ImGui::GetWindowSize();
 		ImGui::End();
 	}
 	
+	void GUI::FrameTimes() const
+	{
+		if (!ImGui::CollapsingHeader("Frame Times"))
+			return;
+		
+		const TimingStatistics statistics = FrameHistory::Statistics();
+		ImGui::Text("Min: %.2f, Avg: %.2f, Max: %.2f ms", statistics.min, statistics.mean, statistics.max);
+		ImGui::Text("P95: %.2f, P99: %.2f ms", statistics.p95, statistics.p99);
+		
+		const std::vector<float> times = FrameHistory::Times();
+		ImGui::PlotLines(
+				"##FrameTimes", times.data(), static_cast<int>(times.size()), 0, nullptr, 0.f,
+				static_cast<float>(statistics.max) * 1.1f, ImVec2(ImGui::GetContentRegionAvail().x, 60.f)
+		);
+		
+		float threshold = static_cast<float>(FrameHistory::hitchThreshold);
+		if (ImGui::SliderFloat("Hitch x Median", &threshold, 1.5f, 10.f, "%.1f"))
+			FrameHistory::hitchThreshold = static_cast<double>(threshold);
+		
+		// the latest first
+		const auto& hitches = FrameHistory::hitches;
+		ImGui::Text("Hitches: %u", static_cast<uint32_t>(hitches.size()));
+		ImGui::Indent(16.0f);
+		for (auto it = hitches.rbegin(); it != hitches.rend() && it - hitches.rbegin() < 8; ++it)
+		{
+			ImGui::Text(
+					"Frame %llu: %.2f ms (x%.1f) %s", static_cast<unsigned long long>(it->frame), it->ms,
+					it->ms / it->median, it->subsystem
+			);
+		}
+		ImGui::Unindent(16.0f);
+	}
+	
+	void GUI::Memory() const
+	{
+		if (!ImGui::CollapsingHeader("Memory"))
+			return;
+		
+		constexpr float MB = 1024.f * 1024.f;
+		
+		ImGui::Text("Device:");
+		ImGui::Indent(16.0f);
+		for (size_t i = 0; i < static_cast<size_t>(MemoryCategory::Count); i++)
+		{
+			const auto category = static_cast<MemoryCategory>(i);
+			ImGui::Text(
+					"%s: %.1f MB (%u)", MemoryStats::Name(category),
+					static_cast<float>(MemoryStats::Bytes(category)) / MB, MemoryStats::Allocations(category)
+			);
+		}
+		ImGui::Unindent(16.0f);
+		
+		const std::vector<HeapBudget> heaps = MemoryStats::Budgets();
+		for (size_t i = 0; i < heaps.size(); i++)
+		{
+			const HeapBudget& heap = heaps[i];
+			if (!heap.budget)
+				continue;
+			
+			char overlay[64];
+			snprintf(
+					overlay, sizeof(overlay), "%.0f / %.0f MB", static_cast<float>(heap.usage) / MB,
+					static_cast<float>(heap.budget) / MB
+			);
+			ImGui::Text("Heap %u%s:", static_cast<uint32_t>(i), heap.deviceLocal ? " (device)" : "");
+			ImGui::ProgressBar(static_cast<float>(heap.usage) / static_cast<float>(heap.budget), ImVec2(-1.f, 0.f),
+			                   overlay);
+		}
+		
+		ImGui::Text("Descriptor Sets: %u / %u", MemoryStats::DescriptorSets(), MemoryStats::descriptorPoolSize);
+		ImGui::Text("Host Geometry: %.1f MB", static_cast<float>(MemoryStats::HostGeometryBytes()) / MB);
+		if (PE_NULL)
+			ImGui::Text("Host Textures: %.1f MB", static_cast<float>(MemoryStats::HostTextureBytes()) / MB);
+	}
+	
+	void GUI::FlameGraph() const
+	{
+		if (!ImGui::CollapsingHeader("CPU Profiler"))
+			return;
+#ifdef PE_NO_PROFILE
+		ImGui::Text("Compiled out (PHASMA_PROFILE=OFF)");
+#else
+		static int captureFrames = 120;
+		if (Profiler::Capturing())
+		{
+			ImGui::Text("Capturing...");
+		}
+		else
+		{
+			ImGui::InputInt("Frames", &captureFrames);
+			captureFrames = std::clamp(captureFrames, 1, 10000);
+			if (ImGui::Button("Capture to profile.json"))
+				Profiler::Capture(static_cast<uint32_t>(captureFrames), "profile.json");
+		}
+		
+		const ProfileFrame& frame = Profiler::LastFrame();
+		const double duration = static_cast<double>(std::max<uint64_t>(frame.end - frame.start, 1));
+		ImGui::Text("Frame: %.3f ms", duration / 1e6);
+		
+		ImDrawList* drawList = ImGui::GetWindowDrawList();
+		const float width = ImGui::GetContentRegionAvail().x;
+		const float rowHeight = ImGui::GetTextLineHeight() + 2.f;
+		for (size_t i = 0; i < frame.lanes.size(); i++)
+		{
+			if (frame.lanes[i].empty())
+				continue;
+			
+			ImGui::Text("%s", frame.names[i].c_str());
+			const ImVec2 origin = ImGui::GetCursorScreenPos();
+			uint32_t rows = 0;
+			for (auto& event : frame.lanes[i])
+			{
+				if (event.counter)
+					continue;
+				
+				// zones that started in an earlier frame, e.g. the loading, are clipped to this one
+				const double start = static_cast<double>(std::max(event.start, frame.start) - frame.start);
+				const double end = static_cast<double>(std::min(event.end, frame.end) - frame.start);
+				const ImVec2 min(origin.x + static_cast<float>(start / duration) * width,
+				                 origin.y + static_cast<float>(event.depth) * rowHeight);
+				const ImVec2 max(std::max(origin.x + static_cast<float>(end / duration) * width, min.x + 1.f),
+				                 min.y + rowHeight - 1.f);
+				rows = std::max(rows, event.depth + 1);
+				
+				// a zone keeps its color between frames
+				const float hue = static_cast<float>(std::hash<std::string_view>()(event.name) % 360) / 360.f;
+				drawList->AddRectFilled(min, max, ImColor::HSV(hue, 0.5f, 0.7f));
+				if (ImGui::CalcTextSize(event.name).x < max.x - min.x)
+					drawList->AddText(min, IM_COL32_WHITE, event.name);
+				if (ImGui::IsMouseHoveringRect(min, max))
+					ImGui::SetTooltip("%s: %.3f ms", event.name, static_cast<double>(event.end - event.start) / 1e6);
+			}
+			ImGui::Dummy(ImVec2(width, static_cast<float>(rows) * rowHeight));
+			
+			for (auto& event : frame.lanes[i])
+			{
+				if (event.counter)
+					ImGui::Text("%s: %.0f", event.name, event.value);
+			}
+		}
+#endif
+	}
+	
 	void GUI::ConsoleWindow()
 	{
 		static bool console_open = true;
@@ -412,7 +595,7 @@ namespace pe
 			const std::string path(result);
 			std::string folderPath = path.substr(0, path.find_last_of('\\') + 1);
 			std::string modelName = path.substr(path.find_last_of('\\') + 1);
-			Queue::loadModel.emplace_back(folderPath, modelName);
+			Queue::requestLoadModel(folderPath, modelName);
 		}
 		
 		for (uint32_t i = 0; i < modelList.size(); i++)
@@ -469,6 +652,12 @@ namespace pe
 		ImGui::Checkbox("IBL", &use_IBL);
 		ImGui::Checkbox("SSR", &show_ssr);
 		ImGui::Checkbox("SSAO", &show_ssao);
+		if (show_ssao && SSAO::ComputeSupported())
+		{
+			ImGui::Indent(16.0f);
+			ImGui::Checkbox("Async Compute##SSAO", &ssao_async_compute);
+			ImGui::Unindent(16.0f);
+		}
 		ImGui::Checkbox("Depth of Field", &use_DOF);
 		if (use_DOF)
 		{
@@ -484,6 +673,18 @@ namespace pe
 		{
 			ImGui::Indent(16.0f);
 			ImGui::InputFloat("Strength#mb", &motionBlur_strength, 0.05f, 0.2f);
+			if (use_DOF)
+				ImGui::Checkbox("Fuse with Depth of Field#mb", &fuse_DOF_motionBlur);
+			ImGui::Unindent(16.0f);
+			ImGui::Separator();
+			ImGui::Separator();
+		}
+		ImGui::Checkbox("Dynamic Resolution", &dynamic_resolution);
+		if (dynamic_resolution)
+		{
+			ImGui::Indent(16.0f);
+			ImGui::InputFloat("GPU Budget (ms)#dr", &dynamic_resolution_budget, 0.5f, 2.0f);
+			ImGui::InputFloat("Min Scale#dr", &dynamic_resolution_min, 0.05f, 0.1f);
 			ImGui::Unindent(16.0f);
 			ImGui::Separator();
 			ImGui::Separator();
@@ -592,6 +793,10 @@ namespace pe
 			randomize_lights = true;
 		ImGui::SliderFloat("Light Intst", &lights_intensity, 0.01f, 30.f);
 		ImGui::SliderFloat("Light Rng", &lights_range, 0.1f, 30.f);
+		if (ImGui::SliderInt("Point Lights", &point_lights_count, 0, 8192))
+			randomize_lights = true;
+		if (ImGui::SliderInt("Spot Lights", &spot_lights_count, 0, 8192))
+			randomize_lights = true;
 		
 		// Model properties
 		ImGui::Separator();
@@ -607,7 +812,7 @@ namespace pe
 			
 			ImGui::Separator();
 			if (ImGui::Button("Unload Model"))
-				Queue::unloadModel.push_back(modelItemSelected);
+				Queue::requestUnloadModel(modelItemSelected);
 			
 			ImGui::Separator();
 			const std::string s = "Scale##" + toStr;
@@ -783,10 +988,6 @@ namespace pe
 #endif
 		windowStyle();
 		
-		vk::CommandBufferBeginInfo beginInfo;
-		beginInfo.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit;
-		(*vulkan->dynamicCmdBuffers)[0].begin(beginInfo);
-		
 		// Create fonts texture
 		unsigned char* pixels;
 		int width, height;
@@ -814,79 +1015,13 @@ namespace pe
 			texture.maxLod = 1000.f;
 			texture.createSampler();
 		}
-		// Create the and Upload to Buffer:
-		Buffer stagingBuffer;
-		{
-			stagingBuffer.CreateBuffer(
-					upload_size, BufferUsage::TransferSrc, MemoryProperty::HostVisible
-			);
-			stagingBuffer.Map();
-			stagingBuffer.CopyData(pixels);
-			stagingBuffer.Flush();
-			stagingBuffer.Unmap();
-		}
-		
-		// Copy to Image:
-		{
-			vk::ImageMemoryBarrier copy_barrier = {};
-			copy_barrier.dstAccessMask = vk::AccessFlagBits::eTransferWrite;
-			copy_barrier.oldLayout = vk::ImageLayout::eUndefined;
-			copy_barrier.newLayout = vk::ImageLayout::eTransferDstOptimal;
-			copy_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-			copy_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-			copy_barrier.image = *texture.image;
-			copy_barrier.subresourceRange.aspectMask = vk::ImageAspectFlagBits::eColor;
-			copy_barrier.subresourceRange.levelCount = 1;
-			copy_barrier.subresourceRange.layerCount = 1;
-			(*vulkan->dynamicCmdBuffers)[0].pipelineBarrier(
-					vk::PipelineStageFlagBits::eHost,
-					vk::PipelineStageFlagBits::eTransfer,
-					vk::DependencyFlagBits::eByRegion,
-					nullptr,
-					nullptr,
-					copy_barrier
-			);
-			
-			vk::BufferImageCopy region = {};
-			region.imageSubresource.aspectMask = vk::ImageAspectFlagBits::eColor;
-			region.imageSubresource.layerCount = 1;
-			region.imageExtent.width = width;
-			region.imageExtent.height = height;
-			region.imageExtent.depth = 1;
-			(*vulkan->dynamicCmdBuffers)[0].copyBufferToImage(
-					*stagingBuffer.GetBufferVK(), *texture.image, vk::ImageLayout::eTransferDstOptimal, region
-			);
-			
-			vk::ImageMemoryBarrier use_barrier = {};
-			use_barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
-			use_barrier.dstAccessMask = vk::AccessFlagBits::eShaderRead;
-			use_barrier.oldLayout = vk::ImageLayout::eTransferDstOptimal;
-			use_barrier.newLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
-			use_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-			use_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-			use_barrier.image = *texture.image;
-			use_barrier.subresourceRange.aspectMask = vk::ImageAspectFlagBits::eColor;
-			use_barrier.subresourceRange.levelCount = 1;
-			use_barrier.subresourceRange.layerCount = 1;
-			(*vulkan->dynamicCmdBuffers)[0].pipelineBarrier(
-					vk::PipelineStageFlagBits::eTransfer,
-					vk::PipelineStageFlagBits::eFragmentShader,
-					vk::DependencyFlagBits::eByRegion,
-					nullptr,
-					nullptr,
-					use_barrier
-			);
-		}
+		// Upload to Image:
+		UploadManager::uploadImage(texture, pixels, upload_size);
+		UploadManager::flush();
 		
 		// Store our identifier
 		io.Fonts->TexID = reinterpret_cast<ImTextureID>(reinterpret_cast<intptr_t>(static_cast<VkImage>(*texture
 				.image)));
-		
-		(*vulkan->dynamicCmdBuffers)[0].end();
-		
-		vulkan->submitAndWaitFence((*vulkan->dynamicCmdBuffers)[0], nullptr, nullptr, nullptr);
-		
-		stagingBuffer.Destroy();
 	}
 	
 	void GUI::loadGUI(bool show)
@@ -1002,11 +1137,12 @@ namespace pe
 			
 			cmd.beginRenderPass(rpi, vk::SubpassContents::eInline);
 			
-			const vk::DeviceSize offset {0};
+			// the vertices of this frame are in its own slice
+			const vk::DeviceSize offset {vertexBuffer.FrameOffset()};
 			cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, *pipeline.handle);
 			cmd.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, *pipeline.layout, 0, *descriptorSet, nullptr);
 			cmd.bindVertexBuffers(0, *vertexBuffer.GetBufferVK(), offset);
-			cmd.bindIndexBuffer(*indexBuffer.GetBufferVK(), 0, vk::IndexType::eUint32);
+			cmd.bindIndexBuffer(*indexBuffer.GetBufferVK(), indexBuffer.FrameOffset(), vk::IndexType::eUint32);
 			
 			vk::Viewport viewport;
 			viewport.x = 0.f;
@@ -1154,9 +1290,9 @@ namespace pe
 			return;
 		const size_t vertex_size = draw_data->TotalVtxCount * sizeof(ImDrawVert);
 		const size_t index_size = draw_data->TotalIdxCount * sizeof(ImDrawIdx);
-		if (!*vertexBuffer.GetBufferVK() || vertexBuffer.Size() < vertex_size)
+		if (!*vertexBuffer.GetBufferVK() || vertexBuffer.FrameSize() < vertex_size)
 			createVertexBuffer(vertex_size);
-		if (!*indexBuffer.GetBufferVK() || indexBuffer.Size() < index_size)
+		if (!*indexBuffer.GetBufferVK() || indexBuffer.FrameSize() < index_size)
 			createIndexBuffer(index_size);
 		
 		// Upload Vertex and index Data:
@@ -1258,7 +1394,7 @@ namespace pe
 		VulkanContext::Get()->graphicsQueue->waitIdle();
 		vertexBuffer.Destroy();
 		//vertexBuffer.createBuffer(vertex_size, vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eVertexBuffer, vk::MemoryPropertyFlagBits::eDeviceLocal);
-		vertexBuffer.CreateBuffer(
+		vertexBuffer.CreateBufferPerFrame(
 				vertex_size, BufferUsage::VertexBuffer,
 				MemoryProperty::HostCached | MemoryProperty::HostVisible
 		);
@@ -1269,7 +1405,7 @@ namespace pe
 		VulkanContext::Get()->graphicsQueue->waitIdle();
 		indexBuffer.Destroy();
 		//indexBuffer.createBuffer(index_size, vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eIndexBuffer, vk::MemoryPropertyFlagBits::eDeviceLocal);
-		indexBuffer.CreateBuffer(
+		indexBuffer.CreateBufferPerFrame(
 				index_size, BufferUsage::IndexBuffer,
 				MemoryProperty::HostCached | MemoryProperty::HostVisible
 		);
@@ -1281,7 +1417,7 @@ namespace pe
 		allocateInfo.descriptorPool = *VulkanContext::Get()->descriptorPool;
 		allocateInfo.descriptorSetCount = 1;
 		allocateInfo.pSetLayouts = &descriptorSetLayout;
-		descriptorSet = make_ref(VulkanContext::Get()->device->allocateDescriptorSets(allocateInfo).at(0));
+		descriptorSet = make_ref(VulkanContext::Get()->allocateDescriptorSet(allocateInfo));
 		
 		updateDescriptorSets();
 		
@@ -1360,17 +1496,12 @@ namespace pe
 		pipeline.info.pFragShader = &frag;
 		pipeline.info.vertexInputBindingDescriptions = make_ref(Vertex::getBindingDescriptionGUI());
 		pipeline.info.vertexInputAttributeDescriptions = make_ref(Vertex::getAttributeDescriptionGUI());
-		pipeline.info.width = WIDTH_f;
-		pipeline.info.height = HEIGHT_f;
 		pipeline.info.cullMode = CullMode::Back;
 		pipeline.info.colorBlendAttachments = make_ref(
 				std::vector<vk::PipelineColorBlendAttachmentState> {
 						*VulkanContext::Get()->swapchain.images[0].blentAttachment
 				}
 		);
-		pipeline.info.dynamicStates = make_ref(
-				std::vector<vk::DynamicState> {vk::DynamicState::eViewport, vk::DynamicState::eScissor}
-		);
 		pipeline.info.pushConstantStage = PushConstantStage::Vertex;
 		pipeline.info.pushConstantSize = sizeof(float) * 4;
 		pipeline.info.descriptorSetLayouts = make_ref(
@@ -1399,6 +1530,8 @@ namespace pe
 	
 	void GUI::update()
 	{
+		PE_PROFILE_SCOPE("GUI::update");
+		
 		if (render)
 			newFrame();
 	}
@@ -71,6 +71,7 @@ namespace pe
         static inline int volumetric_dither_strength = 400;
         static inline bool show_ssr = false;
         static inline bool show_ssao = false;
+        static inline bool ssao_async_compute = true;
         static inline bool show_tonemapping = false;
         static inline float exposure = 4.5f;
         static inline bool use_AntiAliasing = false;
@@ -94,9 +95,15 @@ namespace pe
         static inline float Bloom_exposure = 3.5f;
         static inline bool show_motionBlur = false;
         static inline float motionBlur_strength = 1.0f;
+        static inline bool fuse_DOF_motionBlur = true;
+        static inline bool dynamic_resolution = false;
+        static inline float dynamic_resolution_budget = 16.6f;
+        static inline float dynamic_resolution_min = 0.5f;
         static inline bool randomize_lights = false;
         static inline float lights_intensity = 10.0f;
         static inline float lights_range = 10.0f;
+        static inline int point_lights_count = 10;
+        static inline int spot_lights_count = 0;
         static inline bool use_fog = false;
         static inline float fog_ground_thickness = 30.0f;
         static inline float fog_global_thickness = 0.3f;
@@ -105,6 +112,7 @@ namespace pe
         static inline float sun_intensity = 7.f;
         static inline std::array<float, 3> sun_position {160.0f, 300.0f, -120.0f};
         static inline float fps = 60.0f;
+        static inline bool low_latency = false;
         static inline float cameraSpeed = 3.5f;
         static inline std::array<float, 3> depthBias {0.0f, 0.0f, -6.2f};
         static inline std::array<float, 4> clearColor {0.0f, 0.0f, 0.0f, 1.0f};
@@ -114,7 +122,11 @@ namespace pe
         static inline float cpuWaitingTime = 0;
         static inline float timeScale = 1.f;
         static inline std::array<float, 20> metrics = {};
+        static inline std::array<float, 20> metricsAverage = {};
         static inline std::array<float, 20> stats = {};
+        static inline uint32_t drawCalls = 0;
+        static inline uint32_t bindsIssued = 0;
+        static inline uint32_t bindsSaved = 0;
         static inline std::vector<std::string> fileList {};
         static inline std::vector<std::string> shaderList {};
         static inline std::vector<std::string> modelList {};
@@ -172,6 +184,15 @@ namespace pe
         
         void Metrics() const;
         
+        // the frame time graph, its statistics and the last hitches
+        void FrameTimes() const;
+        
+        // the device memory per category, the heap budgets and the host copies
+        void Memory() const;
+        
+        // the zones of the last frame per thread, from the cpu profiler
+        void FlameGraph() const;
+        
         static void ConsoleWindow();
         
         static const char* async_fileDialog_ImGuiButton(
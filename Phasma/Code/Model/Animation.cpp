@@ -0,0 +1,287 @@
+/*
+Copyright (c) 2018-2021 Christos Karamoustos
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#include "PhasmaPch.h"
+#include "Animation.h"
+#include "../Core/Timer.h"
+#include <algorithm>
+
+namespace pe
+{
+	void AnimationSampler::setOutputs(const std::vector<vec4>& values, uint32_t componentsCount)
+	{
+		components = componentsCount;
+		
+		float minValue[4] {FLT_MAX, FLT_MAX, FLT_MAX, FLT_MAX};
+		float maxValue[4] {-FLT_MAX, -FLT_MAX, -FLT_MAX, -FLT_MAX};
+		for (auto& value : values)
+		{
+			const float* v = &value.x;
+			for (uint32_t c = 0; c < components; c++)
+			{
+				minValue[c] = std::min(minValue[c], v[c]);
+				maxValue[c] = std::max(maxValue[c], v[c]);
+			}
+		}
+		
+		rangeMin = vec4(0.f);
+		rangeExtent = vec4(0.f);
+		for (uint32_t c = 0; c < components && !values.empty(); c++)
+		{
+			rangeMin[c] = minValue[c];
+			rangeExtent[c] = maxValue[c] - minValue[c];
+		}
+		
+		outputs.resize(values.size() * components);
+		for (size_t i = 0; i < values.size(); i++)
+		{
+			const float* v = &values[i].x;
+			for (uint32_t c = 0; c < components; c++)
+			{
+				const float normalized = rangeExtent[c] > 0.f ? (v[c] - rangeMin[c]) / rangeExtent[c] : 0.f;
+				outputs[i * components + c] = static_cast<uint16_t>(clamp(normalized, 0.f, 1.f) * 65535.f + 0.5f);
+			}
+		}
+	}
+	
+	vec4 AnimationSampler::output(size_t index) const
+	{
+		const float* minValue = &rangeMin.x;
+		const float* extent = &rangeExtent.x;
+		const uint16_t* quantized = &outputs[index * components];
+		
+		vec4 value(0.f);
+		for (uint32_t c = 0; c < components; c++)
+			value[c] = minValue[c] + static_cast<float>(quantized[c]) / 65535.f * extent[c];
+		return value;
+	}
+	
+	vec4 AnimationSampler::sample(float time, uint32_t& cursor, bool rotation) const
+	{
+		const size_t count = inputs.size();
+		const size_t stride = interpolation == CUBICSPLINE ? 3 : 1;
+		const size_t valueOffset = interpolation == CUBICSPLINE ? 1 : 0;
+		if (count == 0 || outputs.size() < count * stride * components)
+			return vec4(0.f);
+		
+		if (count == 1 || time <= inputs[0])
+		{
+			cursor = 0;
+			return output(valueOffset);
+		}
+		if (time >= inputs[count - 1])
+		{
+			cursor = static_cast<uint32_t>(count - 1);
+			return output((count - 1) * stride + valueOffset);
+		}
+		
+		// the time moved back, when the clip looped, find the key again
+		if (cursor >= count - 1 || time < inputs[cursor])
+		{
+			const auto it = std::upper_bound(inputs.begin(), inputs.end(), time);
+			cursor = static_cast<uint32_t>(std::distance(inputs.begin(), it) - 1);
+		}
+		while (time >= inputs[cursor + 1])
+			cursor++;
+		
+		const size_t i = cursor;
+		const float dt = inputs[i + 1] - inputs[i];
+		const float u = dt > 0.f ? (time - inputs[i]) / dt : 0.f;
+		
+		switch (interpolation)
+		{
+			case STEP:
+				return output(i);
+			case CUBICSPLINE:
+			{
+				const float u2 = u * u;
+				const float u3 = u2 * u;
+				const vec4 p0 = output(i * 3 + 1);
+				const vec4 m0 = output(i * 3 + 2) * dt;
+				const vec4 p1 = output((i + 1) * 3 + 1);
+				const vec4 m1 = output((i + 1) * 3) * dt;
+				vec4 value = p0 * (2.f * u3 - 3.f * u2 + 1.f) + m0 * (u3 - 2.f * u2 + u) +
+				             p1 * (-2.f * u3 + 3.f * u2) + m1 * (u3 - u2);
+				if (rotation)
+					value = normalize(value);
+				return value;
+			}
+			case LINEAR:
+			default:
+			{
+				const vec4 v0 = output(i);
+				const vec4 v1 = output(i + 1);
+				if (!rotation)
+					return mix(v0, v1, u);
+				
+				const quat q = normalize(slerp(quat(&v0.x), quat(&v1.x), u));
+				return vec4(q.x, q.y, q.z, q.w);
+			}
+		}
+	}
+	
+	void AnimationPose::reset(size_t nodesCount)
+	{
+		translations.assign(nodesCount, vec3(0.f));
+		rotations.assign(nodesCount, quat(0.f, 0.f, 0.f, 0.f));
+		scales.assign(nodesCount, vec3(0.f));
+		weights.assign(nodesCount, vec3(0.f));
+	}
+	
+	void Animator::play(const std::vector<Animation>& animations, uint32_t animation, float weight, float speed)
+	{
+		if (animation >= animations.size())
+			return;
+		
+		AnimationLayer layer;
+		layer.animation = animation;
+		layer.time = animations[animation].start;
+		layer.weight = weight;
+		layer.speed = speed;
+		layer.cursors.assign(animations[animation].channels.size(), 0);
+		layers.push_back(layer);
+	}
+	
+	void Animator::stop()
+	{
+		layers.clear();
+	}
+	
+	void Animator::advance(const std::vector<Animation>& animations, float delta)
+	{
+		for (auto& layer : layers)
+		{
+			const Animation& animation = animations[layer.animation];
+			const float length = animation.end - animation.start;
+			
+			layer.time += delta * layer.speed;
+			if (length <= 0.f)
+				layer.time = animation.start;
+			else if (layer.time > animation.end || layer.time < animation.start)
+				layer.time = animation.start + std::fmod(std::fmod(layer.time - animation.start, length) + length, length);
+		}
+	}
+	
+	void Animator::evaluate(const std::vector<Animation>& animations, AnimationPose& pose)
+	{
+		for (auto& layer : layers)
+		{
+			if (layer.weight <= 0.f)
+				continue;
+			
+			const Animation& animation = animations[layer.animation];
+			for (size_t i = 0; i < animation.channels.size(); i++)
+			{
+				const AnimationChannel& channel = animation.channels[i];
+				const AnimationSampler& sampler = animation.samplers[channel.samplerIndex];
+				const uint32_t target = channel.target;
+				if (target >= pose.weights.size())
+					continue;
+				
+				const bool rotation = channel.path == AnimationChannel::PathType::ROTATION;
+				const vec4 value = sampler.sample(layer.time, layer.cursors[i], rotation);
+				
+				switch (channel.path)
+				{
+					case AnimationChannel::PathType::TRANSLATION:
+						pose.translations[target] += vec3(value) * layer.weight;
+						pose.weights[target].x += layer.weight;
+						break;
+					case AnimationChannel::PathType::ROTATION:
+					{
+						// keep the rotations in the same hemisphere so they do not cancel out
+						quat q(&value.x);
+						if (dot(pose.rotations[target], q) < 0.f)
+							q = -q;
+						pose.rotations[target] = pose.rotations[target] + q * layer.weight;
+						pose.weights[target].y += layer.weight;
+						break;
+					}
+					case AnimationChannel::PathType::SCALE:
+						pose.scales[target] += vec3(value) * layer.weight;
+						pose.weights[target].z += layer.weight;
+						break;
+				}
+			}
+		}
+	}
+	
+	void Animator::apply(const AnimationPose& pose, const std::vector<Node*>& nodes)
+	{
+		const size_t count = std::min(nodes.size(), pose.weights.size());
+		for (size_t i = 0; i < count; i++)
+		{
+			cvec3& weights = pose.weights[i];
+			if (weights.x > 0.f)
+				nodes[i]->translation = pose.translations[i] / weights.x;
+			if (weights.y > 0.f)
+				nodes[i]->rotation = normalize(pose.rotations[i]);
+			if (weights.z > 0.f)
+				nodes[i]->scale = pose.scales[i] / weights.z;
+		}
+	}
+	
+	void Animator::update(const std::vector<Animation>& animations, const std::vector<Node*>& nodes, float delta)
+	{
+		if (layers.empty())
+			return;
+		
+		advance(animations, delta);
+		m_pose.reset(nodes.size());
+		evaluate(animations, m_pose);
+		apply(m_pose, nodes);
+	}
+	
+	double Animator::Benchmark(
+			const std::vector<Animation>& animations, size_t nodesCount, uint32_t instances, uint32_t frames
+	)
+	{
+		if (animations.empty() || instances == 0 || frames == 0)
+			return 0.0;
+		
+		// every instance starts at a different time, so the cursors do not move together
+		std::vector<Animator> animators(instances);
+		for (uint32_t i = 0; i < instances; i++)
+		{
+			const uint32_t first = i % static_cast<uint32_t>(animations.size());
+			animators[i].play(animations, first, 1.f);
+			if (animations.size() > 1)
+				animators[i].play(animations, (first + 1) % static_cast<uint32_t>(animations.size()), 0.5f);
+			animators[i].advance(animations, static_cast<float>(i) * 0.137f);
+		}
+		
+		AnimationPose pose;
+		Timer timer;
+		timer.Start();
+		for (uint32_t frame = 0; frame < frames; frame++)
+		{
+			for (auto& animator : animators)
+			{
+				animator.advance(animations, 1.f / 60.f);
+				pose.reset(nodesCount);
+				animator.evaluate(animations, pose);
+			}
+		}
+		return timer.Count() * 1000.0 / static_cast<double>(frames);
+	}
+}
@@ -41,9 +41,12 @@ namespace pe
 		};
 		PathType path;
 		Node* node;
+		uint32_t target; // index of the node in Model::linearNodes
 		int32_t samplerIndex;
 	};
 	
+	// The outputs are quantized to 16 bits per component in the range of the sampler,
+	// cubic splines store 3 outputs per key, the in tangent, the value and the out tangent
 	struct AnimationSampler
 	{
 		enum InterpolationType
@@ -52,7 +55,17 @@ namespace pe
 		};
 		InterpolationType interpolation;
 		std::vector<float> inputs;
-		std::vector<vec4> outputsVec4;
+		std::vector<uint16_t> outputs;
+		uint32_t components = 4;
+		vec4 rangeMin;
+		vec4 rangeExtent;
+		
+		void setOutputs(const std::vector<vec4>& values, uint32_t componentsCount);
+		
+		vec4 output(size_t index) const;
+		
+		// the cursor is the key sampled last time, playback moves forward so it is found in O(1) amortized
+		vec4 sample(float time, uint32_t& cursor, bool rotation) const;
 	};
 	
 	struct Animation
@@ -63,4 +76,54 @@ namespace pe
 		float start = std::numeric_limits<float>::max();
 		float end = std::numeric_limits<float>::min();
 	};
+	
+	// translation, rotation and scale of the nodes of a model, in the order of Model::linearNodes
+	struct AnimationPose
+	{
+		std::vector<vec3> translations;
+		std::vector<quat> rotations;
+		std::vector<vec3> scales;
+		std::vector<vec3> weights; // accumulated weight of the translation, rotation and scale of each node
+		
+		void reset(size_t nodesCount);
+	};
+	
+	// a clip played with a weight, with a key cursor for each of its channels
+	struct AnimationLayer
+	{
+		uint32_t animation = 0;
+		float time = 0.f;
+		float weight = 1.f;
+		float speed = 1.f;
+		std::vector<uint32_t> cursors {};
+	};
+	
+	// Plays any number of clips and blends them by their weights,
+	// the weights of the clips that animate a node are normalized
+	class Animator
+	{
+	public:
+		std::vector<AnimationLayer> layers {};
+		
+		void play(const std::vector<Animation>& animations, uint32_t animation, float weight = 1.f, float speed = 1.f);
+		
+		void stop();
+		
+		void advance(const std::vector<Animation>& animations, float delta);
+		
+		void evaluate(const std::vector<Animation>& animations, AnimationPose& pose);
+		
+		static void apply(const AnimationPose& pose, const std::vector<Node*>& nodes);
+		
+		void update(const std::vector<Animation>& animations, const std::vector<Node*>& nodes, float delta);
+		
+		// Evaluates the animations for a number of instances and frames, blending two clips when there are more than one.
+		// Returns the average milliseconds per frame for all the instances
+		static double Benchmark(
+				const std::vector<Animation>& animations, size_t nodesCount, uint32_t instances, uint32_t frames
+		);
+	
+	private:
+		AnimationPose m_pose {};
+	};
 }
\ No newline at end of file
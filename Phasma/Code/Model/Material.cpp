@@ -0,0 +1,168 @@
+/*
+Copyright (c) 2018-2021 Christos Karamoustos
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "PhasmaPch.h"
+#include "Material.h"
+#include "../Renderer/Pipeline.h"
+#include "../Renderer/RenderApi.h"
+#include <mutex>
+
+namespace pe
+{
+	Ref<vk::DescriptorSet> BindlessMaterials::descriptorSet = make_ref(vk::DescriptorSet());
+	Ref<vk::DescriptorPool> BindlessMaterials::descriptorPool = make_ref(vk::DescriptorPool());
+	Buffer BindlessMaterials::buffer {};
+	std::map<std::string, uint32_t> BindlessMaterials::textureIndices {};
+	std::vector<uint32_t> BindlessMaterials::freeMaterials {};
+	uint32_t BindlessMaterials::materialsCount = 0;
+	
+	static std::mutex s_bindless_mutex {};
+	
+	bool BindlessMaterials::enabled()
+	{
+		return VulkanContext::Get()->descriptorIndexing;
+	}
+	
+	void BindlessMaterials::init()
+	{
+		if (!enabled() || *descriptorSet)
+			return;
+		
+		auto vulkan = VulkanContext::Get();
+		
+		// sets with update after bind bindings must be allocated from a pool that allows it
+		std::vector<vk::DescriptorPoolSize> descPoolsize(2);
+		descPoolsize[0].type = vk::DescriptorType::eCombinedImageSampler;
+		descPoolsize[0].descriptorCount = MAX_BINDLESS_TEXTURES;
+		descPoolsize[1].type = vk::DescriptorType::eStorageBuffer;
+		descPoolsize[1].descriptorCount = 1;
+		
+		vk::DescriptorPoolCreateInfo createInfo;
+		createInfo.flags = vk::DescriptorPoolCreateFlagBits::eUpdateAfterBind;
+		createInfo.poolSizeCount = static_cast<uint32_t>(descPoolsize.size());
+		createInfo.pPoolSizes = descPoolsize.data();
+		createInfo.maxSets = 1;
+		descriptorPool = make_ref(vulkan->device->createDescriptorPool(createInfo));
+		
+		vk::DescriptorSetAllocateInfo allocateInfo;
+		allocateInfo.descriptorPool = *descriptorPool;
+		allocateInfo.descriptorSetCount = 1;
+		allocateInfo.pSetLayouts = &Pipeline::getDescriptorSetLayoutBindless();
+		descriptorSet = make_ref(vulkan->device->allocateDescriptorSets(allocateInfo).at(0));
+		
+		buffer.CreateBuffer(
+				sizeof(MaterialData) * MAX_BINDLESS_MATERIALS, BufferUsage::StorageBuffer, MemoryProperty::HostVisible
+		);
+		buffer.Map();
+		buffer.Zero();
+		buffer.Flush();
+		buffer.Unmap();
+		
+		vk::DescriptorBufferInfo dbi {*buffer.GetBufferVK(), 0, buffer.Size()};
+		vk::WriteDescriptorSet writeSet {
+				*descriptorSet, 1, 0, 1, vk::DescriptorType::eStorageBuffer, nullptr, &dbi, nullptr
+		};
+		vulkan->device->updateDescriptorSets(writeSet, nullptr);
+	}
+	
+	uint32_t BindlessMaterials::addTexture(const std::string& path, Image& image)
+	{
+		if (!enabled())
+			return 0;
+		
+		std::lock_guard<std::mutex> guard(s_bindless_mutex);
+		
+		auto it = textureIndices.find(path);
+		if (it != textureIndices.end())
+			return it->second;
+		
+		const uint32_t index = static_cast<uint32_t>(textureIndices.size());
+		if (index >= MAX_BINDLESS_TEXTURES)
+			throw std::runtime_error("Bindless textures limit reached");
+		
+		vk::DescriptorImageInfo dii {*image.sampler, *image.view, vk::ImageLayout::eShaderReadOnlyOptimal};
+		vk::WriteDescriptorSet writeSet {
+				*descriptorSet, 0, index, 1, vk::DescriptorType::eCombinedImageSampler, &dii, nullptr, nullptr
+		};
+		VulkanContext::Get()->device->updateDescriptorSets(writeSet, nullptr);
+		
+		textureIndices[path] = index;
+		return index;
+	}
+	
+	uint32_t BindlessMaterials::addMaterial(const mat4& factors, const uint32_t* textures)
+	{
+		MaterialData data {};
+		data.factors = factors;
+		memcpy(data.textures, textures, sizeof(data.textures));
+		
+		std::lock_guard<std::mutex> guard(s_bindless_mutex);
+		
+		uint32_t index;
+		if (!freeMaterials.empty())
+		{
+			index = freeMaterials.back();
+			freeMaterials.pop_back();
+		}
+		else
+		{
+			if (materialsCount >= MAX_BINDLESS_MATERIALS)
+				throw std::runtime_error("Bindless materials limit reached");
+			index = materialsCount++;
+		}
+		
+		const size_t offset = index * sizeof(MaterialData);
+		buffer.Map();
+		buffer.CopyData(&data, sizeof(MaterialData), offset);
+		buffer.Flush(offset, sizeof(MaterialData));
+		buffer.Unmap();
+		
+		return index;
+	}
+	
+	void BindlessMaterials::removeMaterial(uint32_t index)
+	{
+		std::lock_guard<std::mutex> guard(s_bindless_mutex);
+		freeMaterials.push_back(index);
+	}
+	
+	void BindlessMaterials::destroy()
+	{
+		auto vulkan = VulkanContext::Get();
+		
+		buffer.Destroy();
+		if (*descriptorPool)
+		{
+			vulkan->device->destroyDescriptorPool(*descriptorPool);
+			*descriptorPool = nullptr;
+			*descriptorSet = nullptr;
+		}
+		if (Pipeline::getDescriptorSetLayoutBindless())
+		{
+			vulkan->device->destroyDescriptorSetLayout(Pipeline::getDescriptorSetLayoutBindless());
+			Pipeline::getDescriptorSetLayoutBindless() = nullptr;
+		}
+		textureIndices.clear();
+		freeMaterials.clear();
+		materialsCount = 0;
+	}
+}
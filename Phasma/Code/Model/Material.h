@@ -23,7 +23,19 @@ SOFTWARE.
 #pragma once
 
 #include "../Renderer/Image.h"
+#include "../Renderer/Buffer.h"
 #include "../Core/Math.h"
+#include <map>
+
+constexpr auto MAX_BINDLESS_TEXTURES = 4096u;
+constexpr auto MAX_BINDLESS_MATERIALS = 4096u;
+
+namespace vk
+{
+	class DescriptorSet;
+	
+	class DescriptorPool;
+}
 
 namespace pe
 {
@@ -51,5 +63,42 @@ namespace pe
 		Image normalTexture;
 		Image occlusionTexture;
 		Image emissiveTexture;
+		
+		// indices in the bindless texture array, by MaterialType
+		uint32_t textureIndices[5] {};
+	};
+	
+	// All material textures in one sampled image array and all material factors in one storage buffer,
+	// a draw only pushes its material index
+	class BindlessMaterials
+	{
+	public:
+		struct MaterialData
+		{
+			mat4 factors;
+			uint32_t textures[5];
+			uint32_t dummy[3];
+		};
+		
+		static bool enabled();
+		
+		static void init();
+		
+		static uint32_t addTexture(const std::string& path, Image& image);
+		
+		static uint32_t addMaterial(const mat4& factors, const uint32_t* textureIndices);
+		
+		static void removeMaterial(uint32_t index);
+		
+		static void destroy();
+		
+		static Ref<vk::DescriptorSet> descriptorSet;
+		
+	private:
+		static Ref<vk::DescriptorPool> descriptorPool;
+		static Buffer buffer;
+		static std::map<std::string, uint32_t> textureIndices;
+		static std::vector<uint32_t> freeMaterials;
+		static uint32_t materialsCount;
 	};
 }
\ No newline at end of file
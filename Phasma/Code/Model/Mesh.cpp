@@ -23,9 +23,11 @@ SOFTWARE.
 #include "PhasmaPch.h"
 #include "Mesh.h"
 #include "../Renderer/Pipeline.h"
+#include "../Renderer/UploadManager.h"
 #include "../../Include/tinygltf/stb_image.h"
 #include "../Renderer/RenderApi.h"
 #include "../Core/Path.h"
+#include "../Core/Profiler.h"
 
 namespace pe
 {
@@ -51,7 +53,7 @@ namespace pe
 	
 	void Mesh::createUniformBuffers()
 	{
-		uniformBuffer.CreateBuffer(
+		uniformBuffer.CreateBufferPerFrame(
 				sizeof(ubo), BufferUsage::UniformBuffer, MemoryProperty::HostVisible
 		);
 		uniformBuffer.Map();
@@ -72,6 +74,14 @@ namespace pe
 			);
 			factors[3][0] = static_cast<float>(primitive.hasBones);
 			
+			if (BindlessMaterials::enabled())
+			{
+				primitive.materialIndex = BindlessMaterials::addMaterial(
+						factors, primitive.pbrMaterial.textureIndices
+				);
+				continue;
+			}
+			
 			const size_t size = sizeof(mat4);
 			primitive.uniformBuffer.CreateBuffer(
 					size, BufferUsage::UniformBuffer, MemoryProperty::HostVisible
@@ -91,6 +101,8 @@ namespace pe
 			const Microsoft::glTF::GLTFResourceReader* resourceReader
 	)
 	{
+		PE_PROFILE_SCOPE("Primitive::loadTexture");
+		
 		std::string path = folderPath;
 		if (image)
 			path = folderPath + image->uri;
@@ -153,41 +165,44 @@ namespace pe
 			
 			const vk::DeviceSize imageSize = texWidth * texHeight * STBI_rgb_alpha;
 			
-			VulkanContext::Get()->graphicsQueue->waitIdle();
-			VulkanContext::Get()->waitAndLockSubmits();
-			
-			Buffer staging;
-			staging.CreateBuffer(
-					imageSize, BufferUsage::TransferSrc, MemoryProperty::HostVisible
-			);
-			staging.Map();
-			staging.CopyData(pixels);
-			staging.Flush();
-			staging.Unmap();
-			
-			stbi_image_free(pixels);
-			
-			tex->format = make_ref(vk::Format::eR8G8B8A8Unorm);
-			tex->mipLevels =
-					static_cast<uint32_t>(std::floor(std::log2(texWidth > texHeight ? texWidth : texHeight))) + 1;
-			tex->createImage(
-					texWidth, texHeight, vk::ImageTiling::eOptimal,
-					vk::ImageUsageFlagBits::eTransferSrc | vk::ImageUsageFlagBits::eTransferDst |
-					vk::ImageUsageFlagBits::eSampled, vk::MemoryPropertyFlagBits::eDeviceLocal
-			);
-			tex->transitionImageLayout(vk::ImageLayout::ePreinitialized, vk::ImageLayout::eTransferDstOptimal);
-			tex->copyBufferToImage(*staging.GetBufferVK());
-			tex->generateMipMaps();
-			tex->createImageView(vk::ImageAspectFlagBits::eColor);
-			tex->maxLod = static_cast<float>(tex->mipLevels);
-			tex->createSampler();
-			
-			staging.Destroy();
-			
-			VulkanContext::Get()->unlockSubmits();
+			if DYNAMIC_CONSTEXPR (PE_NULL)
+			{
+				tex->width = static_cast<uint32_t>(texWidth);
+				tex->height = static_cast<uint32_t>(texHeight);
+				tex->width_f = static_cast<float>(texWidth);
+				tex->height_f = static_cast<float>(texHeight);
+				tex->hostPixels = make_ref(std::vector<uint8_t>(pixels, pixels + imageSize));
+				stbi_image_free(pixels);
+			}
+			else
+			{
+				tex->format = make_ref(vk::Format::eR8G8B8A8Unorm);
+				tex->mipLevels =
+						static_cast<uint32_t>(std::floor(std::log2(texWidth > texHeight ? texWidth : texHeight))) + 1;
+				tex->createImage(
+						texWidth, texHeight, vk::ImageTiling::eOptimal,
+						vk::ImageUsageFlagBits::eTransferSrc | vk::ImageUsageFlagBits::eTransferDst |
+						vk::ImageUsageFlagBits::eSampled, vk::MemoryPropertyFlagBits::eDeviceLocal
+				);
+				UploadManager::uploadImage(*tex, pixels, imageSize);
+				const uint64_t uploadValue = UploadManager::flush();
+				
+				stbi_image_free(pixels);
+				
+				// the blits need the graphics queue, the rendering is only locked out for their submit
+				VulkanContext::Get()->waitAndLockSubmits();
+				tex->generateMipMaps(uploadValue);
+				VulkanContext::Get()->unlockSubmits();
+				
+				tex->createImageView(vk::ImageAspectFlagBits::eColor);
+				tex->maxLod = static_cast<float>(tex->mipLevels);
+				tex->createSampler();
+			}
 			
 			Mesh::uniqueTextures[path] = *tex;
 		}
+		
+		pbrMaterial.textureIndices[type] = BindlessMaterials::addTexture(path, *tex);
 	}
 	
 	//void Mesh::calculateBoundingSphere()
@@ -206,24 +221,34 @@ namespace pe
 	void Mesh::destroy()
 	{
 		uniformBuffer.Destroy();
-		if (Pipeline::getDescriptorSetLayoutMesh())
+		// the getter creates the layout when there is none, the null api has no device for it
+		if DYNAMIC_CONSTEXPR (PE_VULKAN)
 		{
-			VulkanContext::Get()->device->destroyDescriptorSetLayout(Pipeline::getDescriptorSetLayoutMesh());
-			Pipeline::getDescriptorSetLayoutMesh() = nullptr;
+			if (Pipeline::getDescriptorSetLayoutMesh())
+			{
+				VulkanContext::Get()->device->destroyDescriptorSetLayout(Pipeline::getDescriptorSetLayoutMesh());
+				Pipeline::getDescriptorSetLayoutMesh() = nullptr;
+			}
 		}
 		
 		for (auto& primitive : primitives)
 		{
-			primitive.uniformBuffer.Destroy();
+			if (BindlessMaterials::enabled())
+				BindlessMaterials::removeMaterial(primitive.materialIndex);
+			else
+				primitive.uniformBuffer.Destroy();
 		}
 		vertices.clear();
 		vertices.shrink_to_fit();
 		indices.clear();
 		indices.shrink_to_fit();
-		if (Pipeline::getDescriptorSetLayoutPrimitive())
+		if DYNAMIC_CONSTEXPR (PE_VULKAN)
 		{
-			VulkanContext::Get()->device->destroyDescriptorSetLayout(Pipeline::getDescriptorSetLayoutPrimitive());
-			Pipeline::getDescriptorSetLayoutPrimitive() = nullptr;
+			if (Pipeline::getDescriptorSetLayoutPrimitive())
+			{
+				VulkanContext::Get()->device->destroyDescriptorSetLayout(Pipeline::getDescriptorSetLayoutPrimitive());
+				Pipeline::getDescriptorSetLayoutPrimitive() = nullptr;
+			}
 		}
 	}
 }
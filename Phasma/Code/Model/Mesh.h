@@ -30,8 +30,6 @@ SOFTWARE.
 #include "../../Include/GLTFSDK/GLTFResourceReader.h"
 #include <map>
 
-constexpr auto MAX_NUM_JOINTS = 128u;
-
 namespace vk
 {
 	class DescriptorSet;
@@ -50,6 +48,7 @@ namespace pe
 		
 		Ref<vk::DescriptorSet> descriptorSet;
 		Buffer uniformBuffer;
+		uint32_t materialIndex = 0;
 		
 		bool render = true, cull = true;
 		uint32_t vertexOffset = 0, indexOffset = 0;
@@ -90,9 +89,9 @@ namespace pe
 		{
 			mat4 matrix;
 			mat4 previousMatrix;
-			mat4 jointMatrix[MAX_NUM_JOINTS];
-			float jointcount {0};
-			float dummy[3];
+			uint32_t jointOffset {0}; // first joint matrix in AnimationCompute::jointsBuffer
+			uint32_t jointCount {0};
+			uint32_t dummy[2];
 		} ubo;
 		
 		static std::map<std::string, Image> uniqueTextures;
@@ -25,12 +25,16 @@ SOFTWARE.
 #include "Mesh.h"
 #include "../Core/Queue.h"
 #include "../Renderer/Pipeline.h"
+#include "../Renderer/UploadManager.h"
 #include <iostream>
 #include <future>
 #include <deque>
+#include <set>
 #include <GLTFSDK/GLBResourceReader.h>
 #include <GLTFSDK/Deserialize.h>
 #include "../Renderer/RenderApi.h"
+#include "../Core/Profiler.h"
+#include "../Core/Timer.h"
 
 #undef max
 
@@ -46,8 +50,6 @@ namespace pe
 	{
 		if (commandBuffer == nullptr)
 			commandBuffer = make_ref(vk::CommandBuffer());
-		
-		descriptorSet = make_ref(vk::DescriptorSet());
 	}
 	
 	Model::~Model()
@@ -373,66 +375,33 @@ namespace pe
 	
 	void Model::loadModel(const std::string& folderPath, const std::string& modelName, bool show)
 	{
+		PE_PROFILE_SCOPE("Model::loadModel");
+		
+		Timer timer;
+		timer.Start();
+		
 		loadModelGltf(folderPath, modelName, show);
 		//calculateBoundingSphere();
 		name = modelName;
 		fullPathName = folderPath + modelName;
 		render = show;
-		createVertexBuffer();
-		createIndexBuffer();
-		createUniformBuffers();
-		createDescriptorSets();
-	}
-	
-	void Model::updateAnimation(uint32_t index, float time)
-	{
-		if (index > static_cast<uint32_t>(animations.size()) - 1)
+		
+		// the geometry stays in the meshes, there is no device to upload it to or sets to write
+		if DYNAMIC_CONSTEXPR (PE_NULL)
 		{
-			std::cout << "No animation with index " << index << std::endl;
+			createUniformBuffers();
+			loadTime = timer.Count();
 			return;
 		}
-		Animation& animation = animations[index];
 		
-		for (auto& channel : animation.channels)
-		{
-			pe::AnimationSampler& sampler = animation.samplers[channel.samplerIndex];
-			if (sampler.inputs.size() > sampler.outputsVec4.size())
-				continue;
-			
-			for (size_t i = 0; i < sampler.inputs.size() - 1; i++)
-			{
-				if ((time >= sampler.inputs[i]) && (time <= sampler.inputs[i + 1]))
-				{
-					const float u =
-							std::max(0.0f, time - sampler.inputs[i]) / (sampler.inputs[i + 1] - sampler.inputs[i]);
-					if (u <= 1.0f)
-					{
-						switch (channel.path)
-						{
-							case pe::AnimationChannel::PathType::TRANSLATION:
-							{
-								cvec4 t = mix(sampler.outputsVec4[i], sampler.outputsVec4[i + 1], u);
-								channel.node->translation = vec3(t);
-								break;
-							}
-							case pe::AnimationChannel::PathType::SCALE:
-							{
-								cvec4 s = mix(sampler.outputsVec4[i], sampler.outputsVec4[i + 1], u);
-								channel.node->scale = vec3(s);
-								break;
-							}
-							case pe::AnimationChannel::PathType::ROTATION:
-							{
-								cquat q1(&sampler.outputsVec4[i].x);
-								cquat q2(&sampler.outputsVec4[i + 1].x);
-								channel.node->rotation = normalize(slerp(q1, q2, u));
-								break;
-							}
-						}
-					}
-				}
-			}
-		}
+		createVertexBuffer();
+		createIndexBuffer();
+		AnimationCompute::addModel(*this);
+		// the frames wait on the upload timeline, the model is usable as soon as it is added
+		UploadManager::flush();
+		createUniformBuffers();
+		createDescriptorSets();
+		loadTime = timer.Count();
 	}
 	
 	void frustumCheckAsync(const Model& model, Mesh* mesh, const Camera& camera, uint32_t index)
@@ -451,6 +420,14 @@ namespace pe
 		{
 			node->update();
 			
+			// shared nodes are culled per instance in updateInstances
+			if (model.instances->modelsCount > 1)
+			{
+				for (auto& primitive : node->mesh->primitives)
+					primitive.cull = false;
+				return;
+			}
+			
 			// async calls should be at least bigger than a number, else this will be slower
 			if (node->mesh->primitives.size() > 3)
 			{
@@ -472,7 +449,9 @@ namespace pe
 	
 	void Model::update(pe::Camera& camera, double delta)
 	{
-		if (render)
+		PE_PROFILE_SCOPE("Model::update");
+		
+		if (render || (updatesNodes && instances->modelsCount > 1))
 		{
 			if (script)
 			{
@@ -487,21 +466,12 @@ namespace pe
 			ubo.previousMvp = ubo.mvp;
 			ubo.mvp = camera.viewProjection * transform;
 			
-			Queue::memcpyRequest(&uniformBuffer, {{&ubo, sizeof(ubo), 0}});
-			//uniformBuffer.map();
-			//memcpy(uniformBuffer.data, &ubo, sizeof(ubo));
-			//uniformBuffer.flush();
-			//uniformBuffer.unmap();
+			// the rest of the instances only need their transform
+			if (!updatesNodes)
+				return;
 			
 			if (!animations.empty())
-			{
-				animationTimer += static_cast<float>(delta);
-				
-				if (animationTimer > animations[animationIndex].end)
-					animationTimer -= animations[animationIndex].end;
-				
-				updateAnimation(animationIndex, animationTimer);
-			}
+				animator.update(animations, linearNodes, static_cast<float>(delta));
 			
 			// async calls should be at least bigger than a number, else this will be slower
 			if (linearNodes.size() > 3)
@@ -519,56 +489,12 @@ namespace pe
 				for (auto& linearNode : linearNodes)
 					updateNodeAsync(*this, linearNode, camera);
 			}
+			
+			if (nodesRange.count > 0)
+				AnimationCompute::updateNodes(*this);
 		}
 	}
 	
-	void Model::draw(uint16_t renderQueue)
-	{
-		if (!render || !Model::pipeline)
-			return;
-		
-		auto& cmd = Model::commandBuffer;
-		const vk::DeviceSize offset {0};
-		
-		cmd->bindPipeline(vk::PipelineBindPoint::eGraphics, *Model::pipeline->handle);
-		cmd->bindVertexBuffers(0, 1, &*vertexBuffer.GetBufferVK(), &offset);
-		cmd->bindIndexBuffer(*indexBuffer.GetBufferVK(), 0, vk::IndexType::eUint32);
-		
-		int culled = 0;
-		int total = 0;
-		for (auto& node : linearNodes)
-		{
-			if (node->mesh)
-			{
-				for (auto& primitive : node->mesh->primitives)
-				{
-					if (primitive.pbrMaterial.alphaMode == renderQueue && primitive.render)
-					{
-						total++;
-						if (!primitive.cull)
-						{
-							cmd->bindDescriptorSets(
-									vk::PipelineBindPoint::eGraphics, *Model::pipeline->layout, 0, {
-											*node->mesh->descriptorSet, *primitive.descriptorSet, *descriptorSet
-									}, nullptr
-							);
-							cmd->drawIndexed(
-									primitive.indicesSize, 1, node->mesh->indexOffset + primitive.indexOffset,
-									node->mesh->vertexOffset + primitive.vertexOffset, 0
-							);
-						}
-						else
-						{
-							culled++;
-						}
-					}
-				}
-			}
-		}
-		
-		//std::cout << "RenderQueue: " << renderQueue << " Culled: " << culled << "/" << total << std::endl;
-	}
-	
 	// position x, y, z and radius w
 	void Model::calculateBoundingSphere()
 	{
@@ -698,19 +624,23 @@ namespace pe
 					{
 						case glTF::AccessorType::TYPE_VEC3:
 						{
+							std::vector<vec4> values;
 							for (size_t i = 0; i < accessor.count; i++)
 							{
 								const vec3 v3(&data[i * 3]);
-								sampler.outputsVec4.emplace_back(v3, 0.0f);
+								values.emplace_back(v3, 0.0f);
 							}
+							sampler.setOutputs(values, 3);
 							break;
 						}
 						case glTF::AccessorType::TYPE_VEC4:
 						{
+							std::vector<vec4> values;
 							for (size_t i = 0; i < accessor.count; i++)
 							{
-								sampler.outputsVec4.emplace_back(&data[i * 4]);
+								values.emplace_back(&data[i * 4]);
 							}
+							sampler.setOutputs(values, 4);
 							break;
 						}
 						default:
@@ -750,10 +680,16 @@ namespace pe
 				{
 					continue;
 				}
+				const auto it = std::find(linearNodes.begin(), linearNodes.end(), channel.node);
+				channel.target = static_cast<uint32_t>(std::distance(linearNodes.begin(), it));
 				animation.channels.push_back(channel);
 			}
 			animations.push_back(animation);
 		}
+		
+		// the first clip plays by default
+		animator.stop();
+		animator.play(animations, 0);
 	}
 	
 	void Model::loadSkins()
@@ -815,22 +751,14 @@ namespace pe
 			}
 		}
 		numberOfVertices = static_cast<uint32_t>(vertices.size());
-		auto size = sizeof(Vertex) * numberOfVertices;
-		vertexBuffer.CreateBuffer(
-				size, BufferUsage::TransferDst | BufferUsage::VertexBuffer,
-				MemoryProperty::DeviceLocal
-		);
-		
-		// Staging buffer
-		Buffer staging;
-		staging.CreateBuffer(size, BufferUsage::TransferSrc, MemoryProperty::HostVisible);
-		staging.Map();
-		staging.CopyData(vertices.data());
-		staging.Flush();
-		staging.Unmap();
+		vertexRange = GeometryArena::uploadVertices(vertices.data(), numberOfVertices);
 		
-		vertexBuffer.CopyBuffer(&staging, staging.Size());
-		staging.Destroy();
+		// mesh offsets are relative to the whole arena
+		for (auto& node : linearNodes)
+		{
+			if (node->mesh)
+				node->mesh->vertexOffset += vertexRange.offset;
+		}
 	}
 	
 	void Model::createIndexBuffer()
@@ -848,33 +776,28 @@ namespace pe
 			}
 		}
 		numberOfIndices = static_cast<uint32_t>(indices.size());
-		auto size = sizeof(uint32_t) * numberOfIndices;
-		indexBuffer.CreateBuffer(
-				size, BufferUsage::TransferDst | BufferUsage::IndexBuffer,
-				MemoryProperty::DeviceLocal
-		);
+		indexRange = GeometryArena::uploadIndices(indices.data(), numberOfIndices);
 		
-		// Staging buffer
-		Buffer staging;
-		staging.CreateBuffer(size, BufferUsage::TransferSrc, MemoryProperty::HostVisible);
-		staging.Map();
-		staging.CopyData(indices.data());
-		staging.Flush();
-		staging.Unmap();
-		
-		indexBuffer.CopyBuffer(&staging, staging.Size());
-		staging.Destroy();
+		for (auto& node : linearNodes)
+		{
+			if (node->mesh)
+				node->mesh->indexOffset += indexRange.offset;
+		}
 	}
 	
 	void Model::createUniformBuffers()
 	{
-		uniformBuffer.CreateBuffer(
-				sizeof(ubo), BufferUsage::UniformBuffer, MemoryProperty::HostVisible
+		instances = make_ref(Instances());
+		instances->capacity = 1;
+		instances->modelsCount = 1;
+		instances->descriptorSet = make_ref(vk::DescriptorSet());
+		instances->storageBuffer.CreateBufferPerFrame(
+				sizeof(UBOModel) * instances->capacity, BufferUsage::StorageBuffer, MemoryProperty::HostVisible
 		);
-		uniformBuffer.Map();
-		uniformBuffer.Zero();
-		uniformBuffer.Flush();
-		uniformBuffer.Unmap();
+		instances->storageBuffer.Map();
+		instances->storageBuffer.Zero();
+		instances->storageBuffer.Flush();
+		instances->storageBuffer.Unmap();
 		for (auto& node : linearNodes)
 		{
 			if (node->mesh)
@@ -903,14 +826,22 @@ namespace pe
 			};
 		};
 		
-		// model dSet
+		// model dSet, shared by all instances
 		vk::DescriptorSetAllocateInfo allocateInfo0;
 		allocateInfo0.descriptorPool = *VulkanContext::Get()->descriptorPool;
 		allocateInfo0.descriptorSetCount = 1;
 		allocateInfo0.pSetLayouts = &Pipeline::getDescriptorSetLayoutModel();
-		descriptorSet = make_ref(VulkanContext::Get()->device->allocateDescriptorSets(allocateInfo0).at(0));
+		instances->descriptorSet = make_ref(
+				VulkanContext::Get()->allocateDescriptorSet(allocateInfo0)
+		);
 		
-		VulkanContext::Get()->device->updateDescriptorSets(wSetBuffer(*descriptorSet, 0, uniformBuffer), nullptr);
+		vk::DescriptorBufferInfo dbi {
+				*instances->storageBuffer.GetBufferVK(), 0, instances->storageBuffer.FrameSize()
+		};
+		vk::WriteDescriptorSet writeSet {
+				*instances->descriptorSet, 0, 0, 1, vk::DescriptorType::eStorageBufferDynamic, nullptr, &dbi, nullptr
+		};
+		VulkanContext::Get()->device->updateDescriptorSets(writeSet, nullptr);
 		
 		// mesh dSets
 		for (auto& node : linearNodes)
@@ -923,12 +854,27 @@ namespace pe
 			allocateInfo.descriptorPool = *VulkanContext::Get()->descriptorPool;
 			allocateInfo.descriptorSetCount = 1;
 			allocateInfo.pSetLayouts = &Pipeline::getDescriptorSetLayoutMesh();
-			mesh->descriptorSet = make_ref(VulkanContext::Get()->device->allocateDescriptorSets(allocateInfo).at(0));
+			mesh->descriptorSet = make_ref(VulkanContext::Get()->allocateDescriptorSet(allocateInfo));
 			
-			VulkanContext::Get()->device
-			                    ->updateDescriptorSets(
-					                    wSetBuffer(*mesh->descriptorSet, 0, mesh->uniformBuffer), nullptr
-			                    );
+			vk::DescriptorBufferInfo meshDbi {*mesh->uniformBuffer.GetBufferVK(), 0, mesh->uniformBuffer.FrameSize()};
+			vk::DescriptorBufferInfo jointsDbi {
+					*AnimationCompute::jointsBuffer.GetBufferVK(), 0, AnimationCompute::jointsBuffer.FrameSize()
+			};
+			std::vector<vk::WriteDescriptorSet> meshWriteSets {
+					{
+							*mesh->descriptorSet, 0, 0, 1, vk::DescriptorType::eUniformBufferDynamic, nullptr, &meshDbi,
+							nullptr
+					},
+					{
+							*mesh->descriptorSet, 1, 0, 1, vk::DescriptorType::eStorageBufferDynamic, nullptr, &jointsDbi,
+							nullptr
+					}
+			};
+			VulkanContext::Get()->device->updateDescriptorSets(meshWriteSets, nullptr);
+			
+			// primitives index the bindless materials set instead
+			if (BindlessMaterials::enabled())
+				continue;
 			
 			// primitive dSets
 			for (auto& primitive : mesh->primitives)
@@ -939,7 +885,7 @@ namespace pe
 				allocateInfo2.descriptorSetCount = 1;
 				allocateInfo2.pSetLayouts = &Pipeline::getDescriptorSetLayoutPrimitive();
 				primitive.descriptorSet = make_ref(
-						VulkanContext::Get()->device->allocateDescriptorSets(allocateInfo2).at(0)
+						VulkanContext::Get()->allocateDescriptorSet(allocateInfo2)
 				);
 				
 				std::vector<vk::WriteDescriptorSet> textureWriteSets {
@@ -955,6 +901,126 @@ namespace pe
 		}
 	}
 	
+	Model Model::createInstance()
+	{
+		// grow the storage buffer, the device is idle while the queue is checked
+		if (instances->modelsCount + 1 > instances->capacity)
+		{
+			instances->capacity *= 2;
+			instances->storageBuffer.Destroy();
+			instances->storageBuffer.CreateBufferPerFrame(
+					sizeof(UBOModel) * instances->capacity, BufferUsage::StorageBuffer, MemoryProperty::HostVisible
+			);
+			
+			if DYNAMIC_CONSTEXPR (PE_VULKAN)
+			{
+				vk::DescriptorBufferInfo dbi {
+						*instances->storageBuffer.GetBufferVK(), 0, instances->storageBuffer.FrameSize()
+				};
+				vk::WriteDescriptorSet writeSet {
+						*instances->descriptorSet, 0, 0, 1, vk::DescriptorType::eStorageBufferDynamic, nullptr, &dbi,
+						nullptr
+				};
+				VulkanContext::Get()->device->updateDescriptorSets(writeSet, nullptr);
+			}
+		}
+		instances->modelsCount++;
+		
+		Model instance = *this;
+		instance.name = name + "_" + std::to_string(++instances->created);
+		instance.script = nullptr;
+		instance.updatesNodes = false;
+		instance.ubo = {};
+		instance.scale = vec3(1.0f);
+		instance.pos = vec3(0.0f);
+		instance.rot = vec3(0.0f);
+		instance.render = true;
+		instance.loadTime = 0.0;
+		return instance;
+	}
+	
+	bool Model::isInstanceVisible(const Camera& camera) const
+	{
+		for (auto& node : linearNodes)
+		{
+			if (node->mesh)
+			{
+				cmat4 trans = transform * node->mesh->ubo.matrix;
+				for (auto& primitive : node->mesh->primitives)
+				{
+					vec4 bs = trans * vec4(vec3(primitive.boundingSphere), 1.0f);
+					bs.w = primitive.boundingSphere.w * abs(trans.scale().x);
+					if (camera.SphereInFrustum(bs))
+						return true;
+				}
+			}
+		}
+		return false;
+	}
+	
+	Model* Model::findLoaded(const std::string& fullPathName)
+	{
+		for (auto& model : models)
+		{
+			if (model.fullPathName == fullPathName)
+				return &model;
+		}
+		return nullptr;
+	}
+	
+	void Model::assignInstanceOwners()
+	{
+		std::set<Instances*> owned {};
+		for (auto& model : models)
+			model.updatesNodes = owned.insert(model.instances.get()).second;
+	}
+	
+	void Model::updateInstances(const Camera& camera)
+	{
+		PE_PROFILE_SCOPE("Model::updateInstances");
+		
+		for (auto& model : models)
+		{
+			if (model.updatesNodes)
+			{
+				model.instances->data.clear();
+				model.instances->transforms.clear();
+			}
+		}
+		
+		// visible instances first, then the ones only the shadows need
+		for (auto& model : models)
+		{
+			model.visible = model.instances->modelsCount == 1 || model.isInstanceVisible(camera);
+			if (model.render && model.visible)
+				model.instances->data.push_back(model.ubo);
+			if (model.render)
+				model.instances->transforms.push_back(&model.transform);
+		}
+		for (auto& model : models)
+		{
+			if (model.updatesNodes)
+				model.instances->visibleCount = static_cast<uint32_t>(model.instances->data.size());
+		}
+		for (auto& model : models)
+		{
+			if (model.render && !model.visible)
+				model.instances->data.push_back(model.ubo);
+		}
+		for (auto& model : models)
+		{
+			if (model.updatesNodes)
+			{
+				auto& inst = *model.instances;
+				inst.renderCount = static_cast<uint32_t>(inst.data.size());
+				if (inst.renderCount > 0)
+					Queue::memcpyRequest(
+							&inst.storageBuffer, {{inst.data.data(), inst.renderCount * sizeof(UBOModel), 0}}
+					);
+			}
+		}
+	}
+	
 	void Model::destroy()
 	{
 		if (script)
@@ -962,13 +1028,31 @@ namespace pe
 			delete script;
 			script = nullptr;
 		}
-		uniformBuffer.Destroy();
+		
+		// the shared resources stay with the rest of the instances
+		if (instances && --instances->modelsCount > 0)
+		{
+			instances.reset();
+			return;
+		}
+		
+		if (instances)
+		{
+			instances->storageBuffer.Destroy();
+			instances.reset();
+		}
+		if (nodesRange.count > 0)
+			AnimationCompute::removeModel(*this);
 		delete document;
 		delete resourceReader;
-		if (Pipeline::getDescriptorSetLayoutModel())
+		// the getter creates the layout when there is none, the null api has no device for it
+		if DYNAMIC_CONSTEXPR (PE_VULKAN)
 		{
-			VulkanContext::Get()->device->destroyDescriptorSetLayout(Pipeline::getDescriptorSetLayoutModel());
-			Pipeline::getDescriptorSetLayoutModel() = nullptr;
+			if (Pipeline::getDescriptorSetLayoutModel())
+			{
+				VulkanContext::Get()->device->destroyDescriptorSetLayout(Pipeline::getDescriptorSetLayoutModel());
+				Pipeline::getDescriptorSetLayoutModel() = nullptr;
+			}
 		}
 		for (auto& node : linearNodes)
 		{
@@ -989,7 +1073,7 @@ namespace pe
 		//for (auto& texture : Mesh::uniqueTextures)
 		//	texture.second.destroy();
 		//Mesh::uniqueTextures.clear();
-		vertexBuffer.Destroy();
-		indexBuffer.Destroy();
+		GeometryArena::freeVertices(vertexRange);
+		GeometryArena::freeIndices(indexRange);
 	}
 }
\ No newline at end of file
@@ -23,6 +23,8 @@ SOFTWARE.
 #pragma once
 
 #include "../Renderer/Buffer.h"
+#include "../Renderer/GeometryArena.h"
+#include "../Renderer/AnimationCompute.h"
 #include "../Core/Math.h"
 #include "../Script/Script.h"
 #include "../Camera/Camera.h"
@@ -58,14 +60,34 @@ namespace pe
 		static std::vector<Model> models;
 		static Pipeline* pipeline;
 		static Ref<vk::CommandBuffer> commandBuffer;
-		Ref<vk::DescriptorSet> descriptorSet;
-		Buffer uniformBuffer;
 		struct UBOModel
 		{
 			mat4 matrix = mat4::identity();
 			mat4 mvp = mat4::identity();
 			mat4 previousMvp = mat4::identity();
 		} ubo;
+		
+		// Models loaded from the same file share their nodes, geometry and materials.
+		// Each one writes its UBOModel in a storage buffer and every primitive is drawn once for all of them,
+		// visible instances first, followed by the rest that only cast shadows
+		struct Instances
+		{
+			Buffer storageBuffer;
+			Ref<vk::DescriptorSet> descriptorSet;
+			std::vector<UBOModel> data {};
+			// the transforms of the rendered models of the group this frame, in the order of the models
+			std::vector<const mat4*> transforms {};
+			uint32_t capacity = 0;
+			uint32_t modelsCount = 0;
+			uint32_t visibleCount = 0;
+			uint32_t renderCount = 0;
+			// instances ever created from the group, numbers their names so the gui can tell them apart
+			uint32_t created = 0;
+		};
+		Ref<Instances> instances;
+		// the first model of the instances updates the shared nodes and issues the draws
+		bool updatesNodes = true;
+		bool visible = true;
 		vec3 scale = vec3(1.0f);
 		vec3 pos = vec3(0.0f);
 		vec3 rot = vec3(0.0f); // euler angles
@@ -75,29 +97,30 @@ namespace pe
 		
 		std::string name;
 		std::string fullPathName;
+		// seconds loadModel took, 0 for an instance
+		double loadTime = 0.0;
 		std::vector<pe::Node*> linearNodes {};
 		std::vector<Skin*> skins {};
 		std::vector<Animation> animations {};
 		std::vector<std::string> extensions {};
 		
-		int32_t animationIndex = 0;
-		float animationTimer = 0.0f;
+		Animator animator;
 #if 0
 		Script* script = nullptr;
 #else
 		void* script = nullptr;
 #endif
 		
-		Buffer vertexBuffer;
-		Buffer indexBuffer;
+		// ranges in the geometry arena buffers
+		GeometryRange vertexRange;
+		GeometryRange indexRange;
+		// ranges in the animation compute buffers, skinned models only
+		GeometryRange nodesRange;
+		GeometryRange jointsRange;
 		uint32_t numberOfVertices = 0, numberOfIndices = 0;
 		
-		void draw(uint16_t renderQueue);
-		
 		void update(Camera& camera, double delta);
 		
-		void updateAnimation(uint32_t index, float time);
-		
 		void calculateBoundingSphere();
 		
 		void loadNode(pe::Node* parent, const Microsoft::glTF::Node& node, const std::string& folderPath);
@@ -131,6 +154,16 @@ namespace pe
 		
 		void createDescriptorSets();
 		
+		Model createInstance();
+		
+		bool isInstanceVisible(const Camera& camera) const;
+		
 		void destroy();
+		
+		static Model* findLoaded(const std::string& fullPathName);
+		
+		static void assignInstanceOwners();
+		
+		static void updateInstances(const Camera& camera);
 	};
 }
\ No newline at end of file
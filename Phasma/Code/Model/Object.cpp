@@ -24,6 +24,7 @@ SOFTWARE.
 #include "Object.h"
 #include "tinygltf/stb_image.h"
 #include "../Renderer/RenderApi.h"
+#include "../Renderer/UploadManager.h"
 
 namespace pe
 {
@@ -40,19 +41,8 @@ namespace pe
 				MemoryProperty::DeviceLocal
 		);
 		
-		// Staging buffer
-		Buffer staging;
-		staging.CreateBuffer(
-				sizeof(float) * vertices.size(), BufferUsage::TransferSrc,
-				MemoryProperty::HostVisible
-		);
-		staging.Map();
-		staging.CopyData(vertices.data());
-		staging.Flush();
-		staging.Unmap();
-		
-		vertexBuffer.CopyBuffer(&staging, staging.Size());
-		staging.Destroy();
+		UploadManager::uploadBuffer(vertexBuffer, 0, vertices.data(), sizeof(float) * vertices.size());
+		UploadManager::flush();
 	}
 	
 	void Object::createUniformBuffer(size_t size)
@@ -75,17 +65,6 @@ namespace pe
 		if (!pixels)
 			throw std::runtime_error("No pixel data loaded");
 		
-		Buffer staging;
-		staging.CreateBuffer(
-				imageSize, BufferUsage::TransferSrc, MemoryProperty::HostVisible
-		);
-		staging.Map();
-		staging.CopyData(pixels);
-		staging.Flush();
-		staging.Unmap();
-		
-		stbi_image_free(pixels);
-		
 		texture.format = make_ref(vk::Format::eR8G8B8A8Unorm);
 		texture.mipLevels = 1;
 		texture.createImage(
@@ -93,13 +72,13 @@ namespace pe
 				vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled,
 				vk::MemoryPropertyFlagBits::eDeviceLocal
 		);
-		texture.transitionImageLayout(vk::ImageLayout::ePreinitialized, vk::ImageLayout::eTransferDstOptimal);
-		texture.copyBufferToImage(*staging.GetBufferVK());
-		texture.transitionImageLayout(vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal);
+		UploadManager::uploadImage(texture, pixels, imageSize);
+		UploadManager::flush();
+		
+		stbi_image_free(pixels);
+		
 		texture.createImageView(vk::ImageAspectFlagBits::eColor);
 		texture.createSampler();
-		
-		staging.Destroy();
 	}
 	
 	void Object::createDescriptorSet(const vk::DescriptorSetLayout& descriptorSetLayout)
@@ -108,7 +87,7 @@ namespace pe
 		allocateInfo.descriptorPool = *VulkanContext::Get()->descriptorPool;
 		allocateInfo.descriptorSetCount = 1;
 		allocateInfo.pSetLayouts = &descriptorSetLayout;
-		descriptorSet = make_ref(VulkanContext::Get()->device->allocateDescriptorSets(allocateInfo).at(0));
+		descriptorSet = make_ref(VulkanContext::Get()->allocateDescriptorSet(allocateInfo));
 		
 		
 		std::vector<vk::WriteDescriptorSet> textureWriteSets(2);
@@ -33,32 +33,18 @@ namespace pe
 {
 	Bloom::Bloom()
 	{
-		DSBrightFilter = make_ref(vk::DescriptorSet());
+		for (auto& set : DSBrightFilter)
+			set = make_ref(vk::DescriptorSet());
 		DSGaussianBlurHorizontal = make_ref(vk::DescriptorSet());
 		DSGaussianBlurVertical = make_ref(vk::DescriptorSet());
-		DSCombine = make_ref(vk::DescriptorSet());
+		for (auto& set : DSCombine)
+			set = make_ref(vk::DescriptorSet());
 	}
 	
 	Bloom::~Bloom()
 	{
 	}
 	
-	void Bloom::Init()
-	{
-		frameImage.format = make_ref(VulkanContext::Get()->surface.formatKHR->format);
-		frameImage.initialLayout = make_ref(vk::ImageLayout::eUndefined);
-		frameImage.createImage(
-				static_cast<uint32_t>(WIDTH_f * GUI::renderTargetsScale),
-				static_cast<uint32_t>(HEIGHT_f * GUI::renderTargetsScale),
-				vk::ImageTiling::eOptimal,
-				vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled,
-				vk::MemoryPropertyFlagBits::eDeviceLocal
-		);
-		frameImage.transitionImageLayout(vk::ImageLayout::eUndefined, vk::ImageLayout::eShaderReadOnlyOptimal);
-		frameImage.createImageView(vk::ImageAspectFlagBits::eColor);
-		frameImage.createSampler();
-	}
-	
 	void Bloom::createRenderPasses(std::map<std::string, Image>& renderTargets)
 	{
 		renderPassBrightFilter.Create(*renderTargets["brightFilter"].format, vk::Format::eUndefined);
@@ -69,7 +55,8 @@ namespace pe
 	void Bloom::createFrameBuffers(std::map<std::string, Image>& renderTargets)
 	{
 		auto vulkan = VulkanContext::Get();
-		framebuffers.resize(vulkan->swapchain.images.size() * 4);
+		// the combine pass has one framebuffer per post process target
+		framebuffers.resize(vulkan->swapchain.images.size() * 5);
 		for (size_t i = 0; i < vulkan->swapchain.images.size(); ++i)
 		{
 			uint32_t width = renderTargets["brightFilter"].width;
@@ -94,12 +81,10 @@ namespace pe
 			framebuffers[i].Create(width, height, view, renderPassGaussianBlur);
 		}
 		
-		for (size_t i = vulkan->swapchain.images.size() * 3; i < vulkan->swapchain.images.size() * 4; ++i)
+		for (size_t i = vulkan->swapchain.images.size() * 3; i < vulkan->swapchain.images.size() * 5; ++i)
 		{
-			uint32_t width = renderTargets["viewport"].width;
-			uint32_t height = renderTargets["viewport"].height;
-			vk::ImageView view = *renderTargets["viewport"].view;
-			framebuffers[i].Create(width, height, view, renderPassCombine);
+			Image& target = renderTargets[POST_PROCESS_TARGETS[i / vulkan->swapchain.images.size() - 3]];
+			framebuffers[i].Create(target.width, target.height, *target.view, renderPassCombine);
 		}
 	}
 	
@@ -112,19 +97,21 @@ namespace pe
 		
 		// Composition image to Bright Filter shader
 		allocateInfo.pSetLayouts = &Pipeline::getDescriptorSetLayoutBrightFilter();
-		DSBrightFilter = make_ref(vulkan->device->allocateDescriptorSets(allocateInfo).at(0));
+		for (auto& set : DSBrightFilter)
+			set = make_ref(vulkan->allocateDescriptorSet(allocateInfo));
 		
 		// Bright Filter image to Gaussian Blur Horizontal shader
 		allocateInfo.pSetLayouts = &Pipeline::getDescriptorSetLayoutGaussianBlurH();
-		DSGaussianBlurHorizontal = make_ref(vulkan->device->allocateDescriptorSets(allocateInfo).at(0));
+		DSGaussianBlurHorizontal = make_ref(vulkan->allocateDescriptorSet(allocateInfo));
 		
 		// Gaussian Blur Horizontal image to Gaussian Blur Vertical shader
 		allocateInfo.pSetLayouts = &Pipeline::getDescriptorSetLayoutGaussianBlurV();
-		DSGaussianBlurVertical = make_ref(vulkan->device->allocateDescriptorSets(allocateInfo).at(0));
+		DSGaussianBlurVertical = make_ref(vulkan->allocateDescriptorSet(allocateInfo));
 		
 		// Gaussian Blur Vertical image to Combine shader
 		allocateInfo.pSetLayouts = &Pipeline::getDescriptorSetLayoutCombine();
-		DSCombine = make_ref(vulkan->device->allocateDescriptorSets(allocateInfo).at(0));
+		for (auto& set : DSCombine)
+			set = make_ref(vulkan->allocateDescriptorSet(allocateInfo));
 		
 		updateDescriptorSets(renderTargets);
 	}
@@ -141,16 +128,21 @@ namespace pe
 		};
 		
 		std::vector<vk::WriteDescriptorSet> textureWriteSets {
-				wSetImage(*DSBrightFilter, 0, frameImage),
 				wSetImage(*DSGaussianBlurHorizontal, 0, renderTargets["brightFilter"]),
-				wSetImage(*DSGaussianBlurVertical, 0, renderTargets["gaussianBlurHorizontal"]),
-				wSetImage(*DSCombine, 0, frameImage),
-				wSetImage(*DSCombine, 1, renderTargets["gaussianBlurVertical"])
+				wSetImage(*DSGaussianBlurVertical, 0, renderTargets["gaussianBlurHorizontal"])
 		};
+		for (uint32_t i = 0; i < 2; i++)
+		{
+			textureWriteSets.push_back(wSetImage(*DSBrightFilter[i], 0, renderTargets[POST_PROCESS_TARGETS[i]]));
+			textureWriteSets.push_back(wSetImage(*DSCombine[i], 0, renderTargets[POST_PROCESS_TARGETS[i]]));
+			textureWriteSets.push_back(wSetImage(*DSCombine[i], 1, renderTargets["gaussianBlurVertical"]));
+		}
 		VulkanContext::Get()->device->updateDescriptorSets(textureWriteSets, nullptr);
 	}
 	
-	void Bloom::draw(vk::CommandBuffer cmd, uint32_t imageIndex, std::map<std::string, Image>& renderTargets)
+	void Bloom::draw(
+			vk::CommandBuffer cmd, uint32_t imageIndex, uint32_t input, std::map<std::string, Image>& renderTargets
+	)
 	{
 		uint32_t totalImages = static_cast<uint32_t>(VulkanContext::Get()->swapchain.images.size());
 		
@@ -174,10 +166,11 @@ namespace pe
 		
 		renderTargets["brightFilter"].changeLayout(cmd, LayoutState::ColorWrite);
 		cmd.beginRenderPass(rpi, vk::SubpassContents::eInline);
+		RenderPass::SetViewport(cmd, rpi.renderArea);
 		cmd.pushConstants<float>(*pipelineBrightFilter.layout, vk::ShaderStageFlagBits::eFragment, 0, values);
 		cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, *pipelineBrightFilter.handle);
 		cmd.bindDescriptorSets(
-				vk::PipelineBindPoint::eGraphics, *pipelineBrightFilter.layout, 0, *DSBrightFilter, nullptr
+				vk::PipelineBindPoint::eGraphics, *pipelineBrightFilter.layout, 0, *DSBrightFilter[input], nullptr
 		);
 		cmd.draw(3, 1, 0, 0);
 		cmd.endRenderPass();
@@ -188,6 +181,7 @@ namespace pe
 		
 		renderTargets["gaussianBlurHorizontal"].changeLayout(cmd, LayoutState::ColorWrite);
 		cmd.beginRenderPass(rpi, vk::SubpassContents::eInline);
+		RenderPass::SetViewport(cmd, rpi.renderArea);
 		cmd.pushConstants<float>(*pipelineGaussianBlurHorizontal.layout, vk::ShaderStageFlagBits::eFragment, 0, values);
 		cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, *pipelineGaussianBlurHorizontal.handle);
 		cmd.bindDescriptorSets(
@@ -201,6 +195,7 @@ namespace pe
 		
 		renderTargets["gaussianBlurVertical"].changeLayout(cmd, LayoutState::ColorWrite);
 		cmd.beginRenderPass(rpi, vk::SubpassContents::eInline);
+		RenderPass::SetViewport(cmd, rpi.renderArea);
 		cmd.pushConstants<float>(*pipelineGaussianBlurVertical.layout, vk::ShaderStageFlagBits::eFragment, 0, values);
 		cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, *pipelineGaussianBlurVertical.handle);
 		cmd.bindDescriptorSets(
@@ -212,12 +207,14 @@ namespace pe
 		renderTargets["gaussianBlurVertical"].changeLayout(cmd, LayoutState::ColorRead);
 		
 		rpi.renderPass = *renderPassCombine.handle;
-		rpi.framebuffer = *framebuffers[static_cast<size_t>(totalImages) * 3 + static_cast<size_t>(imageIndex)].handle;
+		const size_t combineOutput = static_cast<size_t>(totalImages) * (4 - input);
+		rpi.framebuffer = *framebuffers[combineOutput + static_cast<size_t>(imageIndex)].handle;
 		
 		cmd.beginRenderPass(rpi, vk::SubpassContents::eInline);
+		RenderPass::SetViewport(cmd, rpi.renderArea);
 		cmd.pushConstants<float>(*pipelineCombine.layout, vk::ShaderStageFlagBits::eFragment, 0, values);
 		cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, *pipelineCombine.handle);
-		cmd.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, *pipelineCombine.layout, 0, *DSCombine, nullptr);
+		cmd.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, *pipelineCombine.layout, 0, *DSCombine[input], nullptr);
 		cmd.draw(3, 1, 0, 0);
 		cmd.endRenderPass();
 	}
@@ -237,8 +234,6 @@ namespace pe
 		
 		pipelineBrightFilter.info.pVertShader = &vert;
 		pipelineBrightFilter.info.pFragShader = &frag;
-		pipelineBrightFilter.info.width = renderTargets["brightFilter"].width_f;
-		pipelineBrightFilter.info.height = renderTargets["brightFilter"].height_f;
 		pipelineBrightFilter.info.cullMode = CullMode::Back;
 		pipelineBrightFilter.info.colorBlendAttachments = make_ref(
 				std::vector<vk::PipelineColorBlendAttachmentState> {*renderTargets["brightFilter"].blentAttachment}
@@ -260,8 +255,6 @@ namespace pe
 		
 		pipelineGaussianBlurHorizontal.info.pVertShader = &vert;
 		pipelineGaussianBlurHorizontal.info.pFragShader = &frag;
-		pipelineGaussianBlurHorizontal.info.width = renderTargets["gaussianBlurHorizontal"].width_f;
-		pipelineGaussianBlurHorizontal.info.height = renderTargets["gaussianBlurHorizontal"].height_f;
 		pipelineGaussianBlurHorizontal.info.cullMode = CullMode::Back;
 		pipelineGaussianBlurHorizontal.info.colorBlendAttachments = make_ref(
 				std::vector<vk::PipelineColorBlendAttachmentState> {
@@ -285,8 +278,6 @@ namespace pe
 		
 		pipelineGaussianBlurVertical.info.pVertShader = &vert;
 		pipelineGaussianBlurVertical.info.pFragShader = &frag;
-		pipelineGaussianBlurVertical.info.width = renderTargets["gaussianBlurVertical"].width_f;
-		pipelineGaussianBlurVertical.info.height = renderTargets["gaussianBlurVertical"].height_f;
 		pipelineGaussianBlurVertical.info.cullMode = CullMode::Back;
 		pipelineGaussianBlurVertical.info.colorBlendAttachments = make_ref(
 				std::vector<vk::PipelineColorBlendAttachmentState> {
@@ -311,8 +302,6 @@ namespace pe
 		
 		pipelineCombine.info.pVertShader = &vert;
 		pipelineCombine.info.pFragShader = &frag;
-		pipelineCombine.info.width = renderTargets["viewport"].width_f;
-		pipelineCombine.info.height = renderTargets["viewport"].height_f;
 		pipelineCombine.info.cullMode = CullMode::Back;
 		pipelineCombine.info.colorBlendAttachments = make_ref(
 				std::vector<vk::PipelineColorBlendAttachmentState> {*renderTargets["viewport"].blentAttachment}
@@ -357,7 +346,6 @@ namespace pe
 			vulkan->device->destroyDescriptorSetLayout(Pipeline::getDescriptorSetLayoutCombine());
 			Pipeline::getDescriptorSetLayoutCombine() = nullptr;
 		}
-		frameImage.destroy();
 		pipelineBrightFilter.destroy();
 		pipelineGaussianBlurHorizontal.destroy();
 		pipelineGaussianBlurVertical.destroy();
@@ -27,6 +27,7 @@ SOFTWARE.
 #include "../Renderer/RenderPass.h"
 #include "../Renderer/Framebuffer.h"
 #include <map>
+#include <array>
 #include <string>
 
 namespace vk
@@ -53,13 +54,10 @@ namespace pe
 		RenderPass renderPassBrightFilter;
 		RenderPass renderPassGaussianBlur;
 		RenderPass renderPassCombine;
-		Ref<vk::DescriptorSet> DSBrightFilter;
+		std::array<Ref<vk::DescriptorSet>, 2> DSBrightFilter;
 		Ref<vk::DescriptorSet> DSGaussianBlurHorizontal;
 		Ref<vk::DescriptorSet> DSGaussianBlurVertical;
-		Ref<vk::DescriptorSet> DSCombine;
-		Image frameImage;
-		
-		void Init();
+		std::array<Ref<vk::DescriptorSet>, 2> DSCombine;
 		
 		void createRenderPasses(std::map<std::string, Image>& renderTargets);
 		
@@ -79,7 +77,9 @@ namespace pe
 		
 		void updateDescriptorSets(std::map<std::string, Image>& renderTargets);
 		
-		void draw(vk::CommandBuffer cmd, uint32_t imageIndex, std::map<std::string, Image>& renderTargets);
+		void draw(
+				vk::CommandBuffer cmd, uint32_t imageIndex, uint32_t input, std::map<std::string, Image>& renderTargets
+		);
 		
 		void destroy();
 	};
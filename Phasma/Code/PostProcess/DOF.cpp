@@ -27,35 +27,21 @@ SOFTWARE.
 #include "../Renderer/Surface.h"
 #include "../Shader/Shader.h"
 #include "../Renderer/RenderApi.h"
+#include "../Renderer/DynamicResolution.h"
 #include <deque>
 
 namespace pe
 {
 	DOF::DOF()
 	{
-		DSet = make_ref(vk::DescriptorSet());
+		for (auto& set : DSet)
+			set = make_ref(vk::DescriptorSet());
 	}
 	
 	DOF::~DOF()
 	{
 	}
 	
-	void DOF::Init()
-	{
-		frameImage.format = make_ref(VulkanContext::Get()->surface.formatKHR->format);
-		frameImage.initialLayout = make_ref(vk::ImageLayout::eUndefined);
-		frameImage.createImage(
-				static_cast<uint32_t>(WIDTH_f * GUI::renderTargetsScale),
-				static_cast<uint32_t>(HEIGHT_f * GUI::renderTargetsScale),
-				vk::ImageTiling::eOptimal,
-				vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled,
-				vk::MemoryPropertyFlagBits::eDeviceLocal
-		);
-		frameImage.transitionImageLayout(vk::ImageLayout::eUndefined, vk::ImageLayout::eShaderReadOnlyOptimal);
-		frameImage.createImageView(vk::ImageAspectFlagBits::eColor);
-		frameImage.createSampler();
-	}
-	
 	void DOF::createRenderPass(std::map<std::string, Image>& renderTargets)
 	{
 		renderPass.Create(*renderTargets["viewport"].format, vk::Format::eUndefined);
@@ -64,13 +50,12 @@ namespace pe
 	void DOF::createFrameBuffers(std::map<std::string, Image>& renderTargets)
 	{
 		auto vulkan = VulkanContext::Get();
-		framebuffers.resize(vulkan->swapchain.images.size());
-		for (size_t i = 0; i < vulkan->swapchain.images.size(); ++i)
+		const size_t images = vulkan->swapchain.images.size();
+		framebuffers.resize(images * 2);
+		for (size_t i = 0; i < images * 2; ++i)
 		{
-			uint32_t width = renderTargets["viewport"].width;
-			uint32_t height = renderTargets["viewport"].height;
-			vk::ImageView view = *renderTargets["viewport"].view;
-			framebuffers[i].Create(width, height, view, renderPass);
+			Image& target = renderTargets[POST_PROCESS_TARGETS[i / images]];
+			framebuffers[i].Create(target.width, target.height, *target.view, renderPass);
 		}
 	}
 	
@@ -82,7 +67,8 @@ namespace pe
 		allocateInfo.descriptorSetCount = 1;
 		
 		allocateInfo.pSetLayouts = &Pipeline::getDescriptorSetLayoutDOF();
-		DSet = make_ref(vulkan->device->allocateDescriptorSets(allocateInfo).at(0));
+		for (auto& set : DSet)
+			set = make_ref(vulkan->allocateDescriptorSet(allocateInfo));
 		
 		updateDescriptorSets(renderTargets);
 	}
@@ -99,33 +85,41 @@ namespace pe
 		};
 		
 		std::vector<vk::WriteDescriptorSet> textureWriteSets {
-				wSetImage(*DSet, 0, frameImage),
-				wSetImage(*DSet, 1, renderTargets["depth"])
+				wSetImage(*DSet[0], 0, renderTargets[POST_PROCESS_TARGETS[0]]),
+				wSetImage(*DSet[0], 1, renderTargets["depth"]),
+				wSetImage(*DSet[1], 0, renderTargets[POST_PROCESS_TARGETS[1]]),
+				wSetImage(*DSet[1], 1, renderTargets["depth"])
 		};
 		VulkanContext::Get()->device->updateDescriptorSets(textureWriteSets, nullptr);
 	}
 	
-	void DOF::draw(vk::CommandBuffer cmd, uint32_t imageIndex, std::map<std::string, Image>& renderTargets)
+	void DOF::draw(
+			vk::CommandBuffer cmd, uint32_t imageIndex, uint32_t input, std::map<std::string, Image>& renderTargets
+	)
 	{
+		const size_t output = static_cast<size_t>(1 - input) * VulkanContext::Get()->swapchain.images.size();
+		
 		vk::ClearValue clearColor;
 		memcpy(clearColor.color.float32, GUI::clearColor.data(), 4 * sizeof(float));
 		
 		std::vector<vk::ClearValue> clearValues = {clearColor};
 		
-		std::vector<float> values {GUI::DOF_focus_scale, GUI::DOF_blur_range, 0.0f, 0.0f};
+		const vec2 scale = DynamicResolution::UVScale();
+		std::vector<float> values {GUI::DOF_focus_scale, GUI::DOF_blur_range, scale.x, scale.y};
 		
 		vk::RenderPassBeginInfo rpi;
 		rpi.renderPass = *renderPass.handle;
-		rpi.framebuffer = *framebuffers[imageIndex].handle;
+		rpi.framebuffer = *framebuffers[output + imageIndex].handle;
 		rpi.renderArea.offset = vk::Offset2D {0, 0};
 		rpi.renderArea.extent = *renderTargets["viewport"].extent;
 		rpi.clearValueCount = 1;
 		rpi.pClearValues = clearValues.data();
 		
 		cmd.beginRenderPass(rpi, vk::SubpassContents::eInline);
+		RenderPass::SetViewport(cmd, rpi.renderArea);
 		cmd.pushConstants<float>(*pipeline.layout, vk::ShaderStageFlagBits::eFragment, 0, values);
 		cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, *pipeline.handle);
-		cmd.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, *pipeline.layout, 0, *DSet, nullptr);
+		cmd.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, *pipeline.layout, 0, *DSet[input], nullptr);
 		cmd.draw(3, 1, 0, 0);
 		cmd.endRenderPass();
 	}
@@ -137,8 +131,6 @@ namespace pe
 		
 		pipeline.info.pVertShader = &vert;
 		pipeline.info.pFragShader = &frag;
-		pipeline.info.width = renderTargets["viewport"].width_f;
-		pipeline.info.height = renderTargets["viewport"].height_f;
 		pipeline.info.cullMode = CullMode::Back;
 		pipeline.info.colorBlendAttachments = make_ref(
 				std::vector<vk::PipelineColorBlendAttachmentState> {*renderTargets["viewport"].blentAttachment}
@@ -167,7 +159,6 @@ namespace pe
 			vulkan->device->destroyDescriptorSetLayout(Pipeline::getDescriptorSetLayoutDOF());
 			Pipeline::getDescriptorSetLayoutDOF() = nullptr;
 		}
-		frameImage.destroy();
 		pipeline.destroy();
 	}
 }
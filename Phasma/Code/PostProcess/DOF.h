@@ -27,6 +27,7 @@ SOFTWARE.
 #include "../Renderer/RenderPass.h"
 #include "../Renderer/Framebuffer.h"
 #include <map>
+#include <array>
 #include <string>
 
 namespace vk
@@ -48,10 +49,7 @@ namespace pe
 		std::vector<Framebuffer> framebuffers {};
 		Pipeline pipeline;
 		RenderPass renderPass;
-		Ref<vk::DescriptorSet> DSet;
-		Image frameImage;
-		
-		void Init();
+		std::array<Ref<vk::DescriptorSet>, 2> DSet;
 		
 		void createRenderPass(std::map<std::string, Image>& renderTargets);
 		
@@ -63,7 +61,9 @@ namespace pe
 		
 		void updateDescriptorSets(std::map<std::string, Image>& renderTargets);
 		
-		void draw(vk::CommandBuffer cmd, uint32_t imageIndex, std::map<std::string, Image>& renderTargets);
+		void draw(
+				vk::CommandBuffer cmd, uint32_t imageIndex, uint32_t input, std::map<std::string, Image>& renderTargets
+		);
 		
 		void destroy();
 	};
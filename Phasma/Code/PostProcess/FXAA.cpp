@@ -32,61 +32,54 @@ namespace pe
 {
 	FXAA::FXAA()
 	{
-		DSet = make_ref(vk::DescriptorSet());
+		for (auto& set : DSet)
+			set = make_ref(vk::DescriptorSet());
 	}
 	
 	FXAA::~FXAA()
 	{
 	}
 	
-	void FXAA::Init()
-	{
-		frameImage.format = make_ref(VulkanContext::Get()->surface.formatKHR->format);
-		frameImage.initialLayout = make_ref(vk::ImageLayout::eUndefined);
-		frameImage.createImage(
-				static_cast<uint32_t>(WIDTH_f * GUI::renderTargetsScale),
-				static_cast<uint32_t>(HEIGHT_f * GUI::renderTargetsScale),
-				vk::ImageTiling::eOptimal,
-				vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled,
-				vk::MemoryPropertyFlagBits::eDeviceLocal
-		);
-		frameImage.transitionImageLayout(vk::ImageLayout::eUndefined, vk::ImageLayout::eShaderReadOnlyOptimal);
-		frameImage.createImageView(vk::ImageAspectFlagBits::eColor);
-		frameImage.createSampler();
-	}
-	
 	void FXAA::createUniforms(std::map<std::string, Image>& renderTargets)
 	{
 		vk::DescriptorSetAllocateInfo allocateInfo2;
 		allocateInfo2.descriptorPool = *VulkanContext::Get()->descriptorPool;
 		allocateInfo2.descriptorSetCount = 1;
 		allocateInfo2.pSetLayouts = &Pipeline::getDescriptorSetLayoutFXAA();
-		DSet = make_ref(VulkanContext::Get()->device->allocateDescriptorSets(allocateInfo2).at(0));
+		for (auto& set : DSet)
+			set = make_ref(VulkanContext::Get()->allocateDescriptorSet(allocateInfo2));
 		
 		updateDescriptorSets(renderTargets);
 	}
 	
 	void FXAA::updateDescriptorSets(std::map<std::string, Image>& renderTargets) const
 	{
-		// Composition sampler
-		vk::DescriptorImageInfo dii;
-		dii.sampler = *frameImage.sampler;
-		dii.imageView = *frameImage.view;
-		dii.imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
-		
-		vk::WriteDescriptorSet textureWriteSet;
-		textureWriteSet.dstSet = *DSet;
-		textureWriteSet.dstBinding = 0;
-		textureWriteSet.dstArrayElement = 0;
-		textureWriteSet.descriptorCount = 1;
-		textureWriteSet.descriptorType = vk::DescriptorType::eCombinedImageSampler;
-		textureWriteSet.pImageInfo = &dii;
-		
-		VulkanContext::Get()->device->updateDescriptorSets(textureWriteSet, nullptr);
+		for (uint32_t i = 0; i < 2; i++)
+		{
+			// Composition sampler, one set per post process target
+			Image& input = renderTargets[POST_PROCESS_TARGETS[i]];
+			
+			vk::DescriptorImageInfo dii;
+			dii.sampler = *input.sampler;
+			dii.imageView = *input.view;
+			dii.imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
+			
+			vk::WriteDescriptorSet textureWriteSet;
+			textureWriteSet.dstSet = *DSet[i];
+			textureWriteSet.dstBinding = 0;
+			textureWriteSet.dstArrayElement = 0;
+			textureWriteSet.descriptorCount = 1;
+			textureWriteSet.descriptorType = vk::DescriptorType::eCombinedImageSampler;
+			textureWriteSet.pImageInfo = &dii;
+			
+			VulkanContext::Get()->device->updateDescriptorSets(textureWriteSet, nullptr);
+		}
 	}
 	
-	void FXAA::draw(vk::CommandBuffer cmd, uint32_t imageIndex, const vk::Extent2D& extent)
+	void FXAA::draw(vk::CommandBuffer cmd, uint32_t imageIndex, uint32_t input, const vk::Extent2D& extent)
 	{
+		const size_t output = static_cast<size_t>(1 - input) * VulkanContext::Get()->swapchain.images.size();
+		
 		vk::ClearValue clearColor;
 		memcpy(clearColor.color.float32, GUI::clearColor.data(), 4 * sizeof(float));
 		
@@ -94,15 +87,16 @@ namespace pe
 		
 		vk::RenderPassBeginInfo rpi;
 		rpi.renderPass = *renderPass.handle;
-		rpi.framebuffer = *framebuffers[imageIndex].handle;
+		rpi.framebuffer = *framebuffers[output + imageIndex].handle;
 		rpi.renderArea.offset = vk::Offset2D {0, 0};
 		rpi.renderArea.extent = extent;
 		rpi.clearValueCount = 1;
 		rpi.pClearValues = clearValues.data();
 		
 		cmd.beginRenderPass(rpi, vk::SubpassContents::eInline);
+		RenderPass::SetViewport(cmd, rpi.renderArea);
 		cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, *pipeline.handle);
-		cmd.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, *pipeline.layout, 0, *DSet, nullptr);
+		cmd.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, *pipeline.layout, 0, *DSet[input], nullptr);
 		cmd.draw(3, 1, 0, 0);
 		cmd.endRenderPass();
 	}
@@ -115,13 +109,12 @@ namespace pe
 	void FXAA::createFrameBuffers(std::map<std::string, Image>& renderTargets)
 	{
 		auto vulkan = VulkanContext::Get();
-		framebuffers.resize(vulkan->swapchain.images.size());
-		for (size_t i = 0; i < vulkan->swapchain.images.size(); ++i)
+		const size_t images = vulkan->swapchain.images.size();
+		framebuffers.resize(images * 2);
+		for (size_t i = 0; i < images * 2; ++i)
 		{
-			uint32_t width = renderTargets["viewport"].width;
-			uint32_t height = renderTargets["viewport"].height;
-			vk::ImageView view = *renderTargets["viewport"].view;
-			framebuffers[i].Create(width, height, view, renderPass);
+			Image& target = renderTargets[POST_PROCESS_TARGETS[i / images]];
+			framebuffers[i].Create(target.width, target.height, *target.view, renderPass);
 		}
 	}
 	
@@ -132,8 +125,6 @@ namespace pe
 		
 		pipeline.info.pVertShader = &vert;
 		pipeline.info.pFragShader = &frag;
-		pipeline.info.width = renderTargets["viewport"].width_f;
-		pipeline.info.height = renderTargets["viewport"].height_f;
 		pipeline.info.cullMode = CullMode::Back;
 		pipeline.info.colorBlendAttachments = make_ref(
 				std::vector<vk::PipelineColorBlendAttachmentState> {*renderTargets["viewport"].blentAttachment}
@@ -158,7 +149,6 @@ namespace pe
 			VulkanContext::Get()->device->destroyDescriptorSetLayout(Pipeline::getDescriptorSetLayoutFXAA());
 			Pipeline::getDescriptorSetLayoutFXAA() = nullptr;
 		}
-		frameImage.destroy();
 		pipeline.destroy();
 	}
 }
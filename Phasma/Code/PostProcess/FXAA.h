@@ -27,6 +27,7 @@ SOFTWARE.
 #include "../Renderer/RenderPass.h"
 #include "../Renderer/Framebuffer.h"
 #include <vector>
+#include <array>
 #include <map>
 #include <string>
 
@@ -51,16 +52,13 @@ namespace pe
 		std::vector<Framebuffer> framebuffers {};
 		Pipeline pipeline;
 		RenderPass renderPass;
-		Ref<vk::DescriptorSet> DSet;
-		Image frameImage;
-		
-		void Init();
+		std::array<Ref<vk::DescriptorSet>, 2> DSet;
 		
 		void createUniforms(std::map<std::string, Image>& renderTargets);
 		
 		void updateDescriptorSets(std::map<std::string, Image>& renderTargets) const;
 		
-		void draw(vk::CommandBuffer cmd, uint32_t imageIndex, const vk::Extent2D& extent);
+		void draw(vk::CommandBuffer cmd, uint32_t imageIndex, uint32_t input, const vk::Extent2D& extent);
 		
 		void createRenderPass(std::map<std::string, Image>& renderTargets);
 		
@@ -30,38 +30,24 @@ SOFTWARE.
 #include "../Core/Queue.h"
 #include "../Core/Timer.h"
 #include "../Renderer/RenderApi.h"
+#include "../Renderer/DynamicResolution.h"
 
 namespace pe
 {
 	MotionBlur::MotionBlur()
 	{
-		DSet = make_ref(vk::DescriptorSet());
+		for (auto& set : DSet)
+			set = make_ref(vk::DescriptorSet());
 	}
 	
 	MotionBlur::~MotionBlur()
 	{
 	}
 	
-	void MotionBlur::Init()
-	{
-		frameImage.format = make_ref(VulkanContext::Get()->surface.formatKHR->format);
-		frameImage.initialLayout = make_ref(vk::ImageLayout::eUndefined);
-		frameImage.createImage(
-				static_cast<uint32_t>(WIDTH_f * GUI::renderTargetsScale),
-				static_cast<uint32_t>(HEIGHT_f * GUI::renderTargetsScale),
-				vk::ImageTiling::eOptimal,
-				vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled,
-				vk::MemoryPropertyFlagBits::eDeviceLocal
-		);
-		frameImage.transitionImageLayout(vk::ImageLayout::eUndefined, vk::ImageLayout::eShaderReadOnlyOptimal);
-		frameImage.createImageView(vk::ImageAspectFlagBits::eColor);
-		frameImage.createSampler();
-	}
-	
 	void MotionBlur::createMotionBlurUniforms(std::map<std::string, Image>& renderTargets)
 	{
 		auto size = 4 * sizeof(mat4);
-		UBmotionBlur.CreateBuffer(size, BufferUsage::UniformBuffer, MemoryProperty::HostVisible);
+		UBmotionBlur.CreateBufferPerFrame(size, BufferUsage::UniformBuffer, MemoryProperty::HostVisible);
 		UBmotionBlur.Map();
 		UBmotionBlur.Zero();
 		UBmotionBlur.Flush();
@@ -71,7 +57,8 @@ namespace pe
 		allocateInfo.descriptorPool = *VulkanContext::Get()->descriptorPool;
 		allocateInfo.descriptorSetCount = 1;
 		allocateInfo.pSetLayouts = &Pipeline::getDescriptorSetLayoutMotionBlur();
-		DSet = make_ref(VulkanContext::Get()->device->allocateDescriptorSets(allocateInfo).at(0));
+		for (auto& set : DSet)
+			set = make_ref(VulkanContext::Get()->allocateDescriptorSet(allocateInfo));
 		
 		updateDescriptorSets(renderTargets);
 	}
@@ -89,23 +76,29 @@ namespace pe
 		std::deque<vk::DescriptorBufferInfo> dsbi {};
 		auto const wSetBuffer = [&dsbi](const vk::DescriptorSet& dstSet, uint32_t dstBinding, Buffer& buffer)
 		{
-			dsbi.emplace_back(*buffer.GetBufferVK(), 0, buffer.Size());
+			dsbi.emplace_back(*buffer.GetBufferVK(), 0, buffer.FrameSize());
 			return vk::WriteDescriptorSet {
-					dstSet, dstBinding, 0, 1, vk::DescriptorType::eUniformBuffer, nullptr, &dsbi.back(), nullptr
+					dstSet, dstBinding, 0, 1, vk::DescriptorType::eUniformBufferDynamic, nullptr, &dsbi.back(), nullptr
 			};
 		};
 		
-		std::vector<vk::WriteDescriptorSet> textureWriteSets {
-				wSetImage(*DSet, 0, frameImage),
-				wSetImage(*DSet, 1, renderTargets["depth"]),
-				wSetImage(*DSet, 2, renderTargets["velocity"]),
-				wSetBuffer(*DSet, 3, UBmotionBlur)
-		};
+		std::vector<vk::WriteDescriptorSet> textureWriteSets {};
+		for (uint32_t i = 0; i < 2; i++)
+		{
+			textureWriteSets.push_back(wSetImage(*DSet[i], 0, renderTargets[POST_PROCESS_TARGETS[i]]));
+			textureWriteSets.push_back(wSetImage(*DSet[i], 1, renderTargets["depth"]));
+			textureWriteSets.push_back(wSetImage(*DSet[i], 2, renderTargets["velocity"]));
+			textureWriteSets.push_back(wSetBuffer(*DSet[i], 3, UBmotionBlur));
+		}
 		VulkanContext::Get()->device->updateDescriptorSets(textureWriteSets, nullptr);
 	}
 	
-	void MotionBlur::draw(vk::CommandBuffer cmd, uint32_t imageIndex, const vk::Extent2D& extent)
+	void MotionBlur::draw(
+			vk::CommandBuffer cmd, uint32_t imageIndex, uint32_t input, const vk::Extent2D& extent, bool withDOF
+	)
 	{
+		const size_t output = static_cast<size_t>(1 - input) * VulkanContext::Get()->swapchain.images.size();
+		
 		vk::ClearValue clearColor;
 		memcpy(clearColor.color.float32, GUI::clearColor.data(), 4 * sizeof(float));
 		
@@ -113,20 +106,29 @@ namespace pe
 		
 		vk::RenderPassBeginInfo rpi;
 		rpi.renderPass = *renderPass.handle;
-		rpi.framebuffer = *framebuffers[imageIndex].handle;
+		rpi.framebuffer = *framebuffers[output + imageIndex].handle;
 		rpi.renderArea.offset = vk::Offset2D {0, 0};
 		rpi.renderArea.extent = extent;
 		rpi.clearValueCount = static_cast<uint32_t>(clearValues.size());
 		rpi.pClearValues = clearValues.data();
 		cmd.beginRenderPass(rpi, vk::SubpassContents::eInline);
+		RenderPass::SetViewport(cmd, rpi.renderArea);
 		
-		const vec4 values {
-				1.f / static_cast<float>(FrameTimer::Instance().delta),
-				sin(static_cast<float>(FrameTimer::Instance().time) * 0.125f), GUI::motionBlur_strength, 0.f
+		// the fused pipeline also resolves the depth of field, saving a full screen pass
+		Pipeline& current = withDOF ? pipelineDOF : pipeline;
+		const vec2 scale = DynamicResolution::UVScale();
+		const vec4 values[2] {
+				{
+						1.f / static_cast<float>(FrameTimer::Instance().delta),
+						sin(static_cast<float>(FrameTimer::Instance().time) * 0.125f), GUI::motionBlur_strength, 0.f
+				},
+				{GUI::DOF_focus_scale, GUI::DOF_blur_range, scale.x, scale.y}
 		};
-		cmd.pushConstants<vec4>(*pipeline.layout, vk::ShaderStageFlagBits::eFragment, 0, values);
-		cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, *pipeline.handle);
-		cmd.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, *pipeline.layout, 0, *DSet, nullptr);
+		cmd.pushConstants(*current.layout, vk::ShaderStageFlagBits::eFragment, 0, sizeof(values), values);
+		cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, *current.handle);
+		cmd.bindDescriptorSets(
+				vk::PipelineBindPoint::eGraphics, *current.layout, 0, *DSet[input], UBmotionBlur.FrameOffset()
+		);
 		cmd.draw(3, 1, 0, 0);
 		cmd.endRenderPass();
 	}
@@ -143,9 +145,9 @@ namespace pe
 			VulkanContext::Get()->device->destroyDescriptorSetLayout(Pipeline::getDescriptorSetLayoutMotionBlur());
 			Pipeline::getDescriptorSetLayoutMotionBlur() = nullptr;
 		}
-		frameImage.destroy();
 		UBmotionBlur.Destroy();
 		pipeline.destroy();
+		pipelineDOF.destroy();
 	}
 	
 	void MotionBlur::update(Camera& camera)
@@ -177,13 +179,12 @@ namespace pe
 	void MotionBlur::createFrameBuffers(std::map<std::string, Image>& renderTargets)
 	{
 		auto vulkan = VulkanContext::Get();
-		framebuffers.resize(vulkan->swapchain.images.size());
-		for (size_t i = 0; i < vulkan->swapchain.images.size(); ++i)
+		const size_t images = vulkan->swapchain.images.size();
+		framebuffers.resize(images * 2);
+		for (size_t i = 0; i < images * 2; ++i)
 		{
-			uint32_t width = renderTargets["viewport"].width;
-			uint32_t height = renderTargets["viewport"].height;
-			vk::ImageView view = *renderTargets["viewport"].view;
-			framebuffers[i].Create(width, height, view, renderPass);
+			Image& target = renderTargets[POST_PROCESS_TARGETS[i / images]];
+			framebuffers[i].Create(target.width, target.height, *target.view, renderPass);
 		}
 	}
 	
@@ -195,19 +196,40 @@ namespace pe
 		
 		pipeline.info.pVertShader = &vert;
 		pipeline.info.pFragShader = &frag;
-		pipeline.info.width = renderTargets["viewport"].width_f;
-		pipeline.info.height = renderTargets["viewport"].height_f;
 		pipeline.info.cullMode = CullMode::Back;
 		pipeline.info.colorBlendAttachments = make_ref(
 				std::vector<vk::PipelineColorBlendAttachmentState> {*renderTargets["viewport"].blentAttachment}
 		);
 		pipeline.info.pushConstantStage = PushConstantStage::Fragment;
-		pipeline.info.pushConstantSize = sizeof(vec4);
+		pipeline.info.pushConstantSize = 2 * sizeof(vec4);
 		pipeline.info.descriptorSetLayouts = make_ref(
 				std::vector<vk::DescriptorSetLayout> {Pipeline::getDescriptorSetLayoutMotionBlur()}
 		);
 		pipeline.info.renderPass = renderPass;
 		
 		pipeline.createGraphicsPipeline();
+		
+		createPipelineDOF(renderTargets);
+	}
+	
+	void MotionBlur::createPipelineDOF(std::map<std::string, Image>& renderTargets)
+	{
+		Shader vert {"Shaders/Common/quad.vert", ShaderType::Vertex, true};
+		Shader frag {"Shaders/MotionBlur/motionBlurDOF.frag", ShaderType::Fragment, true};
+		
+		pipelineDOF.info.pVertShader = &vert;
+		pipelineDOF.info.pFragShader = &frag;
+		pipelineDOF.info.cullMode = CullMode::Back;
+		pipelineDOF.info.colorBlendAttachments = make_ref(
+				std::vector<vk::PipelineColorBlendAttachmentState> {*renderTargets["viewport"].blentAttachment}
+		);
+		pipelineDOF.info.pushConstantStage = PushConstantStage::Fragment;
+		pipelineDOF.info.pushConstantSize = 2 * sizeof(vec4);
+		pipelineDOF.info.descriptorSetLayouts = make_ref(
+				std::vector<vk::DescriptorSetLayout> {Pipeline::getDescriptorSetLayoutMotionBlur()}
+		);
+		pipelineDOF.info.renderPass = renderPass;
+		
+		pipelineDOF.createGraphicsPipeline();
 	}
 }
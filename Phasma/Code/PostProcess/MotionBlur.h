@@ -31,6 +31,7 @@ SOFTWARE.
 #include <vector>
 #include <string>
 #include <map>
+#include <array>
 
 namespace vk
 {
@@ -53,12 +54,9 @@ namespace pe
 		mat4 motionBlurInput[4];
 		Buffer UBmotionBlur;
 		std::vector<Framebuffer> framebuffers {};
-		Pipeline pipeline;
+		Pipeline pipeline, pipelineDOF;
 		RenderPass renderPass;
-		Ref<vk::DescriptorSet> DSet;
-		Image frameImage;
-		
-		void Init();
+		std::array<Ref<vk::DescriptorSet>, 2> DSet;
 		
 		void update(Camera& camera);
 		
@@ -68,11 +66,15 @@ namespace pe
 		
 		void createPipeline(std::map<std::string, Image>& renderTargets);
 		
+		void createPipelineDOF(std::map<std::string, Image>& renderTargets);
+		
 		void createMotionBlurUniforms(std::map<std::string, Image>& renderTargets);
 		
 		void updateDescriptorSets(std::map<std::string, Image>& renderTargets);
 		
-		void draw(vk::CommandBuffer cmd, uint32_t imageIndex, const vk::Extent2D& extent);
+		void draw(
+				vk::CommandBuffer cmd, uint32_t imageIndex, uint32_t input, const vk::Extent2D& extent, bool withDOF
+		);
 		
 		void destroy();
 	};
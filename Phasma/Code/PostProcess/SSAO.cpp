@@ -29,6 +29,8 @@ SOFTWARE.
 #include "../Shader/Shader.h"
 #include "../Core/Queue.h"
 #include "../Renderer/RenderApi.h"
+#include "../Renderer/UploadManager.h"
+#include "../Renderer/DynamicResolution.h"
 
 namespace pe
 {
@@ -36,6 +38,29 @@ namespace pe
 	{
 		DSet = make_ref(vk::DescriptorSet());
 		DSBlur = make_ref(vk::DescriptorSet());
+		DSCompute = make_ref(vk::DescriptorSet());
+		DSBlurCompute = make_ref(vk::DescriptorSet());
+	}
+	
+	bool SSAO::ComputeSupported()
+	{
+		static const bool supported = []()
+		{
+			auto vulkan = VulkanContext::Get();
+			if (!vulkan->asyncCompute || !vulkan->gpuFeatures->shaderStorageImageExtendedFormats)
+				return false;
+			
+			// the ssao targets are written as r16 and r8 storage images
+			for (auto format : {vk::Format::eR16Unorm, vk::Format::eR8Unorm})
+			{
+				const vk::FormatProperties props = vulkan->gpu->getFormatProperties(format);
+				if (!(props.optimalTilingFeatures & vk::FormatFeatureFlagBits::eStorageImage))
+					return false;
+			}
+			return true;
+		}();
+		
+		return supported;
 	}
 	
 	SSAO::~SSAO()
@@ -66,14 +91,6 @@ namespace pe
 		for (unsigned int i = 0; i < 16; i++)
 			noise.emplace_back(rand(-1.f, 1.f), rand(-1.f, 1.f), 0.f, 1.f);
 		
-		Buffer staging;
-		const uint64_t bufSize = sizeof(vec4) * 16;
-		staging.CreateBuffer(bufSize, BufferUsage::TransferSrc, MemoryProperty::HostVisible);
-		staging.Map();
-		staging.CopyData(noise.data());
-		staging.Flush();
-		staging.Unmap();
-		
 		noiseTex.filter = make_ref(vk::Filter::eNearest);
 		noiseTex.minLod = 0.0f;
 		noiseTex.maxLod = 0.0f;
@@ -84,14 +101,12 @@ namespace pe
 				vk::ImageUsageFlagBits::eTransferSrc | vk::ImageUsageFlagBits::eTransferDst |
 				vk::ImageUsageFlagBits::eSampled, vk::MemoryPropertyFlagBits::eDeviceLocal
 		);
-		noiseTex.transitionImageLayout(vk::ImageLayout::ePreinitialized, vk::ImageLayout::eTransferDstOptimal);
-		noiseTex.copyBufferToImage(*staging.GetBufferVK());
-		noiseTex.transitionImageLayout(vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal);
+		UploadManager::uploadImage(noiseTex, noise.data(), sizeof(vec4) * noise.size());
+		UploadManager::flush();
 		noiseTex.createImageView(vk::ImageAspectFlagBits::eColor);
 		noiseTex.createSampler();
-		staging.Destroy();
 		// pvm uniform
-		UB_PVM.CreateBuffer(3 * sizeof(mat4), BufferUsage::UniformBuffer, MemoryProperty::HostVisible);
+		UB_PVM.CreateBufferPerFrame(3 * sizeof(mat4) + sizeof(vec4), BufferUsage::UniformBuffer, MemoryProperty::HostVisible);
 		UB_PVM.Map();
 		UB_PVM.Zero();
 		UB_PVM.Flush();
@@ -103,7 +118,7 @@ namespace pe
 				1,                                                //uint32_t descriptorSetCount;
 				&Pipeline::getDescriptorSetLayoutSSAO()            //const DescriptorSetLayout* pSetLayouts;
 		};
-		DSet = make_ref(VulkanContext::Get()->device->allocateDescriptorSets(allocInfo).at(0));
+		DSet = make_ref(VulkanContext::Get()->allocateDescriptorSet(allocInfo));
 		
 		// DESCRIPTOR SET FOR SSAO BLUR
 		const vk::DescriptorSetAllocateInfo allocInfoBlur = vk::DescriptorSetAllocateInfo {
@@ -111,7 +126,28 @@ namespace pe
 				1,                                                //uint32_t descriptorSetCount;
 				&Pipeline::getDescriptorSetLayoutSSAOBlur()    //const DescriptorSetLayout* pSetLayouts;
 		};
-		DSBlur = make_ref(VulkanContext::Get()->device->allocateDescriptorSets(allocInfoBlur).at(0));
+		DSBlur = make_ref(VulkanContext::Get()->allocateDescriptorSet(allocInfoBlur));
+		
+		if (ComputeSupported())
+		{
+			// same values as the noise image, which repeats every 4 pixels
+			UB_Noise.CreateBuffer(sizeof(vec4) * 16, BufferUsage::UniformBuffer, MemoryProperty::HostVisible);
+			UB_Noise.Map();
+			UB_Noise.CopyData(noise.data());
+			UB_Noise.Flush();
+			UB_Noise.Unmap();
+			
+			// DESCRIPTOR SETS FOR ASYNC COMPUTE SSAO AND BLUR
+			const vk::DescriptorSetAllocateInfo allocInfoCompute = vk::DescriptorSetAllocateInfo {
+					*VulkanContext::Get()->descriptorPool, 1, &Pipeline::getDescriptorSetLayoutSSAOCompute()
+			};
+			DSCompute = make_ref(VulkanContext::Get()->allocateDescriptorSet(allocInfoCompute));
+			
+			const vk::DescriptorSetAllocateInfo allocInfoBlurCompute = vk::DescriptorSetAllocateInfo {
+					*VulkanContext::Get()->descriptorPool, 1, &Pipeline::getDescriptorSetLayoutSSAOBlurCompute()
+			};
+			DSBlurCompute = make_ref(VulkanContext::Get()->allocateDescriptorSet(allocInfoBlurCompute));
+		}
 		
 		updateDescriptorSets(renderTargets);
 	}
@@ -130,22 +166,44 @@ namespace pe
 			};
 		};
 		std::deque<vk::DescriptorBufferInfo> dsbi {};
-		const auto wSetBuffer = [&dsbi](const vk::DescriptorSet& dstSet, uint32_t dstBinding, Buffer& buffer)
+		const auto wSetBuffer = [&dsbi](
+				const vk::DescriptorSet& dstSet, uint32_t dstBinding, Buffer& buffer, vk::DescriptorType type
+		)
 		{
-			dsbi.emplace_back(*buffer.GetBufferVK(), 0, buffer.Size());
-			return vk::WriteDescriptorSet {
-					dstSet, dstBinding, 0, 1, vk::DescriptorType::eUniformBuffer, nullptr, &dsbi.back(), nullptr
-			};
+			dsbi.emplace_back(*buffer.GetBufferVK(), 0, buffer.FrameSize());
+			return vk::WriteDescriptorSet {dstSet, dstBinding, 0, 1, type, nullptr, &dsbi.back(), nullptr};
 		};
 		
 		std::vector<vk::WriteDescriptorSet> writeDescriptorSets {
 				wSetImage(*DSet, 0, renderTargets["depth"]),
 				wSetImage(*DSet, 1, renderTargets["normal"]),
 				wSetImage(*DSet, 2, noiseTex),
-				wSetBuffer(*DSet, 3, UB_Kernel),
-				wSetBuffer(*DSet, 4, UB_PVM),
+				wSetBuffer(*DSet, 3, UB_Kernel, vk::DescriptorType::eUniformBuffer),
+				wSetBuffer(*DSet, 4, UB_PVM, vk::DescriptorType::eUniformBufferDynamic),
 				wSetImage(*DSBlur, 0, renderTargets["ssao"])
 		};
+		
+		if (ComputeSupported())
+		{
+			const auto wSetStorageImage = [&dsii](const vk::DescriptorSet& dstSet, uint32_t dstBinding, Image& image)
+			{
+				dsii.emplace_back(nullptr, *image.view, vk::ImageLayout::eGeneral);
+				return vk::WriteDescriptorSet {
+						dstSet, dstBinding, 0, 1, vk::DescriptorType::eStorageImage, &dsii.back(), nullptr, nullptr
+				};
+			};
+			
+			writeDescriptorSets.push_back(wSetImage(*DSCompute, 0, renderTargets["depth"]));
+			writeDescriptorSets.push_back(wSetImage(*DSCompute, 1, renderTargets["normal"]));
+			writeDescriptorSets.push_back(wSetBuffer(*DSCompute, 2, UB_Noise, vk::DescriptorType::eUniformBuffer));
+			writeDescriptorSets.push_back(wSetBuffer(*DSCompute, 3, UB_Kernel, vk::DescriptorType::eUniformBuffer));
+			writeDescriptorSets.push_back(
+					wSetBuffer(*DSCompute, 4, UB_PVM, vk::DescriptorType::eUniformBufferDynamic)
+			);
+			writeDescriptorSets.push_back(wSetStorageImage(*DSCompute, 5, renderTargets["ssao"]));
+			writeDescriptorSets.push_back(wSetImage(*DSBlurCompute, 0, renderTargets["ssao"]));
+			writeDescriptorSets.push_back(wSetStorageImage(*DSBlurCompute, 1, renderTargets["ssaoBlur"]));
+		}
 		VulkanContext::Get()->device->updateDescriptorSets(writeDescriptorSets, nullptr);
 	}
 	
@@ -162,15 +220,19 @@ namespace pe
 		rpi.renderPass = *renderPass.handle;
 		rpi.framebuffer = *framebuffers[imageIndex].handle;
 		rpi.renderArea.offset = vk::Offset2D {0, 0};
-		rpi.renderArea.extent = *image.extent;
+		rpi.renderArea.extent = DynamicResolution::Extent();
 		rpi.clearValueCount = 1;
 		rpi.pClearValues = clearValues.data();
 		
 		image.changeLayout(cmd, LayoutState::ColorWrite);
 		cmd.beginRenderPass(rpi, vk::SubpassContents::eInline);
+		// with dynamic resolution only a part of the targets is rendered
+		RenderPass::SetViewport(cmd, rpi.renderArea);
 		cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, *pipeline.handle);
 		const vk::DescriptorSet descriptorSets = {*DSet};
-		cmd.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, *pipeline.layout, 0, descriptorSets, nullptr);
+		cmd.bindDescriptorSets(
+				vk::PipelineBindPoint::eGraphics, *pipeline.layout, 0, descriptorSets, UB_PVM.FrameOffset()
+		);
 		cmd.draw(3, 1, 0, 0);
 		cmd.endRenderPass();
 		image.changeLayout(cmd, LayoutState::ColorRead);
@@ -179,7 +241,12 @@ namespace pe
 		rpi.renderPass = *blurRenderPass.handle;
 		rpi.framebuffer = *blurFramebuffers[imageIndex].handle;
 		
+		const vec2 scale = DynamicResolution::UVScale();
+		const vec4 values {scale.x, scale.y, 0.f, 0.f};
+		
 		cmd.beginRenderPass(rpi, vk::SubpassContents::eInline);
+		RenderPass::SetViewport(cmd, rpi.renderArea);
+		cmd.pushConstants<vec4>(*pipelineBlur.layout, vk::ShaderStageFlagBits::eFragment, 0, values);
 		cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, *pipelineBlur.handle);
 		const vk::DescriptorSet descriptorSetsBlur = {*DSBlur};
 		cmd.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, *pipelineBlur.layout, 0, descriptorSetsBlur, nullptr);
@@ -187,10 +254,174 @@ namespace pe
 		cmd.endRenderPass();
 	}
 	
+	void SSAO::releaseToCompute(vk::CommandBuffer cmd, std::map<std::string, Image>& renderTargets)
+	{
+		// recorded in the g-buffer command buffer, the compute queue acquires them in SSAO::compute
+		const uint32_t graphicsFamily = VulkanContext::Get()->graphicsFamilyId;
+		const uint32_t computeFamily = VulkanContext::Get()->computeFamilyId;
+		
+		for (auto& name : {"depth", "normal"})
+		{
+			Image& image = renderTargets[name];
+			image.transitionImageLayout(
+					cmd,
+					vk::ImageLayout::eColorAttachmentOptimal,
+					vk::ImageLayout::eShaderReadOnlyOptimal,
+					vk::PipelineStageFlagBits::eColorAttachmentOutput,
+					vk::PipelineStageFlagBits::eBottomOfPipe,
+					vk::AccessFlagBits::eColorAttachmentWrite,
+					vk::AccessFlags(),
+					vk::ImageAspectFlagBits::eColor,
+					graphicsFamily,
+					computeFamily
+			);
+			image.layoutState = LayoutState::ColorRead;
+		}
+	}
+	
+	void SSAO::compute(vk::CommandBuffer cmd, std::map<std::string, Image>& renderTargets)
+	{
+		const uint32_t graphicsFamily = VulkanContext::Get()->graphicsFamilyId;
+		const uint32_t computeFamily = VulkanContext::Get()->computeFamilyId;
+		Image& ssaoImage = renderTargets["ssao"];
+		Image& ssaoBlurImage = renderTargets["ssaoBlur"];
+		
+		// acquire the g-buffer inputs
+		for (auto& name : {"depth", "normal"})
+		{
+			renderTargets[name].transitionImageLayout(
+					cmd,
+					vk::ImageLayout::eColorAttachmentOptimal,
+					vk::ImageLayout::eShaderReadOnlyOptimal,
+					vk::PipelineStageFlagBits::eTopOfPipe,
+					vk::PipelineStageFlagBits::eComputeShader,
+					vk::AccessFlags(),
+					vk::AccessFlagBits::eShaderRead,
+					vk::ImageAspectFlagBits::eColor,
+					graphicsFamily,
+					computeFamily
+			);
+		}
+		
+		// the outputs are fully overwritten, their contents are discarded so they skip the ownership transfer
+		for (Image* image : {&ssaoImage, &ssaoBlurImage})
+		{
+			image->transitionImageLayout(
+					cmd,
+					vk::ImageLayout::eUndefined,
+					vk::ImageLayout::eGeneral,
+					vk::PipelineStageFlagBits::eTopOfPipe,
+					vk::PipelineStageFlagBits::eComputeShader,
+					vk::AccessFlags(),
+					vk::AccessFlagBits::eShaderWrite,
+					vk::ImageAspectFlagBits::eColor
+			);
+		}
+		
+		// SSAO image
+		cmd.bindPipeline(vk::PipelineBindPoint::eCompute, *pipelineCompute.handle);
+		cmd.bindDescriptorSets(
+				vk::PipelineBindPoint::eCompute, *pipelineCompute.layout, 0, *DSCompute, UB_PVM.FrameOffset()
+		);
+		// with dynamic resolution only a part of the targets is computed
+		const vk::Extent2D extent = DynamicResolution::Extent();
+		cmd.dispatch((extent.width + 7) / 8, (extent.height + 7) / 8, 1);
+		
+		ssaoImage.transitionImageLayout(
+				cmd,
+				vk::ImageLayout::eGeneral,
+				vk::ImageLayout::eShaderReadOnlyOptimal,
+				vk::PipelineStageFlagBits::eComputeShader,
+				vk::PipelineStageFlagBits::eComputeShader,
+				vk::AccessFlagBits::eShaderWrite,
+				vk::AccessFlagBits::eShaderRead,
+				vk::ImageAspectFlagBits::eColor
+		);
+		
+		// new blurry SSAO image
+		cmd.bindPipeline(vk::PipelineBindPoint::eCompute, *pipelineBlurCompute.handle);
+		cmd.bindDescriptorSets(
+				vk::PipelineBindPoint::eCompute, *pipelineBlurCompute.layout, 0, *DSBlurCompute, nullptr
+		);
+		const vec2 scale = DynamicResolution::UVScale();
+		const vec4 values {scale.x, scale.y, 0.f, 0.f};
+		cmd.pushConstants<vec4>(*pipelineBlurCompute.layout, vk::ShaderStageFlagBits::eCompute, 0, values);
+		cmd.dispatch((extent.width + 7) / 8, (extent.height + 7) / 8, 1);
+		
+		// release all of them back to graphics, acquired in SSAO::acquireFromCompute
+		ssaoBlurImage.transitionImageLayout(
+				cmd,
+				vk::ImageLayout::eGeneral,
+				vk::ImageLayout::eShaderReadOnlyOptimal,
+				vk::PipelineStageFlagBits::eComputeShader,
+				vk::PipelineStageFlagBits::eBottomOfPipe,
+				vk::AccessFlagBits::eShaderWrite,
+				vk::AccessFlags(),
+				vk::ImageAspectFlagBits::eColor,
+				computeFamily,
+				graphicsFamily
+		);
+		for (auto& name : {"depth", "normal", "ssao"})
+		{
+			renderTargets[name].transitionImageLayout(
+					cmd,
+					vk::ImageLayout::eShaderReadOnlyOptimal,
+					vk::ImageLayout::eShaderReadOnlyOptimal,
+					vk::PipelineStageFlagBits::eComputeShader,
+					vk::PipelineStageFlagBits::eBottomOfPipe,
+					vk::AccessFlags(),
+					vk::AccessFlags(),
+					vk::ImageAspectFlagBits::eColor,
+					computeFamily,
+					graphicsFamily
+			);
+		}
+	}
+	
+	void SSAO::acquireFromCompute(vk::CommandBuffer cmd, std::map<std::string, Image>& renderTargets)
+	{
+		// recorded in the deferred command buffer, it has to match the release barriers of SSAO::compute
+		const uint32_t graphicsFamily = VulkanContext::Get()->graphicsFamilyId;
+		const uint32_t computeFamily = VulkanContext::Get()->computeFamilyId;
+		
+		Image& ssaoBlurImage = renderTargets["ssaoBlur"];
+		ssaoBlurImage.transitionImageLayout(
+				cmd,
+				vk::ImageLayout::eGeneral,
+				vk::ImageLayout::eShaderReadOnlyOptimal,
+				vk::PipelineStageFlagBits::eTopOfPipe,
+				vk::PipelineStageFlagBits::eFragmentShader,
+				vk::AccessFlags(),
+				vk::AccessFlagBits::eShaderRead,
+				vk::ImageAspectFlagBits::eColor,
+				computeFamily,
+				graphicsFamily
+		);
+		ssaoBlurImage.layoutState = LayoutState::ColorRead;
+		for (auto& name : {"depth", "normal", "ssao"})
+		{
+			Image& image = renderTargets[name];
+			image.transitionImageLayout(
+					cmd,
+					vk::ImageLayout::eShaderReadOnlyOptimal,
+					vk::ImageLayout::eShaderReadOnlyOptimal,
+					vk::PipelineStageFlagBits::eTopOfPipe,
+					vk::PipelineStageFlagBits::eFragmentShader,
+					vk::AccessFlags(),
+					vk::AccessFlagBits::eShaderRead,
+					vk::ImageAspectFlagBits::eColor,
+					computeFamily,
+					graphicsFamily
+			);
+			image.layoutState = LayoutState::ColorRead;
+		}
+	}
+	
 	void SSAO::destroy()
 	{
 		UB_Kernel.Destroy();
 		UB_PVM.Destroy();
+		UB_Noise.Destroy();
 		noiseTex.destroy();
 		
 		renderPass.Destroy();
@@ -203,6 +434,8 @@ namespace pe
 		
 		pipeline.destroy();
 		pipelineBlur.destroy();
+		pipelineCompute.destroy();
+		pipelineBlurCompute.destroy();
 		if (Pipeline::getDescriptorSetLayoutSSAO())
 		{
 			VulkanContext::Get()->device->destroyDescriptorSetLayout(Pipeline::getDescriptorSetLayoutSSAO());
@@ -213,6 +446,16 @@ namespace pe
 			VulkanContext::Get()->device->destroyDescriptorSetLayout(Pipeline::getDescriptorSetLayoutSSAOBlur());
 			Pipeline::getDescriptorSetLayoutSSAOBlur() = nullptr;
 		}
+		if (Pipeline::getDescriptorSetLayoutSSAOCompute())
+		{
+			VulkanContext::Get()->device->destroyDescriptorSetLayout(Pipeline::getDescriptorSetLayoutSSAOCompute());
+			Pipeline::getDescriptorSetLayoutSSAOCompute() = nullptr;
+		}
+		if (Pipeline::getDescriptorSetLayoutSSAOBlurCompute())
+		{
+			VulkanContext::Get()->device->destroyDescriptorSetLayout(Pipeline::getDescriptorSetLayoutSSAOBlurCompute());
+			Pipeline::getDescriptorSetLayoutSSAOBlurCompute() = nullptr;
+		}
 	}
 	
 	void SSAO::update(Camera& camera)
@@ -222,8 +465,10 @@ namespace pe
 			pvm[0] = camera.projection;
 			pvm[1] = camera.view;
 			pvm[2] = camera.invProjection;
+			const vec2 scale = DynamicResolution::UVScale();
+			renderScale = vec4(scale.x, scale.y, 0.f, 0.f);
 			
-			Queue::memcpyRequest(&UB_PVM, {{&pvm, sizeof(pvm), 0}});
+			Queue::memcpyRequest(&UB_PVM, {{&pvm, sizeof(pvm), 0}, {&renderScale, sizeof(renderScale), sizeof(pvm)}});
 			//UB_PVM.map();
 			//memcpy(UB_PVM.data, pvm, sizeof(pvm));
 			//UB_PVM.flush();
@@ -273,6 +518,7 @@ namespace pe
 	{
 		createPipeline(renderTargets);
 		createBlurPipeline(renderTargets);
+		createComputePipelines(renderTargets);
 	}
 	
 	void SSAO::createPipeline(std::map<std::string, Image>& renderTargets)
@@ -282,8 +528,6 @@ namespace pe
 		
 		pipeline.info.pVertShader = &vert;
 		pipeline.info.pFragShader = &frag;
-		pipeline.info.width = renderTargets["ssao"].width_f;
-		pipeline.info.height = renderTargets["ssao"].height_f;
 		pipeline.info.cullMode = CullMode::Back;
 		pipeline.info.colorBlendAttachments = make_ref(
 				std::vector<vk::PipelineColorBlendAttachmentState> {*renderTargets["ssao"].blentAttachment}
@@ -303,12 +547,12 @@ namespace pe
 		
 		pipelineBlur.info.pVertShader = &vert;
 		pipelineBlur.info.pFragShader = &frag;
-		pipelineBlur.info.width = renderTargets["ssaoBlur"].width_f;
-		pipelineBlur.info.height = renderTargets["ssaoBlur"].height_f;
 		pipelineBlur.info.cullMode = CullMode::Back;
 		pipelineBlur.info.colorBlendAttachments = make_ref(
 				std::vector<vk::PipelineColorBlendAttachmentState> {*renderTargets["ssaoBlur"].blentAttachment}
 		);
+		pipelineBlur.info.pushConstantStage = PushConstantStage::Fragment;
+		pipelineBlur.info.pushConstantSize = sizeof(vec4);
 		pipelineBlur.info.descriptorSetLayouts = make_ref(
 				std::vector<vk::DescriptorSetLayout> {Pipeline::getDescriptorSetLayoutSSAOBlur()}
 		);
@@ -316,4 +560,26 @@ namespace pe
 		
 		pipelineBlur.createGraphicsPipeline();
 	}
+	
+	void SSAO::createComputePipelines(std::map<std::string, Image>& renderTargets)
+	{
+		if (!ComputeSupported())
+			return;
+		
+		Shader comp {"Shaders/SSAO/ssao.comp", ShaderType::Compute, true};
+		pipelineCompute.info.pCompShader = &comp;
+		pipelineCompute.info.descriptorSetLayouts = make_ref(
+				std::vector<vk::DescriptorSetLayout> {Pipeline::getDescriptorSetLayoutSSAOCompute()}
+		);
+		pipelineCompute.createComputePipeline();
+		
+		Shader compBlur {"Shaders/SSAO/ssaoBlur.comp", ShaderType::Compute, true};
+		pipelineBlurCompute.info.pCompShader = &compBlur;
+		pipelineBlurCompute.info.pushConstantStage = PushConstantStage::Compute;
+		pipelineBlurCompute.info.pushConstantSize = sizeof(vec4);
+		pipelineBlurCompute.info.descriptorSetLayouts = make_ref(
+				std::vector<vk::DescriptorSetLayout> {Pipeline::getDescriptorSetLayoutSSAOBlurCompute()}
+		);
+		pipelineBlurCompute.createComputePipeline();
+	}
 }
@@ -48,6 +48,7 @@ namespace pe
 		~SSAO();
 		
 		mat4 pvm[3];
+		vec4 renderScale; // written after pvm in UB_PVM
 		Buffer UB_Kernel;
 		Buffer UB_PVM;
 		Image noiseTex;
@@ -56,6 +57,13 @@ namespace pe
 		Pipeline pipeline;
 		Pipeline pipelineBlur;
 		Ref<vk::DescriptorSet> DSet, DSBlur;
+		// async compute path, the noise is read from a uniform buffer since the noise image is owned by graphics
+		Buffer UB_Noise;
+		Pipeline pipelineCompute;
+		Pipeline pipelineBlurCompute;
+		Ref<vk::DescriptorSet> DSCompute, DSBlurCompute;
+		
+		static bool ComputeSupported();
 		
 		void update(Camera& camera);
 		
@@ -77,8 +85,16 @@ namespace pe
 		
 		void updateDescriptorSets(std::map<std::string, Image>& renderTargets);
 		
+		void createComputePipelines(std::map<std::string, Image>& renderTargets);
+		
 		void draw(vk::CommandBuffer cmd, uint32_t imageIndex, Image& image);
 		
+		void releaseToCompute(vk::CommandBuffer cmd, std::map<std::string, Image>& renderTargets);
+		
+		void compute(vk::CommandBuffer cmd, std::map<std::string, Image>& renderTargets);
+		
+		void acquireFromCompute(vk::CommandBuffer cmd, std::map<std::string, Image>& renderTargets);
+		
 		void destroy();
 	};
 }
\ No newline at end of file
@@ -29,6 +29,7 @@ SOFTWARE.
 #include "../Shader/Shader.h"
 #include "../Core/Queue.h"
 #include "../Renderer/RenderApi.h"
+#include "../Renderer/DynamicResolution.h"
 
 namespace pe
 {
@@ -43,7 +44,7 @@ namespace pe
 	
 	void SSR::createSSRUniforms(std::map<std::string, Image>& renderTargets)
 	{
-		UBReflection.CreateBuffer(4 * sizeof(mat4), BufferUsage::UniformBuffer, MemoryProperty::HostVisible
+		UBReflection.CreateBufferPerFrame(4 * sizeof(mat4), BufferUsage::UniformBuffer, MemoryProperty::HostVisible
 		);
 		UBReflection.Map();
 		UBReflection.Zero();
@@ -54,7 +55,7 @@ namespace pe
 		allocateInfo2.descriptorPool = *VulkanContext::Get()->descriptorPool;
 		allocateInfo2.descriptorSetCount = 1;
 		allocateInfo2.pSetLayouts = &Pipeline::getDescriptorSetLayoutSSR();
-		DSet = make_ref(VulkanContext::Get()->device->allocateDescriptorSets(allocateInfo2).at(0));
+		DSet = make_ref(VulkanContext::Get()->allocateDescriptorSet(allocateInfo2));
 		
 		updateDescriptorSets(renderTargets);
 	}
@@ -72,9 +73,9 @@ namespace pe
 		std::deque<vk::DescriptorBufferInfo> dsbi {};
 		const auto wSetBuffer = [&dsbi](const vk::DescriptorSet& dstSet, uint32_t dstBinding, Buffer& buffer)
 		{
-			dsbi.emplace_back(*buffer.GetBufferVK(), 0, buffer.Size());
+			dsbi.emplace_back(*buffer.GetBufferVK(), 0, buffer.FrameSize());
 			return vk::WriteDescriptorSet {
-					dstSet, dstBinding, 0, 1, vk::DescriptorType::eUniformBuffer, nullptr, &dsbi.back(), nullptr
+					dstSet, dstBinding, 0, 1, vk::DescriptorType::eUniformBufferDynamic, nullptr, &dsbi.back(), nullptr
 			};
 		};
 		
@@ -95,7 +96,8 @@ namespace pe
 			reflectionInput[0][0] = vec4(camera.position, 1.0f);
 			reflectionInput[0][1] = vec4(camera.front, 1.0f);
 			reflectionInput[0][2] = vec4();
-			reflectionInput[0][3] = vec4();
+			const vec2 scale = DynamicResolution::UVScale();
+			reflectionInput[0][3] = vec4(scale.x, scale.y, 0.f, 0.f);
 			reflectionInput[1] = camera.projection;
 			reflectionInput[2] = camera.view;
 			reflectionInput[3] = camera.invProjection;
@@ -125,8 +127,12 @@ namespace pe
 		renderPassInfo.pClearValues = clearValues.data();
 		
 		cmd.beginRenderPass(&renderPassInfo, vk::SubpassContents::eInline);
+		// with dynamic resolution the extent is only a part of the target
+		RenderPass::SetViewport(cmd, renderPassInfo.renderArea);
 		cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, *pipeline.handle);
-		cmd.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, *pipeline.layout, 0, *DSet, nullptr);
+		cmd.bindDescriptorSets(
+				vk::PipelineBindPoint::eGraphics, *pipeline.layout, 0, *DSet, UBReflection.FrameOffset()
+		);
 		cmd.draw(3, 1, 0, 0);
 		cmd.endRenderPass();
 	}
@@ -156,8 +162,6 @@ namespace pe
 		
 		pipeline.info.pVertShader = &vert;
 		pipeline.info.pFragShader = &frag;
-		pipeline.info.width = renderTargets["ssr"].width_f;
-		pipeline.info.height = renderTargets["ssr"].height_f;
 		pipeline.info.cullMode = CullMode::Back;
 		pipeline.info.colorBlendAttachments = make_ref(
 				std::vector<vk::PipelineColorBlendAttachmentState> {*renderTargets["ssr"].blentAttachment}
@@ -28,13 +28,15 @@ SOFTWARE.
 #include "../Shader/Shader.h"
 #include "../Core/Queue.h"
 #include "../Renderer/RenderApi.h"
+#include "../Renderer/DynamicResolution.h"
 #include <deque>
 
 namespace pe
 {
 	TAA::TAA()
 	{
-		DSet = make_ref(vk::DescriptorSet());
+		for (auto& set : DSet)
+			set = make_ref(vk::DescriptorSet());
 		DSetSharpen = make_ref(vk::DescriptorSet());
 	}
 	
@@ -56,19 +58,6 @@ namespace pe
 		previous.transitionImageLayout(vk::ImageLayout::eUndefined, vk::ImageLayout::eShaderReadOnlyOptimal);
 		previous.createImageView(vk::ImageAspectFlagBits::eColor);
 		previous.createSampler();
-		
-		frameImage.format = make_ref(VulkanContext::Get()->surface.formatKHR->format);
-		frameImage.initialLayout = make_ref(vk::ImageLayout::eUndefined);
-		frameImage.createImage(
-				static_cast<uint32_t>(WIDTH_f * GUI::renderTargetsScale),
-				static_cast<uint32_t>(HEIGHT_f * GUI::renderTargetsScale),
-				vk::ImageTiling::eOptimal,
-				vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled,
-				vk::MemoryPropertyFlagBits::eDeviceLocal
-		);
-		frameImage.transitionImageLayout(vk::ImageLayout::eUndefined, vk::ImageLayout::eShaderReadOnlyOptimal);
-		frameImage.createImageView(vk::ImageAspectFlagBits::eColor);
-		frameImage.createSampler();
 	}
 	
 	void TAA::update(const Camera& camera)
@@ -81,6 +70,8 @@ namespace pe
 					sin(static_cast<float>(ImGui::GetTime()) * 0.125f)
 			};
 			ubo.invProj = camera.invProjection;
+			const vec2 scale = DynamicResolution::UVScale();
+			ubo.renderScale = {scale.x, scale.y, 0.f, 0.f};
 			
 			Queue::memcpyRequest(&uniform, {{&ubo, sizeof(ubo), 0}});
 			//uniform.map();
@@ -92,7 +83,7 @@ namespace pe
 	
 	void TAA::createUniforms(std::map<std::string, Image>& renderTargets)
 	{
-		uniform.CreateBuffer(sizeof(UBO), BufferUsage::UniformBuffer, MemoryProperty::HostVisible);
+		uniform.CreateBufferPerFrame(sizeof(UBO), BufferUsage::UniformBuffer, MemoryProperty::HostVisible);
 		uniform.Map();
 		uniform.Zero();
 		uniform.Flush();
@@ -102,10 +93,11 @@ namespace pe
 		allocateInfo2.descriptorPool = *VulkanContext::Get()->descriptorPool;
 		allocateInfo2.descriptorSetCount = 1;
 		allocateInfo2.pSetLayouts = &Pipeline::getDescriptorSetLayoutTAA();
-		DSet = make_ref(VulkanContext::Get()->device->allocateDescriptorSets(allocateInfo2).at(0));
+		for (auto& set : DSet)
+			set = make_ref(VulkanContext::Get()->allocateDescriptorSet(allocateInfo2));
 		
 		allocateInfo2.pSetLayouts = &Pipeline::getDescriptorSetLayoutTAASharpen();
-		DSetSharpen = make_ref(VulkanContext::Get()->device->allocateDescriptorSets(allocateInfo2).at(0));
+		DSetSharpen = make_ref(VulkanContext::Get()->allocateDescriptorSet(allocateInfo2));
 		
 		updateDescriptorSets(renderTargets);
 	}
@@ -123,27 +115,34 @@ namespace pe
 		std::deque<vk::DescriptorBufferInfo> dsbi {};
 		const auto wSetBuffer = [&dsbi](const vk::DescriptorSet& dstSet, uint32_t dstBinding, Buffer& buffer)
 		{
-			dsbi.emplace_back(*buffer.GetBufferVK(), 0, buffer.Size());
+			dsbi.emplace_back(*buffer.GetBufferVK(), 0, buffer.FrameSize());
 			return vk::WriteDescriptorSet {
-					dstSet, dstBinding, 0, 1, vk::DescriptorType::eUniformBuffer, nullptr, &dsbi.back(), nullptr
+					dstSet, dstBinding, 0, 1, vk::DescriptorType::eUniformBufferDynamic, nullptr, &dsbi.back(), nullptr
 			};
 		};
 		
 		std::vector<vk::WriteDescriptorSet> writeDescriptorSets = {
-				wSetImage(*DSet, 0, previous),
-				wSetImage(*DSet, 1, frameImage),
-				wSetImage(*DSet, 2, renderTargets["depth"]),
-				wSetImage(*DSet, 3, renderTargets["velocity"]),
-				wSetBuffer(*DSet, 4, uniform),
 				wSetImage(*DSetSharpen, 0, renderTargets["taa"]),
 				wSetBuffer(*DSetSharpen, 1, uniform)
 		};
+		for (uint32_t i = 0; i < 2; i++)
+		{
+			writeDescriptorSets.push_back(wSetImage(*DSet[i], 0, previous));
+			writeDescriptorSets.push_back(wSetImage(*DSet[i], 1, renderTargets[POST_PROCESS_TARGETS[i]]));
+			writeDescriptorSets.push_back(wSetImage(*DSet[i], 2, renderTargets["depth"]));
+			writeDescriptorSets.push_back(wSetImage(*DSet[i], 3, renderTargets["velocity"]));
+			writeDescriptorSets.push_back(wSetBuffer(*DSet[i], 4, uniform));
+		}
 		
 		VulkanContext::Get()->device->updateDescriptorSets(writeDescriptorSets, nullptr);
 	}
 	
-	void TAA::draw(vk::CommandBuffer cmd, uint32_t imageIndex, std::map<std::string, Image>& renderTargets)
+	void TAA::draw(
+			vk::CommandBuffer cmd, uint32_t imageIndex, uint32_t input, std::map<std::string, Image>& renderTargets
+	)
 	{
+		const size_t output = static_cast<size_t>(1 - input) * VulkanContext::Get()->swapchain.images.size();
+		
 		vk::ClearValue clearColor;
 		memcpy(clearColor.color.float32, GUI::clearColor.data(), 4 * sizeof(float));
 		
@@ -160,8 +159,11 @@ namespace pe
 		
 		renderTargets["taa"].changeLayout(cmd, LayoutState::ColorWrite);
 		cmd.beginRenderPass(rpi, vk::SubpassContents::eInline);
+		RenderPass::SetViewport(cmd, rpi.renderArea);
 		cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, *pipeline.handle);
-		cmd.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, *pipeline.layout, 0, *DSet, nullptr);
+		cmd.bindDescriptorSets(
+				vk::PipelineBindPoint::eGraphics, *pipeline.layout, 0, *DSet[input], uniform.FrameOffset()
+		);
 		cmd.draw(3, 1, 0, 0);
 		cmd.endRenderPass();
 		renderTargets["taa"].changeLayout(cmd, LayoutState::ColorRead);
@@ -171,15 +173,18 @@ namespace pe
 		// TAA Sharpen pass
 		vk::RenderPassBeginInfo rpi2;
 		rpi2.renderPass = *renderPassSharpen.handle;
-		rpi2.framebuffer = *framebuffersSharpen[imageIndex].handle;
+		rpi2.framebuffer = *framebuffersSharpen[output + imageIndex].handle;
 		rpi2.renderArea.offset = vk::Offset2D {0, 0};
 		rpi2.renderArea.extent = *renderTargets["viewport"].extent;
 		rpi2.clearValueCount = 1;
 		rpi2.pClearValues = clearValues.data();
 		
 		cmd.beginRenderPass(rpi2, vk::SubpassContents::eInline);
+		RenderPass::SetViewport(cmd, rpi2.renderArea);
 		cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, *pipelineSharpen.handle);
-		cmd.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, *pipelineSharpen.layout, 0, *DSetSharpen, nullptr);
+		cmd.bindDescriptorSets(
+				vk::PipelineBindPoint::eGraphics, *pipelineSharpen.layout, 0, *DSetSharpen, uniform.FrameOffset()
+		);
 		cmd.draw(3, 1, 0, 0);
 		cmd.endRenderPass();
 	}
@@ -203,13 +208,12 @@ namespace pe
 			framebuffers[i].Create(width, height, view, renderPass);
 		}
 		
-		framebuffersSharpen.resize(vulkan->swapchain.images.size());
-		for (size_t i = 0; i < vulkan->swapchain.images.size(); ++i)
+		const size_t images = vulkan->swapchain.images.size();
+		framebuffersSharpen.resize(images * 2);
+		for (size_t i = 0; i < images * 2; ++i)
 		{
-			uint32_t width = renderTargets["viewport"].width;
-			uint32_t height = renderTargets["viewport"].height;
-			vk::ImageView view = *renderTargets["viewport"].view;
-			framebuffersSharpen[i].Create(width, height, view, renderPassSharpen);
+			Image& target = renderTargets[POST_PROCESS_TARGETS[i / images]];
+			framebuffersSharpen[i].Create(target.width, target.height, *target.view, renderPassSharpen);
 		}
 	}
 	
@@ -226,8 +230,6 @@ namespace pe
 		
 		pipeline.info.pVertShader = &vert;
 		pipeline.info.pFragShader = &frag;
-		pipeline.info.width = renderTargets["taa"].width_f;
-		pipeline.info.height = renderTargets["taa"].height_f;
 		pipeline.info.cullMode = CullMode::Back;
 		pipeline.info.colorBlendAttachments = make_ref(
 				std::vector<vk::PipelineColorBlendAttachmentState> {*renderTargets["taa"].blentAttachment}
@@ -247,8 +249,6 @@ namespace pe
 		
 		pipelineSharpen.info.pVertShader = &vert;
 		pipelineSharpen.info.pFragShader = &frag;
-		pipelineSharpen.info.width = renderTargets["viewport"].width_f;
-		pipelineSharpen.info.height = renderTargets["viewport"].height_f;
 		pipelineSharpen.info.cullMode = CullMode::Back;
 		pipelineSharpen.info.colorBlendAttachments = make_ref(
 				std::vector<vk::PipelineColorBlendAttachmentState> {*renderTargets["viewport"].blentAttachment}
@@ -332,7 +332,6 @@ namespace pe
 	{
 		uniform.Destroy();
 		previous.destroy();
-		frameImage.destroy();
 		
 		for (auto& framebuffer : framebuffers)
 			framebuffer.Destroy();
@@ -31,6 +31,7 @@ SOFTWARE.
 #include "../Renderer/Framebuffer.h"
 #include <vector>
 #include <map>
+#include <array>
 
 namespace vk
 {
@@ -51,15 +52,16 @@ namespace pe
 		std::vector<Framebuffer> framebuffers {}, framebuffersSharpen {};
 		Pipeline pipeline, pipelineSharpen;
 		RenderPass renderPass, renderPassSharpen;
-		Ref<vk::DescriptorSet> DSet, DSetSharpen;
+		std::array<Ref<vk::DescriptorSet>, 2> DSet;
+		Ref<vk::DescriptorSet> DSetSharpen;
 		Image previous;
-		Image frameImage;
 		
 		struct UBO
 		{
 			vec4 values;
 			vec4 sharpenValues;
 			mat4 invProj;
+			vec4 renderScale;
 		} ubo;
 		Buffer uniform;
 		
@@ -71,7 +73,9 @@ namespace pe
 		
 		void updateDescriptorSets(std::map<std::string, Image>& renderTargets);
 		
-		void draw(vk::CommandBuffer cmd, uint32_t imageIndex, std::map<std::string, Image>& renderTargets);
+		void draw(
+				vk::CommandBuffer cmd, uint32_t imageIndex, uint32_t input, std::map<std::string, Image>& renderTargets
+		);
 		
 		void createRenderPasses(std::map<std::string, Image>& renderTargets);
 		
@@ -0,0 +1,274 @@
+/*
+Copyright (c) 2018-2021 Christos Karamoustos
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#include "PhasmaPch.h"
+#include "AnimationCompute.h"
+#include "UploadManager.h"
+#include "../Model/Model.h"
+#include "../Model/Mesh.h"
+#include "../Shader/Shader.h"
+#include "../Core/Queue.h"
+#include "RenderApi.h"
+#include <deque>
+#include <unordered_map>
+
+namespace pe
+{
+	std::vector<NodeData> AnimationCompute::nodes {};
+	Buffer AnimationCompute::nodesBuffer {};
+	Buffer AnimationCompute::globalsBuffer {};
+	Buffer AnimationCompute::jointDataBuffer {};
+	Buffer AnimationCompute::jointsBuffer {};
+	RangeAllocator AnimationCompute::nodeAllocator {};
+	RangeAllocator AnimationCompute::jointAllocator {};
+	Pipeline AnimationCompute::pipelineNodes {};
+	Pipeline AnimationCompute::pipelineJoints {};
+	Ref<vk::DescriptorSet> AnimationCompute::descriptorSet = make_ref(vk::DescriptorSet());
+	
+	void AnimationCompute::init()
+	{
+		if (*nodesBuffer.GetBufferVK())
+			return;
+		
+		nodes.resize(ANIMATION_COMPUTE_NODES);
+		nodesBuffer.CreateBufferPerFrame(
+				sizeof(NodeData) * ANIMATION_COMPUTE_NODES, BufferUsage::StorageBuffer, MemoryProperty::HostVisible
+		);
+		globalsBuffer.CreateBufferPerFrame(
+				sizeof(mat4) * ANIMATION_COMPUTE_NODES, BufferUsage::StorageBuffer, MemoryProperty::DeviceLocal
+		);
+		jointDataBuffer.CreateBuffer(
+				sizeof(JointData) * ANIMATION_COMPUTE_JOINTS, BufferUsage::TransferDst | BufferUsage::StorageBuffer,
+				MemoryProperty::DeviceLocal
+		);
+		jointsBuffer.CreateBufferPerFrame(
+				sizeof(mat4) * ANIMATION_COMPUTE_JOINTS, BufferUsage::StorageBuffer, MemoryProperty::DeviceLocal
+		);
+		nodeAllocator.init(ANIMATION_COMPUTE_NODES);
+		jointAllocator.init(ANIMATION_COMPUTE_JOINTS);
+		
+		vk::DescriptorSetAllocateInfo allocateInfo;
+		allocateInfo.descriptorPool = *VulkanContext::Get()->descriptorPool;
+		allocateInfo.descriptorSetCount = 1;
+		allocateInfo.pSetLayouts = &Pipeline::getDescriptorSetLayoutAnimation();
+		descriptorSet = make_ref(VulkanContext::Get()->allocateDescriptorSet(allocateInfo));
+		
+		std::deque<vk::DescriptorBufferInfo> dsbi {};
+		auto const wSetBuffer = [&dsbi](uint32_t dstBinding, Buffer& buffer, vk::DescriptorType type)
+		{
+			dsbi.emplace_back(*buffer.GetBufferVK(), 0, buffer.FrameSize());
+			return vk::WriteDescriptorSet {*descriptorSet, dstBinding, 0, 1, type, nullptr, &dsbi.back(), nullptr};
+		};
+		std::vector<vk::WriteDescriptorSet> writeSets {
+				wSetBuffer(0, nodesBuffer, vk::DescriptorType::eStorageBufferDynamic),
+				wSetBuffer(1, globalsBuffer, vk::DescriptorType::eStorageBufferDynamic),
+				wSetBuffer(2, jointDataBuffer, vk::DescriptorType::eStorageBuffer),
+				wSetBuffer(3, jointsBuffer, vk::DescriptorType::eStorageBufferDynamic)
+		};
+		VulkanContext::Get()->device->updateDescriptorSets(writeSets, nullptr);
+		
+		createPipelines();
+	}
+	
+	void AnimationCompute::addModel(Model& model)
+	{
+		// only the skinned models need their nodes on the gpu
+		uint32_t jointsCount = 0;
+		for (auto& node : model.linearNodes)
+		{
+			if (node->mesh && node->skin)
+				jointsCount += static_cast<uint32_t>(node->skin->joints.size());
+		}
+		if (jointsCount == 0)
+			return;
+		
+		const uint32_t nodesCount = static_cast<uint32_t>(model.linearNodes.size());
+		size_t nodesOffset, jointsOffset;
+		{
+			std::lock_guard<std::mutex> guard(m_mutex);
+			
+			if (!nodeAllocator.allocate(nodesCount, nodesOffset))
+				throw std::runtime_error("Animation compute is out of node space");
+			if (!jointAllocator.allocate(jointsCount, jointsOffset))
+			{
+				nodeAllocator.free(nodesOffset, nodesCount);
+				throw std::runtime_error("Animation compute is out of joint space");
+			}
+			m_nodesEnd = std::max(m_nodesEnd, static_cast<uint32_t>(nodesOffset) + nodesCount);
+		}
+		model.nodesRange = {static_cast<uint32_t>(nodesOffset), nodesCount};
+		model.jointsRange = {static_cast<uint32_t>(jointsOffset), jointsCount};
+		
+		std::unordered_map<const Node*, uint32_t> nodeIndices;
+		for (uint32_t i = 0; i < nodesCount; i++)
+			nodeIndices[model.linearNodes[i]] = model.nodesRange.offset + i;
+		
+		for (uint32_t i = 0; i < nodesCount; i++)
+		{
+			const Node* node = model.linearNodes[i];
+			NodeData& data = nodes[model.nodesRange.offset + i];
+			data.localMatrix = node->localMatrix();
+			data.parent = node->parent ? static_cast<int32_t>(nodeIndices[node->parent]) : -1;
+		}
+		
+		// the joint descriptions do not change, they are uploaded once
+		std::vector<JointData> joints;
+		joints.reserve(jointsCount);
+		for (auto& node : model.linearNodes)
+		{
+			if (!node->mesh || !node->skin)
+				continue;
+			
+			Skin* skin = node->skin;
+			node->mesh->ubo.jointOffset = model.jointsRange.offset + static_cast<uint32_t>(joints.size());
+			node->mesh->ubo.jointCount = static_cast<uint32_t>(skin->joints.size());
+			for (size_t i = 0; i < skin->joints.size(); i++)
+			{
+				JointData joint {};
+				joint.inverseBindMatrix = i < skin->inverseBindMatrices.size() ?
+				                          skin->inverseBindMatrices[i] : mat4::identity();
+				joint.node = nodeIndices[skin->joints[i]];
+				joint.meshNode = nodeIndices[node];
+				joints.push_back(joint);
+			}
+		}
+		UploadManager::uploadBuffer(
+				jointDataBuffer, model.jointsRange.offset * sizeof(JointData), joints.data(),
+				joints.size() * sizeof(JointData)
+		);
+	}
+	
+	void AnimationCompute::removeModel(Model& model)
+	{
+		std::lock_guard<std::mutex> guard(m_mutex);
+		nodeAllocator.free(model.nodesRange.offset, model.nodesRange.count);
+		jointAllocator.free(model.jointsRange.offset, model.jointsRange.count);
+		model.nodesRange = {};
+		model.jointsRange = {};
+	}
+	
+	void AnimationCompute::updateNodes(const Model& model)
+	{
+		for (uint32_t i = 0; i < model.nodesRange.count; i++)
+			nodes[model.nodesRange.offset + i].localMatrix = model.linearNodes[i]->localMatrix();
+	}
+	
+	void AnimationCompute::update()
+	{
+		std::lock_guard<std::mutex> guard(m_mutex);
+		if (m_nodesEnd > 0)
+			Queue::memcpyRequest(&nodesBuffer, {{nodes.data(), m_nodesEnd * sizeof(NodeData), 0}});
+	}
+	
+	void AnimationCompute::dispatch(vk::CommandBuffer cmd)
+	{
+		const auto dispatchRanges = [&](Pipeline& pipeline, bool joints)
+		{
+			bool bound = false;
+			for (auto& model : Model::models)
+			{
+				const GeometryRange& range = joints ? model.jointsRange : model.nodesRange;
+				if (!model.updatesNodes || range.count == 0)
+					continue;
+				
+				if (!bound)
+				{
+					cmd.bindPipeline(vk::PipelineBindPoint::eCompute, *pipeline.handle);
+					cmd.bindDescriptorSets(
+							vk::PipelineBindPoint::eCompute, *pipeline.layout, 0, *descriptorSet, {
+									nodesBuffer.FrameOffset(), globalsBuffer.FrameOffset(), jointsBuffer.FrameOffset()
+							}
+					);
+					bound = true;
+				}
+				const uint32_t values[2] {range.offset, range.count};
+				cmd.pushConstants(*pipeline.layout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(values), values);
+				cmd.dispatch((range.count + 63) / 64, 1, 1);
+			}
+			return bound;
+		};
+		
+		if (!dispatchRanges(pipelineNodes, false))
+			return;
+		
+		// the joints read the global matrices of any node of their model
+		vk::MemoryBarrier barrier;
+		barrier.srcAccessMask = vk::AccessFlagBits::eShaderWrite;
+		barrier.dstAccessMask = vk::AccessFlagBits::eShaderRead;
+		cmd.pipelineBarrier(
+				vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eComputeShader,
+				vk::DependencyFlags(), barrier, nullptr, nullptr
+		);
+		
+		dispatchRanges(pipelineJoints, true);
+		
+		// the g-buffer and the shadow passes, submitted later on the same queue, skin with the joint matrices
+		cmd.pipelineBarrier(
+				vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eVertexShader,
+				vk::DependencyFlags(), barrier, nullptr, nullptr
+		);
+	}
+	
+	void AnimationCompute::createPipelines()
+	{
+		pipelineNodes.destroy();
+		pipelineJoints.destroy();
+		
+		Shader nodesShader {"Shaders/Compute/nodes.comp", ShaderType::Compute, true};
+		Shader jointsShader {"Shaders/Compute/animations.comp", ShaderType::Compute, true};
+		
+		pipelineNodes.info.pCompShader = &nodesShader;
+		pipelineNodes.info.pushConstantStage = PushConstantStage::Compute;
+		pipelineNodes.info.pushConstantSize = 2 * sizeof(uint32_t);
+		pipelineNodes.info.descriptorSetLayouts = make_ref(
+				std::vector<vk::DescriptorSetLayout> {Pipeline::getDescriptorSetLayoutAnimation()}
+		);
+		pipelineNodes.createComputePipeline();
+		
+		pipelineJoints.info.pCompShader = &jointsShader;
+		pipelineJoints.info.pushConstantStage = PushConstantStage::Compute;
+		pipelineJoints.info.pushConstantSize = 2 * sizeof(uint32_t);
+		pipelineJoints.info.descriptorSetLayouts = make_ref(
+				std::vector<vk::DescriptorSetLayout> {Pipeline::getDescriptorSetLayoutAnimation()}
+		);
+		pipelineJoints.createComputePipeline();
+	}
+	
+	void AnimationCompute::destroy()
+	{
+		pipelineNodes.destroy();
+		pipelineJoints.destroy();
+		nodesBuffer.Destroy();
+		globalsBuffer.Destroy();
+		jointDataBuffer.Destroy();
+		jointsBuffer.Destroy();
+		nodes.clear();
+		m_nodesEnd = 0;
+		
+		if (Pipeline::getDescriptorSetLayoutAnimation())
+		{
+			VulkanContext::Get()->device->destroyDescriptorSetLayout(Pipeline::getDescriptorSetLayoutAnimation());
+			Pipeline::getDescriptorSetLayoutAnimation() = nullptr;
+		}
+	}
+}
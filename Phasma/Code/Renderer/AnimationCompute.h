@@ -0,0 +1,100 @@
+/*
+Copyright (c) 2018-2021 Christos Karamoustos
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#pragma once
+
+#include "Buffer.h"
+#include "Pipeline.h"
+#include "GeometryArena.h"
+#include <mutex>
+
+constexpr auto ANIMATION_COMPUTE_NODES = 16u * 1024u;
+constexpr auto ANIMATION_COMPUTE_JOINTS = 16u * 1024u;
+
+namespace vk
+{
+	class CommandBuffer;
+	
+	class DescriptorSet;
+}
+
+namespace pe
+{
+	class Model;
+	
+	// local matrix of a node and the index of its parent in the nodes buffer, -1 for the roots
+	struct NodeData
+	{
+		mat4 localMatrix;
+		int32_t parent;
+		uint32_t dummy[3];
+	};
+	
+	// a joint of a skinned mesh, the node that moves it and the node of the mesh it deforms
+	struct JointData
+	{
+		mat4 inverseBindMatrix;
+		uint32_t node;
+		uint32_t meshNode;
+		uint32_t dummy[2];
+	};
+	
+	// The nodes and joints of the skinned models are evaluated on the gpu.
+	// Each model gets a range of nodes and joints, the local matrices are uploaded every frame,
+	// nodes.comp computes the global matrices and animations.comp the joint matrices,
+	// which the vertex shaders read at the joint offset of their mesh
+	class AnimationCompute
+	{
+	public:
+		static void init();
+		
+		static void addModel(Model& model);
+		
+		static void removeModel(Model& model);
+		
+		static void updateNodes(const Model& model);
+		
+		static void update();
+		
+		static void dispatch(vk::CommandBuffer cmd);
+		
+		static void createPipelines();
+		
+		static void destroy();
+		
+		static std::vector<NodeData> nodes;
+		static Buffer nodesBuffer;
+		static Buffer globalsBuffer;
+		static Buffer jointDataBuffer;
+		static Buffer jointsBuffer;
+		static RangeAllocator nodeAllocator;
+		static RangeAllocator jointAllocator;
+		static Pipeline pipelineNodes;
+		static Pipeline pipelineJoints;
+		static Ref<vk::DescriptorSet> descriptorSet;
+	
+	private:
+		static inline std::mutex m_mutex {};
+		static inline uint32_t m_nodesEnd = 0;
+	};
+}
@@ -23,6 +23,7 @@ SOFTWARE.
 #include "Buffer.h"
 #include "RenderApi.h"
 #include "Vulkan/BufferVK.h"
+#include "Null/BufferNull.h"
 //#include "Dx12/BufferDX.h"
 
 namespace pe
@@ -33,6 +34,10 @@ namespace pe
 		{
 			m_bufferVK = make_ref(BufferVK());
 		}
+		else if DYNAMIC_CONSTEXPR (PE_NULL)
+		{
+			m_bufferNull = make_ref(BufferNull());
+		}
 		else //if (PE_DX12)
 		{
 		
@@ -41,22 +46,45 @@ namespace pe
 	
 	void Buffer::CreateBuffer(size_t size, BufferUsageFlags usage, MemoryPropertyFlags properties)
 	{
+		m_frameSize = 0;
 		if DYNAMIC_CONSTEXPR (PE_VULKAN)
 		{
 			m_bufferVK->CreateBuffer(size, usage, properties);
 		}
+		else if DYNAMIC_CONSTEXPR (PE_NULL)
+		{
+			m_bufferNull->CreateBuffer(size, usage, properties);
+		}
 		else //if (PE_DX12)
 		{
 		
 		}
 	}
 	
+	void Buffer::CreateBufferPerFrame(size_t size, BufferUsageFlags usage, MemoryPropertyFlags properties)
+	{
+		size_t alignment = 256;
+		if DYNAMIC_CONSTEXPR (PE_VULKAN)
+		{
+			const auto& limits = VulkanContext::Get()->gpuProperties->limits;
+			alignment = std::max(limits.minUniformBufferOffsetAlignment, limits.minStorageBufferOffsetAlignment);
+		}
+		const size_t frameSize = (size + alignment - 1) & ~(alignment - 1);
+		
+		CreateBuffer(frameSize * MAX_FRAMES_IN_FLIGHT, usage, properties);
+		m_frameSize = frameSize;
+	}
+	
 	void Buffer::Map(size_t mapSize, size_t offset)
 	{
 		if DYNAMIC_CONSTEXPR (PE_VULKAN)
 		{
 			m_bufferVK->Map(mapSize, offset);
 		}
+		else if DYNAMIC_CONSTEXPR (PE_NULL)
+		{
+			m_bufferNull->Map(mapSize, offset);
+		}
 		else //if (PE_DX12)
 		{
 		
@@ -69,6 +97,10 @@ namespace pe
 		{
 			m_bufferVK->Unmap();
 		}
+		else if DYNAMIC_CONSTEXPR (PE_NULL)
+		{
+			m_bufferNull->Unmap();
+		}
 		else //if (PE_DX12)
 		{
 		
@@ -81,6 +113,10 @@ namespace pe
 		{
 			m_bufferVK->Zero();
 		}
+		else if DYNAMIC_CONSTEXPR (PE_NULL)
+		{
+			m_bufferNull->Zero();
+		}
 		else //if (PE_DX12)
 		{
 		
@@ -93,6 +129,10 @@ namespace pe
 		{
 			m_bufferVK->CopyData(srcData, srcSize, offset);
 		}
+		else if DYNAMIC_CONSTEXPR (PE_NULL)
+		{
+			m_bufferNull->CopyData(srcData, srcSize, offset);
+		}
 		else //if (PE_DX12)
 		{
 		
@@ -105,6 +145,10 @@ namespace pe
 		{
 			m_bufferVK->CopyBuffer(*srcBuffer->m_bufferVK->buffer, srcSize);
 		}
+		else if DYNAMIC_CONSTEXPR (PE_NULL)
+		{
+			m_bufferNull->CopyBuffer(*srcBuffer->m_bufferNull, srcSize);
+		}
 		else //if (PE_DX12)
 		{
 		
@@ -117,6 +161,10 @@ namespace pe
 		{
 			m_bufferVK->Flush(offset, flushSize);
 		}
+		else if DYNAMIC_CONSTEXPR (PE_NULL)
+		{
+			m_bufferNull->Flush(offset, flushSize);
+		}
 		else //if (PE_DX12)
 		{
 		
@@ -129,6 +177,10 @@ namespace pe
 		{
 			m_bufferVK->Destroy();
 		}
+		else if DYNAMIC_CONSTEXPR (PE_NULL)
+		{
+			m_bufferNull->Destroy();
+		}
 		else //if (PE_DX12)
 		{
 		
@@ -141,6 +193,10 @@ namespace pe
 		{
 			return m_bufferVK->size;
 		}
+		else if DYNAMIC_CONSTEXPR (PE_NULL)
+		{
+			return m_bufferNull->size;
+		}
 		else //if (PE_DX12)
 		{
 			return 0;
@@ -153,18 +209,37 @@ namespace pe
 		{
 			return m_bufferVK->sizeRequested;
 		}
+		else if DYNAMIC_CONSTEXPR (PE_NULL)
+		{
+			return m_bufferNull->sizeRequested;
+		}
 		else //if (PE_DX12)
 		{
 			return 0;
 		}
 	}
 	
+	size_t Buffer::FrameSize()
+	{
+		return m_frameSize ? m_frameSize : Size();
+	}
+	
+	uint32_t Buffer::FrameOffset()
+	{
+		const uint32_t frameIndex = PE_NULL ? NullContext::Get()->frameIndex : VulkanContext::Get()->frameIndex;
+		return static_cast<uint32_t>(m_frameSize * frameIndex);
+	}
+	
 	void* Buffer::Data()
 	{
 		if DYNAMIC_CONSTEXPR (PE_VULKAN)
 		{
 			return m_bufferVK->data;
 		}
+		else if DYNAMIC_CONSTEXPR (PE_NULL)
+		{
+			return m_bufferNull->data;
+		}
 		else //if (PE_DX12)
 		{
 			return nullptr;
@@ -174,6 +249,6 @@ namespace pe
 	// TEMPORARY
 	Ref<vk::Buffer> Buffer::GetBufferVK()
 	{
-		return m_bufferVK->buffer;
+		return m_bufferVK ? m_bufferVK->buffer : nullptr;
 	}
 }
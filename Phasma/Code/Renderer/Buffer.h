@@ -36,6 +36,8 @@ namespace pe
 	class BufferVK;
 	class BufferDX;
 	
+	class BufferNull;
+	
 	class Buffer
 	{
 	public:
@@ -43,6 +45,9 @@ namespace pe
 		
 		void CreateBuffer(size_t size, BufferUsageFlags usage, MemoryPropertyFlags properties);
 		
+		// One slice of the size for each frame in flight, bound with the slice's offset
+		void CreateBufferPerFrame(size_t size, BufferUsageFlags usage, MemoryPropertyFlags properties);
+		
 		void Map(size_t mapSize = 0, size_t offset = 0);
 		
 		void Unmap();
@@ -61,6 +66,12 @@ namespace pe
 		
 		size_t SizeRequested();
 		
+		// The size of a frame's slice, or the whole size if the buffer is not per frame
+		size_t FrameSize();
+		
+		// The offset of the current frame's slice, or 0 if the buffer is not per frame
+		uint32_t FrameOffset();
+		
 		void* Data();
 		
 		// TEMPORARY
@@ -69,5 +80,7 @@ namespace pe
 	private:
 		Ref<BufferVK> m_bufferVK;
 		Ref<BufferDX> m_bufferDX;
+		Ref<BufferNull> m_bufferNull;
+		size_t m_frameSize = 0;
 	};
 }
\ No newline at end of file
@@ -97,7 +97,7 @@ namespace pe
 		allocInfo.descriptorPool = *VulkanContext::Get()->descriptorPool;
 		allocInfo.descriptorSetCount = 1;
 		allocInfo.pSetLayouts = &Pipeline::getDescriptorSetLayoutCompute();
-		DSCompute = make_ref(VulkanContext::Get()->device->allocateDescriptorSets(allocInfo).at(0));
+		DSCompute = make_ref(VulkanContext::Get()->allocateDescriptorSet(allocInfo));
 	}
 	
 	void Compute::updateDescriptorSet()
@@ -33,6 +33,8 @@ SOFTWARE.
 #include <deque>
 #include "../Shader/Reflection.h"
 #include "RenderApi.h"
+#include "UploadManager.h"
+#include "DynamicResolution.h"
 #include "../Core/Path.h"
 
 namespace pe
@@ -68,6 +70,10 @@ namespace pe
 		rpi.pClearValues = clearValues.data();
 		
 		cmd.beginRenderPass(rpi, vk::SubpassContents::eInline);
+		// with dynamic resolution the extent is only a part of the targets
+		RenderPass::SetViewport(cmd, rpi.renderArea);
+		
+		GeometryArena::bind(cmd);
 		
 		*Model::commandBuffer = cmd;
 		Model::pipeline = &pipeline;
@@ -82,7 +88,7 @@ namespace pe
 	
 	void Deferred::createDeferredUniforms(std::map<std::string, Image>& renderTargets, LightUniforms& lightUniforms)
 	{
-		uniform.CreateBuffer(sizeof(ubo), BufferUsage::UniformBuffer, MemoryProperty::HostVisible);
+		uniform.CreateBufferPerFrame(sizeof(ubo), BufferUsage::UniformBuffer, MemoryProperty::HostVisible);
 		uniform.Map();
 		uniform.Zero();
 		uniform.Flush();
@@ -95,7 +101,7 @@ namespace pe
 						1,                                        //uint32_t descriptorSetCount;
 						&Pipeline::getDescriptorSetLayoutComposition() //const DescriptorSetLayout* pSetLayouts;
 				};
-		DSComposition = make_ref(vulkan->device->allocateDescriptorSets(allocInfo).at(0));
+		DSComposition = make_ref(vulkan->allocateDescriptorSet(allocInfo));
 		
 		// Check if ibl_brdf_lut is already loaded
 		const std::string path = Path::Assets + "Objects/ibl_brdf_lut.png";
@@ -113,18 +119,6 @@ namespace pe
 				throw std::runtime_error("No pixel data loaded");
 			const vk::DeviceSize imageSize = texWidth * texHeight * STBI_rgb_alpha;
 			
-			vulkan->graphicsQueue->waitIdle();
-			vulkan->waitAndLockSubmits();
-			
-			Buffer staging;
-			staging.CreateBuffer(imageSize, BufferUsage::TransferSrc, MemoryProperty::HostVisible);
-			staging.Map();
-			staging.CopyData(pixels);
-			staging.Flush();
-			staging.Unmap();
-			
-			stbi_image_free(pixels);
-			
 			ibl_brdf_lut.format = make_ref(vk::Format::eR8G8B8A8Unorm);
 			ibl_brdf_lut.mipLevels =
 					static_cast<uint32_t>(std::floor(std::log2(texWidth > texHeight ? texWidth : texHeight))) + 1;
@@ -133,17 +127,19 @@ namespace pe
 					vk::ImageUsageFlagBits::eTransferSrc | vk::ImageUsageFlagBits::eTransferDst |
 					vk::ImageUsageFlagBits::eSampled, vk::MemoryPropertyFlagBits::eDeviceLocal
 			);
-			ibl_brdf_lut.transitionImageLayout(vk::ImageLayout::ePreinitialized, vk::ImageLayout::eTransferDstOptimal);
-			ibl_brdf_lut.copyBufferToImage(*staging.GetBufferVK());
-			ibl_brdf_lut.generateMipMaps();
-			ibl_brdf_lut.createImageView(vk::ImageAspectFlagBits::eColor);
-			ibl_brdf_lut.maxLod = static_cast<float>(ibl_brdf_lut.mipLevels);
-			ibl_brdf_lut.createSampler();
+			UploadManager::uploadImage(ibl_brdf_lut, pixels, imageSize);
+			const uint64_t uploadValue = UploadManager::flush();
 			
-			staging.Destroy();
+			stbi_image_free(pixels);
 			
+			vulkan->waitAndLockSubmits();
+			ibl_brdf_lut.generateMipMaps(uploadValue);
 			vulkan->unlockSubmits();
 			
+			ibl_brdf_lut.createImageView(vk::ImageAspectFlagBits::eColor);
+			ibl_brdf_lut.maxLod = static_cast<float>(ibl_brdf_lut.mipLevels);
+			ibl_brdf_lut.createSampler();
+			
 			Mesh::uniqueTextures[path] = ibl_brdf_lut;
 		}
 		
@@ -152,6 +148,8 @@ namespace pe
 	
 	void Deferred::updateDescriptorSets(std::map<std::string, Image>& renderTargets, LightUniforms& lightUniforms)
 	{
+		lights = &lightUniforms;
+		
 		std::deque<vk::DescriptorImageInfo> dsii {};
 		auto const wSetImage = [&dsii](const vk::DescriptorSet& dstSet, uint32_t dstBinding, Image& image)
 		{
@@ -161,12 +159,13 @@ namespace pe
 			};
 		};
 		std::deque<vk::DescriptorBufferInfo> dsbi {};
-		auto const wSetBuffer = [&dsbi](const vk::DescriptorSet& dstSet, uint32_t dstBinding, Buffer& buffer)
+		auto const wSetBuffer = [&dsbi](
+				const vk::DescriptorSet& dstSet, uint32_t dstBinding, Buffer& buffer,
+				vk::DescriptorType type = vk::DescriptorType::eUniformBufferDynamic
+		)
 		{
-			dsbi.emplace_back(*buffer.GetBufferVK(), 0, buffer.Size());
-			return vk::WriteDescriptorSet {
-					dstSet, dstBinding, 0, 1, vk::DescriptorType::eUniformBuffer, nullptr, &dsbi.back(), nullptr
-			};
+			dsbi.emplace_back(*buffer.GetBufferVK(), 0, buffer.FrameSize());
+			return vk::WriteDescriptorSet {dstSet, dstBinding, 0, 1, type, nullptr, &dsbi.back(), nullptr};
 		};
 		
 		std::vector<vk::WriteDescriptorSet> writeDescriptorSets = {
@@ -179,7 +178,10 @@ namespace pe
 				wSetImage(*DSComposition, 6, renderTargets["ssr"]),
 				wSetImage(*DSComposition, 7, renderTargets["emissive"]),
 				wSetImage(*DSComposition, 8, ibl_brdf_lut),
-				wSetBuffer(*DSComposition, 9, uniform)
+				wSetBuffer(*DSComposition, 9, uniform),
+				wSetBuffer(*DSComposition, 10, lightUniforms.lightsBuffer, vk::DescriptorType::eStorageBufferDynamic),
+				wSetBuffer(*DSComposition, 11, lightUniforms.clustersBuffer, vk::DescriptorType::eStorageBufferDynamic),
+				wSetBuffer(*DSComposition, 12, lightUniforms.indicesBuffer, vk::DescriptorType::eStorageBufferDynamic)
 		};
 		
 		VulkanContext::Get()->device->updateDescriptorSets(writeDescriptorSets, nullptr);
@@ -203,6 +205,8 @@ namespace pe
 		ubo.screenSpace[7] = {
 				GUI::fog_ground_thickness, static_cast<float>(GUI::use_fog), static_cast<float>(GUI::shadow_cast), 0.0f
 		};
+		const vec2 renderScale = DynamicResolution::UVScale();
+		ubo.screenSpace[8] = {renderScale.x, renderScale.y, 0.0f, 0.0f};
 		
 		Queue::memcpyRequest(&uniform, {{&ubo, sizeof(ubo), 0}});
 		//uniform.map();
@@ -229,13 +233,20 @@ namespace pe
 		rpi.clearValueCount = static_cast<uint32_t>(clearValues.size());
 		rpi.pClearValues = clearValues.data();
 		cmd.beginRenderPass(rpi, vk::SubpassContents::eInline);
+		RenderPass::SetViewport(cmd, rpi.renderArea);
 		
 		cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, *pipelineComposition.handle);
+		const std::vector<uint32_t> dynamicOffsets {
+				lights->uniform.FrameOffset(), uniform.FrameOffset(), lights->lightsBuffer.FrameOffset(),
+				lights->clustersBuffer.FrameOffset(), lights->indicesBuffer.FrameOffset(),
+				shadows.uniformBuffers[0].FrameOffset(), shadows.uniformBuffers[1].FrameOffset(),
+				shadows.uniformBuffers[2].FrameOffset()
+		};
 		cmd.bindDescriptorSets(
 				vk::PipelineBindPoint::eGraphics, *pipelineComposition.layout, 0, {
 						*DSComposition, (*shadows.descriptorSets)[0], (*shadows.descriptorSets)[1],
 						(*shadows.descriptorSets)[2], *skybox.descriptorSet
-				}, nullptr
+				}, dynamicOffsets
 		);
 		cmd.draw(3, 1, 0, 0);
 		cmd.endRenderPass();
@@ -307,15 +318,18 @@ namespace pe
 	
 	void Deferred::createGBufferPipeline(std::map<std::string, Image>& renderTargets)
 	{
-		Shader vert {"Shaders/Deferred/gBuffer.vert", ShaderType::Vertex, true};
-		Shader frag {"Shaders/Deferred/gBuffer.frag", ShaderType::Fragment, true};
+		const bool bindless = BindlessMaterials::enabled();
+		std::vector<Define> defines {};
+		if (bindless)
+			defines.push_back({"BINDLESS_MATERIALS", ""});
+		
+		Shader vert {"Shaders/Deferred/gBuffer.vert", ShaderType::Vertex, true, defines};
+		Shader frag {"Shaders/Deferred/gBuffer.frag", ShaderType::Fragment, true, defines};
 		
 		pipeline.info.pVertShader = &vert;
 		pipeline.info.pFragShader = &frag;
 		pipeline.info.vertexInputBindingDescriptions = make_ref(Vertex::getBindingDescriptionGeneral());
 		pipeline.info.vertexInputAttributeDescriptions = make_ref(Vertex::getAttributeDescriptionGeneral());
-		pipeline.info.width = renderTargets["albedo"].width_f;
-		pipeline.info.height = renderTargets["albedo"].height_f;
 		pipeline.info.cullMode = CullMode::Front;
 		pipeline.info.colorBlendAttachments = make_ref(
 				std::vector<vk::PipelineColorBlendAttachmentState>
@@ -332,10 +346,18 @@ namespace pe
 				std::vector<vk::DescriptorSetLayout>
 						{
 								Pipeline::getDescriptorSetLayoutMesh(),
+								bindless ?
+								Pipeline::getDescriptorSetLayoutBindless() :
 								Pipeline::getDescriptorSetLayoutPrimitive(),
 								Pipeline::getDescriptorSetLayoutModel()
 						}
 		);
+		if (bindless)
+		{
+			// material index
+			pipeline.info.pushConstantStage = PushConstantStage::VertexAndFragment;
+			pipeline.info.pushConstantSize = sizeof(uint32_t);
+		}
 		pipeline.info.renderPass = renderPass;
 		
 		pipeline.createGraphicsPipeline();
@@ -348,8 +370,6 @@ namespace pe
 		
 		pipelineComposition.info.pVertShader = &vert;
 		pipelineComposition.info.pFragShader = &frag;
-		pipelineComposition.info.width = renderTargets["viewport"].width_f;
-		pipelineComposition.info.height = renderTargets["viewport"].height_f;
 		pipelineComposition.info.cullMode = CullMode::Back;
 		pipelineComposition.info.colorBlendAttachments = make_ref(
 				std::vector<vk::PipelineColorBlendAttachmentState> {
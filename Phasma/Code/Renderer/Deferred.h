@@ -56,9 +56,11 @@ namespace pe
 		
 		struct UBO
 		{
-			vec4 screenSpace[8];
+			vec4 screenSpace[9];
 		} ubo;
 		Buffer uniform;
+		// the lights buffer written in the composition set, for its frame offset
+		LightUniforms* lights = nullptr;
 		
 		void batchStart(vk::CommandBuffer cmd, uint32_t imageIndex, const vk::Extent2D& extent);
 		
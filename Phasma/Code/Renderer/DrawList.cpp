@@ -0,0 +1,324 @@
+/*
+Copyright (c) 2018-2021 Christos Karamoustos
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "PhasmaPch.h"
+#include "DrawList.h"
+#include "Pipeline.h"
+#include "RendererEnums.h"
+#include "../GUI/GUI.h"
+#include "../Model/Model.h"
+#include "../Model/Mesh.h"
+#include "AnimationCompute.h"
+#include "../Camera/Camera.h"
+#include "Null/Null.h"
+#include "../Core/Profiler.h"
+
+namespace pe
+{
+	uint16_t RenderQueueFromAlphaMode(uint16_t alphaMode)
+	{
+		switch (alphaMode)
+		{
+			case Microsoft::glTF::ALPHA_BLEND:
+				return static_cast<uint16_t>(RenderQueue::AlphaBlend);
+			case Microsoft::glTF::ALPHA_MASK:
+				return static_cast<uint16_t>(RenderQueue::AlphaCut);
+			default:
+				return static_cast<uint16_t>(RenderQueue::Opaque);
+		}
+	}
+	
+	uint64_t DrawList::makeKey(uint16_t renderQueue, uint32_t pipeline, uint32_t material, uint32_t geometry, float depth)
+	{
+		// positive floats keep their order when their bits are compared as integers
+		uint32_t depthBits;
+		memcpy(&depthBits, &depth, sizeof(float));
+		
+		uint64_t key = static_cast<uint64_t>(renderQueue & 0x3) << 62;
+		if (renderQueue == static_cast<uint16_t>(RenderQueue::AlphaBlend))
+		{
+			key |= static_cast<uint64_t>(~depthBits) << 30;
+			key |= static_cast<uint64_t>(pipeline & 0x3F) << 24;
+			key |= static_cast<uint64_t>(material & 0xFFFFF) << 4;
+			key |= static_cast<uint64_t>(geometry & 0xF);
+		}
+		else
+		{
+			key |= static_cast<uint64_t>(pipeline & 0x3F) << 56;
+			key |= static_cast<uint64_t>(material & 0xFFFFF) << 36;
+			key |= static_cast<uint64_t>(geometry & 0xF) << 32;
+			key |= static_cast<uint64_t>(depthBits);
+		}
+		return key;
+	}
+	
+	void DrawList::build(const Camera& camera)
+	{
+		PE_PROFILE_SCOPE("DrawList::build");
+		
+		items.clear();
+		
+		const bool bindless = BindlessMaterials::enabled();
+		for (auto& model : Model::models)
+		{
+			if (!model.updatesNodes || model.instances->visibleCount == 0)
+				continue;
+			
+			for (auto& node : model.linearNodes)
+			{
+				if (!node->mesh)
+					continue;
+				
+				cmat4 trans = model.transform * node->mesh->ubo.matrix;
+				for (auto& primitive : node->mesh->primitives)
+				{
+					if (!primitive.render || primitive.cull)
+						continue;
+					
+					const vec3 center = vec3(trans * vec4(vec3(primitive.boundingSphere), 1.0f));
+					const float depth = length(center - camera.position);
+					
+					// without bindless every primitive has its own material set, nothing to group,
+					// the field stays 0 so the opaque queue still sorts front to back
+					const uint32_t material = bindless ? primitive.materialIndex : 0;
+					
+					// one pipeline and one geometry arena for now
+					const uint64_t key = makeKey(
+							RenderQueueFromAlphaMode(primitive.pbrMaterial.alphaMode), 0, material, 0, depth
+					);
+					items.push_back({key, &model, node->mesh, &primitive});
+				}
+			}
+		}
+		
+		sort();
+	}
+	
+	// LSD radix sort, 8 bits per pass, passes where all keys have the same digit are skipped
+	void DrawList::sort()
+	{
+		if (items.size() < 2)
+			return;
+		
+		sortBuffer.resize(items.size());
+		for (uint32_t shift = 0; shift < 64; shift += 8)
+		{
+			uint32_t counts[256] {};
+			for (auto& item : items)
+				counts[(item.key >> shift) & 0xFF]++;
+			
+			if (counts[(items[0].key >> shift) & 0xFF] == items.size())
+				continue;
+			
+			uint32_t offset = 0;
+			for (auto& count : counts)
+			{
+				const uint32_t c = count;
+				count = offset;
+				offset += c;
+			}
+			
+			for (auto& item : items)
+				sortBuffer[counts[(item.key >> shift) & 0xFF]++] = item;
+			
+			items.swap(sortBuffer);
+		}
+	}
+	
+	// the calls of DrawList::recordItems on a vulkan command buffer, the sets are told apart by their handles
+	class VulkanDrawCommands
+	{
+	public:
+		using Set = vk::DescriptorSet;
+		
+		VulkanDrawCommands(vk::CommandBuffer cmd, Pipeline& pipeline) : cmd(cmd), pipeline(pipeline)
+		{}
+		
+		void bindPipeline()
+		{ cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, *pipeline.handle); }
+		
+		static Set set(uint32_t index, const DrawItem& item, bool bindless)
+		{
+			switch (index)
+			{
+				case 0:
+					return *item.mesh->descriptorSet;
+				case 1:
+					return bindless ? *BindlessMaterials::descriptorSet : *item.primitive->descriptorSet;
+				default:
+					return *item.model->instances->descriptorSet;
+			}
+		}
+		
+		// the mesh and model sets are bound with the offset of this frame's slice
+		void bindSet(uint32_t index, Set set, const DrawItem& item)
+		{
+			if (index == 0)
+			{
+				const uint32_t offsets[2] {
+						item.mesh->uniformBuffer.FrameOffset(), AnimationCompute::jointsBuffer.FrameOffset()
+				};
+				cmd.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, *pipeline.layout, index, set, offsets);
+			}
+			else if (index == 1)
+				cmd.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, *pipeline.layout, index, set, nullptr);
+			else
+			{
+				const uint32_t offset = item.model->instances->storageBuffer.FrameOffset();
+				cmd.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, *pipeline.layout, index, set, offset);
+			}
+		}
+		
+		void pushMaterial(uint32_t materialIndex)
+		{
+			cmd.pushConstants<uint32_t>(
+					*pipeline.layout, vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment, 0,
+					materialIndex
+			);
+		}
+		
+		void draw(const DrawItem& item)
+		{
+			cmd.drawIndexed(
+					item.primitive->indicesSize, item.model->instances->visibleCount,
+					item.mesh->indexOffset + item.primitive->indexOffset,
+					item.mesh->vertexOffset + item.primitive->vertexOffset, 0
+			);
+		}
+	
+	private:
+		vk::CommandBuffer cmd;
+		Pipeline& pipeline;
+	};
+	
+	// the calls of DrawList::recordItems on the null api, the sets are told apart by their owners
+	// since there are no handles
+	class NullDrawCommands
+	{
+	public:
+		using Set = const void*;
+		
+		explicit NullDrawCommands(NullCommandBuffer& cmd) : cmd(cmd)
+		{}
+		
+		void bindPipeline()
+		{ cmd.bindPipeline(); }
+		
+		static Set set(uint32_t index, const DrawItem& item, bool bindless)
+		{
+			switch (index)
+			{
+				case 0:
+					return item.mesh;
+				case 1:
+					return bindless ? static_cast<Set>(&BindlessMaterials::descriptorSet) : item.primitive;
+				default:
+					return item.model->instances.get();
+			}
+		}
+		
+		void bindSet(uint32_t /*index*/, Set /*set*/, const DrawItem& /*item*/)
+		{ cmd.bindDescriptorSets(); }
+		
+		void pushMaterial(uint32_t /*materialIndex*/)
+		{ cmd.pushConstants(); }
+		
+		void draw(const DrawItem& item)
+		{ cmd.drawIndexed(item.primitive->indicesSize, item.model->instances->visibleCount); }
+	
+	private:
+		NullCommandBuffer& cmd;
+	};
+	
+	void DrawList::record(vk::CommandBuffer cmd, Pipeline& pipeline)
+	{
+		VulkanDrawCommands commands(cmd, pipeline);
+		recordItems(commands);
+	}
+	
+	void DrawList::record(NullCommandBuffer& cmd)
+	{
+		NullDrawCommands commands(cmd);
+		recordItems(commands);
+	}
+	
+	template<class Commands>
+	void DrawList::recordItems(Commands& commands)
+	{
+		PE_PROFILE_SCOPE("DrawList::record");
+		
+		const bool bindless = BindlessMaterials::enabled();
+		
+		bool pipelineBound = false;
+		typename Commands::Set boundSets[3] {};
+		uint32_t boundMaterial = UINT32_MAX;
+		uint32_t requested = 0;
+		uint32_t binds = 0;
+		
+		// the mesh, the primitive or the bindless set and the instances have one set each
+		const auto bindSet = [&](uint32_t index, const DrawItem& item)
+		{
+			requested++;
+			const auto set = Commands::set(index, item, bindless);
+			if (boundSets[index] != set)
+			{
+				commands.bindSet(index, set, item);
+				boundSets[index] = set;
+				binds++;
+			}
+		};
+		
+		for (auto& item : items)
+		{
+			// one pipeline for the whole list
+			requested++;
+			if (!pipelineBound)
+			{
+				commands.bindPipeline();
+				pipelineBound = true;
+				binds++;
+			}
+			
+			bindSet(0, item);
+			bindSet(1, item);
+			bindSet(2, item);
+			
+			if (bindless)
+			{
+				requested++;
+				if (boundMaterial != item.primitive->materialIndex)
+				{
+					commands.pushMaterial(item.primitive->materialIndex);
+					boundMaterial = item.primitive->materialIndex;
+					binds++;
+				}
+			}
+			
+			commands.draw(item);
+		}
+		
+		PE_PROFILE_COUNTER("Draw calls", items.size());
+		GUI::drawCalls = static_cast<uint32_t>(items.size());
+		GUI::bindsIssued = binds;
+		GUI::bindsSaved = requested - binds;
+	}
+}
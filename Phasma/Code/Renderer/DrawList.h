@@ -0,0 +1,82 @@
+/*
+Copyright (c) 2018-2021 Christos Karamoustos
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include "../Core/Base.h"
+#include <vector>
+
+namespace vk
+{
+	class CommandBuffer;
+}
+
+namespace pe
+{
+	class Model;
+	
+	class Mesh;
+	
+	class Primitive;
+	
+	class Pipeline;
+	
+	class Camera;
+	
+	class NullCommandBuffer;
+	
+	struct DrawItem
+	{
+		uint64_t key;
+		Model* model;
+		Mesh* mesh;
+		Primitive* primitive;
+	};
+	
+	// Collects the visible primitives of all models with a 64 bit sort key, sorts them and records them
+	// binding only the state that changed from the previous draw
+	//
+	// Opaque, AlphaCut: | queue 2 | pipeline 6 | material 20 | geometry 4 | depth 32, front to back |
+	// AlphaBlend:       | queue 2 | depth 32, back to front | pipeline 6 | material 20 | geometry 4 |
+	class DrawList
+	{
+	public:
+		void build(const Camera& camera);
+		
+		void record(vk::CommandBuffer cmd, Pipeline& pipeline);
+		
+		// the same walk for the null api, so it counts the binds and draws of the vulkan path
+		void record(NullCommandBuffer& cmd);
+		
+		static uint64_t makeKey(uint16_t renderQueue, uint32_t pipeline, uint32_t material, uint32_t geometry, float depth);
+	
+	private:
+		void sort();
+		
+		// binds only what changed and draws every item, Commands issues the calls of one api
+		template<class Commands>
+		void recordItems(Commands& commands);
+		
+		std::vector<DrawItem> items {};
+		std::vector<DrawItem> sortBuffer {};
+	};
+}
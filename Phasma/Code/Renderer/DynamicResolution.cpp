@@ -0,0 +1,77 @@
+/*
+Copyright (c) 2018-2021 Christos Karamoustos
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "PhasmaPch.h"
+#include "DynamicResolution.h"
+#include "Image.h"
+#include "../GUI/GUI.h"
+#include "RenderApi.h"
+
+namespace pe
+{
+	void DynamicResolution::Update(float gpuTime, const Image& target)
+	{
+		if (!GUI::dynamic_resolution)
+		{
+			scale = 1.f;
+			smoothedTime = 0.f;
+		}
+		else if (gpuTime > 0.f)
+		{
+			// the timings are noisy and a frame or two late, smooth them so the scale does not oscillate
+			smoothedTime = smoothedTime > 0.f ? smoothedTime + (gpuTime - smoothedTime) * 0.1f : gpuTime;
+			
+			// leave some headroom under the budget and only react outside of it
+			const float budget = GUI::dynamic_resolution_budget;
+			if (smoothedTime > budget || smoothedTime < budget * 0.85f)
+			{
+				// the cost follows the pixel count, which is the square of the scale
+				const float wanted = scale * std::sqrt(budget * 0.925f / smoothedTime);
+				// drop fast when over the budget, recover slowly
+				scale = clamp(wanted, scale * 0.9f, scale * 1.02f);
+				scale = clamp(scale, clamp(GUI::dynamic_resolution_min, 0.1f, 1.f), 1.f);
+			}
+		}
+		
+		width = maximum(static_cast<uint32_t>(static_cast<float>(target.width) * scale), 1u);
+		height = maximum(static_cast<uint32_t>(static_cast<float>(target.height) * scale), 1u);
+		uvScale = vec2(
+				static_cast<float>(width) / static_cast<float>(target.width),
+				static_cast<float>(height) / static_cast<float>(target.height)
+		);
+	}
+	
+	vk::Extent2D DynamicResolution::Extent()
+	{
+		return vk::Extent2D {width, height};
+	}
+	
+	vec2 DynamicResolution::UVScale()
+	{
+		return uvScale;
+	}
+	
+	float DynamicResolution::Scale()
+	{
+		return scale;
+	}
+}
@@ -0,0 +1,60 @@
+/*
+Copyright (c) 2018-2021 Christos Karamoustos
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include "../Core/Math.h"
+
+namespace vk
+{
+	struct Extent2D;
+}
+
+namespace pe
+{
+	class Image;
+	
+	// Scales the rendered part of the scene render targets from the gpu frame time, without recreating them.
+	// The targets are allocated at the full scale, the scene passes render into the top left part of them
+	// and the composition reads that part back to the full viewport
+	class DynamicResolution
+	{
+	public:
+		// Adjusts the scale towards the frame time budget, gpuTime is the last measured gpu frame time in ms
+		static void Update(float gpuTime, const Image& target);
+		
+		// The rendered part of the targets
+		static vk::Extent2D Extent();
+		
+		// Scale from the uv of the rendered part to the uv of the targets
+		static vec2 UVScale();
+		
+		static float Scale();
+	
+	private:
+		static inline float scale = 1.f;
+		static inline float smoothedTime = 0.f;
+		static inline uint32_t width = 0;
+		static inline uint32_t height = 0;
+		static inline vec2 uvScale {1.f, 1.f};
+	};
+}
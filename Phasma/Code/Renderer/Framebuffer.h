@@ -36,6 +36,9 @@ namespace pe
 {
 	class RenderPass;
 	
+	// The post process effects read one of these targets and write the other, instead of copying the frame
+	constexpr const char* POST_PROCESS_TARGETS[2] {"viewport", "viewportPong"};
+	
 	class Framebuffer
 	{
 	public:
@@ -0,0 +1,168 @@
+/*
+Copyright (c) 2018-2021 Christos Karamoustos
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "PhasmaPch.h"
+#include "GeometryArena.h"
+#include "UploadManager.h"
+#include "Vertex.h"
+#include "RenderApi.h"
+
+namespace pe
+{
+	void RangeAllocator::init(size_t capacity)
+	{
+		freeRanges.clear();
+		freeRanges[0] = capacity;
+		totalSize = capacity;
+		usedSize = 0;
+	}
+	
+	bool RangeAllocator::allocate(size_t size, size_t& offset)
+	{
+		if (size == 0)
+		{
+			offset = 0;
+			return true;
+		}
+		
+		for (auto it = freeRanges.begin(); it != freeRanges.end(); ++it)
+		{
+			if (it->second < size)
+				continue;
+			
+			offset = it->first;
+			const size_t remaining = it->second - size;
+			freeRanges.erase(it);
+			if (remaining > 0)
+				freeRanges[offset + size] = remaining;
+			
+			usedSize += size;
+			return true;
+		}
+		return false;
+	}
+	
+	void RangeAllocator::free(size_t offset, size_t size)
+	{
+		if (size == 0)
+			return;
+		
+		auto next = freeRanges.lower_bound(offset);
+		
+		// merge with the previous free range
+		if (next != freeRanges.begin())
+		{
+			auto prev = std::prev(next);
+			if (prev->first + prev->second == offset)
+			{
+				offset = prev->first;
+				size += prev->second;
+				freeRanges.erase(prev);
+			}
+		}
+		
+		// merge with the next free range
+		if (next != freeRanges.end() && offset + size == next->first)
+		{
+			size += next->second;
+			freeRanges.erase(next);
+		}
+		
+		freeRanges[offset] = size;
+		usedSize -= std::min(usedSize, size);
+	}
+	
+	Buffer GeometryArena::vertexBuffer {};
+	Buffer GeometryArena::indexBuffer {};
+	RangeAllocator GeometryArena::vertexAllocator {};
+	RangeAllocator GeometryArena::indexAllocator {};
+	
+	void GeometryArena::init()
+	{
+		if (*vertexBuffer.GetBufferVK())
+			return;
+		
+		vertexBuffer.CreateBuffer(
+				sizeof(Vertex) * GEOMETRY_ARENA_VERTICES, BufferUsage::TransferDst | BufferUsage::VertexBuffer,
+				MemoryProperty::DeviceLocal
+		);
+		indexBuffer.CreateBuffer(
+				sizeof(uint32_t) * GEOMETRY_ARENA_INDICES, BufferUsage::TransferDst | BufferUsage::IndexBuffer,
+				MemoryProperty::DeviceLocal
+		);
+		vertexAllocator.init(GEOMETRY_ARENA_VERTICES);
+		indexAllocator.init(GEOMETRY_ARENA_INDICES);
+	}
+	
+	GeometryRange GeometryArena::uploadVertices(const void* data, uint32_t count)
+	{
+		std::lock_guard<std::mutex> guard(m_mutex);
+		
+		size_t offset;
+		if (!vertexAllocator.allocate(count, offset))
+			throw std::runtime_error("Geometry arena is out of vertex space");
+		
+		UploadManager::uploadBuffer(vertexBuffer, offset * sizeof(Vertex), data, count * sizeof(Vertex));
+		
+		return {static_cast<uint32_t>(offset), count};
+	}
+	
+	GeometryRange GeometryArena::uploadIndices(const uint32_t* data, uint32_t count)
+	{
+		std::lock_guard<std::mutex> guard(m_mutex);
+		
+		size_t offset;
+		if (!indexAllocator.allocate(count, offset))
+			throw std::runtime_error("Geometry arena is out of index space");
+		
+		UploadManager::uploadBuffer(indexBuffer, offset * sizeof(uint32_t), data, count * sizeof(uint32_t));
+		
+		return {static_cast<uint32_t>(offset), count};
+	}
+	
+	void GeometryArena::freeVertices(GeometryRange& range)
+	{
+		std::lock_guard<std::mutex> guard(m_mutex);
+		vertexAllocator.free(range.offset, range.count);
+		range = {};
+	}
+	
+	void GeometryArena::freeIndices(GeometryRange& range)
+	{
+		std::lock_guard<std::mutex> guard(m_mutex);
+		indexAllocator.free(range.offset, range.count);
+		range = {};
+	}
+	
+	void GeometryArena::bind(vk::CommandBuffer cmd)
+	{
+		const vk::DeviceSize offset {0};
+		cmd.bindVertexBuffers(0, *vertexBuffer.GetBufferVK(), offset);
+		cmd.bindIndexBuffer(*indexBuffer.GetBufferVK(), 0, vk::IndexType::eUint32);
+	}
+	
+	void GeometryArena::destroy()
+	{
+		vertexBuffer.Destroy();
+		indexBuffer.Destroy();
+	}
+}
@@ -0,0 +1,95 @@
+/*
+Copyright (c) 2018-2021 Christos Karamoustos
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include "Buffer.h"
+#include <map>
+#include <mutex>
+
+constexpr auto GEOMETRY_ARENA_VERTICES = 2u * 1024u * 1024u;
+constexpr auto GEOMETRY_ARENA_INDICES = 8u * 1024u * 1024u;
+
+namespace vk
+{
+	class CommandBuffer;
+}
+
+namespace pe
+{
+	// First fit suballocator of a fixed capacity, free ranges are kept by offset and merged when freed
+	class RangeAllocator
+	{
+	public:
+		void init(size_t capacity);
+		
+		bool allocate(size_t size, size_t& offset);
+		
+		void free(size_t offset, size_t size);
+		
+		size_t used() const
+		{ return usedSize; }
+		
+		size_t capacity() const
+		{ return totalSize; }
+	
+	private:
+		std::map<size_t, size_t> freeRanges {}; // offset, size
+		size_t totalSize = 0;
+		size_t usedSize = 0;
+	};
+	
+	// range in elements (vertices, indices, nodes or joints)
+	struct GeometryRange
+	{
+		uint32_t offset = 0;
+		uint32_t count = 0;
+	};
+	
+	// All model vertices and indices live in one vertex and one index buffer,
+	// uploads go through the UploadManager and are visible to the frames once their batch is flushed
+	class GeometryArena
+	{
+	public:
+		static void init();
+		
+		static GeometryRange uploadVertices(const void* data, uint32_t count);
+		
+		static GeometryRange uploadIndices(const uint32_t* data, uint32_t count);
+		
+		static void freeVertices(GeometryRange& range);
+		
+		static void freeIndices(GeometryRange& range);
+		
+		static void bind(vk::CommandBuffer cmd);
+		
+		static void destroy();
+		
+		static Buffer vertexBuffer;
+		static Buffer indexBuffer;
+		static RangeAllocator vertexAllocator;
+		static RangeAllocator indexAllocator;
+	
+	private:
+		static inline std::mutex m_mutex {};
+	};
+}
@@ -22,6 +22,7 @@ SOFTWARE.
 
 #include "Image.h"
 #include "RenderApi.h"
+#include "UploadManager.h"
 #include "../ECS/Context.h"
 #include <utility>
 
@@ -63,17 +64,21 @@ namespace pe
 			const vk::PipelineStageFlags& newStageMask,
 			const vk::AccessFlags& srcMask,
 			const vk::AccessFlags& dstMask,
-			const vk::ImageAspectFlags& aspectFlags
+			const vk::ImageAspectFlags& aspectFlags,
+			uint32_t srcQueueFamily,
+			uint32_t dstQueueFamily
 	) const
 	{
+		// with different queue families this is the release or the acquire half of an ownership transfer,
+		// the same barrier has to be recorded on both queues
 		vk::ImageMemoryBarrier barrier;
 		barrier.srcAccessMask = srcMask;
 		barrier.dstAccessMask = dstMask;
 		barrier.image = *image;
 		barrier.oldLayout = oldLayout;
 		barrier.newLayout = newLayout;
-		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.srcQueueFamilyIndex = srcQueueFamily;
+		barrier.dstQueueFamilyIndex = dstQueueFamily;
 		barrier.subresourceRange.aspectMask = aspectFlags;
 		barrier.subresourceRange.baseMipLevel = 0;
 		barrier.subresourceRange.levelCount = mipLevels;
@@ -147,6 +152,19 @@ namespace pe
 		imageInfo.tiling = tiling;
 		imageInfo.usage = usage;
 		imageInfo.sharingMode = vk::SharingMode::eExclusive;
+		// textures are filled on the transfer queue and sampled on graphics, without ownership transfers
+		const uint32_t families[] {
+				static_cast<uint32_t>(vCtx->graphicsFamilyId), static_cast<uint32_t>(vCtx->transferFamilyId)
+		};
+		const vk::ImageUsageFlags attachments = vk::ImageUsageFlagBits::eColorAttachment |
+		                                        vk::ImageUsageFlagBits::eDepthStencilAttachment |
+		                                        vk::ImageUsageFlagBits::eStorage;
+		if (vCtx->dedicatedTransferQueue && usage & vk::ImageUsageFlagBits::eTransferDst && !(usage & attachments))
+		{
+			imageInfo.sharingMode = vk::SharingMode::eConcurrent;
+			imageInfo.queueFamilyIndexCount = 2;
+			imageInfo.pQueueFamilyIndices = families;
+		}
 		imageInfo.initialLayout = *initialLayout;
 		VkImageCreateInfo vkImageInfo = VkImageCreateInfo(imageInfo);
 		
@@ -161,6 +179,9 @@ namespace pe
 		);
 		image = make_ref(vk::Image(vkImage));
 		
+		category = usage & attachments ? MemoryCategory::RenderTargets : MemoryCategory::Textures;
+		MemoryStats::Allocated(category, allocationInfo.size);
+		
 		vCtx->SetDebugObjectName(*image, "");
 	}
 	
@@ -451,7 +472,7 @@ namespace pe
 		);
 	}
 	
-	void Image::generateMipMaps() const
+	void Image::generateMipMaps(uint64_t uploadValue) const
 	{
 		auto vCtx = VulkanContext::Get();
 		
@@ -474,16 +495,17 @@ namespace pe
 		
 		vk::CommandBufferAllocateInfo allocInfo;
 		allocInfo.level = vk::CommandBufferLevel::ePrimary;
-		allocInfo.commandBufferCount = mipLevels;
+		allocInfo.commandBufferCount = 1;
 		allocInfo.commandPool = *vCtx->commandPool2;
 		
-		const auto commandBuffers = vCtx->device->allocateCommandBuffers(allocInfo);
+		const vk::CommandBuffer commandBuffer = vCtx->device->allocateCommandBuffers(allocInfo).at(0);
 		
 		auto mipWidth = static_cast<int32_t>(width);
 		auto mipHeight = static_cast<int32_t>(height);
 		
 		vk::CommandBufferBeginInfo beginInfo;
 		beginInfo.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit;
+		commandBuffer.begin(beginInfo);
 		
 		vk::ImageMemoryBarrier barrier = {};
 		barrier.image = *image;
@@ -504,18 +526,16 @@ namespace pe
 		blit.dstSubresource.baseArrayLayer = 0;
 		blit.dstSubresource.layerCount = 1;
 		
+		// all the levels in one submit, each level is read after the previous blit wrote it
 		for (uint32_t i = 1; i < mipLevels; i++)
 		{
-			
-			commandBuffers[i].begin(beginInfo);
-			
 			barrier.subresourceRange.baseMipLevel = i - 1;
 			barrier.oldLayout = vk::ImageLayout::eTransferDstOptimal;
 			barrier.newLayout = vk::ImageLayout::eTransferSrcOptimal;
 			barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
 			barrier.dstAccessMask = vk::AccessFlagBits::eTransferRead;
 			
-			commandBuffers[i].pipelineBarrier(
+			commandBuffer.pipelineBarrier(
 					vk::PipelineStageFlagBits::eTransfer,
 					vk::PipelineStageFlagBits::eTransfer,
 					vk::DependencyFlagBits(),
@@ -524,13 +544,12 @@ namespace pe
 					barrier
 			);
 			
-			
 			blit.srcOffsets[1] = vk::Offset3D {mipWidth, mipHeight, 1};
-			blit.dstOffsets[1] = vk::Offset3D {mipWidth / 2, mipHeight / 2, 1};
+			blit.dstOffsets[1] = vk::Offset3D {mipWidth > 1 ? mipWidth / 2 : 1, mipHeight > 1 ? mipHeight / 2 : 1, 1};
 			blit.srcSubresource.mipLevel = i - 1;
 			blit.dstSubresource.mipLevel = i;
 			
-			commandBuffers[i].blitImage(
+			commandBuffer.blitImage(
 					*image,
 					vk::ImageLayout::eTransferSrcOptimal,
 					*image,
@@ -544,7 +563,7 @@ namespace pe
 			barrier.srcAccessMask = vk::AccessFlagBits::eTransferRead;
 			barrier.dstAccessMask = vk::AccessFlagBits::eShaderRead;
 			
-			commandBuffers[i].pipelineBarrier(
+			commandBuffer.pipelineBarrier(
 					vk::PipelineStageFlagBits::eTransfer,
 					vk::PipelineStageFlagBits::eFragmentShader,
 					vk::DependencyFlagBits::eByRegion,
@@ -555,21 +574,15 @@ namespace pe
 			
 			if (mipWidth > 1) mipWidth /= 2;
 			if (mipHeight > 1) mipHeight /= 2;
-			
-			commandBuffers[i].end();
-			
-			vCtx->submitAndWaitFence(commandBuffers[i], nullptr, nullptr, nullptr);
 		}
 		
-		commandBuffers.front().begin(beginInfo);
-		
 		barrier.subresourceRange.baseMipLevel = mipLevels - 1;
 		barrier.oldLayout = vk::ImageLayout::eTransferDstOptimal;
 		barrier.newLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
 		barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
 		barrier.dstAccessMask = vk::AccessFlagBits::eShaderRead;
 		
-		commandBuffers.front().pipelineBarrier(
+		commandBuffer.pipelineBarrier(
 				vk::PipelineStageFlagBits::eTransfer,
 				vk::PipelineStageFlagBits::eFragmentShader,
 				vk::DependencyFlagBits::eByRegion,
@@ -578,11 +591,24 @@ namespace pe
 				barrier
 		);
 		
-		commandBuffers.front().end();
+		commandBuffer.end();
 		
-		vCtx->submitAndWaitFence(commandBuffers.front(), nullptr, nullptr, nullptr);
+		// the base level may still be in flight on the transfer queue
+		if (uploadValue > 0 && !UploadManager::isComplete(uploadValue))
+		{
+			const vk::Semaphore semaphore = UploadManager::semaphore();
+			const vk::PipelineStageFlags waitStage = vk::PipelineStageFlagBits::eTransfer;
+			vk::TimelineSemaphoreSubmitInfo tssi;
+			tssi.waitSemaphoreValueCount = 1;
+			tssi.pWaitSemaphoreValues = &uploadValue;
+			vCtx->submitAndWaitFence(commandBuffer, waitStage, semaphore, nullptr, &tssi);
+		}
+		else
+		{
+			vCtx->submitAndWaitFence(commandBuffer, nullptr, nullptr, nullptr);
+		}
 		
-		vCtx->device->freeCommandBuffers(*vCtx->commandPool2, commandBuffers);
+		vCtx->device->freeCommandBuffers(*vCtx->commandPool2, commandBuffer);
 	}
 	
 	void Image::createSampler()
@@ -610,10 +636,26 @@ namespace pe
 	
 	void Image::destroy() const
 	{
+		if DYNAMIC_CONSTEXPR (PE_NULL)
+		{
+			if (hostPixels)
+			{
+				hostPixels->clear();
+				hostPixels->shrink_to_fit();
+			}
+			return;
+		}
+		
 		auto vCtx = VulkanContext::Get();
 		
 		if (*view) vCtx->device->destroyImageView(*view);
-		if (*image) vmaDestroyImage(VulkanContext::Get()->allocator, VkImage(*image), allocation);
+		if (*image)
+		{
+			VmaAllocationInfo allocationInfo;
+			vmaGetAllocationInfo(VulkanContext::Get()->allocator, allocation, &allocationInfo);
+			MemoryStats::Freed(category, allocationInfo.size);
+			vmaDestroyImage(VulkanContext::Get()->allocator, VkImage(*image), allocation);
+		}
 		if (*sampler) vCtx->device->destroySampler(*sampler);
 		*view = nullptr;
 		*image = nullptr;
@@ -23,6 +23,8 @@ SOFTWARE.
 #pragma once
 
 #include "../Core/Base.h"
+#include "MemoryStats.h"
+#include <vector>
 
 namespace vk
 {
@@ -91,6 +93,7 @@ namespace pe
 		
 		Ref<vk::Image> image;
 		VmaAllocation allocation {};
+		MemoryCategory category = MemoryCategory::Textures;
 		Ref<vk::ImageView> view;
 		Ref<vk::Sampler> sampler;
 		uint32_t width {};
@@ -119,6 +122,9 @@ namespace pe
 		Ref<vk::SamplerMipmapMode> samplerMipmapMode;
 		Ref<vk::PipelineColorBlendAttachmentState> blentAttachment;
 		
+		// the null api keeps the pixels in a host allocation instead of a device image
+		Ref<std::vector<uint8_t>> hostPixels;
+		
 		void transitionImageLayout(
 				vk::CommandBuffer cmd,
 				vk::ImageLayout oldLayout,
@@ -127,7 +133,9 @@ namespace pe
 				const vk::PipelineStageFlags& newStageMask,
 				const vk::AccessFlags& srcMask,
 				const vk::AccessFlags& dstMask,
-				const vk::ImageAspectFlags& aspectFlags
+				const vk::ImageAspectFlags& aspectFlags,
+				uint32_t srcQueueFamily = ~0U, // VK_QUEUE_FAMILY_IGNORED
+				uint32_t dstQueueFamily = ~0U
 		) const;
 		
 		void createImage(
@@ -145,7 +153,8 @@ namespace pe
 		
 		void copyColorAttachment(const vk::CommandBuffer& cmd, Image& renderedImage) const;
 		
-		void generateMipMaps() const;
+		// waits on the gpu for the upload value of the base level, if it is not complete yet
+		void generateMipMaps(uint64_t uploadValue = 0) const;
 		
 		void createSampler();
 		
@@ -25,6 +25,8 @@ SOFTWARE.
 #include "../Core/Queue.h"
 #include "../GUI/GUI.h"
 #include "RenderApi.h"
+#include "../ECS/Context.h"
+#include "../Core/Profiler.h"
 
 namespace pe
 {
@@ -40,33 +42,281 @@ namespace pe
 			position(position)
 	{}
 	
-	void LightUniforms::createLightUniforms()
+	// The tile range that the projection of a sphere covers on one screen axis.
+	// The bounds are the tangents from the camera to the sphere, which must be in front of the near plane
+	static bool TileRange(float axis, float depth, float radius, float projection, uint32_t tiles, uint32_t& first,
+	                      uint32_t& last)
 	{
-		getDescriptorSetLayout();
+		const float tangent = sqrt(axis * axis + depth * depth - radius * radius);
+		const float minimum = (axis * tangent - depth * radius) / (depth * tangent + axis * radius);
+		const float maximum = (axis * tangent + depth * radius) / (depth * tangent - axis * radius);
+		
+		// to uv, the composition finds the tile of a pixel from its uv
+		const float uvMin = minimum * projection * 0.5f + 0.5f;
+		const float uvMax = maximum * projection * 0.5f + 0.5f;
+		if (uvMax < 0.f || uvMin > 1.f)
+			return false;
+		
+		first = std::min(static_cast<uint32_t>(clamp(uvMin, 0.f, 1.f) * tiles), tiles - 1);
+		last = std::min(static_cast<uint32_t>(clamp(uvMax, 0.f, 1.f) * tiles), tiles - 1);
+		return true;
+	}
+	
+	void LightSystem::Init()
+	{
+		Entity* sunEntity = GetContext()->CreateEntity();
+		m_sun = sunEntity->CreateComponent<DirectionalLight>();
+		AddComponent(m_sun);
+		
+		m_range = GUI::lights_range;
+		Randomize();
+	}
+	
+	void LightSystem::Update(double delta)
+	{
+		PE_PROFILE_SCOPE("LightSystem::Update");
+		
+		// the gui edits the sun and the randomized lights
+		m_sun->color = {.9765f, .8431f, .9098f, GUI::sun_intensity};
+		m_sun->direction = vec3(GUI::sun_position.data());
+		
+		if (GUI::randomize_lights)
+		{
+			GUI::randomize_lights = false;
+			Randomize();
+		}
+		
+		// the range of the gui limits all the point lights
+		if (m_range != GUI::lights_range)
+		{
+			m_range = GUI::lights_range;
+			for (uint32_t slot = 0; slot < m_owners.size(); slot++)
+			{
+				if (!m_spots[slot])
+					MarkDirty(m_owners[slot]);
+			}
+		}
+		
+		PE_PROFILE_COUNTER("Lights", Count());
+	}
+	
+	void LightSystem::Destroy()
+	{
+		for (size_t id : m_randomEntities)
+			GetContext()->RemoveEntity(id);
+		m_randomEntities.clear();
+	}
+	
+	uint32_t LightSystem::AddSlot(IComponent* light, bool spot)
+	{
+		const uint32_t slot = static_cast<uint32_t>(m_owners.size());
+		m_owners.push_back(light);
+		m_spots.push_back(spot);
+		m_uploads.push_back(0);
+		m_packed.emplace_back();
+		positions.emplace_back();
+		colors.emplace_back();
+		directions.emplace_back();
+		m_slots[light] = slot;
+		return slot;
+	}
+	
+	void LightSystem::AddLight(PointLight* light)
+	{
+		AddComponent(light);
+		Write(AddSlot(light, false));
+	}
+	
+	void LightSystem::AddLight(SpotLight* light)
+	{
+		AddComponent(light);
+		Write(AddSlot(light, true));
+	}
+	
+	void LightSystem::RemoveLight(IComponent* light)
+	{
+		auto it = m_slots.find(light);
+		if (it == m_slots.end())
+			return;
+		
+		const uint32_t slot = it->second;
+		if (m_spots[slot])
+			RemoveComponent<SpotLight>(light);
+		else
+			RemoveComponent<PointLight>(light);
+		m_slots.erase(it);
+		
+		// the last light moves to the empty slot, the arrays stay contiguous
+		const uint32_t last = static_cast<uint32_t>(m_owners.size() - 1);
+		if (slot != last)
+		{
+			m_owners[slot] = m_owners[last];
+			m_spots[slot] = m_spots[last];
+			m_slots[m_owners[slot]] = slot;
+			Write(slot);
+		}
+		m_owners.pop_back();
+		m_spots.pop_back();
+		m_uploads.pop_back();
+		m_packed.pop_back();
+		positions.pop_back();
+		colors.pop_back();
+		directions.pop_back();
+		m_version++;
+	}
+	
+	void LightSystem::MarkDirty(IComponent* light)
+	{
+		auto it = m_slots.find(light);
+		if (it != m_slots.end())
+			Write(it->second);
+	}
+	
+	void LightSystem::MarkAllDirty()
+	{
+		for (uint32_t slot = 0; slot < m_owners.size(); slot++)
+			Write(slot);
+	}
+	
+	void LightSystem::Write(uint32_t slot)
+	{
+		if (m_spots[slot])
+		{
+			// the bounding sphere of the cone is the sphere of its range
+			const SpotLight* light = static_cast<SpotLight*>(m_owners[slot]);
+			const vec3 start(light->start);
+			const vec3 axis = light->end - start;
+			const float range = std::max(length(axis), 0.001f);
+			colors[slot] = light->color;
+			positions[slot] = {start, range};
+			directions[slot] = {axis / range, range / sqrt(range * range + light->radius * light->radius)};
+		}
+		else
+		{
+			const PointLight* light = static_cast<PointLight*>(m_owners[slot]);
+			colors[slot] = light->color;
+			positions[slot] = {light->position, std::min(light->radius, m_range)};
+			directions[slot] = {0.f, 0.f, 0.f, -1.f};
+		}
+		m_packed[slot] = {colors[slot], positions[slot], directions[slot]};
+		m_uploads[slot] = MAX_FRAMES_IN_FLIGHT;
+		m_pendingUploads = true;
+		m_version++;
+	}
+	
+	void LightSystem::CollectUploads(std::vector<MemoryRange>& ranges)
+	{
+		if (!m_pendingUploads)
+			return;
+		
+		// every frame in flight has its own copy, each one is written once after a change
+		m_pendingUploads = false;
+		const uint32_t count = static_cast<uint32_t>(m_uploads.size());
+		for (uint32_t first = 0; first < count;)
+		{
+			if (m_uploads[first] == 0)
+			{
+				first++;
+				continue;
+			}
+			
+			uint32_t end = first;
+			while (end < count && m_uploads[end] > 0)
+			{
+				if (--m_uploads[end] > 0)
+					m_pendingUploads = true;
+				end++;
+			}
+			ranges.push_back({&m_packed[first], (end - first) * sizeof(LightData), first * sizeof(LightData)});
+			first = end;
+		}
+	}
+	
+	void LightSystem::Randomize()
+	{
+		for (size_t id : m_randomEntities)
+		{
+			Entity* entity = GetContext()->GetEntity(id);
+			if (PointLight* light = entity->GetComponent<PointLight>())
+				RemoveLight(light);
+			if (SpotLight* light = entity->GetComponent<SpotLight>())
+				RemoveLight(light);
+			GetContext()->RemoveEntity(id);
+		}
+		m_randomEntities.clear();
+		
+		for (int i = 0; i < GUI::point_lights_count; i++)
+		{
+			const Light random;
+			Entity* entity = GetContext()->CreateEntity();
+			PointLight* light = entity->CreateComponent<PointLight>();
+			light->color = random.color;
+			light->position = vec3(random.position);
+			light->radius = 30.f;
+			AddLight(light);
+			m_randomEntities.push_back(entity->GetID());
+		}
 		
-		uniform.CreateBuffer(sizeof(LightsUBO), BufferUsage::UniformBuffer, MemoryProperty::HostVisible);
+		for (int i = 0; i < GUI::spot_lights_count; i++)
+		{
+			const Light random;
+			Entity* entity = GetContext()->CreateEntity();
+			SpotLight* light = entity->CreateComponent<SpotLight>();
+			light->color = random.color;
+			light->start = random.position;
+			light->end = vec3(random.position) + vec3(rand(-3.f, 3.f), rand(-8.f, -4.f), rand(-3.f, 3.f));
+			light->radius = rand(1.f, 4.f);
+			AddLight(light);
+			m_randomEntities.push_back(entity->GetID());
+		}
+	}
+	
+	void LightUniforms::createLightUniforms()
+	{
+		uniform.CreateBufferPerFrame(sizeof(LightsUBO), BufferUsage::UniformBuffer, MemoryProperty::HostVisible);
 		uniform.Map();
-		uniform.CopyData(&lubo);
+		for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+			uniform.CopyData(&lubo, sizeof(lubo), uniform.FrameSize() * i);
 		uniform.Flush();
 		uniform.Unmap();
 		
+		lightsBuffer.CreateBufferPerFrame(
+				sizeof(LightData) * m_lightsCapacity, BufferUsage::StorageBuffer, MemoryProperty::HostVisible
+		);
+		clustersBuffer.CreateBufferPerFrame(
+				2 * sizeof(uint32_t) * CLUSTER_COUNT, BufferUsage::StorageBuffer, MemoryProperty::HostVisible
+		);
+		indicesBuffer.CreateBufferPerFrame(
+				sizeof(uint32_t) * m_indicesCapacity, BufferUsage::StorageBuffer, MemoryProperty::HostVisible
+		);
+		// empty clusters until the first update
+		clustersBuffer.Map();
+		clustersBuffer.Zero();
+		clustersBuffer.Flush();
+		clustersBuffer.Unmap();
+		
+		if DYNAMIC_CONSTEXPR (PE_NULL)
+			return;
+		
+		getDescriptorSetLayout();
+		
 		vk::DescriptorSetAllocateInfo allocateInfo;
 		allocateInfo.descriptorPool = *VulkanContext::Get()->descriptorPool;
 		allocateInfo.descriptorSetCount = 1;
 		allocateInfo.pSetLayouts = descriptorSetLayout.get();
-		descriptorSet = make_ref(VulkanContext::Get()->device->allocateDescriptorSets(allocateInfo).at(0));
+		descriptorSet = make_ref(VulkanContext::Get()->allocateDescriptorSet(allocateInfo));
 		
 		vk::DescriptorBufferInfo dbi;
 		dbi.buffer = *uniform.GetBufferVK();
 		dbi.offset = 0;
-		dbi.range = uniform.Size();
+		dbi.range = uniform.FrameSize();
 		
 		vk::WriteDescriptorSet writeSet;
 		writeSet.dstSet = *descriptorSet;
 		writeSet.dstBinding = 0;
 		writeSet.dstArrayElement = 0;
 		writeSet.descriptorCount = 1;
-		writeSet.descriptorType = vk::DescriptorType::eUniformBuffer;
+		writeSet.descriptorType = vk::DescriptorType::eUniformBufferDynamic;
 		writeSet.pBufferInfo = &dbi;
 		VulkanContext::Get()->device->updateDescriptorSets(writeSet, nullptr);
 	}
@@ -74,6 +324,9 @@ namespace pe
 	void LightUniforms::destroy()
 	{
 		uniform.Destroy();
+		lightsBuffer.Destroy();
+		clustersBuffer.Destroy();
+		indicesBuffer.Destroy();
 		if (*descriptorSetLayout)
 		{
 			VulkanContext::Get()->device->destroyDescriptorSetLayout(*descriptorSetLayout);
@@ -82,35 +335,180 @@ namespace pe
 		}
 	}
 	
-	void LightUniforms::update(const Camera& camera)
+	bool LightUniforms::reserve(LightSystem& lightSystem)
 	{
-		if (GUI::randomize_lights)
+		size_t lightsCapacity = m_lightsCapacity;
+		while (lightsCapacity < lightSystem.Count())
+			lightsCapacity *= 2;
+		size_t indicesCapacity = m_indicesCapacity;
+		while (indicesCapacity < m_indicesNeeded)
+			indicesCapacity *= 2;
+		if (lightsCapacity == m_lightsCapacity && indicesCapacity == m_indicesCapacity)
+			return false;
+		
+		if DYNAMIC_CONSTEXPR (PE_VULKAN)
+			VulkanContext::Get()->device->waitIdle();
+		if (lightsCapacity != m_lightsCapacity)
 		{
-			
-			GUI::randomize_lights = false;
-			
-			lubo = LightsUBO();
-			lubo.camPos = {camera.position, 1.0f};
-			
-			Queue::memcpyRequest(&uniform, {{&lubo, sizeof(lubo), 0}});
-			//uniform.map();
-			//memcpy(uniform.data, &lubo, sizeof(lubo));
-			//uniform.flush();
-			//uniform.unmap();
-			
+			m_lightsCapacity = lightsCapacity;
+			lightsBuffer.Destroy();
+			lightsBuffer.CreateBufferPerFrame(
+					sizeof(LightData) * m_lightsCapacity, BufferUsage::StorageBuffer, MemoryProperty::HostVisible
+			);
+			lightSystem.MarkAllDirty();
+		}
+		if (indicesCapacity != m_indicesCapacity)
+		{
+			m_indicesCapacity = indicesCapacity;
+			indicesBuffer.Destroy();
+			indicesBuffer.CreateBufferPerFrame(
+					sizeof(uint32_t) * m_indicesCapacity, BufferUsage::StorageBuffer, MemoryProperty::HostVisible
+			);
+			// the dropped indices are culled again
+			m_cullVersion = UINT64_MAX;
+		}
+		return true;
+	}
+	
+	void LightUniforms::cullLights(const Camera& camera, const LightSystem& lightSystem)
+	{
+		PE_PROFILE_SCOPE("LightUniforms::cullLights");
+		
+		// the depth grows along front * worldOrientation.z, it is the w of the clip space
+		const vec3 front = camera.front * camera.worldOrientation.z;
+		// the reversed depth swaps the planes of the camera
+		const float nearPlane = std::min(camera.nearPlane, camera.farPlane);
+		const float farPlane = std::max(camera.nearPlane, camera.farPlane);
+		const float aspect = camera.renderArea.viewport.width / camera.renderArea.viewport.height;
+		const float tanHalfFovy = tan(radians(camera.FOV) * .5f);
+		const float projectionX = 1.f / (aspect * tanHalfFovy);
+		const float projectionY = 1.f / tanHalfFovy;
+		const float depthScale = static_cast<float>(CLUSTER_Z) / log(farPlane / nearPlane);
+		
+		lubo.clusterFront = {front, 0.f};
+		lubo.clusterDepth = {nearPlane, farPlane, depthScale, 0.f};
+		
+		const vec4 projection {projectionX, projectionY, nearPlane, farPlane};
+		if (m_cullVersion == lightSystem.Version() &&
+		    memcmp(&m_cullView, &camera.view, sizeof(mat4)) == 0 &&
+		    memcmp(&m_cullProjection, &projection, sizeof(vec4)) == 0)
 			return;
+		m_cullVersion = lightSystem.Version();
+		m_cullView = camera.view;
+		m_cullProjection = projection;
+		m_clusterUploads = MAX_FRAMES_IN_FLIGHT;
+		
+		const auto slice = [&](float depth)
+		{
+			const float value = log(depth / nearPlane) * depthScale;
+			return static_cast<uint32_t>(clamp(value, 0.f, static_cast<float>(CLUSTER_Z - 1)));
+		};
+		
+		m_visible.clear();
+		m_bounds.clear();
+		const size_t count = lightSystem.Count();
+		for (size_t i = 0; i < count; i++)
+		{
+			const vec4& sphere = lightSystem.positions[i];
+			const float range = sphere.w;
+			const vec3 relative = vec3(sphere) - camera.position;
+			const float depth = dot(relative, front);
+			if (depth + range < nearPlane || depth - range > farPlane)
+				continue;
+			
+			uint32_t bounds[6] {0, CLUSTER_X - 1, 0, CLUSTER_Y - 1, 0, 0};
+			// a sphere that crosses the near plane covers the whole screen
+			if (depth - range > nearPlane)
+			{
+				if (!TileRange(dot(relative, camera.right), depth, range, projectionX, CLUSTER_X, bounds[0], bounds[1]))
+					continue;
+				if (!TileRange(dot(relative, camera.up), depth, range, projectionY, CLUSTER_Y, bounds[2], bounds[3]))
+					continue;
+			}
+			bounds[4] = slice(std::max(depth - range, nearPlane));
+			bounds[5] = slice(std::min(depth + range, farPlane));
 			
+			m_bounds.insert(m_bounds.end(), bounds, bounds + 6);
+			m_visible.push_back(static_cast<uint32_t>(i));
+		}
+		
+		// count the lights of each cluster, then give every cluster its part of the index list
+		m_clusters.assign(2 * CLUSTER_COUNT, 0);
+		const auto forEachCluster = [this](size_t visible, auto&& func)
+		{
+			const uint32_t* bounds = &m_bounds[visible * 6];
+			for (uint32_t z = bounds[4]; z <= bounds[5]; z++)
+				for (uint32_t y = bounds[2]; y <= bounds[3]; y++)
+					for (uint32_t x = bounds[0]; x <= bounds[1]; x++)
+						func(x + y * CLUSTER_X + z * CLUSTER_X * CLUSTER_Y);
+		};
+		for (size_t i = 0; i < m_visible.size(); i++)
+			forEachCluster(i, [this](uint32_t cluster) { m_clusters[2 * cluster + 1]++; });
+		
+		uint32_t total = 0;
+		for (uint32_t cluster = 0; cluster < CLUSTER_COUNT; cluster++)
+		{
+			const uint32_t clusterCount = m_clusters[2 * cluster + 1];
+			m_clusters[2 * cluster] = total;
+			m_clusters[2 * cluster + 1] = 0;
+			total += clusterCount;
 		}
 		
+		// the indices that do not fit are dropped for this frame, the next one reserves more space
+		m_indicesNeeded = total;
+		m_indices.resize(std::min(static_cast<size_t>(total), m_indicesCapacity));
+		for (size_t i = 0; i < m_visible.size(); i++)
+		{
+			const uint32_t light = m_visible[i];
+			forEachCluster(
+					i, [this, light](uint32_t cluster)
+					{
+						const uint32_t index = m_clusters[2 * cluster] + m_clusters[2 * cluster + 1];
+						if (index < m_indices.size())
+						{
+							m_indices[index] = light;
+							m_clusters[2 * cluster + 1]++;
+						}
+					}
+			);
+		}
+	}
+	
+	void LightUniforms::update(const Camera& camera, LightSystem& lightSystem)
+	{
+		PE_PROFILE_SCOPE("LightUniforms::update");
+		
 		lubo.camPos = {camera.position, 1.0f};
-		lubo.sun.color = {.9765f, .8431f, .9098f, GUI::sun_intensity};
-		lubo.sun.position = {GUI::sun_position[0], GUI::sun_position[1], GUI::sun_position[2], 1.0f};
+		const DirectionalLight* sun = lightSystem.GetSun();
+		lubo.sun.color = sun->color;
+		lubo.sun.position = {sun->direction, 1.0f};
+		
+		cullLights(camera, lightSystem);
+		
+		// every buffer is written to the frames in flight only after it changes
+		if (memcmp(&lubo, &m_uploadedUBO, sizeof(lubo)) != 0)
+		{
+			m_uploadedUBO = lubo;
+			m_uboUploads = MAX_FRAMES_IN_FLIGHT;
+		}
+		if (m_uboUploads > 0)
+		{
+			m_uboUploads--;
+			Queue::memcpyRequest(&uniform, {{&m_uploadedUBO, sizeof(lubo), 0}});
+		}
+		
+		if (m_clusterUploads > 0)
+		{
+			m_clusterUploads--;
+			Queue::memcpyRequest(&clustersBuffer, {{m_clusters.data(), m_clusters.size() * sizeof(uint32_t), 0}});
+			if (!m_indices.empty())
+				Queue::memcpyRequest(&indicesBuffer, {{m_indices.data(), m_indices.size() * sizeof(uint32_t), 0}});
+		}
 		
-		Queue::memcpyRequest(&uniform, {{&lubo, 3 * sizeof(vec4), 0}});
-		//uniform.map();
-		//memcpy(uniform.data, values, sizeof(values));
-		//uniform.flush();
-		//uniform.unmap();
+		m_uploads.clear();
+		lightSystem.CollectUploads(m_uploads);
+		if (!m_uploads.empty())
+			Queue::memcpyRequest(&lightsBuffer, m_uploads);
 	}
 	
 	LightUniforms::LightUniforms()
@@ -130,7 +528,7 @@ namespace pe
 			vk::DescriptorSetLayoutBinding descriptorSetLayoutBinding;
 			descriptorSetLayoutBinding.binding = 0;
 			descriptorSetLayoutBinding.descriptorCount = 1;
-			descriptorSetLayoutBinding.descriptorType = vk::DescriptorType::eUniformBuffer;
+			descriptorSetLayoutBinding.descriptorType = vk::DescriptorType::eUniformBufferDynamic;
 			descriptorSetLayoutBinding.stageFlags = vk::ShaderStageFlagBits::eFragment;
 			
 			vk::DescriptorSetLayoutCreateInfo createInfo;
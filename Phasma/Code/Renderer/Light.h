@@ -27,6 +27,9 @@ SOFTWARE.
 #include "../Camera/Camera.h"
 #include "../GUI/GUI.h"
 #include "../ECS/Component.h"
+#include "../ECS/System.h"
+#include "../MemoryHash/MemoryHash.h"
+#include <unordered_map>
 
 namespace vk
 {
@@ -37,7 +40,14 @@ namespace vk
 
 namespace pe
 {
-#define MAX_LIGHTS 10
+	// froxel grid of the clustered shading, tiles of the screen times exponential depth slices
+	constexpr auto CLUSTER_X = 16u;
+	constexpr auto CLUSTER_Y = 9u;
+	constexpr auto CLUSTER_Z = 24u;
+	constexpr auto CLUSTER_COUNT = CLUSTER_X * CLUSTER_Y * CLUSTER_Z;
+	// starting sizes of the light storage, it grows with the scene
+	constexpr auto LIGHTS_INITIAL_CAPACITY = 1024u;
+	constexpr auto CLUSTER_INITIAL_INDICES = 64u * 1024u;
 	
 	class Light
 	{
@@ -65,6 +75,7 @@ namespace pe
 		float radius;
 	};
 	
+	// a cone from start to end, radius is the radius of its base
 	class SpotLight : public IComponent
 	{
 	public:
@@ -74,6 +85,14 @@ namespace pe
 		float radius;
 	};
 	
+	// a point or spot light as the composition reads it
+	struct LightData
+	{
+		vec4 color; // .a is the intensity
+		vec4 position; // .w is the range
+		vec4 direction; // .w is the cosine of the spot cone, -1 for the point lights
+	};
+	
 	struct LightsUBO
 	{
 		vec4 camPos;
@@ -82,15 +101,78 @@ namespace pe
 						{.9765f,               .8431f,               .9098f,               GUI::sun_intensity},
 						{GUI::sun_position[0], GUI::sun_position[1], GUI::sun_position[2], 1.0f}
 				};
-#ifdef MAX_LIGHTS
-#if MAX_LIGHTS == 0 // to avoid warnings when 0 lights are set
-		std::array<Light, MAX_LIGHTS> lights{};
-#else
-		Light lights[MAX_LIGHTS];
-#endif
-#endif
+		vec4 clusterFront; // camera front towards the depth that grows
+		vec4 clusterDepth; // near, far, slices / log(far / near)
+		uint32_t clusterGrid[4] {CLUSTER_X, CLUSTER_Y, CLUSTER_Z, 0};
 	};
 	
+	// Owns the light components of the scene in contiguous arrays, one element per light.
+	// A light is written to the arrays when it is added or marked dirty and uploaded
+	// to every frame in flight once, static lights cost nothing per frame
+	class LightSystem : public ISystem
+	{
+	public:
+		LightSystem() = default;
+		
+		~LightSystem() override = default;
+		
+		// Inherited via ISystem
+		void Init() override;
+		
+		void Update(double delta) override;
+		
+		void Destroy() override;
+		
+		DirectionalLight* GetSun()
+		{ return m_sun; }
+		
+		void AddLight(PointLight* light);
+		
+		void AddLight(SpotLight* light);
+		
+		void RemoveLight(IComponent* light);
+		
+		// call it after changing the values of a light
+		void MarkDirty(IComponent* light);
+		
+		void MarkAllDirty();
+		
+		size_t Count() const
+		{ return positions.size(); }
+		
+		// increases with every change of the lights
+		uint64_t Version() const
+		{ return m_version; }
+		
+		// the ranges of the lights that the current frame in flight has to upload
+		void CollectUploads(std::vector<MemoryRange>& ranges);
+		
+		std::vector<vec4> positions; // .w is the range
+		std::vector<vec4> colors; // .a is the intensity
+		std::vector<vec4> directions; // .w is the cosine of the spot cone, -1 for the point lights
+	
+	private:
+		uint32_t AddSlot(IComponent* light, bool spot);
+		
+		void Write(uint32_t slot);
+		
+		void Randomize();
+		
+		std::vector<IComponent*> m_owners;
+		std::vector<uint8_t> m_spots;
+		std::vector<uint8_t> m_uploads; // frames in flight that still have to upload each light
+		std::vector<LightData> m_packed; // the layout of the gpu, the source of the uploads
+		std::unordered_map<IComponent*, uint32_t> m_slots;
+		std::vector<size_t> m_randomEntities;
+		DirectionalLight* m_sun = nullptr;
+		float m_range = 0.f;
+		uint64_t m_version = 0;
+		bool m_pendingUploads = false;
+	};
+	
+	// The lights are culled on the cpu into a froxel grid over the view frustum.
+	// Each light covers the tiles and depth slices of its projected bounding sphere,
+	// the clusters keep an offset and a count into a compact list of light indices
 	class LightUniforms : public Light
 	{
 	public:
@@ -100,15 +182,41 @@ namespace pe
 		
 		LightsUBO lubo;
 		Buffer uniform;
+		Buffer lightsBuffer;
+		Buffer clustersBuffer;
+		Buffer indicesBuffer;
 		Ref<vk::DescriptorSet> descriptorSet;
 		static Ref<vk::DescriptorSetLayout> descriptorSetLayout;
 		
 		static const vk::DescriptorSetLayout& getDescriptorSetLayout();
 		
-		void update(const Camera& camera);
+		void update(const Camera& camera, LightSystem& lightSystem);
+		
+		// grows the storage for the lights and the indices of the last frame,
+		// returns true when the buffers are recreated and the descriptor sets need an update
+		bool reserve(LightSystem& lightSystem);
+		
+		void cullLights(const Camera& camera, const LightSystem& lightSystem);
 		
 		void createLightUniforms();
 		
 		void destroy();
+	
+	private:
+		std::vector<uint32_t> m_clusters; // offset and count pairs
+		std::vector<uint32_t> m_indices;
+		std::vector<uint32_t> m_bounds; // the cluster ranges of the visible lights
+		std::vector<uint32_t> m_visible;
+		std::vector<MemoryRange> m_uploads;
+		size_t m_lightsCapacity = LIGHTS_INITIAL_CAPACITY;
+		size_t m_indicesCapacity = CLUSTER_INITIAL_INDICES;
+		size_t m_indicesNeeded = 0;
+		// the culling is skipped while the camera and the lights do not change
+		mat4 m_cullView {};
+		vec4 m_cullProjection {};
+		uint64_t m_cullVersion = UINT64_MAX;
+		uint32_t m_clusterUploads = 0;
+		LightsUBO m_uploadedUBO {};
+		uint32_t m_uboUploads = 0;
 	};
-}
\ No newline at end of file
+}
@@ -0,0 +1,188 @@
+/*
+Copyright (c) 2018-2021 Christos Karamoustos
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "PhasmaPch.h"
+#include "MemoryStats.h"
+#include "RenderApi.h"
+#include "../Model/Model.h"
+#include "../Model/Mesh.h"
+#include "rapidjson/prettywriter.h"
+#include "rapidjson/stringbuffer.h"
+#include <set>
+
+namespace pe
+{
+	static const char* s_memoryCategories[static_cast<size_t>(MemoryCategory::Count)] {
+			"render_targets", "textures", "geometry", "uniforms", "staging", "other"
+	};
+	
+	void MemoryStats::Allocated(MemoryCategory category, uint64_t bytes) noexcept
+	{
+		Counter& counter = counters[static_cast<size_t>(category)];
+		counter.bytes += bytes;
+		counter.allocations++;
+	}
+	
+	void MemoryStats::Freed(MemoryCategory category, uint64_t bytes) noexcept
+	{
+		Counter& counter = counters[static_cast<size_t>(category)];
+		counter.bytes -= bytes;
+		counter.allocations--;
+	}
+	
+	void MemoryStats::DescriptorSetsAllocated(uint32_t count) noexcept
+	{
+		descriptorSets += count;
+	}
+	
+	uint64_t MemoryStats::Bytes(MemoryCategory category) noexcept
+	{
+		return counters[static_cast<size_t>(category)].bytes;
+	}
+	
+	uint32_t MemoryStats::Allocations(MemoryCategory category) noexcept
+	{
+		return counters[static_cast<size_t>(category)].allocations;
+	}
+	
+	uint32_t MemoryStats::DescriptorSets() noexcept
+	{
+		return descriptorSets;
+	}
+	
+	std::vector<HeapBudget> MemoryStats::Budgets()
+	{
+		if (!PE_VULKAN || !VulkanContext::Get()->allocator)
+			return {};
+		
+		const VkPhysicalDeviceMemoryProperties* properties;
+		vmaGetMemoryProperties(VulkanContext::Get()->allocator, &properties);
+		
+		VmaBudget budgets[VK_MAX_MEMORY_HEAPS];
+		vmaGetBudget(VulkanContext::Get()->allocator, budgets);
+		
+		std::vector<HeapBudget> heaps(properties->memoryHeapCount);
+		for (uint32_t i = 0; i < properties->memoryHeapCount; i++)
+		{
+			heaps[i].blockBytes = budgets[i].blockBytes;
+			heaps[i].allocationBytes = budgets[i].allocationBytes;
+			heaps[i].usage = budgets[i].usage;
+			heaps[i].budget = budgets[i].budget;
+			heaps[i].deviceLocal = properties->memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT;
+		}
+		return heaps;
+	}
+	
+	uint64_t MemoryStats::HostGeometryBytes()
+	{
+		// the instances share the meshes of their source
+		std::set<const Mesh*> meshes;
+		uint64_t bytes = 0;
+		for (auto& model : Model::models)
+		{
+			for (auto& node : model.linearNodes)
+			{
+				if (!node->mesh || !meshes.insert(node->mesh).second)
+					continue;
+				bytes += node->mesh->vertices.capacity() * sizeof(Vertex);
+				bytes += node->mesh->indices.capacity() * sizeof(uint32_t);
+			}
+		}
+		return bytes;
+	}
+	
+	uint64_t MemoryStats::HostTextureBytes()
+	{
+		uint64_t bytes = 0;
+		for (auto& texture : Mesh::uniqueTextures)
+		{
+			if (texture.second.hostPixels)
+				bytes += texture.second.hostPixels->capacity();
+		}
+		return bytes;
+	}
+	
+	const char* MemoryStats::Name(MemoryCategory category)
+	{
+		return s_memoryCategories[static_cast<size_t>(category)];
+	}
+	
+	std::string MemoryStats::Report()
+	{
+		rapidjson::StringBuffer buffer;
+		rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(buffer);
+		
+		writer.StartObject();
+		writer.Key("device");
+		writer.StartObject();
+		for (size_t i = 0; i < static_cast<size_t>(MemoryCategory::Count); i++)
+		{
+			const auto category = static_cast<MemoryCategory>(i);
+			writer.Key(Name(category));
+			writer.StartObject();
+			writer.Key("bytes");
+			writer.Uint64(Bytes(category));
+			writer.Key("allocations");
+			writer.Uint(Allocations(category));
+			writer.EndObject();
+		}
+		writer.EndObject();
+		
+		writer.Key("heaps");
+		writer.StartArray();
+		for (auto& heap : Budgets())
+		{
+			writer.StartObject();
+			writer.Key("deviceLocal");
+			writer.Bool(heap.deviceLocal);
+			writer.Key("blockBytes");
+			writer.Uint64(heap.blockBytes);
+			writer.Key("allocationBytes");
+			writer.Uint64(heap.allocationBytes);
+			writer.Key("usage");
+			writer.Uint64(heap.usage);
+			writer.Key("budget");
+			writer.Uint64(heap.budget);
+			writer.EndObject();
+		}
+		writer.EndArray();
+		
+		writer.Key("descriptorSets");
+		writer.StartObject();
+		writer.Key("allocated");
+		writer.Uint(DescriptorSets());
+		writer.Key("poolSize");
+		writer.Uint(descriptorPoolSize);
+		writer.EndObject();
+		
+		writer.Key("host");
+		writer.StartObject();
+		writer.Key("geometry");
+		writer.Uint64(HostGeometryBytes());
+		writer.Key("textures");
+		writer.Uint64(HostTextureBytes());
+		writer.EndObject();
+		writer.EndObject();
+		
+		return buffer.GetString();
+	}
+}
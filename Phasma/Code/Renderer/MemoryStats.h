@@ -0,0 +1,96 @@
+/*
+Copyright (c) 2018-2021 Christos Karamoustos
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <string>
+#include <vector>
+
+namespace pe
+{
+	// what a device allocation is used for
+	enum class MemoryCategory : uint32_t
+	{
+		RenderTargets,
+		Textures,
+		Geometry,
+		Uniforms,
+		Staging,
+		Other,
+		Count
+	};
+	
+	// a memory heap as VMA sees it, usage and budget come from VK_EXT_memory_budget when the gpu has it
+	struct HeapBudget
+	{
+		uint64_t blockBytes;
+		uint64_t allocationBytes;
+		uint64_t usage;
+		uint64_t budget;
+		bool deviceLocal;
+	};
+	
+	// Device memory per category, counted where the buffers and images are allocated and freed,
+	// the heap budgets, the sets taken from the shared descriptor pool and the host copies of the scene
+	class MemoryStats
+	{
+	public:
+		static void Allocated(MemoryCategory category, uint64_t bytes) noexcept;
+		
+		static void Freed(MemoryCategory category, uint64_t bytes) noexcept;
+		
+		static void DescriptorSetsAllocated(uint32_t count) noexcept;
+		
+		static uint64_t Bytes(MemoryCategory category) noexcept;
+		
+		static uint32_t Allocations(MemoryCategory category) noexcept;
+		
+		static uint32_t DescriptorSets() noexcept;
+		
+		static std::vector<HeapBudget> Budgets();
+		
+		// the vertices and indices the meshes keep after the upload
+		static uint64_t HostGeometryBytes();
+		
+		// the decoded pixels the null api keeps instead of device images
+		static uint64_t HostTextureBytes();
+		
+		static const char* Name(MemoryCategory category);
+		
+		// everything above as json
+		static std::string Report();
+		
+		inline static uint32_t descriptorPoolSize = 0;
+	
+	private:
+		struct Counter
+		{
+			std::atomic<uint64_t> bytes {0};
+			std::atomic<uint32_t> allocations {0};
+		};
+		
+		inline static std::array<Counter, static_cast<size_t>(MemoryCategory::Count)> counters {};
+		inline static std::atomic<uint32_t> descriptorSets {0};
+	};
+}
@@ -0,0 +1,81 @@
+/*
+Copyright (c) 2018-2021 Christos Karamoustos
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "PhasmaPch.h"
+#include "BufferNull.h"
+
+namespace pe
+{
+	void BufferNull::CreateBuffer(size_t size, BufferUsageFlags /*usage*/, MemoryPropertyFlags /*properties*/)
+	{
+		sizeRequested = size;
+		this->size = size;
+		data = nullptr;
+		memory.assign(size, 0);
+	}
+	
+	void BufferNull::Map(size_t mapSize, size_t offset)
+	{
+		if (data)
+			return;
+		assert(mapSize + offset <= size);
+		data = memory.data();
+	}
+	
+	void BufferNull::Unmap()
+	{
+		data = nullptr;
+	}
+	
+	void BufferNull::Zero() const
+	{
+		if (!data)
+			return;
+		memset(data, 0, size);
+	}
+	
+	void BufferNull::CopyData(const void* srcData, size_t srcSize, size_t offset)
+	{
+		if (!data)
+			return;
+		assert(srcSize + offset <= size);
+		memcpy((char*) data + offset, srcData, srcSize > 0 ? srcSize : size);
+	}
+	
+	void BufferNull::CopyBuffer(const BufferNull& srcBuffer, size_t srcSize)
+	{
+		assert(srcSize <= size);
+		memcpy(memory.data(), srcBuffer.memory.data(), srcSize > 0 ? srcSize : size);
+	}
+	
+	void BufferNull::Flush(size_t /*offset*/, size_t /*flushSize*/) const
+	{
+	}
+	
+	void BufferNull::Destroy()
+	{
+		memory.clear();
+		memory.shrink_to_fit();
+		data = nullptr;
+		size = 0;
+	}
+}
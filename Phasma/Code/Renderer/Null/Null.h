@@ -0,0 +1,90 @@
+/*
+Copyright (c) 2018-2021 Christos Karamoustos
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include "../../Core/Base.h"
+#include <cstdint>
+
+namespace pe
+{
+	// The calls a command buffer would have recorded
+	struct NullCommandCounts
+	{
+		uint32_t draws = 0;
+		uint32_t dispatches = 0;
+		uint32_t pipelineBinds = 0;
+		uint32_t descriptorSetBinds = 0;
+		uint32_t pushConstants = 0;
+		uint32_t copies = 0;
+		uint64_t indices = 0;
+	};
+	
+	// Same names as the vk::CommandBuffer calls it stands in for, nothing is recorded, the calls are only counted
+	class NullCommandBuffer
+	{
+	public:
+		void begin()
+		{ counts = {}; }
+		
+		void end()
+		{}
+		
+		void bindPipeline()
+		{ counts.pipelineBinds++; }
+		
+		void bindDescriptorSets()
+		{ counts.descriptorSetBinds++; }
+		
+		void pushConstants()
+		{ counts.pushConstants++; }
+		
+		void drawIndexed(uint32_t indexCount, uint32_t instanceCount)
+		{
+			counts.draws++;
+			counts.indices += static_cast<uint64_t>(indexCount) * instanceCount;
+		}
+		
+		void dispatch(uint32_t /*groupCountX*/, uint32_t /*groupCountY*/, uint32_t /*groupCountZ*/)
+		{ counts.dispatches++; }
+		
+		void copyBuffer()
+		{ counts.copies++; }
+		
+		NullCommandCounts counts {};
+	};
+	
+	// The frame state of the null api, there is no device, the frames are complete as soon as they are submitted
+	class NullContext
+	{
+	public:
+		uint32_t frameIndex = 0;
+		uint64_t submits = 0;
+		NullCommandCounts lastFrame {};
+		
+		void submit(const NullCommandBuffer& cmd);
+		
+		static NullContext* Get() noexcept;
+		
+		static void Remove() noexcept;
+	};
+}
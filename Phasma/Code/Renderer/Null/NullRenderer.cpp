@@ -0,0 +1,166 @@
+/*
+Copyright (c) 2018-2021 Christos Karamoustos
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "PhasmaPch.h"
+#include "NullRenderer.h"
+#include "../../ECS/Context.h"
+#include "../../Camera/Camera.h"
+#include "../../Model/Model.h"
+#include "../../GUI/GUI.h"
+#include "../../Core/Queue.h"
+#include "../../Core/Timer.h"
+#include "../../Core/Profiler.h"
+#include <future>
+
+namespace pe
+{
+	void NullRenderer::Init()
+	{
+		GUI::winPos = ImVec2(0.f, 0.f);
+		GUI::winSize = ImVec2(width, height);
+		lightUniforms.createLightUniforms();
+	}
+	
+	void NullRenderer::CheckQueue()
+	{
+		PE_PROFILE_SCOPE("NullRenderer::CheckQueue");
+		
+		// the loads are not overlapped with the frames, there is nothing to upload
+		while (!Queue::loadModel.empty())
+		{
+			const std::string folderPath = std::get<0>(Queue::loadModel.front());
+			const std::string modelName = std::get<1>(Queue::loadModel.front());
+			Queue::loadModel.pop_front();
+			
+			if (Model* source = Model::findLoaded(folderPath + modelName))
+				Model::models.push_back(source->createInstance());
+			else
+			{
+				Model model;
+				model.loadModel(folderPath, modelName, true);
+				for (auto& _model : Model::models)
+					if (_model.name == model.name)
+						model.name = "_" + model.name;
+				Model::models.push_back(std::move(model));
+			}
+			GUI::modelList.push_back(Model::models.back().name);
+			GUI::model_scale.push_back({1.f, 1.f, 1.f});
+			GUI::model_pos.push_back({0.f, 0.f, 0.f});
+			GUI::model_rot.push_back({0.f, 0.f, 0.f});
+		}
+		
+		for (auto it = Queue::unloadModel.begin(); it != Queue::unloadModel.end();)
+		{
+			Model::models[*it].destroy();
+			Model::models.erase(Model::models.begin() + *it);
+			GUI::modelList.erase(GUI::modelList.begin() + *it);
+			GUI::model_scale.erase(GUI::model_scale.begin() + *it);
+			GUI::model_pos.erase(GUI::model_pos.begin() + *it);
+			GUI::model_rot.erase(GUI::model_rot.begin() + *it);
+			GUI::modelItemSelected = -1;
+			it = Queue::unloadModel.erase(it);
+		}
+		
+		Model::assignInstanceOwners();
+	}
+	
+	void NullRenderer::Update(double delta)
+	{
+		PE_PROFILE_SCOPE("NullRenderer::Update");
+		
+		static Timer timer;
+		timer.Start();
+		
+		CheckQueue();
+		
+		Camera* camera_main = GetContext()->GetSystem<CameraSystem>()->GetCamera(0);
+		LightSystem* lightSystem = GetContext()->GetSystem<LightSystem>();
+		
+		// there are no descriptor sets to update after the host buffers grow
+		lightUniforms.reserve(*lightSystem);
+		
+		static Timer timerStage;
+		timerStage.Start();
+		
+		std::vector<std::future<void>> futureUpdates;
+		futureUpdates.reserve(Model::models.size() + 1);
+		
+		// MODELS
+		for (auto& model : Model::models)
+		{
+			const auto updateModel = [&]()
+			{ model.update(*camera_main, delta); };
+			futureUpdates.push_back(std::async(std::launch::async, updateModel));
+		}
+		
+		// LIGHTS
+		auto updateLights = [&]()
+		{ lightUniforms.update(*camera_main, *lightSystem); };
+		futureUpdates.push_back(std::async(std::launch::async, updateLights));
+		
+		for (auto& f : futureUpdates)
+			f.get();
+		
+		auto& timestamps = FrameTimer::Instance().timestamps;
+		timestamps[StageUpdates] = timerStage.Count();
+		timerStage.Start();
+		
+		Model::updateInstances(*camera_main);
+		drawList.build(*camera_main);
+		
+		timestamps[StageCulling] = timerStage.Count();
+		timerStage.Start();
+		
+		// the frames are complete as soon as they are submitted, there is nothing to wait for
+		timestamps[StageFenceWait] = 0.0;
+		
+		Queue::exec_memcpyRequests();
+		timestamps[StageMemcpy] = timerStage.Count();
+		
+		GUI::updatesTimeCount = static_cast<float>(timer.Count());
+	}
+	
+	void NullRenderer::Draw()
+	{
+		PE_PROFILE_SCOPE("NullRenderer::Draw");
+		
+		auto& timestamps = FrameTimer::Instance().timestamps;
+		
+		static Timer timerStage;
+		timestamps[StageAcquire] = 0.0;
+		timerStage.Start();
+		
+		cmd.begin();
+		drawList.record(cmd);
+		cmd.end();
+		timestamps[StageRecording] = timerStage.Count();
+		timerStage.Start();
+		
+		NullContext::Get()->submit(cmd);
+		timestamps[StageSubmit] = timerStage.Count();
+	}
+	
+	void NullRenderer::Destroy()
+	{
+		lightUniforms.destroy();
+	}
+}
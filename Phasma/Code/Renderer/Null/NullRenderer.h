@@ -0,0 +1,57 @@
+/*
+Copyright (c) 2018-2021 Christos Karamoustos
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include "../../ECS/System.h"
+#include "../Light.h"
+#include "../DrawList.h"
+#include "Null.h"
+
+namespace pe
+{
+	// The frame of the null api, for machines without a gpu. The models are loaded without uploads, animated,
+	// culled and sorted in the draw list, the lights are culled, the uniforms are copied to host buffers
+	// and the draw list is recorded on a command buffer that only counts the calls
+	class NullRenderer final : public ISystem
+	{
+	public:
+		// there is no window, the camera renders at a fixed size
+		static constexpr float width = 1920.f;
+		static constexpr float height = 1080.f;
+		
+		void Init() override;
+		
+		void Update(double delta) override;
+		
+		void Destroy() override;
+		
+		void Draw();
+	
+	private:
+		void CheckQueue();
+		
+		DrawList drawList;
+		LightUniforms lightUniforms;
+		NullCommandBuffer cmd;
+	};
+}
@@ -24,6 +24,7 @@ SOFTWARE.
 #include "Pipeline.h"
 #include "../Shader/Shader.h"
 #include "RenderApi.h"
+#include "../Model/Material.h"
 
 namespace pe
 {
@@ -34,8 +35,6 @@ namespace pe
 		pCompShader = nullptr;
 		vertexInputBindingDescriptions = make_ref(std::vector<vk::VertexInputBindingDescription>());
 		vertexInputAttributeDescriptions = make_ref(std::vector<vk::VertexInputAttributeDescription>());
-		width = 0.f;
-		height = 0.f;
 		pushConstantStage = PushConstantStage::Vertex;
 		pushConstantSize = 0;
 		cullMode = CullMode::None;
@@ -108,22 +107,12 @@ namespace pe
 		pipeinfo.pInputAssemblyState = &piasci;
 		
 		// Viewports and Scissors
-		vk::Viewport vp;
-		vp.x = 0.0f;
-		vp.y = 0.0f;
-		vp.width = info.width;
-		vp.height = info.height;
-		vp.minDepth = 0.0f;
-		vp.maxDepth = 1.0f;
-		
-		vk::Rect2D r2d;
-		r2d.extent = vk::Extent2D {static_cast<uint32_t>(info.width), static_cast<uint32_t>(info.height)};
-		
+		// always dynamic, so pipelines do not depend on the size of the targets and survive a resize
 		vk::PipelineViewportStateCreateInfo pvsci;
 		pvsci.viewportCount = 1;
-		pvsci.pViewports = &vp;
+		pvsci.pViewports = nullptr;
 		pvsci.scissorCount = 1;
-		pvsci.pScissors = &r2d;
+		pvsci.pScissors = nullptr;
 		pipeinfo.pViewportState = &pvsci;
 		
 		// Rasterization state
@@ -174,9 +163,15 @@ namespace pe
 		pipeinfo.pColorBlendState = &pcbsci;
 		
 		// Dynamic state
+		std::vector<vk::DynamicState> dynamicStates {vk::DynamicState::eViewport, vk::DynamicState::eScissor};
+		for (auto& state : *info.dynamicStates)
+		{
+			if (std::find(dynamicStates.begin(), dynamicStates.end(), state) == dynamicStates.end())
+				dynamicStates.push_back(state);
+		}
 		vk::PipelineDynamicStateCreateInfo dsi;
-		dsi.dynamicStateCount = static_cast<uint32_t>(info.dynamicStates->size());
-		dsi.pDynamicStates = info.dynamicStates->data();
+		dsi.dynamicStateCount = static_cast<uint32_t>(dynamicStates.size());
+		dsi.pDynamicStates = dynamicStates.data();
 		pipeinfo.pDynamicState = &dsi;
 		
 		// Push Constant Range
@@ -216,9 +211,15 @@ namespace pe
 		csmci.codeSize = info.pCompShader->byte_size();
 		csmci.pCode = info.pCompShader->get_spriv();
 		
+		vk::PushConstantRange pcr;
+		pcr.stageFlags = static_cast<vk::ShaderStageFlagBits>(info.pushConstantStage);
+		pcr.size = info.pushConstantSize;
+		
 		vk::PipelineLayoutCreateInfo plci;
 		plci.setLayoutCount = static_cast<uint32_t>(info.descriptorSetLayouts->size());
 		plci.pSetLayouts = info.descriptorSetLayouts->data();
+		plci.pushConstantRangeCount = info.pushConstantSize ? 1 : 0;
+		plci.pPushConstantRanges = info.pushConstantSize ? &pcr : nullptr;
 		
 		vk::UniqueShaderModule module = VulkanContext::Get()->device->createShaderModuleUnique(csmci);
 		
@@ -263,12 +264,15 @@ namespace pe
 					layoutBinding(1, vk::DescriptorType::eCombinedImageSampler),
 					layoutBinding(2, vk::DescriptorType::eCombinedImageSampler),
 					layoutBinding(3, vk::DescriptorType::eCombinedImageSampler),
-					layoutBinding(4, vk::DescriptorType::eUniformBuffer),
+					layoutBinding(4, vk::DescriptorType::eUniformBufferDynamic),
 					layoutBinding(5, vk::DescriptorType::eCombinedImageSampler),
 					layoutBinding(6, vk::DescriptorType::eCombinedImageSampler),
 					layoutBinding(7, vk::DescriptorType::eCombinedImageSampler),
 					layoutBinding(8, vk::DescriptorType::eCombinedImageSampler),
-					layoutBinding(9, vk::DescriptorType::eUniformBuffer)
+					layoutBinding(9, vk::DescriptorType::eUniformBufferDynamic),
+					layoutBinding(10, vk::DescriptorType::eStorageBufferDynamic),
+					layoutBinding(11, vk::DescriptorType::eStorageBufferDynamic),
+					layoutBinding(12, vk::DescriptorType::eStorageBufferDynamic)
 			};
 			vk::DescriptorSetLayoutCreateInfo descriptorLayout;
 			descriptorLayout.bindingCount = static_cast<uint32_t>(setLayoutBindings.size());
@@ -441,7 +445,7 @@ namespace pe
 					layoutBinding(0, vk::DescriptorType::eCombinedImageSampler),
 					layoutBinding(1, vk::DescriptorType::eCombinedImageSampler),
 					layoutBinding(2, vk::DescriptorType::eCombinedImageSampler),
-					layoutBinding(3, vk::DescriptorType::eUniformBuffer),
+					layoutBinding(3, vk::DescriptorType::eUniformBufferDynamic),
 			};
 			vk::DescriptorSetLayoutCreateInfo descriptorLayout;
 			descriptorLayout.bindingCount = static_cast<uint32_t>(setLayoutBindings.size());
@@ -469,7 +473,7 @@ namespace pe
 					layoutBinding(1, vk::DescriptorType::eCombinedImageSampler),
 					layoutBinding(2, vk::DescriptorType::eCombinedImageSampler),
 					layoutBinding(3, vk::DescriptorType::eUniformBuffer),
-					layoutBinding(4, vk::DescriptorType::eUniformBuffer),
+					layoutBinding(4, vk::DescriptorType::eUniformBufferDynamic),
 			};
 			vk::DescriptorSetLayoutCreateInfo descriptorLayout;
 			descriptorLayout.bindingCount = static_cast<uint32_t>(setLayoutBindings.size());
@@ -504,6 +508,60 @@ namespace pe
 		return DSLayout;
 	}
 	
+	vk::DescriptorSetLayout& Pipeline::getDescriptorSetLayoutSSAOCompute()
+	{
+		static vk::DescriptorSetLayout DSLayout = nullptr;
+		
+		if (!DSLayout)
+		{
+			auto layoutBinding = [](uint32_t binding, vk::DescriptorType descriptorType)
+			{
+				return vk::DescriptorSetLayoutBinding {
+						binding, descriptorType, 1, vk::ShaderStageFlagBits::eCompute, nullptr
+				};
+			};
+			std::vector<vk::DescriptorSetLayoutBinding> setLayoutBindings {
+					layoutBinding(0, vk::DescriptorType::eCombinedImageSampler),
+					layoutBinding(1, vk::DescriptorType::eCombinedImageSampler),
+					layoutBinding(2, vk::DescriptorType::eUniformBuffer),
+					layoutBinding(3, vk::DescriptorType::eUniformBuffer),
+					layoutBinding(4, vk::DescriptorType::eUniformBufferDynamic),
+					layoutBinding(5, vk::DescriptorType::eStorageImage),
+			};
+			vk::DescriptorSetLayoutCreateInfo descriptorLayout;
+			descriptorLayout.bindingCount = static_cast<uint32_t>(setLayoutBindings.size());
+			descriptorLayout.pBindings = setLayoutBindings.data();
+			DSLayout = VulkanContext::Get()->device->createDescriptorSetLayout(descriptorLayout);
+		}
+		
+		return DSLayout;
+	}
+	
+	vk::DescriptorSetLayout& Pipeline::getDescriptorSetLayoutSSAOBlurCompute()
+	{
+		static vk::DescriptorSetLayout DSLayout = nullptr;
+		
+		if (!DSLayout)
+		{
+			auto layoutBinding = [](uint32_t binding, vk::DescriptorType descriptorType)
+			{
+				return vk::DescriptorSetLayoutBinding {
+						binding, descriptorType, 1, vk::ShaderStageFlagBits::eCompute, nullptr
+				};
+			};
+			std::vector<vk::DescriptorSetLayoutBinding> setLayoutBindings {
+					layoutBinding(0, vk::DescriptorType::eCombinedImageSampler),
+					layoutBinding(1, vk::DescriptorType::eStorageImage),
+			};
+			vk::DescriptorSetLayoutCreateInfo descriptorLayout;
+			descriptorLayout.bindingCount = static_cast<uint32_t>(setLayoutBindings.size());
+			descriptorLayout.pBindings = setLayoutBindings.data();
+			DSLayout = VulkanContext::Get()->device->createDescriptorSetLayout(descriptorLayout);
+		}
+		
+		return DSLayout;
+	}
+	
 	vk::DescriptorSetLayout& Pipeline::getDescriptorSetLayoutSSR()
 	{
 		static vk::DescriptorSetLayout DSLayout = nullptr;
@@ -521,7 +579,7 @@ namespace pe
 					layoutBinding(1, vk::DescriptorType::eCombinedImageSampler),
 					layoutBinding(2, vk::DescriptorType::eCombinedImageSampler),
 					layoutBinding(3, vk::DescriptorType::eCombinedImageSampler),
-					layoutBinding(4, vk::DescriptorType::eUniformBuffer),
+					layoutBinding(4, vk::DescriptorType::eUniformBufferDynamic),
 			};
 			vk::DescriptorSetLayoutCreateInfo descriptorLayout;
 			descriptorLayout.bindingCount = static_cast<uint32_t>(setLayoutBindings.size());
@@ -549,7 +607,7 @@ namespace pe
 					layoutBinding(1, vk::DescriptorType::eCombinedImageSampler),
 					layoutBinding(2, vk::DescriptorType::eCombinedImageSampler),
 					layoutBinding(3, vk::DescriptorType::eCombinedImageSampler),
-					layoutBinding(4, vk::DescriptorType::eUniformBuffer)
+					layoutBinding(4, vk::DescriptorType::eUniformBufferDynamic)
 			};
 			vk::DescriptorSetLayoutCreateInfo descriptorLayout;
 			descriptorLayout.bindingCount = static_cast<uint32_t>(setLayoutBindings.size());
@@ -574,7 +632,7 @@ namespace pe
 			};
 			std::vector<vk::DescriptorSetLayoutBinding> setLayoutBindings {
 					layoutBinding(0, vk::DescriptorType::eCombinedImageSampler),
-					layoutBinding(1, vk::DescriptorType::eUniformBuffer)
+					layoutBinding(1, vk::DescriptorType::eUniformBufferDynamic)
 			};
 			vk::DescriptorSetLayoutCreateInfo descriptorLayout;
 			descriptorLayout.bindingCount = static_cast<uint32_t>(setLayoutBindings.size());
@@ -598,7 +656,7 @@ namespace pe
 				return vk::DescriptorSetLayoutBinding {binding, descriptorType, 1, stageFlags, nullptr};
 			};
 			std::vector<vk::DescriptorSetLayoutBinding> setLayoutBindings {
-					layoutBinding(0, vk::DescriptorType::eUniformBuffer, vk::ShaderStageFlagBits::eVertex),
+					layoutBinding(0, vk::DescriptorType::eUniformBufferDynamic, vk::ShaderStageFlagBits::eVertex),
 					layoutBinding(1, vk::DescriptorType::eCombinedImageSampler, vk::ShaderStageFlagBits::eFragment),
 			};
 			vk::DescriptorSetLayoutCreateInfo descriptorLayout;
@@ -623,7 +681,8 @@ namespace pe
 				};
 			};
 			std::vector<vk::DescriptorSetLayoutBinding> setLayoutBindings {
-					layoutBinding(0, vk::DescriptorType::eUniformBuffer),
+					layoutBinding(0, vk::DescriptorType::eUniformBufferDynamic),
+					layoutBinding(1, vk::DescriptorType::eStorageBufferDynamic), // joint matrices
 			};
 			vk::DescriptorSetLayoutCreateInfo descriptorLayout;
 			descriptorLayout.bindingCount = static_cast<uint32_t>(setLayoutBindings.size());
@@ -672,7 +731,7 @@ namespace pe
 			vk::DescriptorSetLayoutBinding dslb;
 			dslb.binding = 0;
 			dslb.descriptorCount = 1; // number of descriptors contained
-			dslb.descriptorType = vk::DescriptorType::eUniformBuffer;
+			dslb.descriptorType = vk::DescriptorType::eStorageBufferDynamic; // per instance data, one slice per frame
 			dslb.stageFlags = vk::ShaderStageFlagBits::eVertex;
 			
 			vk::DescriptorSetLayoutCreateInfo dslci;
@@ -684,6 +743,43 @@ namespace pe
 		return DSLayout;
 	}
 	
+	vk::DescriptorSetLayout& Pipeline::getDescriptorSetLayoutBindless()
+	{
+		static vk::DescriptorSetLayout DSLayout = nullptr;
+		
+		if (!DSLayout)
+		{
+			std::vector<vk::DescriptorSetLayoutBinding> setLayoutBindings {
+					{
+							0, vk::DescriptorType::eCombinedImageSampler, MAX_BINDLESS_TEXTURES,
+							vk::ShaderStageFlagBits::eFragment, nullptr
+					},
+					{
+							1, vk::DescriptorType::eStorageBuffer, 1,
+							vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment, nullptr
+					}
+			};
+			// textures are written while the set is in use, unused slots stay empty
+			std::vector<vk::DescriptorBindingFlags> bindingFlags {
+					vk::DescriptorBindingFlagBits::ePartiallyBound | vk::DescriptorBindingFlagBits::eUpdateAfterBind |
+					vk::DescriptorBindingFlagBits::eUpdateUnusedWhilePending,
+					vk::DescriptorBindingFlags()
+			};
+			vk::DescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo;
+			bindingFlagsInfo.bindingCount = static_cast<uint32_t>(bindingFlags.size());
+			bindingFlagsInfo.pBindingFlags = bindingFlags.data();
+			
+			vk::DescriptorSetLayoutCreateInfo descriptorLayout;
+			descriptorLayout.flags = vk::DescriptorSetLayoutCreateFlagBits::eUpdateAfterBindPool;
+			descriptorLayout.bindingCount = static_cast<uint32_t>(setLayoutBindings.size());
+			descriptorLayout.pBindings = setLayoutBindings.data();
+			descriptorLayout.pNext = &bindingFlagsInfo;
+			DSLayout = VulkanContext::Get()->device->createDescriptorSetLayout(descriptorLayout);
+		}
+		
+		return DSLayout;
+	}
+	
 	vk::DescriptorSetLayout& Pipeline::getDescriptorSetLayoutSkybox()
 	{
 		static vk::DescriptorSetLayout DSLayout = nullptr;
@@ -733,4 +829,33 @@ namespace pe
 		
 		return DSLayout;
 	}
+	
+	vk::DescriptorSetLayout& Pipeline::getDescriptorSetLayoutAnimation()
+	{
+		static vk::DescriptorSetLayout DSLayout = nullptr;
+		
+		if (!DSLayout)
+		{
+			auto const setLayoutBinding = [](uint32_t binding, vk::DescriptorType descriptorType)
+			{
+				return vk::DescriptorSetLayoutBinding {
+						binding, descriptorType, 1, vk::ShaderStageFlagBits::eCompute, nullptr
+				};
+			};
+			
+			std::vector<vk::DescriptorSetLayoutBinding> setLayoutBindings {
+					setLayoutBinding(0, vk::DescriptorType::eStorageBufferDynamic), // node local matrices
+					setLayoutBinding(1, vk::DescriptorType::eStorageBufferDynamic), // node global matrices
+					setLayoutBinding(2, vk::DescriptorType::eStorageBuffer),        // joints
+					setLayoutBinding(3, vk::DescriptorType::eStorageBufferDynamic)  // joint matrices
+			};
+			
+			vk::DescriptorSetLayoutCreateInfo dlci;
+			dlci.bindingCount = static_cast<uint32_t>(setLayoutBindings.size());
+			dlci.pBindings = setLayoutBindings.data();
+			DSLayout = VulkanContext::Get()->device->createDescriptorSetLayout(dlci);
+		}
+		
+		return DSLayout;
+	}
 }
\ No newline at end of file
@@ -53,6 +53,7 @@ namespace pe
 	{
 		Vertex = 1,
 		Fragment = 16,
+		VertexAndFragment = 17,
 		Compute = 32
 	};
 	
@@ -68,8 +69,6 @@ namespace pe
 		Shader* pCompShader;
 		Ref<std::vector<vk::VertexInputBindingDescription>> vertexInputBindingDescriptions;
 		Ref<std::vector<vk::VertexInputAttributeDescription>> vertexInputAttributeDescriptions;
-		float width;
-		float height;
 		CullMode cullMode;
 		Ref<std::vector<vk::PipelineColorBlendAttachmentState>> colorBlendAttachments;
 		Ref<std::vector<vk::DynamicState>> dynamicStates;
@@ -116,6 +115,10 @@ namespace pe
 		
 		static vk::DescriptorSetLayout& getDescriptorSetLayoutSSAOBlur();
 		
+		static vk::DescriptorSetLayout& getDescriptorSetLayoutSSAOCompute();
+		
+		static vk::DescriptorSetLayout& getDescriptorSetLayoutSSAOBlurCompute();
+		
 		static vk::DescriptorSetLayout& getDescriptorSetLayoutSSR();
 		
 		static vk::DescriptorSetLayout& getDescriptorSetLayoutTAA();
@@ -130,8 +133,12 @@ namespace pe
 		
 		static vk::DescriptorSetLayout& getDescriptorSetLayoutModel();
 		
+		static vk::DescriptorSetLayout& getDescriptorSetLayoutBindless();
+		
 		static vk::DescriptorSetLayout& getDescriptorSetLayoutSkybox();
 		
 		static vk::DescriptorSetLayout& getDescriptorSetLayoutCompute();
+		
+		static vk::DescriptorSetLayout& getDescriptorSetLayoutAnimation();
 	};
 }
\ No newline at end of file
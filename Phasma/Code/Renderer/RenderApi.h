@@ -23,6 +23,7 @@ SOFTWARE.
 #pragma once
 
 #include "Vulkan/Vulkan.h"
+#include "Null/Null.h"
 #ifdef WIN32
 	#include "Dx12/Dx12.h"
 #endif
@@ -32,6 +33,7 @@ namespace pe
 	enum class RenderApi
 	{
 		Vulkan,
+		Null, // Host allocations and no-op command recording, for cpu only runs
 #ifdef WIN32
 		Dx12 // Not implemented yet
 #endif
@@ -44,7 +46,8 @@ namespace pe
 
 //                  DYNAMIC RENDERING API
 // ------------------------------------------------------------//
-//#define DYNAMIC_RENDER_API
+// Needed for the Null api, which is picked at startup with --null
+#define DYNAMIC_RENDER_API
 // ------------------------------------------------------------//
 
 //                  DEFAULT RENDERING API
@@ -58,6 +61,7 @@ namespace pe
 	inline RenderApi g_Api = defaultRenderApi;
 	
 	#define PE_VULKAN bool(g_Api == RenderApi::Vulkan)
+	#define PE_NULL bool(g_Api == RenderApi::Null)
 	#ifdef WIN32
 		#define PE_DX12 bool(g_Api == RenderApi::Dx12)
 	#endif
@@ -67,6 +71,7 @@ namespace pe
 	constexpr RenderApi g_Api = defaultRenderApi;
 	
 	constexpr bool PE_VULKAN = g_Api == RenderApi::Vulkan;
+	constexpr bool PE_NULL = g_Api == RenderApi::Null;
 	#ifdef WIN32
 		constexpr bool PE_DX12 = g_Api == RenderApi::Dx12;
 	#endif
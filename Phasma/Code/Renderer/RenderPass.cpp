@@ -95,6 +95,20 @@ namespace pe
 		handle = make_ref(VulkanContext::Get()->device->createRenderPass(renderPassInfo));
 	}
 	
+	void RenderPass::SetViewport(vk::CommandBuffer cmd, const vk::Rect2D& renderArea)
+	{
+		vk::Viewport viewport;
+		viewport.x = static_cast<float>(renderArea.offset.x);
+		viewport.y = static_cast<float>(renderArea.offset.y);
+		viewport.width = static_cast<float>(renderArea.extent.width);
+		viewport.height = static_cast<float>(renderArea.extent.height);
+		viewport.minDepth = 0.0f;
+		viewport.maxDepth = 1.0f;
+		
+		cmd.setViewport(0, viewport);
+		cmd.setScissor(0, renderArea);
+	}
+	
 	void RenderPass::Destroy()
 	{
 		if (*handle)
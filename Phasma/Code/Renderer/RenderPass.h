@@ -30,6 +30,10 @@ namespace vk
 	enum class Format;
 	
 	class RenderPass;
+	
+	class CommandBuffer;
+	
+	struct Rect2D;
 }
 
 namespace pe
@@ -47,6 +51,9 @@ namespace pe
 		
 		void Destroy();
 		
+		// Pipelines have dynamic viewport and scissor, set them after beginning a render pass
+		static void SetViewport(vk::CommandBuffer cmd, const vk::Rect2D& renderArea);
+		
 		Ref<vk::RenderPass> handle;
 	};
 }
\ No newline at end of file
@@ -23,12 +23,19 @@ SOFTWARE.
 #include "PhasmaPch.h"
 #include "Renderer.h"
 #include "../Core/Queue.h"
+#include "UploadManager.h"
+#include "DynamicResolution.h"
+#include "AnimationCompute.h"
 #include "../Model/Mesh.h"
 #include "RenderApi.h"
 #include "../Camera/Camera.h"
 #include "../ECS/Context.h"
 #include "../Core/Path.h"
 #include "../Event/EventSystem.h"
+#include "../Core/Profiler.h"
+#include "../Core/FrameHistory.h"
+#include <set>
+#include <iostream>
 
 namespace pe
 {
@@ -60,13 +67,17 @@ namespace pe
 		EventSystem::Get()->DispatchEvent(EventType::SetWindowTitle, title);
 		
 		// INIT RENDERING
+		// the ssao targets are also storage images when SSAO can run on the async compute queue
+		const vk::ImageUsageFlags ssaoUsage = SSAO::ComputeSupported() ?
+		                                      vk::ImageUsageFlagBits::eStorage : vk::ImageUsageFlags();
 		AddRenderTarget("viewport", vulkan->surface.formatKHR->format, vk::ImageUsageFlagBits::eTransferSrc);
+		AddRenderTarget("viewportPong", vulkan->surface.formatKHR->format, vk::ImageUsageFlagBits::eTransferSrc);
 		AddRenderTarget("depth", vk::Format::eR32Sfloat, vk::ImageUsageFlags());
 		AddRenderTarget("normal", vk::Format::eR32G32B32A32Sfloat, vk::ImageUsageFlags());
 		AddRenderTarget("albedo", vulkan->surface.formatKHR->format, vk::ImageUsageFlags());
 		AddRenderTarget("srm", vulkan->surface.formatKHR->format, vk::ImageUsageFlags()); // Specular Roughness Metallic
-		AddRenderTarget("ssao", vk::Format::eR16Unorm, vk::ImageUsageFlags());
-		AddRenderTarget("ssaoBlur", vk::Format::eR8Unorm, vk::ImageUsageFlags());
+		AddRenderTarget("ssao", vk::Format::eR16Unorm, ssaoUsage);
+		AddRenderTarget("ssaoBlur", vk::Format::eR8Unorm, ssaoUsage);
 		AddRenderTarget("ssr", vulkan->surface.formatKHR->format, vk::ImageUsageFlags());
 		AddRenderTarget("velocity", vk::Format::eR16G16Sfloat, vk::ImageUsageFlags());
 		AddRenderTarget("brightFilter", vulkan->surface.formatKHR->format, vk::ImageUsageFlags());
@@ -76,10 +87,6 @@ namespace pe
 		AddRenderTarget("taa", vulkan->surface.formatKHR->format, vk::ImageUsageFlagBits::eTransferSrc);
 		
 		taa.Init();
-		bloom.Init();
-		fxaa.Init();
-		motionBlur.Init();
-		dof.Init();
 		
 		// render passes
 		shadows.createRenderPass();
@@ -107,6 +114,7 @@ namespace pe
 		
 		// pipelines
 		shadows.createPipeline();
+		shadows.invalidate();
 		ssao.createPipelines(renderTargets);
 		ssr.createPipeline(renderTargets);
 		deferred.createPipelines(renderTargets);
@@ -119,7 +127,13 @@ namespace pe
 		
 		//transformsCompute = Compute::Create("Shaders/Compute/shader.comp", 64, 64);
 		
-		metrics.resize(20);
+		gpuTimer.init();
+		// STAGING RING AND TRANSFER QUEUE FOR ALL UPLOADS
+		UploadManager::init();
+		// GEOMETRY ARENA FOR ALL MODELS
+		GeometryArena::init();
+		// NODE AND JOINT BUFFERS FOR THE SKINNED MODELS
+		AnimationCompute::init();
 		//LOAD RESOURCES
 		LoadResources();
 		// CREATE UNIFORMS AND DESCRIPTOR SETS
@@ -160,6 +174,10 @@ namespace pe
 		for (auto& texture : Mesh::uniqueTextures)
 			texture.second.destroy();
 		Mesh::uniqueTextures.clear();
+		BindlessMaterials::destroy();
+		GeometryArena::destroy();
+		AnimationCompute::destroy();
+		UploadManager::destroy();
 		
 		Compute::DestroyResources();
 		shadows.destroy();
@@ -175,24 +193,65 @@ namespace pe
 		skyBoxNight.destroy();
 		gui.destroy();
 		lightUniforms.destroy();
-		for (auto& metric : metrics)
-			metric.destroy();
+		gpuTimer.destroy();
 		ctx->GetVKContext()->Destroy();
 		ctx->GetVKContext()->Remove();
 	}
 	
+	// a load that threw, out of arena or bindless space or a broken file, the partial model is destroyed like an unload
+	struct ModelLoadFailure
+	{
+		Model model;
+		std::string fullPathName;
+		std::string message;
+	};
+	
 	void Renderer::CheckQueue()
 	{
+		PE_PROFILE_SCOPE("Renderer::CheckQueue");
+		
+		// paths with a load in progress, their duplicates wait for it and become instances
+		static std::set<std::string> loadingModels {};
+		
 		for (auto it = Queue::loadModel.begin(); it != Queue::loadModel.end();)
 		{
+			const std::string fullPathName = std::get<0>(*it) + std::get<1>(*it);
+			if (Model* source = Model::findLoaded(fullPathName))
+			{
+				FrameHistory::Mark("model_instance");
+				VulkanContext::Get()->device->waitIdle();
+				Model::models.push_back(source->createInstance());
+				GUI::modelList.push_back(Model::models.back().name);
+				GUI::model_scale.push_back({1.f, 1.f, 1.f});
+				GUI::model_pos.push_back({0.f, 0.f, 0.f});
+				GUI::model_rot.push_back({0.f, 0.f, 0.f});
+				it = Queue::loadModel.erase(it);
+				continue;
+			}
+			if (loadingModels.find(fullPathName) != loadingModels.end())
+			{
+				++it;
+				continue;
+			}
+			loadingModels.insert(fullPathName);
+			
+			FrameHistory::Mark("model_load");
 			VulkanContext::Get()->device->waitIdle();
 			Queue::loadModelFutures.push_back(
 					std::async(
 							std::launch::async,
 							[](const std::string& folderPath, const std::string& modelName, bool show = true)
 							{
+								PE_PROFILE_THREAD("Loader");
 								Model model;
-								model.loadModel(folderPath, modelName, show);
+								try
+								{
+									model.loadModel(folderPath, modelName, show);
+								}
+								catch (const std::exception& e)
+								{
+									return std::any(ModelLoadFailure {model, folderPath + modelName, e.what()});
+								}
 								for (auto& _model : Model::models)
 									if (_model.name == model.name)
 										model.name = "_" + model.name;
@@ -207,7 +266,20 @@ namespace pe
 		{
 			if (it->wait_for(std::chrono::seconds(0)) != std::future_status::timeout)
 			{
-				Model::models.push_back(std::any_cast<Model>(it->get()));
+				FrameHistory::Mark("model_load");
+				std::any result = it->get();
+				if (auto* failure = std::any_cast<ModelLoadFailure>(&result))
+				{
+					// the rest of the scene keeps running, the duplicates that waited on it try again
+					VulkanContext::Get()->device->waitIdle();
+					failure->model.destroy();
+					loadingModels.erase(failure->fullPathName);
+					std::cerr << "Failed to load " << failure->fullPathName << ": " << failure->message << std::endl;
+					it = Queue::loadModelFutures.erase(it);
+					continue;
+				}
+				Model::models.push_back(std::any_cast<Model>(std::move(result)));
+				loadingModels.erase(Model::models.back().fullPathName);
 				GUI::modelList.push_back(Model::models.back().name);
 				GUI::model_scale.push_back({1.f, 1.f, 1.f});
 				GUI::model_pos.push_back({0.f, 0.f, 0.f});
@@ -222,6 +294,7 @@ namespace pe
 		
 		for (auto it = Queue::unloadModel.begin(); it != Queue::unloadModel.end();)
 		{
+			FrameHistory::Mark("model_unload");
 			VulkanContext::Get()->device->waitIdle();
 			Model::models[*it].destroy();
 			Model::models.erase(Model::models.begin() + *it);
@@ -232,6 +305,8 @@ namespace pe
 			GUI::modelItemSelected = -1;
 			it = Queue::unloadModel.erase(it);
 		}
+		
+		Model::assignInstanceOwners();
 #ifndef IGNORE_SCRIPTS
 		for (auto it = Queue::addScript.begin(); it != Queue::addScript.end();) {
 			delete Model::models[std::get<0>(*it)].script;
@@ -260,18 +335,23 @@ namespace pe
 	}
 	
 	
-	void Renderer::ComputeAnimations()
+	void Renderer::ComputeAnimations(vk::CommandBuffer cmd)
 	{
-	
+		AnimationCompute::dispatch(cmd);
 	}
 	
 	void Renderer::Update(double delta)
 	{
+		PE_PROFILE_SCOPE("Renderer::Update");
+		
 		static Timer timer;
 		timer.Start();
 		
 		// check for commands in queue
 		CheckQueue();
+		
+		// pick the scene resolution from the last measured gpu frame time
+		DynamicResolution::Update(GpuFrameTime(), renderTargets["viewport"]);
 
 #ifndef IGNORE_SCRIPTS
 		// universal scripts
@@ -281,6 +361,17 @@ namespace pe
 		
 		CameraSystem* cameraSystem = ctx->GetSystem<CameraSystem>();
 		Camera* camera_main = cameraSystem->GetCamera(0);
+		LightSystem* lightSystem = ctx->GetSystem<LightSystem>();
+		
+		// the light storage grows before the update writes into it
+		if (lightUniforms.reserve(*lightSystem))
+		{
+			FrameHistory::Mark("light_storage");
+			deferred.updateDescriptorSets(renderTargets, lightUniforms);
+		}
+		
+		static Timer timerStage;
+		timerStage.Start();
 		
 		// Model updates + 8(the rest updates)
 		std::vector<std::future<void>> futureUpdates;
@@ -307,7 +398,7 @@ namespace pe
 		
 		// LIGHTS
 		auto updateLights = [&]()
-		{ lightUniforms.update(*camera_main); };
+		{ lightUniforms.update(*camera_main, *lightSystem); };
 		futureUpdates.push_back(std::async(std::launch::async, updateLights));
 		
 		// SSAO
@@ -343,46 +434,169 @@ namespace pe
 		for (auto& f : futureUpdates)
 			f.get();
 		
-		static Timer timerFenceWait;
-		timerFenceWait.Start();
-		VulkanContext::Get()->waitFences((*VulkanContext::Get()->fences)[previousImageIndex]);
-		FrameTimer::Instance().timestamps[0] = timerFenceWait.Count();
+		auto& timestamps = FrameTimer::Instance().timestamps;
+		timestamps[StageUpdates] = timerStage.Count();
+		timerStage.Start();
+		
+		// gather the instance data of the models, after their transforms are updated
+		Model::updateInstances(*camera_main);
+		drawList.build(*camera_main);
+		shadows.cullCasters();
+		AnimationCompute::update();
+		
+		timestamps[StageCulling] = timerStage.Count();
+		timerStage.Start();
+		
+		// wait only for the gpu work that used this frame's resources, MAX_FRAMES_IN_FLIGHT frames ago,
+		// unless WaitForFrame already did before the input was sampled
+		if (!frameWaited)
+		{
+			VulkanContext::Get()->waitFences((*VulkanContext::Get()->fences)[VulkanContext::Get()->frameIndex]);
+			timestamps[StageFenceWait] = timerStage.Count();
+			timestamps[StageLatencySleep] = 0.0;
+		}
+		frameWaited = false;
+		timerStage.Start();
+		
+		// the timestamps of that frame are written by now
+		ResolveMetrics();
+		// vma refreshes the heap budgets once per frame
+		vmaSetCurrentFrameIndex(VulkanContext::Get()->allocator, static_cast<uint32_t>(FrameHistory::frame));
+		
 		Queue::exec_memcpyRequests();
+		timestamps[StageMemcpy] = timerStage.Count();
 		
 		GUI::updatesTimeCount = static_cast<float>(timer.Count());
 	}
 	
+	void Renderer::WaitForFrame()
+	{
+		PE_PROFILE_SCOPE("Renderer::WaitForFrame");
+		
+		// the fence stays reset until this frame is submitted, so it can be waited once
+		if (frameWaited)
+			return;
+		
+		Timer timer;
+		timer.Start();
+		
+		auto& vCtx = *VulkanContext::Get();
+		vCtx.waitFences((*vCtx.fences)[vCtx.frameIndex]);
+		frameWaited = true;
+		
+		auto& timestamps = FrameTimer::Instance().timestamps;
+		timestamps[StageFenceWait] = timer.Count();
+		timer.Start();
+		
+		// the gpu just started the previous frame, sleep so the cpu work of this one ends when that is done
+		const double cpuTime = timestamps[StageUpdates] + timestamps[StageCulling] + timestamps[StageMemcpy] +
+		                       timestamps[StageRecording] + timestamps[StageSubmit];
+		const double gpuTime = GpuFrameTime() * 0.001;
+		
+		// keep a margin for the variance of both, a late submit idles the gpu and costs throughput
+		const double slack = gpuTime * 0.9 - cpuTime - 0.001;
+		if (slack > 0.0)
+			FrameTimer::Instance().Delay(slack);
+		
+		timestamps[StageLatencySleep] = timer.Count();
+	}
+	
+	float Renderer::GpuFrameTime()
+	{
+		return GUI::metrics[RegionDeferred] + GUI::metrics[RegionGBuffer] +
+		       (GUI::shadow_cast ? GUI::metrics[RegionShadows] + GUI::metrics[RegionShadows + 1] +
+		                           GUI::metrics[RegionShadows + 2] : 0.f);
+	}
+	
+	void Renderer::ResolveMetrics()
+	{
+		gpuTimer.resolve(VulkanContext::Get()->frameIndex);
+		
+		for (uint32_t i = 0; i < RegionCount; i++)
+		{
+			GUI::metrics[i] = gpuTimer.time(static_cast<GPURegion>(i));
+			GUI::metricsAverage[i] = gpuTimer.average(static_cast<GPURegion>(i));
+		}
+		
+		// time the async ssao ran alongside the shadow passes
+		GUI::metrics[15] = 0.f;
+		for (uint32_t i = 0; i < shadows.textures.size(); i++)
+			GUI::metrics[15] += gpuTimer.overlap(RegionSSAO, static_cast<GPURegion>(RegionShadows + i));
+		GUI::metricsAverage[15] = GUI::metrics[15];
+	}
+	
+	void Renderer::RecordGBufferCmds(const uint32_t& imageIndex)
+	{
+		PE_PROFILE_SCOPE("Renderer::RecordGBufferCmds");
+		
+		vk::CommandBufferBeginInfo beginInfo;
+		beginInfo.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit;
+		
+		const auto& cmd = (*VulkanContext::Get()->gbufferCmdBuffers)[VulkanContext::Get()->frameIndex];
+		
+		cmd.begin(beginInfo);
+		
+		// NODE AND JOINT MATRICES, before the g-buffer and the shadows that skin with them
+		ComputeAnimations(cmd);
+		
+		// the first command buffer of the frame, the timestamps of the frame are written after this reset
+		gpuTimer.reset(cmd);
+		
+		// MODELS
+		gpuTimer.begin(cmd, RegionGBuffer);
+		deferred.batchStart(cmd, imageIndex, DynamicResolution::Extent());
+		
+		drawList.record(cmd, deferred.pipeline);
+		
+		deferred.batchEnd();
+		gpuTimer.end(cmd, RegionGBuffer);
+		
+		if (asyncSSAO)
+			ssao.releaseToCompute(cmd, renderTargets);
+		
+		cmd.end();
+	}
+	
+	void Renderer::RecordComputeCmds()
+	{
+		PE_PROFILE_SCOPE("Renderer::RecordComputeCmds");
+		
+		vk::CommandBufferBeginInfo beginInfo;
+		beginInfo.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit;
+		
+		auto& vCtx = *VulkanContext::Get();
+		const auto& cmd = (*vCtx.computeCmdBuffers)[vCtx.frameIndex];
+		const bool timestamps = (*vCtx.queueFamilyProperties)[vCtx.computeFamilyId].timestampValidBits > 0;
+		
+		cmd.begin(beginInfo);
+		
+		// SCREEN SPACE AMBIENT OCCLUSION, overlaps with the shadow passes of the graphics queue
+		if (timestamps)
+			gpuTimer.begin(cmd, RegionSSAO);
+		ssao.compute(cmd, renderTargets);
+		if (timestamps)
+			gpuTimer.end(cmd, RegionSSAO);
+		
+		cmd.end();
+	}
+	
 	void Renderer::RecordDeferredCmds(const uint32_t& imageIndex)
 	{
+		PE_PROFILE_SCOPE("Renderer::RecordDeferredCmds");
+		
 		vk::CommandBufferBeginInfo beginInfo;
 		beginInfo.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit;
 		
-		const auto& cmd = (*VulkanContext::Get()->dynamicCmdBuffers)[imageIndex];
+		const auto& cmd = (*VulkanContext::Get()->dynamicCmdBuffers)[VulkanContext::Get()->frameIndex];
 		
 		cmd.begin(beginInfo);
-		// TODO: add more queries (times the swapchain images), so they are not overlapped from previous frame
-		metrics[0].start(&cmd);
+		gpuTimer.begin(cmd, RegionDeferred);
 		
 		// SKYBOX
 		SkyBox& skybox = GUI::shadow_cast ? skyBoxDay : skyBoxNight;
 		
-		// MODELS
-		{
-			metrics[2].start(&cmd);
-			deferred.batchStart(cmd, imageIndex, *renderTargets["viewport"].extent);
-			
-			for (auto& model : Model::models)
-				model.draw((uint16_t) RenderQueue::Opaque);
-			
-			for (auto& model : Model::models)
-				model.draw((uint16_t) RenderQueue::AlphaCut);
-			
-			for (auto& model : Model::models)
-				model.draw((uint16_t) RenderQueue::AlphaBlend);
-			
-			deferred.batchEnd();
-			metrics[2].end(&GUI::metrics[2]);
-		}
+		if (asyncSSAO)
+			ssao.acquireFromCompute(cmd, renderTargets);
 		
 		renderTargets["albedo"].changeLayout(cmd, LayoutState::ColorRead);
 		renderTargets["depth"].changeLayout(cmd, LayoutState::ColorRead);
@@ -397,77 +611,100 @@ namespace pe
 			image.changeLayout(cmd, LayoutState::DepthRead);
 		
 		// SCREEN SPACE AMBIENT OCCLUSION
-		if (GUI::show_ssao)
+		if (GUI::show_ssao && !asyncSSAO)
 		{
-			metrics[3].start(&cmd);
+			gpuTimer.begin(cmd, RegionSSAO);
 			renderTargets["ssaoBlur"].changeLayout(cmd, LayoutState::ColorWrite);
 			ssao.draw(cmd, imageIndex, renderTargets["ssao"]);
 			renderTargets["ssaoBlur"].changeLayout(cmd, LayoutState::ColorRead);
-			metrics[3].end(&GUI::metrics[3]);
+			gpuTimer.end(cmd, RegionSSAO);
 		}
 		
 		// SCREEN SPACE REFLECTIONS
 		if (GUI::show_ssr)
 		{
-			metrics[4].start(&cmd);
+			gpuTimer.begin(cmd, RegionSSR);
 			renderTargets["ssr"].changeLayout(cmd, LayoutState::ColorWrite);
-			ssr.draw(cmd, imageIndex, *renderTargets["ssr"].extent);
+			ssr.draw(cmd, imageIndex, DynamicResolution::Extent());
 			renderTargets["ssr"].changeLayout(cmd, LayoutState::ColorRead);
-			metrics[4].end(&GUI::metrics[4]);
+			gpuTimer.end(cmd, RegionSSR);
 		}
 		
 		// COMPOSITION
-		metrics[5].start(&cmd);
+		gpuTimer.begin(cmd, RegionLights);
 		deferred.draw(cmd, imageIndex, shadows, skybox, *renderTargets["viewport"].extent);
-		metrics[5].end(&GUI::metrics[5]);
+		gpuTimer.end(cmd, RegionLights);
+		
+		// POST PROCESS
+		// every effect reads the current post process target and renders into the other one
+		// keep the chain time of both modes, to compare the fused and the separate passes
+		const bool fuseDOF = GUI::use_DOF && GUI::show_motionBlur && GUI::fuse_DOF_motionBlur;
+		const GPURegion postRegion = fuseDOF ? RegionPostFused : RegionPostSeparate;
+		gpuTimer.begin(cmd, postRegion);
+		uint32_t input = 0;
+		const auto prepareTargets = [this, &cmd, &input]()
+		{
+			renderTargets[POST_PROCESS_TARGETS[input]].changeLayout(cmd, LayoutState::ColorRead);
+			renderTargets[POST_PROCESS_TARGETS[1 - input]].changeLayout(cmd, LayoutState::ColorWrite);
+		};
 		
 		if (GUI::use_AntiAliasing)
 		{
 			// TAA
 			if (GUI::use_TAA)
 			{
-				metrics[6].start(&cmd);
-				taa.frameImage.copyColorAttachment(cmd, renderTargets["viewport"]);
-				taa.draw(cmd, imageIndex, renderTargets);
-				metrics[6].end(&GUI::metrics[6]);
+				gpuTimer.begin(cmd, RegionAntiAliasing);
+				prepareTargets();
+				taa.draw(cmd, imageIndex, input, renderTargets);
+				input = 1 - input;
+				gpuTimer.end(cmd, RegionAntiAliasing);
 			}
 				// FXAA
 			else if (GUI::use_FXAA)
 			{
-				metrics[6].start(&cmd);
-				fxaa.frameImage.copyColorAttachment(cmd, renderTargets["viewport"]);
-				fxaa.draw(cmd, imageIndex, *renderTargets["viewport"].extent);
-				metrics[6].end(&GUI::metrics[6]);
+				gpuTimer.begin(cmd, RegionAntiAliasing);
+				prepareTargets();
+				fxaa.draw(cmd, imageIndex, input, *renderTargets["viewport"].extent);
+				input = 1 - input;
+				gpuTimer.end(cmd, RegionAntiAliasing);
 			}
 		}
 		
-		// BLOOM
+		// BLOOM (the combine pass also applies the tone mapping)
 		if (GUI::show_Bloom)
 		{
-			metrics[7].start(&cmd);
-			bloom.frameImage.copyColorAttachment(cmd, renderTargets["viewport"]);
-			bloom.draw(cmd, imageIndex, renderTargets);
-			metrics[7].end(&GUI::metrics[7]);
+			gpuTimer.begin(cmd, RegionBloom);
+			prepareTargets();
+			bloom.draw(cmd, imageIndex, input, renderTargets);
+			input = 1 - input;
+			gpuTimer.end(cmd, RegionBloom);
 		}
 		
-		// Depth of Field
-		if (GUI::use_DOF)
+		// Depth of Field, can be fused in the motion blur pass
+		if (GUI::use_DOF && !fuseDOF)
 		{
-			metrics[8].start(&cmd);
-			dof.frameImage.copyColorAttachment(cmd, renderTargets["viewport"]);
-			dof.draw(cmd, imageIndex, renderTargets);
-			metrics[8].end(&GUI::metrics[8]);
+			gpuTimer.begin(cmd, RegionDOF);
+			prepareTargets();
+			dof.draw(cmd, imageIndex, input, renderTargets);
+			input = 1 - input;
+			gpuTimer.end(cmd, RegionDOF);
 		}
 		
 		// MOTION BLUR
 		if (GUI::show_motionBlur)
 		{
-			metrics[9].start(&cmd);
-			motionBlur.frameImage.copyColorAttachment(cmd, renderTargets["viewport"]);
-			motionBlur.draw(cmd, imageIndex, *renderTargets["viewport"].extent);
-			metrics[9].end(&GUI::metrics[9]);
+			gpuTimer.begin(cmd, RegionMotionBlur);
+			prepareTargets();
+			motionBlur.draw(cmd, imageIndex, input, *renderTargets["viewport"].extent, fuseDOF);
+			input = 1 - input;
+			gpuTimer.end(cmd, RegionMotionBlur);
 		}
 		
+		// the final image is in the input target, both go back to color attachments
+		renderTargets[POST_PROCESS_TARGETS[1 - input]].changeLayout(cmd, LayoutState::ColorWrite);
+		renderTargets[POST_PROCESS_TARGETS[input]].changeLayout(cmd, LayoutState::ColorWrite);
+		gpuTimer.end(cmd, postRegion);
+		
 		renderTargets["albedo"].changeLayout(cmd, LayoutState::ColorWrite);
 		renderTargets["depth"].changeLayout(cmd, LayoutState::ColorWrite);
 		renderTargets["normal"].changeLayout(cmd, LayoutState::ColorWrite);
@@ -481,21 +718,22 @@ namespace pe
 			image.changeLayout(cmd, LayoutState::DepthWrite);
 		
 		// GUI
-		metrics[10].start(&cmd);
-		gui.scaleToRenderArea(cmd, renderTargets["viewport"], imageIndex);
+		gpuTimer.begin(cmd, RegionGUI);
+		gui.scaleToRenderArea(cmd, renderTargets[POST_PROCESS_TARGETS[input]], imageIndex);
 		gui.draw(cmd, imageIndex);
-		metrics[10].end(&GUI::metrics[10]);
+		gpuTimer.end(cmd, RegionGUI);
 		
-		metrics[0].end(&GUI::metrics[0]);
+		gpuTimer.end(cmd, RegionDeferred);
 		
 		cmd.end();
 	}
 	
 	void Renderer::RecordShadowsCmds(const uint32_t& imageIndex)
 	{
+		PE_PROFILE_SCOPE("Renderer::RecordShadowsCmds");
+		
 		// Render Pass (shadows mapping) (outputs the depth image with the light POV)
 		
-		const vk::DeviceSize offset = vk::DeviceSize();
 		std::array<vk::ClearValue, 1> clearValuesShadows {};
 		clearValuesShadows[0].depthStencil = vk::ClearDepthStencilValue {0.0f, 0};
 		
@@ -512,46 +750,53 @@ namespace pe
 		for (uint32_t i = 0; i < shadows.textures.size(); i++)
 		{
 			auto& cmd = (*VulkanContext::Get()->shadowCmdBuffers)[
-					static_cast<uint32_t>(shadows.textures.size()) * imageIndex + i];
+					static_cast<uint32_t>(shadows.textures.size()) * VulkanContext::Get()->frameIndex + i];
 			cmd.begin(beginInfoShadows);
-			metrics[11 + static_cast<size_t>(i)].start(&cmd);
+			gpuTimer.begin(cmd, static_cast<GPURegion>(RegionShadows + i));
 			cmd.setDepthBias(GUI::depthBias[0], GUI::depthBias[1], GUI::depthBias[2]);
 			
 			// depth[i] image ===========================================================
-			renderPassInfoShadows.framebuffer = *shadows.framebuffers[shadows.textures.size() * imageIndex + i].handle;
-			cmd.beginRenderPass(renderPassInfoShadows, vk::SubpassContents::eInline);
-			cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, *shadows.pipeline.handle);
-			for (auto& model : Model::models)
+			// a cached cascade is left untouched, its depth is still valid for the matrices in its uniform buffer
+			if (shadows.renderCascade[i])
 			{
-				if (model.render)
+				renderPassInfoShadows.framebuffer = *shadows.framebuffers[shadows.textures.size() * imageIndex + i].handle;
+				cmd.beginRenderPass(renderPassInfoShadows, vk::SubpassContents::eInline);
+				RenderPass::SetViewport(cmd, renderPassInfoShadows.renderArea);
+				cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, *shadows.pipeline.handle);
+				GeometryArena::bind(cmd);
+				
+				// one draw per primitive for all the instances
+				vk::DescriptorSet boundMesh;
+				vk::DescriptorSet boundInstances;
+				cmd.bindDescriptorSets(
+						vk::PipelineBindPoint::eGraphics, *shadows.pipeline.layout, 0, (*shadows.descriptorSets)[i],
+						shadows.uniformBuffers[i].FrameOffset()
+				);
+				for (auto& caster : shadows.casters[i])
 				{
-					cmd.bindVertexBuffers(0, *model.vertexBuffer.GetBufferVK(), offset);
-					cmd.bindIndexBuffer(*model.indexBuffer.GetBufferVK(), 0, vk::IndexType::eUint32);
-					
-					for (auto& node : model.linearNodes)
+					if (boundMesh != *caster.mesh->descriptorSet ||
+					    boundInstances != *caster.model->instances->descriptorSet)
 					{
-						if (node->mesh)
-						{
-							cmd.bindDescriptorSets(
-									vk::PipelineBindPoint::eGraphics, *shadows.pipeline.layout, 0, {
-											(*shadows.descriptorSets)[i], *node->mesh->descriptorSet,
-											*model.descriptorSet
-									}, nullptr
-							);
-							for (auto& primitive : node->mesh->primitives)
-							{
-								if (primitive.render)
-									cmd.drawIndexed(
-											primitive.indicesSize, 1, node->mesh->indexOffset + primitive.indexOffset,
-											node->mesh->vertexOffset + primitive.vertexOffset, 0
-									);
-							}
-						}
+						boundMesh = *caster.mesh->descriptorSet;
+						boundInstances = *caster.model->instances->descriptorSet;
+						cmd.bindDescriptorSets(
+								vk::PipelineBindPoint::eGraphics, *shadows.pipeline.layout, 1,
+								{boundMesh, boundInstances}, {
+										caster.mesh->uniformBuffer.FrameOffset(),
+										AnimationCompute::jointsBuffer.FrameOffset(),
+										caster.model->instances->storageBuffer.FrameOffset()
+								}
+						);
 					}
+					cmd.drawIndexed(
+							caster.primitive->indicesSize, caster.model->instances->renderCount,
+							caster.mesh->indexOffset + caster.primitive->indexOffset,
+							caster.mesh->vertexOffset + caster.primitive->vertexOffset, 0
+					);
 				}
+				cmd.endRenderPass();
 			}
-			cmd.endRenderPass();
-			metrics[11 + static_cast<size_t>(i)].end(&GUI::metrics[11 + static_cast<size_t>(i)]);
+			gpuTimer.end(cmd, static_cast<GPURegion>(RegionShadows + i));
 			// ==========================================================================
 			cmd.end();
 		}
@@ -565,10 +810,14 @@ namespace pe
 	
 	void Renderer::Draw()
 	{
+		PE_PROFILE_SCOPE("Renderer::Draw");
+		
 		auto& vCtx = *VulkanContext::Get();
 		
 		static const vk::PipelineStageFlags waitStages[] = {
-				vk::PipelineStageFlagBits::eColorAttachmentOutput, vk::PipelineStageFlagBits::eFragmentShader
+				vk::PipelineStageFlagBits::eColorAttachmentOutput, vk::PipelineStageFlagBits::eFragmentShader,
+				vk::PipelineStageFlagBits::eComputeShader,
+				vk::PipelineStageFlagBits::eVertexInput | vk::PipelineStageFlagBits::eFragmentShader
 		};
 		
 		//FIRE_EVENT(Event::OnRender);
@@ -583,53 +832,126 @@ namespace pe
 			//float f = (*matp)[0][0];
 		}
 		
+		// each frame in flight has its own semaphores, fence and command buffers
+		const uint32_t frameIndex = vCtx.frameIndex;
+		const uint32_t semaphoresIndex = frameIndex * SEMAPHORES_PER_FRAME;
+		const auto& aquireSignalSemaphore = (*vCtx.semaphores)[semaphoresIndex];
+		const auto& shadowSignalSemaphore = (*vCtx.semaphores)[semaphoresIndex + 1];
+		const auto& deferredSignalSemaphore = (*vCtx.semaphores)[semaphoresIndex + 2];
+		const auto& gbufferSignalSemaphore = (*vCtx.semaphores)[semaphoresIndex + 3];
+		const auto& computeSignalSemaphore = (*vCtx.semaphores)[semaphoresIndex + 4];
+		const auto& deferredSignalFence = (*vCtx.fences)[frameIndex];
+		
+		auto& timestamps = FrameTimer::Instance().timestamps;
+		static Timer timerStage;
+		timerStage.Start();
+		
 		// aquire the image
-		auto& aquireSignalSemaphore = (*vCtx.semaphores)[0];
 		const uint32_t imageIndex = vCtx.swapchain.Aquire(aquireSignalSemaphore, nullptr);
-		this->previousImageIndex = imageIndex;
+		
+		timestamps[StageAcquire] = timerStage.Count();
+		timerStage.Start();
 		
 		//static Timer timer;
 		//timer.Start();
 		//vCtx.waitFences(vCtx.fences[imageIndex]);
 		//FrameTimer::Instance().timestamps[0] = timer.Count();
 		
-		const auto& cmd = (*vCtx.dynamicCmdBuffers)[imageIndex];
+		const auto& gbufferCmd = (*vCtx.gbufferCmdBuffers)[frameIndex];
+		const auto& cmd = (*vCtx.dynamicCmdBuffers)[frameIndex];
 		
-		vCtx.waitAndLockSubmits();
+		// decided once per frame, all the command buffers of the frame must agree on the image ownership
+		asyncSSAO = GUI::show_ssao && GUI::ssao_async_compute && SSAO::ComputeSupported();
 		
+		// record the command buffers, only the queue access is locked
+		RecordGBufferCmds(imageIndex);
+		if (asyncSSAO)
+			RecordComputeCmds();
 		if (GUI::shadow_cast)
+			RecordShadowsCmds(imageIndex);
+		RecordDeferredCmds(imageIndex);
+		
+		timestamps[StageRecording] = timerStage.Count();
+		timerStage.Start();
+		
+		// uploads still in flight on the transfer queue, every graphics submit of the frame waits for them
+		const uint64_t uploadValue = UploadManager::pendingValue();
+		const auto submitGraphics = [&](
+				const vk::ArrayProxy<const vk::CommandBuffer> commandBuffers,
+				std::vector<vk::PipelineStageFlags> stages,
+				std::vector<vk::Semaphore> semaphores,
+				const vk::ArrayProxy<const vk::Semaphore> signalSemaphores,
+				const vk::Fence signalFence
+		)
 		{
+			if (!uploadValue)
+			{
+				vCtx.submit(commandBuffers, stages, semaphores, signalSemaphores, signalFence);
+				return;
+			}
 			
-			// record the shadow command buffers
-			RecordShadowsCmds(imageIndex);
+			// the binary semaphores ignore their values
+			std::vector<uint64_t> values(semaphores.size(), 0);
+			stages.push_back(waitStages[3]);
+			semaphores.push_back(UploadManager::semaphore());
+			values.push_back(uploadValue);
 			
+			vk::TimelineSemaphoreSubmitInfo tssi;
+			tssi.waitSemaphoreValueCount = static_cast<uint32_t>(values.size());
+			tssi.pWaitSemaphoreValues = values.data();
+			vCtx.submit(commandBuffers, stages, semaphores, signalSemaphores, signalFence, &tssi);
+		};
+		
+		vCtx.waitAndLockSubmits();
+		
+		// the g-buffer does not touch the swapchain image, it does not wait for the aquire
+		if (asyncSSAO)
+		{
+			submitGraphics(gbufferCmd, {}, {}, gbufferSignalSemaphore, nullptr);
+			vCtx.submitCompute(
+					(*vCtx.computeCmdBuffers)[frameIndex], waitStages[2], gbufferSignalSemaphore,
+					computeSignalSemaphore, nullptr
+			);
+		}
+		else
+		{
+			submitGraphics(gbufferCmd, {}, {}, nullptr, nullptr);
+		}
+		
+		std::vector<vk::Semaphore> deferredWaitSemaphores {aquireSignalSemaphore};
+		std::vector<vk::PipelineStageFlags> deferredWaitStages {waitStages[0]};
+		if (GUI::shadow_cast)
+		{
 			// submit the shadow command buffers
-			const auto& shadowWaitSemaphore = aquireSignalSemaphore;
-			const auto& shadowSignalSemaphore = (*vCtx.semaphores)[imageIndex * 3 + 1];
 			const auto& scb = vCtx.shadowCmdBuffers;
 			const auto size = shadows.textures.size();
-			const auto i = size * imageIndex;
+			const auto i = size * frameIndex;
 			const std::vector<vk::CommandBuffer> activeShadowCmdBuffers(scb->begin() + i, scb->begin() + i + size);
-			vCtx.submit(activeShadowCmdBuffers, waitStages[0], shadowWaitSemaphore, shadowSignalSemaphore, nullptr);
+			submitGraphics(
+					activeShadowCmdBuffers, {waitStages[0]}, {aquireSignalSemaphore}, shadowSignalSemaphore, nullptr
+			);
 			
-			aquireSignalSemaphore = shadowSignalSemaphore;
+			deferredWaitSemaphores[0] = shadowSignalSemaphore;
+			deferredWaitStages[0] = waitStages[1];
+		}
+		if (asyncSSAO)
+		{
+			deferredWaitSemaphores.push_back(computeSignalSemaphore);
+			deferredWaitStages.push_back(waitStages[1]);
 		}
-		
-		// record the command buffers
-		RecordDeferredCmds(imageIndex);
 		
 		// submit the command buffers
-		const auto& deferredWaitStage = GUI::shadow_cast ? waitStages[1] : waitStages[0];
-		const auto& deferredWaitSemaphore = aquireSignalSemaphore;
-		const auto& deferredSignalSemaphore = (*vCtx.semaphores)[imageIndex * 3 + 2];
-		const auto& deferredSignalFence = (*vCtx.fences)[imageIndex];
-		vCtx.submit(cmd, deferredWaitStage, deferredWaitSemaphore, deferredSignalSemaphore, deferredSignalFence);
+		submitGraphics(cmd, deferredWaitStages, deferredWaitSemaphores, deferredSignalSemaphore, deferredSignalFence);
 		
 		// Presentation
 		const auto& presentWaitSemaphore = deferredSignalSemaphore;
 		vCtx.swapchain.Present(imageIndex, presentWaitSemaphore, nullptr);
 		
 		vCtx.unlockSubmits();
+		
+		timestamps[StageSubmit] = timerStage.Count();
+		
+		vCtx.frameIndex = (frameIndex + 1) % MAX_FRAMES_IN_FLIGHT;
 	}
 	
 	void
@@ -760,6 +1082,8 @@ namespace pe
 		shadows.createDescriptorSets();
 		// DESCRIPTOR SETS FOR LIGHTS
 		lightUniforms.createLightUniforms();
+		// DESCRIPTOR SET FOR BINDLESS MATERIALS
+		BindlessMaterials::init();
 		// DESCRIPTOR SETS FOR SSAO
 		ssao.createUniforms(renderTargets);
 		// DESCRIPTOR SETS FOR COMPOSITION PIPELINE
@@ -782,9 +1106,14 @@ namespace pe
 	
 	void Renderer::ResizeViewport(uint32_t width, uint32_t height)
 	{
+		FrameHistory::Mark("resize");
+		
 		auto& vulkan = *VulkanContext::Get();
 		vulkan.graphicsQueue->waitIdle();
 		
+		// Render passes depend only on the formats and pipelines have dynamic viewport and scissor,
+		// so a resize recreates just the swapchain, the size dependent images and their framebuffers
+		
 		//- Free resources ----------------------
 		// render targets
 		for (auto& RT : renderTargets)
@@ -792,81 +1121,47 @@ namespace pe
 		renderTargets.clear();
 		
 		// GUI
-		gui.renderPass.Destroy();
 		for (auto& framebuffer : gui.framebuffers)
 			framebuffer.Destroy();
-		gui.pipeline.destroy();
 		
 		// deferred
-		deferred.renderPass.Destroy();
-		deferred.compositionRenderPass.Destroy();
 		for (auto& framebuffer : deferred.framebuffers)
 			framebuffer.Destroy();
 		for (auto& framebuffer : deferred.compositionFramebuffers)
 			framebuffer.Destroy();
-		deferred.pipeline.destroy();
-		deferred.pipelineComposition.destroy();
 		
 		// SSR
 		for (auto& framebuffer : ssr.framebuffers)
 			framebuffer.Destroy();
-		ssr.renderPass.Destroy();
-		ssr.pipeline.destroy();
 		
 		// FXAA
 		for (auto& framebuffer : fxaa.framebuffers)
 			framebuffer.Destroy();
-		fxaa.renderPass.Destroy();
-		fxaa.pipeline.destroy();
-		fxaa.frameImage.destroy();
 		
 		// TAA
 		taa.previous.destroy();
-		taa.frameImage.destroy();
 		for (auto& framebuffer : taa.framebuffers)
 			framebuffer.Destroy();
 		for (auto& framebuffer : taa.framebuffersSharpen)
 			framebuffer.Destroy();
-		taa.renderPass.Destroy();
-		taa.renderPassSharpen.Destroy();
-		taa.pipeline.destroy();
-		taa.pipelineSharpen.destroy();
 		
 		// Bloom
 		for (auto& frameBuffer : bloom.framebuffers)
 			frameBuffer.Destroy();
-		bloom.renderPassBrightFilter.Destroy();
-		bloom.renderPassGaussianBlur.Destroy();
-		bloom.renderPassCombine.Destroy();
-		bloom.pipelineBrightFilter.destroy();
-		bloom.pipelineGaussianBlurHorizontal.destroy();
-		bloom.pipelineGaussianBlurVertical.destroy();
-		bloom.pipelineCombine.destroy();
-		bloom.frameImage.destroy();
 		
 		// Depth of Field
 		for (auto& framebuffer : dof.framebuffers)
 			framebuffer.Destroy();
-		dof.renderPass.Destroy();
-		dof.pipeline.destroy();
-		dof.frameImage.destroy();
 		
 		// Motion blur
 		for (auto& framebuffer : motionBlur.framebuffers)
 			framebuffer.Destroy();
-		motionBlur.renderPass.Destroy();
-		motionBlur.pipeline.destroy();
-		motionBlur.frameImage.destroy();
 		
 		// SSAO
-		ssao.renderPass.Destroy();
-		ssao.blurRenderPass.Destroy();
 		for (auto& framebuffer : ssao.framebuffers)
 			framebuffer.Destroy();
 		for (auto& framebuffer : ssao.blurFramebuffers)
 			framebuffer.Destroy();
-		ssao.pipeline.destroy();
-		ssao.pipelineBlur.destroy();
 		
 		vulkan.depth.destroy();
 		vulkan.swapchain.Destroy();
@@ -878,13 +1173,16 @@ namespace pe
 		vulkan.CreateSwapchain(ctx, 3);
 		vulkan.CreateDepth();
 		
+		const vk::ImageUsageFlags ssaoUsage = SSAO::ComputeSupported() ?
+		                                      vk::ImageUsageFlagBits::eStorage : vk::ImageUsageFlags();
 		AddRenderTarget("viewport", vulkan.surface.formatKHR->format, vk::ImageUsageFlagBits::eTransferSrc);
+		AddRenderTarget("viewportPong", vulkan.surface.formatKHR->format, vk::ImageUsageFlagBits::eTransferSrc);
 		AddRenderTarget("depth", vk::Format::eR32Sfloat, vk::ImageUsageFlags());
 		AddRenderTarget("normal", vk::Format::eR32G32B32A32Sfloat, vk::ImageUsageFlags());
 		AddRenderTarget("albedo", vulkan.surface.formatKHR->format, vk::ImageUsageFlags());
 		AddRenderTarget("srm", vulkan.surface.formatKHR->format, vk::ImageUsageFlags()); // Specular Roughness Metallic
-		AddRenderTarget("ssao", vk::Format::eR16Unorm, vk::ImageUsageFlags());
-		AddRenderTarget("ssaoBlur", vk::Format::eR8Unorm, vk::ImageUsageFlags());
+		AddRenderTarget("ssao", vk::Format::eR16Unorm, ssaoUsage);
+		AddRenderTarget("ssaoBlur", vk::Format::eR8Unorm, ssaoUsage);
 		AddRenderTarget("ssr", vulkan.surface.formatKHR->format, vk::ImageUsageFlags());
 		AddRenderTarget("velocity", vk::Format::eR16G16Sfloat, vk::ImageUsageFlags());
 		AddRenderTarget("brightFilter", vulkan.surface.formatKHR->format, vk::ImageUsageFlags());
@@ -893,55 +1191,32 @@ namespace pe
 		AddRenderTarget("emissive", vulkan.surface.formatKHR->format, vk::ImageUsageFlags());
 		AddRenderTarget("taa", vulkan.surface.formatKHR->format, vk::ImageUsageFlagBits::eTransferSrc);
 		
-		deferred.createRenderPasses(renderTargets);
 		deferred.createFrameBuffers(renderTargets);
-		deferred.createPipelines(renderTargets);
 		deferred.updateDescriptorSets(renderTargets, lightUniforms);
 		
-		ssr.createRenderPass(renderTargets);
 		ssr.createFrameBuffers(renderTargets);
-		ssr.createPipeline(renderTargets);
 		ssr.updateDescriptorSets(renderTargets);
 		
-		fxaa.Init();
-		fxaa.createRenderPass(renderTargets);
 		fxaa.createFrameBuffers(renderTargets);
-		fxaa.createPipeline(renderTargets);
 		fxaa.updateDescriptorSets(renderTargets);
 		
 		taa.Init();
-		taa.createRenderPasses(renderTargets);
 		taa.createFrameBuffers(renderTargets);
-		taa.createPipelines(renderTargets);
 		taa.updateDescriptorSets(renderTargets);
 		
-		bloom.Init();
-		bloom.createRenderPasses(renderTargets);
 		bloom.createFrameBuffers(renderTargets);
-		bloom.createPipelines(renderTargets);
 		bloom.updateDescriptorSets(renderTargets);
 		
-		dof.Init();
-		dof.createRenderPass(renderTargets);
 		dof.createFrameBuffers(renderTargets);
-		dof.createPipeline(renderTargets);
 		dof.updateDescriptorSets(renderTargets);
 		
-		motionBlur.Init();
-		motionBlur.createRenderPass(renderTargets);
 		motionBlur.createFrameBuffers(renderTargets);
-		motionBlur.createPipeline(renderTargets);
 		motionBlur.updateDescriptorSets(renderTargets);
 		
-		ssao.createRenderPasses(renderTargets);
 		ssao.createFrameBuffers(renderTargets);
-		ssao.createPipelines(renderTargets);
 		ssao.updateDescriptorSets(renderTargets);
 		
-		gui.createRenderPass();
 		gui.createFrameBuffers();
-		gui.createPipeline();
-		gui.updateDescriptorSets();
 		
 		//compute.pipeline = createComputePipeline();
 		//compute.updateDescriptorSets();
@@ -950,11 +1225,15 @@ namespace pe
 	
 	void Renderer::RecreatePipelines()
 	{
+		FrameHistory::Mark("shader_compile");
+		
 		VulkanContext::Get()->graphicsQueue->waitIdle();
 		
 		shadows.pipeline.destroy();
 		ssao.pipeline.destroy();
 		ssao.pipelineBlur.destroy();
+		ssao.pipelineCompute.destroy();
+		ssao.pipelineBlurCompute.destroy();
 		ssr.pipeline.destroy();
 		deferred.pipeline.destroy();
 		deferred.pipelineComposition.destroy();
@@ -967,6 +1246,7 @@ namespace pe
 		//bloom.pipelineGaussianBlurVertical.destroy();
 		dof.pipeline.destroy();
 		motionBlur.pipeline.destroy();
+		motionBlur.pipelineDOF.destroy();
 		gui.pipeline.destroy();
 		
 		shadows.createPipeline();
@@ -979,6 +1259,7 @@ namespace pe
 		dof.createPipeline(renderTargets);
 		motionBlur.createPipeline(renderTargets);
 		gui.createPipeline();
+		AnimationCompute::createPipelines();
 		
 		ctx->GetSystem<CameraSystem>()->GetCamera(0)->ReCreateComputePipelines();
 	}
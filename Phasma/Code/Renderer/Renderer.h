@@ -32,6 +32,7 @@ SOFTWARE.
 #include "Light.h"
 #include "../Model/Model.h"
 #include "Deferred.h"
+#include "DrawList.h"
 #include "Compute.h"
 #include "../Core/Timer.h"
 #include "../Script/Script.h"
@@ -56,6 +57,7 @@ namespace pe
 	{
 		Shadows shadows;
 		Deferred deferred;
+		DrawList drawList;
 		SSAO ssao;
 		SSR ssr;
 		FXAA fxaa;
@@ -70,7 +72,8 @@ namespace pe
 		Compute animationsCompute;
 		Compute nodesCompute;
 		
-		std::vector<GPUTimer> metrics {};
+		GPUTimer gpuTimer;
+		bool asyncSSAO = false;
 
 #ifndef IGNORE_SCRIPTS
 		std::vector<Script*> scripts{};
@@ -88,6 +91,12 @@ namespace pe
 		
 		void Draw();
 		
+		// low latency mode, waits for the frame slot and for the gpu before the input is sampled
+		void WaitForFrame();
+		
+		// the last measured gpu time of a frame in ms
+		static float GpuFrameTime();
+		
 		void AddRenderTarget(const std::string& name, vk::Format format, const vk::ImageUsageFlags& additionalFlags);
 		
 		void LoadResources();
@@ -104,7 +113,6 @@ namespace pe
 		inline Context* GetContext()
 		{ return ctx; }
 		
-		uint32_t previousImageIndex = 0;
 		std::map<std::string, Image> renderTargets {};
 	
 	private:
@@ -113,7 +121,15 @@ namespace pe
 		
 		static void CheckQueue();
 		
-		void ComputeAnimations();
+		void ComputeAnimations(vk::CommandBuffer cmd);
+		
+		void ResolveMetrics();
+		
+		bool frameWaited = false;
+		
+		void RecordGBufferCmds(const uint32_t& imageIndex);
+		
+		void RecordComputeCmds();
 		
 		void RecordDeferredCmds(const uint32_t& imageIndex);
 		
@@ -27,7 +27,11 @@ SOFTWARE.
 #include "Vertex.h"
 #include "../Shader/Shader.h"
 #include "../Core/Queue.h"
+#include "../MemoryHash/MemoryHash.h"
 #include "RenderApi.h"
+#include "../Model/Model.h"
+#include "../Model/Mesh.h"
+#include "../Core/Profiler.h"
 
 namespace pe
 {
@@ -52,20 +56,20 @@ namespace pe
 		descriptorSets->resize(textures.size()); // size of wanted number of cascaded shadows
 		for (uint32_t i = 0; i < descriptorSets->size(); i++)
 		{
-			(*descriptorSets)[i] = VulkanContext::Get()->device->allocateDescriptorSets(allocateInfo).at(0);
+			(*descriptorSets)[i] = VulkanContext::Get()->allocateDescriptorSet(allocateInfo);
 			
 			std::vector<vk::WriteDescriptorSet> textureWriteSets(2);
 			// MVP
 			vk::DescriptorBufferInfo dbi;
 			dbi.buffer = *uniformBuffers[i].GetBufferVK();
 			dbi.offset = 0;
-			dbi.range = sizeof(ShadowsUBO);
+			dbi.range = uniformBuffers[i].FrameSize();
 			
 			textureWriteSets[0].dstSet = (*descriptorSets)[i];
 			textureWriteSets[0].dstBinding = 0;
 			textureWriteSets[0].dstArrayElement = 0;
 			textureWriteSets[0].descriptorCount = 1;
-			textureWriteSets[0].descriptorType = vk::DescriptorType::eUniformBuffer;
+			textureWriteSets[0].descriptorType = vk::DescriptorType::eUniformBufferDynamic;
 			textureWriteSets[0].pBufferInfo = &dbi;
 			
 			// sampler
@@ -154,8 +158,6 @@ namespace pe
 		pipeline.info.pVertShader = &vert;
 		pipeline.info.vertexInputBindingDescriptions = make_ref(Vertex::getBindingDescriptionGeneral());
 		pipeline.info.vertexInputAttributeDescriptions = make_ref(Vertex::getAttributeDescriptionGeneral());
-		pipeline.info.width = static_cast<float>(Shadows::imageSize);
-		pipeline.info.height = static_cast<float>(Shadows::imageSize);
 		pipeline.info.cullMode = CullMode::Front;
 		pipeline.info.colorBlendAttachments = make_ref(
 				std::vector<vk::PipelineColorBlendAttachmentState> {*textures[0].blentAttachment}
@@ -179,7 +181,7 @@ namespace pe
 		uniformBuffers.resize(textures.size());
 		for (auto& buffer : uniformBuffers)
 		{
-			buffer.CreateBuffer(sizeof(ShadowsUBO), BufferUsage::UniformBuffer, MemoryProperty::HostVisible);
+			buffer.CreateBufferPerFrame(sizeof(ShadowsUBO), BufferUsage::UniformBuffer, MemoryProperty::HostVisible);
 			buffer.Map();
 			buffer.Zero();
 			buffer.Flush();
@@ -229,7 +231,8 @@ namespace pe
 			vec3 right = normalize(cross(front, camera.WorldUp()));
 			vec3 up = normalize(cross(right, front));
 			float orthoSide = sideSizeOfPyramid * .01f; // small area
-			shadows_UBO[0] = {
+			orthoSides[0] = orthoSide;
+			nextUBO[0] = {
 					ortho(-orthoSide, orthoSide, -orthoSide, orthoSide, camera.nearPlane, camera.farPlane),
 					lookAt(pos, front, right, up),
 					1.0f,
@@ -238,19 +241,14 @@ namespace pe
 					sideSizeOfPyramid
 			};
 			
-			Queue::memcpyRequest(&uniformBuffers[0], {{&shadows_UBO[0], sizeof(ShadowsUBO), 0}});
-			//uniformBuffers[0].map();
-			//memcpy(uniformBuffers[0].data, &shadows_UBO[0], sizeof(ShadowsUBO));
-			//uniformBuffers[0].flush();
-			//uniformBuffers[0].unmap();
-			
 			pointOnPyramid = camera.front * (sideSizeOfPyramid * .05f);
 			pos = p + camera.position + pointOnPyramid;
 			front = normalize(camera.position + pointOnPyramid - pos);
 			right = normalize(cross(front, camera.WorldUp()));
 			up = normalize(cross(right, front));
 			orthoSide = sideSizeOfPyramid * .05f; // medium area
-			shadows_UBO[1] = {
+			orthoSides[1] = orthoSide;
+			nextUBO[1] = {
 					ortho(-orthoSide, orthoSide, -orthoSide, orthoSide, camera.nearPlane, camera.farPlane),
 					lookAt(pos, front, right, up),
 					1.0f,
@@ -259,19 +257,14 @@ namespace pe
 					sideSizeOfPyramid
 			};
 			
-			Queue::memcpyRequest(&uniformBuffers[1], {{&shadows_UBO[1], sizeof(ShadowsUBO), 0}});
-			//uniformBuffers[1].map();
-			//memcpy(uniformBuffers[1].data, &shadows_UBO[1], sizeof(ShadowsUBO));
-			//uniformBuffers[1].flush();
-			//uniformBuffers[1].unmap();
-			
 			pointOnPyramid = camera.front * (sideSizeOfPyramid * .5f);
 			pos = p + camera.position + pointOnPyramid;
 			front = normalize(camera.position + pointOnPyramid - pos);
 			right = normalize(cross(front, camera.WorldUp()));
 			up = normalize(cross(right, front));
 			orthoSide = sideSizeOfPyramid * .5f; // large area
-			shadows_UBO[2] = {
+			orthoSides[2] = orthoSide;
+			nextUBO[2] = {
 					ortho(-orthoSide, orthoSide, -orthoSide, orthoSide, camera.nearPlane, camera.farPlane),
 					lookAt(pos, front, right, up),
 					1.0f,
@@ -279,15 +272,10 @@ namespace pe
 					sideSizeOfPyramid * .1f,
 					sideSizeOfPyramid
 			};
-			
-			Queue::memcpyRequest(&uniformBuffers[2], {{&shadows_UBO[2], sizeof(ShadowsUBO), 0}});
-			//uniformBuffers[2].map();
-			//memcpy(uniformBuffers[2].data, &shadows_UBO[2], sizeof(ShadowsUBO));
-			//uniformBuffers[2].flush();
-			//uniformBuffers[2].unmap();
 		}
 		else
 		{
+			invalidate();
 			shadows_UBO[0].castShadows = 0.f;
 			
 			Queue::memcpyRequest(&uniformBuffers[0], {{&shadows_UBO[0], sizeof(ShadowsUBO), 0}});
@@ -309,4 +297,114 @@ namespace pe
 			//uniformBuffers[2].unmap();
 		}
 	}
+	
+	// folds the MemoryHash of the bytes into hash
+	static void HashCombine(size_t& hash, const void* data, size_t size)
+	{
+		hash ^= MemoryHash(data, size).getHash() + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+	}
+	
+	bool Shadows::isCasterInCascade(uint32_t cascade, const vec4& sphere) const
+	{
+		// the casters between the sun and the volume still cast shadows in it, so only the sides are checked
+		const vec4 center = nextUBO[cascade].view * vec4(vec3(sphere), 1.0f);
+		const float side = orthoSides[cascade] + sphere.w;
+		return abs(center.x) <= side && abs(center.y) <= side;
+	}
+	
+	void Shadows::cullCasters()
+	{
+		PE_PROFILE_SCOPE("Shadows::cullCasters");
+		
+		if (!GUI::shadow_cast)
+			return;
+		
+		frameCounter++;
+		
+		for (uint32_t i = 0; i < 3; i++)
+		{
+			casters[i].clear();
+			
+			size_t hash = 0;
+			HashCombine(hash, &nextUBO[i], sizeof(ShadowsUBO));
+			HashCombine(hash, GUI::depthBias.data(), sizeof(float) * GUI::depthBias.size());
+			
+			for (auto& model : Model::models)
+			{
+				if (!model.updatesNodes || model.instances->renderCount == 0)
+					continue;
+				
+				// every instance of the group draws the shared primitives, Model::updateInstances gathered them
+				const std::vector<const mat4*>& transforms = model.instances->transforms;
+				
+				for (auto& node : model.linearNodes)
+				{
+					if (!node->mesh)
+						continue;
+					
+					Mesh* mesh = node->mesh;
+					bool meshHashed = false;
+					for (auto& primitive : mesh->primitives)
+					{
+						if (!primitive.render)
+							continue;
+						
+						bool inCascade = false;
+						for (auto* transform : transforms)
+						{
+							cmat4 trans = *transform * mesh->ubo.matrix;
+							vec4 bs = trans * vec4(vec3(primitive.boundingSphere), 1.0f);
+							bs.w = primitive.boundingSphere.w * abs(trans.scale().x);
+							if (isCasterInCascade(i, bs))
+							{
+								inCascade = true;
+								break;
+							}
+						}
+						if (!inCascade)
+							continue;
+						
+						casters[i].push_back({&model, mesh, &primitive});
+						
+						const Primitive* primitivePtr = &primitive;
+						HashCombine(hash, &primitivePtr, sizeof(primitivePtr));
+						if (!meshHashed)
+						{
+							HashCombine(hash, &mesh->ubo.matrix, sizeof(mat4));
+							// the joints follow the local matrices of the nodes of the model
+							if (mesh->ubo.jointCount > 0)
+								HashCombine(
+										hash, &AnimationCompute::nodes[model.nodesRange.offset],
+										sizeof(NodeData) * model.nodesRange.count
+								);
+							for (auto* transform : transforms)
+								HashCombine(hash, transform, sizeof(mat4));
+							meshHashed = true;
+						}
+					}
+				}
+			}
+			
+			// the near cascade follows every change, the far ones are staggered so they are not rendered in the same frame
+			const bool scheduled = i == 0 || (i == 1 && frameCounter % 2 == 0) || (i == 2 && frameCounter % 4 == 1);
+			renderCascade[i] = !cascadeValid[i] || (scheduled && hash != cascadeHash[i]);
+			
+			// a cached cascade keeps the matrices its depth was rendered with
+			if (renderCascade[i])
+			{
+				shadows_UBO[i] = nextUBO[i];
+				cascadeHash[i] = hash;
+				cascadeValid[i] = true;
+			}
+			
+			// every frame writes its own slice, so the cached matrices are uploaded too
+			Queue::memcpyRequest(&uniformBuffers[i], {{&shadows_UBO[i], sizeof(ShadowsUBO), 0}});
+		}
+	}
+	
+	void Shadows::invalidate()
+	{
+		for (uint32_t i = 0; i < 3; i++)
+			cascadeValid[i] = false;
+	}
 }
@@ -37,6 +37,19 @@ namespace vk
 
 namespace pe
 {
+	class Model;
+	
+	class Mesh;
+	
+	class Primitive;
+	
+	struct ShadowCaster
+	{
+		Model* model;
+		Mesh* mesh;
+		Primitive* primitive;
+	};
+	
 	struct ShadowsUBO
 	{
 		mat4 projection, view;
@@ -62,8 +75,18 @@ namespace pe
 		std::vector<Buffer> uniformBuffers {};
 		Pipeline pipeline;
 		
+		// the primitives inside each cascade's light volume
+		std::vector<ShadowCaster> casters[3] {};
+		// cascades that are rendered this frame, the rest keep their cached depth and matrices
+		bool renderCascade[3] {};
+		
 		void update(Camera& camera);
 		
+		// called after the models are updated, culls the casters and decides which cascades are rendered
+		void cullCasters();
+		
+		void invalidate();
+		
 		void createUniformBuffers();
 		
 		void createDescriptorSets();
@@ -75,5 +98,14 @@ namespace pe
 		void createPipeline();
 		
 		void destroy();
+	
+	private:
+		bool isCasterInCascade(uint32_t cascade, const vec4& sphere) const;
+		
+		ShadowsUBO nextUBO[3] {};
+		float orthoSides[3] {};
+		size_t cascadeHash[3] {};
+		bool cascadeValid[3] {};
+		uint32_t frameCounter = 0;
 	};
 }
@@ -25,6 +25,7 @@ SOFTWARE.
 #include "RenderApi.h"
 #include "../Core/Math.h"
 #include "../ECS/Context.h"
+#include "../Core/Profiler.h"
 
 namespace pe
 {
@@ -110,6 +111,8 @@ namespace pe
 	
 	uint32_t Swapchain::Aquire(vk::Semaphore semaphore, vk::Fence fence) const
 	{
+		PE_PROFILE_SCOPE("Swapchain::Aquire");
+		
 		const auto aquire = VulkanContext::Get()->device->acquireNextImageKHR(*swapchain, UINT64_MAX, semaphore, fence);
 		if (aquire.result != vk::Result::eSuccess)
 			throw std::runtime_error("Aquire Next Image error");
@@ -122,6 +125,8 @@ namespace pe
 			vk::ArrayProxy<const vk::SwapchainKHR> additionalSwapchains
 	) const
 	{
+		PE_PROFILE_SCOPE("Swapchain::Present");
+		
 		if (imageIndices.size() <= additionalSwapchains.size())
 			throw std::runtime_error("Not enough image indices");
 		std::vector<vk::SwapchainKHR> swapchains(static_cast<size_t>(additionalSwapchains.size()) + 1);
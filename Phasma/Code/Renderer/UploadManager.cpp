@@ -0,0 +1,361 @@
+/*
+Copyright (c) 2018-2021 Christos Karamoustos
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "PhasmaPch.h"
+#include "UploadManager.h"
+#include "Image.h"
+#include "RenderApi.h"
+
+namespace pe
+{
+	struct UploadManager::Batch
+	{
+		vk::CommandBuffer cmd;
+		uint64_t value = 0;
+		size_t ringBytes = 0;
+		std::vector<Buffer> dedicated {}; // staging of uploads larger than the ring
+	};
+	
+	Buffer UploadManager::ring {};
+	size_t UploadManager::ringHead = 0;
+	size_t UploadManager::ringUsed = 0;
+	Ref<vk::CommandPool> UploadManager::commandPool {};
+	Ref<vk::Semaphore> UploadManager::timeline {};
+	std::atomic<uint64_t> UploadManager::submittedValue {0};
+	std::atomic<uint64_t> UploadManager::signaledValue {0};
+	std::vector<UploadManager::Batch> UploadManager::batches {};
+	bool UploadManager::batchOpen = false;
+	
+	void UploadManager::init()
+	{
+		if (commandPool)
+			return;
+		
+		auto vulkan = VulkanContext::Get();
+		
+		vk::CommandPoolCreateInfo cpci;
+		cpci.queueFamilyIndex = vulkan->dedicatedTransferQueue ? vulkan->transferFamilyId : vulkan->graphicsFamilyId;
+		cpci.flags = vk::CommandPoolCreateFlagBits::eTransient;
+		commandPool = make_ref(vulkan->device->createCommandPool(cpci));
+		
+		if (vulkan->timelineSemaphores)
+		{
+			vk::SemaphoreTypeCreateInfo stci;
+			stci.semaphoreType = vk::SemaphoreType::eTimeline;
+			stci.initialValue = 0;
+			
+			vk::SemaphoreCreateInfo sci;
+			sci.pNext = &stci;
+			timeline = make_ref(vulkan->device->createSemaphore(sci));
+		}
+		
+		// stays mapped for the lifetime of the manager
+		ring.CreateBuffer(UPLOAD_RING_SIZE, BufferUsage::TransferSrc, MemoryProperty::HostVisible);
+		ring.Map();
+		ringHead = 0;
+		ringUsed = 0;
+		submittedValue = 0;
+		signaledValue = 0;
+	}
+	
+	void UploadManager::uploadBuffer(Buffer& dst, size_t dstOffset, const void* data, size_t size)
+	{
+		if (size == 0)
+			return;
+		
+		std::lock_guard<std::mutex> guard(m_mutex);
+		
+		vk::Buffer staging;
+		const size_t offset = stage(data, size, staging);
+		
+		const vk::BufferCopy region {offset, dstOffset, size};
+		openBatch().cmd.copyBuffer(staging, *dst.GetBufferVK(), region);
+	}
+	
+	void UploadManager::uploadImage(Image& dst, const void* data, size_t size)
+	{
+		std::lock_guard<std::mutex> guard(m_mutex);
+		
+		vk::Buffer staging;
+		const size_t offset = stage(data, size, staging);
+		const vk::CommandBuffer cmd = openBatch().cmd;
+		
+		dst.transitionImageLayout(
+				cmd,
+				vk::ImageLayout::eUndefined,
+				vk::ImageLayout::eTransferDstOptimal,
+				vk::PipelineStageFlagBits::eTopOfPipe,
+				vk::PipelineStageFlagBits::eTransfer,
+				vk::AccessFlags(),
+				vk::AccessFlagBits::eTransferWrite,
+				vk::ImageAspectFlagBits::eColor
+		);
+		
+		const size_t layerSize = size / dst.arrayLayers;
+		std::vector<vk::BufferImageCopy> regions(dst.arrayLayers);
+		for (uint32_t i = 0; i < dst.arrayLayers; i++)
+		{
+			regions[i].bufferOffset = offset + i * layerSize;
+			regions[i].imageSubresource.aspectMask = vk::ImageAspectFlagBits::eColor;
+			regions[i].imageSubresource.mipLevel = 0;
+			regions[i].imageSubresource.baseArrayLayer = i;
+			regions[i].imageSubresource.layerCount = 1;
+			regions[i].imageExtent = vk::Extent3D(dst.width, dst.height, 1);
+		}
+		cmd.copyBufferToImage(staging, *dst.image, vk::ImageLayout::eTransferDstOptimal, regions);
+		
+		// the mip levels are blitted on the graphics queue, the consumers wait on the timeline for the rest
+		if (dst.mipLevels == 1)
+		{
+			dst.transitionImageLayout(
+					cmd,
+					vk::ImageLayout::eTransferDstOptimal,
+					vk::ImageLayout::eShaderReadOnlyOptimal,
+					vk::PipelineStageFlagBits::eTransfer,
+					vk::PipelineStageFlagBits::eBottomOfPipe,
+					vk::AccessFlagBits::eTransferWrite,
+					vk::AccessFlags(),
+					vk::ImageAspectFlagBits::eColor
+			);
+		}
+	}
+	
+	uint64_t UploadManager::flush()
+	{
+		std::lock_guard<std::mutex> guard(m_mutex);
+		return flushLocked();
+	}
+	
+	bool UploadManager::isComplete(uint64_t value)
+	{
+		return value <= completedValue();
+	}
+	
+	void UploadManager::wait(uint64_t value)
+	{
+		// without timelines every flush completes before it returns
+		if (!timeline)
+			return;
+		
+		vk::SemaphoreWaitInfo swi;
+		swi.semaphoreCount = 1;
+		swi.pSemaphores = &*timeline;
+		swi.pValues = &value;
+		if (VulkanContext::Get()->device->waitSemaphores(swi, UINT64_MAX) != vk::Result::eSuccess)
+			throw std::runtime_error("wait semaphores error!");
+	}
+	
+	uint64_t UploadManager::pendingValue()
+	{
+		const uint64_t value = submittedValue;
+		return value > completedValue() ? value : 0;
+	}
+	
+	vk::Semaphore UploadManager::semaphore()
+	{
+		return timeline ? *timeline : vk::Semaphore();
+	}
+	
+	void UploadManager::destroy()
+	{
+		if (!commandPool)
+			return;
+		
+		auto vulkan = VulkanContext::Get();
+		
+		// the device is idle, the pool frees the command buffers of the batches
+		for (auto& batch : batches)
+			for (auto& staging : batch.dedicated)
+				staging.Destroy();
+		batches.clear();
+		batchOpen = false;
+		
+		vulkan->device->destroyCommandPool(*commandPool);
+		commandPool = nullptr;
+		if (timeline)
+		{
+			vulkan->device->destroySemaphore(*timeline);
+			timeline = nullptr;
+		}
+		
+		ring.Unmap();
+		ring.Destroy();
+		ringHead = 0;
+		ringUsed = 0;
+	}
+	
+	UploadManager::Batch& UploadManager::openBatch()
+	{
+		if (!batchOpen)
+		{
+			auto vulkan = VulkanContext::Get();
+			
+			vk::CommandBufferAllocateInfo cbai;
+			cbai.level = vk::CommandBufferLevel::ePrimary;
+			cbai.commandPool = *commandPool;
+			cbai.commandBufferCount = 1;
+			
+			batches.emplace_back();
+			batches.back().cmd = vulkan->device->allocateCommandBuffers(cbai).at(0);
+			
+			vk::CommandBufferBeginInfo beginInfo;
+			beginInfo.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit;
+			batches.back().cmd.begin(beginInfo);
+			
+			batchOpen = true;
+		}
+		return batches.back();
+	}
+	
+	size_t UploadManager::stage(const void* data, size_t size, vk::Buffer& buffer)
+	{
+		// keep the copies aligned for any texel size
+		const size_t alignedSize = (size + 15) & ~size_t(15);
+		
+		// too large for the ring, a staging buffer of its own is released with the batch
+		if (alignedSize > UPLOAD_RING_SIZE)
+		{
+			Buffer staging;
+			staging.CreateBuffer(size, BufferUsage::TransferSrc, MemoryProperty::HostVisible);
+			staging.Map();
+			staging.CopyData(data, size);
+			staging.Flush(0, size);
+			staging.Unmap();
+			
+			buffer = *staging.GetBufferVK();
+			openBatch().dedicated.push_back(staging);
+			return 0;
+		}
+		
+		while (true)
+		{
+			retire();
+			if (ringUsed == 0)
+				ringHead = 0;
+			
+			// allocations do not wrap, the end of the ring is skipped instead
+			const size_t padding = ringHead + alignedSize > UPLOAD_RING_SIZE ? UPLOAD_RING_SIZE - ringHead : 0;
+			if (ringUsed + padding + alignedSize <= UPLOAD_RING_SIZE)
+			{
+				const size_t offset = (ringHead + padding) % UPLOAD_RING_SIZE;
+				ring.CopyData(data, size, offset);
+				ring.Flush(offset, size);
+				
+				ringHead = offset + alignedSize;
+				ringUsed += padding + alignedSize;
+				openBatch().ringBytes += padding + alignedSize;
+				
+				buffer = *ring.GetBufferVK();
+				return offset;
+			}
+			
+			// the ring is full, wait for the oldest batch to free its part,
+			// a flush can retire the only batch at once, so its value is kept
+			if (batchOpen && batches.size() == 1)
+				wait(flushLocked());
+			else if (!batches.empty())
+				wait(batches.front().value);
+		}
+	}
+	
+	uint64_t UploadManager::flushLocked()
+	{
+		if (!batchOpen)
+			return submittedValue;
+		
+		auto vulkan = VulkanContext::Get();
+		
+		Batch& batch = batches.back();
+		batch.cmd.end();
+		batch.value = submittedValue + 1;
+		batchOpen = false;
+		
+		vk::SubmitInfo si;
+		si.commandBufferCount = 1;
+		si.pCommandBuffers = &batch.cmd;
+		
+		vk::TimelineSemaphoreSubmitInfo tssi;
+		vk::Fence fence;
+		if (timeline)
+		{
+			tssi.signalSemaphoreValueCount = 1;
+			tssi.pSignalSemaphoreValues = &batch.value;
+			si.pNext = &tssi;
+			si.signalSemaphoreCount = 1;
+			si.pSignalSemaphores = &*timeline;
+		}
+		else
+		{
+			fence = vulkan->device->createFence(vk::FenceCreateInfo());
+		}
+		
+		if (vulkan->dedicatedTransferQueue)
+		{
+			vulkan->transferQueue->submit(si, fence);
+		}
+		else
+		{
+			// the graphics queue is shared with the frames, callers must not hold the submit lock
+			vulkan->waitAndLockSubmits();
+			vulkan->graphicsQueue->submit(si, fence);
+			vulkan->unlockSubmits();
+		}
+		
+		if (fence)
+		{
+			if (vulkan->device->waitForFences(fence, VK_TRUE, UINT64_MAX) != vk::Result::eSuccess)
+				throw std::runtime_error("wait fences error!");
+			vulkan->device->destroyFence(fence);
+			signaledValue = batch.value;
+		}
+		
+		// published after the submit, the frames never wait for a value that is not submitted yet
+		submittedValue = batch.value;
+		
+		retire();
+		
+		return submittedValue;
+	}
+	
+	uint64_t UploadManager::completedValue()
+	{
+		return timeline ? VulkanContext::Get()->device->getSemaphoreCounterValue(*timeline) : signaledValue.load();
+	}
+	
+	void UploadManager::retire()
+	{
+		auto vulkan = VulkanContext::Get();
+		
+		const uint64_t completed = completedValue();
+		const size_t inFlight = batches.size() - (batchOpen ? 1 : 0);
+		
+		size_t count = 0;
+		for (; count < inFlight && batches[count].value <= completed; count++)
+		{
+			vulkan->device->freeCommandBuffers(*commandPool, batches[count].cmd);
+			for (auto& staging : batches[count].dedicated)
+				staging.Destroy();
+			ringUsed -= batches[count].ringBytes;
+		}
+		batches.erase(batches.begin(), batches.begin() + count);
+	}
+}
@@ -0,0 +1,97 @@
+/*
+Copyright (c) 2018-2021 Christos Karamoustos
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include "Buffer.h"
+#include <vector>
+#include <mutex>
+#include <atomic>
+
+constexpr auto UPLOAD_RING_SIZE = 64u * 1024u * 1024u;
+
+namespace vk
+{
+	class CommandPool;
+	
+	class Semaphore;
+}
+
+namespace pe
+{
+	class Image;
+	
+	// Streams data to device local buffers and images through a persistently mapped staging ring.
+	// Copies are recorded into one open batch that is submitted on flush, on the dedicated transfer queue
+	// if the gpu has one, and each batch signals the next value of a timeline semaphore that the frames wait on
+	class UploadManager
+	{
+	public:
+		static void init();
+		
+		static void uploadBuffer(Buffer& dst, size_t dstOffset, const void* data, size_t size);
+		
+		// The layers of the data are packed one after the other, the image ends in ShaderReadOnlyOptimal,
+		// or stays in TransferDstOptimal if it has mip levels for generateMipMaps to fill
+		static void uploadImage(Image& dst, const void* data, size_t size);
+		
+		// Submits the open batch, returns the value the uploads so far signal when complete
+		static uint64_t flush();
+		
+		static bool isComplete(uint64_t value);
+		
+		// Blocks the cpu until the value is reached
+		static void wait(uint64_t value);
+		
+		// The last submitted value if the gpu has not reached it yet, 0 otherwise
+		static uint64_t pendingValue();
+		
+		static vk::Semaphore semaphore();
+		
+		static void destroy();
+	
+	private:
+		struct Batch;
+		
+		static Batch& openBatch();
+		
+		static size_t stage(const void* data, size_t size, vk::Buffer& buffer);
+		
+		static uint64_t flushLocked();
+		
+		static uint64_t completedValue();
+		
+		static void retire();
+		
+		static Buffer ring;
+		static size_t ringHead;
+		static size_t ringUsed;
+		static Ref<vk::CommandPool> commandPool;
+		static Ref<vk::Semaphore> timeline;
+		// read by the frames without taking the lock
+		static std::atomic<uint64_t> submittedValue;
+		static std::atomic<uint64_t> signaledValue;
+		static std::vector<Batch> batches; // the in flight batches, then the open one if any
+		static bool batchOpen;
+		static inline std::mutex m_mutex {};
+	};
+}
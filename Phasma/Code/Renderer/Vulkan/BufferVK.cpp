@@ -86,6 +86,19 @@ namespace pe
 		bufferInfo.size = size;
 		bufferInfo.usage = usageVK;
 		bufferInfo.sharingMode = vk::SharingMode::eExclusive;
+		// device local buffers are filled on the transfer queue and read on graphics
+		auto vulkan = VulkanContext::Get();
+		const uint32_t families[] {
+				static_cast<uint32_t>(vulkan->graphicsFamilyId), static_cast<uint32_t>(vulkan->transferFamilyId)
+		};
+		if (vulkan->dedicatedTransferQueue &&
+		    usageVK & vk::BufferUsageFlagBits::eTransferDst &&
+		    propertiesVK & vk::MemoryPropertyFlagBits::eDeviceLocal)
+		{
+			bufferInfo.sharingMode = vk::SharingMode::eConcurrent;
+			bufferInfo.queueFamilyIndexCount = 2;
+			bufferInfo.pQueueFamilyIndices = families;
+		}
 		VkBufferCreateInfo vkBufferCreateInfo = VkBufferCreateInfo(bufferInfo);
 		//buffer = make_ref(vulkan->device->createBuffer(bufferInfo));
 		VmaAllocationCreateInfo allocationCreateInfo = {};
@@ -102,6 +115,16 @@ namespace pe
 				&allocationInfo
 		);
 		buffer = make_ref(vk::Buffer(vkBuffer));
+		
+		if (usageVK & vk::BufferUsageFlagBits::eTransferSrc)
+			category = MemoryCategory::Staging;
+		else if (usageVK & (vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eIndexBuffer))
+			category = MemoryCategory::Geometry;
+		else if (usageVK & (vk::BufferUsageFlagBits::eUniformBuffer | vk::BufferUsageFlagBits::eStorageBuffer))
+			category = MemoryCategory::Uniforms;
+		else
+			category = MemoryCategory::Other;
+		MemoryStats::Allocated(category, allocationInfo.size);
 	}
 	
 	void BufferVK::Map(size_t mapSize, size_t offset)
@@ -171,7 +194,12 @@ namespace pe
 	void BufferVK::Destroy() const
 	{
 		if (*buffer)
+		{
+			VmaAllocationInfo allocationInfo;
+			vmaGetAllocationInfo(VulkanContext::Get()->allocator, allocation, &allocationInfo);
+			MemoryStats::Freed(category, allocationInfo.size);
 			vmaDestroyBuffer(VulkanContext::Get()->allocator, VkBuffer(*buffer), allocation);
+		}
 		*buffer = nullptr;
 	}
 }
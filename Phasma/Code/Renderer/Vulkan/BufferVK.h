@@ -24,6 +24,7 @@ SOFTWARE.
 
 #include "../../Core/Base.h"
 #include "../RendererEnums.h"
+#include "../MemoryStats.h"
 
 namespace vk
 {
@@ -45,6 +46,7 @@ namespace pe
 		// and it will always be less or equal than the actual size of the created buffer
 		size_t sizeRequested {};
 		void* data = nullptr;
+		MemoryCategory category = MemoryCategory::Other;
 		
 		void CreateBuffer(size_t size, BufferUsageFlags usage, MemoryPropertyFlags properties);
 		
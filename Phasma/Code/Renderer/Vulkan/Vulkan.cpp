@@ -24,6 +24,8 @@ SOFTWARE.
 #include "Vulkan.h"
 #include "../../ECS/Context.h"
 #include "../../Renderer/Renderer.h"
+#include "../../Core/Profiler.h"
+#include "../MemoryStats.h"
 #include <iostream>
 
 namespace pe
@@ -43,11 +45,14 @@ namespace pe
 		transferQueue = make_ref(vk::Queue());
 		commandPool = make_ref(vk::CommandPool());
 		commandPool2 = make_ref(vk::CommandPool());
+		computeCommandPool = make_ref(vk::CommandPool());
 		descriptorPool = make_ref(vk::DescriptorPool());
 		dispatchLoaderDynamic = make_ref(vk::DispatchLoaderDynamic());
 		queueFamilyProperties = make_ref(std::vector<vk::QueueFamilyProperties>());
 		dynamicCmdBuffers = make_ref(std::vector<vk::CommandBuffer>());
 		shadowCmdBuffers = make_ref(std::vector<vk::CommandBuffer>());
+		gbufferCmdBuffers = make_ref(std::vector<vk::CommandBuffer>());
+		computeCmdBuffers = make_ref(std::vector<vk::CommandBuffer>());
 		fences = make_ref(std::vector<vk::Fence>());
 		semaphores = make_ref(std::vector<vk::Semaphore>());
 		
@@ -246,6 +251,16 @@ namespace pe
 #else
 		vk::QueueFlags flags = vk::QueueFlagBits::eTransfer;
 		auto& properties = *queueFamilyProperties;
+		// a transfer only family maps to the copy engines of the gpu
+		for (uint32_t i = 0; i < properties.size(); i++)
+		{
+			if (properties[i].queueFlags & flags &&
+			    !(properties[i].queueFlags & (vk::QueueFlagBits::eGraphics | vk::QueueFlagBits::eCompute)))
+			{
+				transferFamilyId = i;
+				return;
+			}
+		}
 		// prefer different families for different queue types, thus the reverse check
 		for (int i = static_cast<int>(properties.size()) - 1; i >= 0; --i)
 		{
@@ -287,7 +302,51 @@ namespace pe
 		{
 			if (std::string(i.extensionName.data()) == VK_KHR_SWAPCHAIN_EXTENSION_NAME)
 				deviceExtensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+			// vma needs 1.1 for the heap budget queries
+			if (std::string(i.extensionName.data()) == VK_EXT_MEMORY_BUDGET_EXTENSION_NAME &&
+			    gpuProperties->apiVersion >= VK_API_VERSION_1_1)
+			{
+				deviceExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+				memoryBudget = true;
+			}
+#ifdef BINDLESS_MATERIALS
+			if (std::string(i.extensionName.data()) == VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME)
+				deviceExtensions.push_back(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME);
+#endif
 		}
+		
+		vk::PhysicalDeviceTimelineSemaphoreFeatures timelineFeatures;
+		vk::PhysicalDeviceDescriptorIndexingFeatures indexingFeatures;
+		vk::PhysicalDeviceFeatures2 features2;
+		features2.pNext = &timelineFeatures;
+#ifdef BINDLESS_MATERIALS
+		timelineFeatures.pNext = &indexingFeatures;
+#endif
+		gpu->getFeatures2(&features2);
+		
+		// timeline semaphores are core in 1.2, the uploads signal them
+		timelineSemaphores =
+				vk::enumerateInstanceVersion() >= VK_API_VERSION_1_2 &&
+				gpuProperties->apiVersion >= VK_API_VERSION_1_2 &&
+				timelineFeatures.timelineSemaphore;
+		timelineFeatures = vk::PhysicalDeviceTimelineSemaphoreFeatures();
+		timelineFeatures.timelineSemaphore = timelineSemaphores;
+#ifdef BINDLESS_MATERIALS
+		descriptorIndexing =
+				indexingFeatures.runtimeDescriptorArray &&
+				indexingFeatures.descriptorBindingPartiallyBound &&
+				indexingFeatures.descriptorBindingSampledImageUpdateAfterBind &&
+				indexingFeatures.descriptorBindingUpdateUnusedWhilePending;
+		
+		// enable only what the bindless materials need
+		const vk::PhysicalDeviceDescriptorIndexingFeatures supported = indexingFeatures;
+		indexingFeatures = vk::PhysicalDeviceDescriptorIndexingFeatures();
+		indexingFeatures.runtimeDescriptorArray = supported.runtimeDescriptorArray;
+		indexingFeatures.descriptorBindingPartiallyBound = supported.descriptorBindingPartiallyBound;
+		indexingFeatures.descriptorBindingSampledImageUpdateAfterBind =
+				supported.descriptorBindingSampledImageUpdateAfterBind;
+		indexingFeatures.descriptorBindingUpdateUnusedWhilePending = supported.descriptorBindingUpdateUnusedWhilePending;
+#endif
 		float priorities[] {1.0f}; // range : [0.0, 1.0]
 		
 		std::vector<vk::DeviceQueueCreateInfo> queueCreateInfos {};
@@ -299,6 +358,7 @@ namespace pe
 		queueCreateInfos.back().pQueuePriorities = priorities;
 		
 		// compute queue
+		asyncCompute = computeFamilyId >= 0 && computeFamilyId != graphicsFamilyId;
 		if (computeFamilyId != graphicsFamilyId)
 		{
 			queueCreateInfos.emplace_back();
@@ -308,7 +368,9 @@ namespace pe
 		}
 		
 		// transer queue
-		if (transferFamilyId != graphicsFamilyId && transferFamilyId != computeFamilyId)
+		dedicatedTransferQueue =
+				transferFamilyId >= 0 && transferFamilyId != graphicsFamilyId && transferFamilyId != computeFamilyId;
+		if (dedicatedTransferQueue)
 		{
 			queueCreateInfos.emplace_back();
 			queueCreateInfos.back().queueFamilyIndex = transferFamilyId;
@@ -322,6 +384,12 @@ namespace pe
 		deviceCreateInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
 		deviceCreateInfo.ppEnabledExtensionNames = deviceExtensions.data();
 		deviceCreateInfo.pEnabledFeatures = &*gpuFeatures;
+		deviceCreateInfo.pNext = descriptorIndexing ? &indexingFeatures : nullptr;
+		if (timelineSemaphores)
+		{
+			timelineFeatures.pNext = descriptorIndexing ? &indexingFeatures : nullptr;
+			deviceCreateInfo.pNext = &timelineFeatures;
+		}
 		
 		device = make_ref(gpu->createDevice(deviceCreateInfo));
 	}
@@ -333,6 +401,8 @@ namespace pe
 		allocator_info.device = VkDevice(*device);
 		allocator_info.instance = VkInstance(*instance);
 		allocator_info.vulkanApiVersion = vk::enumerateInstanceVersion();
+		if (memoryBudget)
+			allocator_info.flags |= VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT;
 		
 		vmaCreateAllocator(&allocator_info, &allocator);
 	}
@@ -372,11 +442,17 @@ namespace pe
 		
 		commandPool = make_ref(device->createCommandPool(cpci));
 		commandPool2 = make_ref(device->createCommandPool(cpci));
+		
+		if (asyncCompute)
+		{
+			cpci.queueFamilyIndex = computeFamilyId;
+			computeCommandPool = make_ref(device->createCommandPool(cpci));
+		}
 	}
 	
 	void VulkanContext::CreateDescriptorPool(uint32_t maxDescriptorSets)
 	{
-		std::vector<vk::DescriptorPoolSize> descPoolsize(4);
+		std::vector<vk::DescriptorPoolSize> descPoolsize(7);
 		descPoolsize[0].type = vk::DescriptorType::eUniformBuffer;
 		descPoolsize[0].descriptorCount = maxDescriptorSets;
 		descPoolsize[1].type = vk::DescriptorType::eStorageBuffer;
@@ -385,6 +461,12 @@ namespace pe
 		descPoolsize[2].descriptorCount = maxDescriptorSets;
 		descPoolsize[3].type = vk::DescriptorType::eCombinedImageSampler;
 		descPoolsize[3].descriptorCount = maxDescriptorSets;
+		descPoolsize[4].type = vk::DescriptorType::eUniformBufferDynamic;
+		descPoolsize[4].descriptorCount = maxDescriptorSets;
+		descPoolsize[5].type = vk::DescriptorType::eStorageBufferDynamic;
+		descPoolsize[5].descriptorCount = maxDescriptorSets;
+		descPoolsize[6].type = vk::DescriptorType::eStorageImage;
+		descPoolsize[6].descriptorCount = maxDescriptorSets;
 		
 		vk::DescriptorPoolCreateInfo createInfo;
 		createInfo.poolSizeCount = static_cast<uint32_t>(descPoolsize.size());
@@ -392,6 +474,7 @@ namespace pe
 		createInfo.maxSets = maxDescriptorSets;
 		
 		descriptorPool = make_ref(device->createDescriptorPool(createInfo));
+		MemoryStats::descriptorPoolSize = maxDescriptorSets;
 	}
 	
 	void VulkanContext::CreateCmdBuffers(uint32_t bufferCount)
@@ -402,8 +485,17 @@ namespace pe
 		cbai.commandBufferCount = bufferCount;
 		dynamicCmdBuffers = make_ref(device->allocateCommandBuffers(cbai));
 		
+		gbufferCmdBuffers = make_ref(device->allocateCommandBuffers(cbai));
+		
 		cbai.commandBufferCount = bufferCount * 3;
 		shadowCmdBuffers = make_ref(device->allocateCommandBuffers(cbai));
+		
+		if (asyncCompute)
+		{
+			cbai.commandPool = *computeCommandPool;
+			cbai.commandBufferCount = bufferCount;
+			computeCmdBuffers = make_ref(device->allocateCommandBuffers(cbai));
+		}
 	}
 	
 	void VulkanContext::CreateFences(uint32_t fenceCount)
@@ -482,9 +574,9 @@ namespace pe
 		CreateCommandPools();
 		CreateSwapchain(ctx, SWAPCHAIN_IMAGES);
 		CreateDescriptorPool(15000); // max number of all descriptor sets to allocate
-		CreateCmdBuffers(SWAPCHAIN_IMAGES);
-		CreateSemaphores(SWAPCHAIN_IMAGES * 3);
-		CreateFences(SWAPCHAIN_IMAGES);
+		CreateCmdBuffers(MAX_FRAMES_IN_FLIGHT);
+		CreateSemaphores(MAX_FRAMES_IN_FLIGHT * SEMAPHORES_PER_FRAME);
+		CreateFences(MAX_FRAMES_IN_FLIGHT);
 		CreateDepth();
 	}
 	
@@ -523,6 +615,10 @@ namespace pe
 		{
 			device->destroyCommandPool(*commandPool2);
 		}
+		if (*computeCommandPool)
+		{
+			device->destroyCommandPool(*computeCommandPool);
+		}
 		
 		swapchain.Destroy();
 		
@@ -551,10 +647,14 @@ namespace pe
 			const vk::ArrayProxy<const vk::PipelineStageFlags> waitStages,
 			const vk::ArrayProxy<const vk::Semaphore> waitSemaphores,
 			const vk::ArrayProxy<const vk::Semaphore> signalSemaphores,
-			const vk::Fence signalFence
+			const vk::Fence signalFence,
+			const void* pNext
 	) const
 	{
+		PE_PROFILE_SCOPE("VulkanContext::submit");
+		
 		vk::SubmitInfo si;
+		si.pNext = pNext;
 		si.waitSemaphoreCount = waitSemaphores.size();
 		si.pWaitSemaphores = waitSemaphores.data();
 		si.pWaitDstStageMask = waitStages.data();
@@ -565,24 +665,54 @@ namespace pe
 		graphicsQueue->submit(si, signalFence);
 	}
 	
+	void VulkanContext::submitCompute(
+			const vk::ArrayProxy<const vk::CommandBuffer> commandBuffers,
+			const vk::ArrayProxy<const vk::PipelineStageFlags> waitStages,
+			const vk::ArrayProxy<const vk::Semaphore> waitSemaphores,
+			const vk::ArrayProxy<const vk::Semaphore> signalSemaphores,
+			const vk::Fence signalFence
+	) const
+	{
+		PE_PROFILE_SCOPE("VulkanContext::submitCompute");
+		
+		vk::SubmitInfo si;
+		si.waitSemaphoreCount = waitSemaphores.size();
+		si.pWaitSemaphores = waitSemaphores.data();
+		si.pWaitDstStageMask = waitStages.data();
+		si.commandBufferCount = commandBuffers.size();
+		si.pCommandBuffers = commandBuffers.data();
+		si.signalSemaphoreCount = signalSemaphores.size();
+		si.pSignalSemaphores = signalSemaphores.data();
+		computeQueue->submit(si, signalFence);
+	}
+	
 	void VulkanContext::waitFences(const vk::ArrayProxy<const vk::Fence> fences) const
 	{
+		PE_PROFILE_SCOPE("VulkanContext::waitFences");
+		
 		if (device->waitForFences(fences, VK_TRUE, UINT64_MAX) != vk::Result::eSuccess)
 			throw std::runtime_error("wait fences error!");
 		device->resetFences(fences);
 	}
 	
+	vk::DescriptorSet VulkanContext::allocateDescriptorSet(const vk::DescriptorSetAllocateInfo& allocateInfo) const
+	{
+		MemoryStats::DescriptorSetsAllocated(allocateInfo.descriptorSetCount);
+		return device->allocateDescriptorSets(allocateInfo).at(0);
+	}
+	
 	void VulkanContext::submitAndWaitFence(
 			const vk::ArrayProxy<const vk::CommandBuffer> commandBuffers,
 			const vk::ArrayProxy<const vk::PipelineStageFlags> waitStages,
 			const vk::ArrayProxy<const vk::Semaphore> waitSemaphores,
-			const vk::ArrayProxy<const vk::Semaphore> signalSemaphores
+			const vk::ArrayProxy<const vk::Semaphore> signalSemaphores,
+			const void* pNext
 	) const
 	{
 		const vk::FenceCreateInfo fi;
 		const vk::Fence fence = device->createFence(fi);
 		
-		submit(commandBuffers, waitStages, waitSemaphores, signalSemaphores, fence);
+		submit(commandBuffers, waitStages, waitSemaphores, signalSemaphores, fence, pNext);
 		
 		if (device->waitForFences(fence, VK_TRUE, UINT64_MAX) != vk::Result::eSuccess)
 			throw std::runtime_error("wait fences error!");
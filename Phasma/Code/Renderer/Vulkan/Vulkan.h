@@ -29,6 +29,14 @@ SOFTWARE.
 
 #define UNIFIED_GRAPHICS_AND_TRANSFER_QUEUE
 
+// Materials use one descriptor set with all textures and factors, if the gpu supports descriptor indexing
+#define BINDLESS_MATERIALS
+
+// Frames the cpu can prepare while the gpu executes the previous ones, independent of the swapchain images
+#define MAX_FRAMES_IN_FLIGHT 2
+// aquire, shadows, render, g-buffer and async compute semaphores of each frame in flight
+#define SEMAPHORES_PER_FRAME 5
+
 #define WIDTH VulkanContext::Get()->surface.actualExtent->width
 #define HEIGHT VulkanContext::Get()->surface.actualExtent->height
 #define WIDTH_f static_cast<float>(WIDTH)
@@ -171,11 +179,14 @@ namespace pe
 		Ref<vk::Queue> graphicsQueue, computeQueue, transferQueue;
 		Ref<vk::CommandPool> commandPool;
 		Ref<vk::CommandPool> commandPool2;
+		Ref<vk::CommandPool> computeCommandPool;
 		Ref<vk::DescriptorPool> descriptorPool;
 		Ref<vk::DispatchLoaderDynamic> dispatchLoaderDynamic;
 		Ref<std::vector<vk::QueueFamilyProperties>> queueFamilyProperties;
 		Ref<std::vector<vk::CommandBuffer>> dynamicCmdBuffers;
 		Ref<std::vector<vk::CommandBuffer>> shadowCmdBuffers;
+		Ref<std::vector<vk::CommandBuffer>> gbufferCmdBuffers;
+		Ref<std::vector<vk::CommandBuffer>> computeCmdBuffers;
 		Ref<std::vector<vk::Fence>> fences;
 		Ref<std::vector<vk::Semaphore>> semaphores;
 		VmaAllocator allocator = nullptr;
@@ -185,9 +196,28 @@ namespace pe
 		Swapchain swapchain;
 		Image depth;
 		int graphicsFamilyId, computeFamilyId, transferFamilyId;
+		bool descriptorIndexing = false;
+		// a compute queue from a different family than graphics, so the work submitted to it can overlap
+		bool asyncCompute = false;
+		// a transfer queue from a family without graphics and compute, uploads on it run alongside the frames
+		bool dedicatedTransferQueue = false;
+		bool timelineSemaphores = false;
+		// VK_EXT_memory_budget, VMA reads the heap usage and budget from the driver instead of estimating them
+		bool memoryBudget = false;
+		// the frame in flight that is updated and recorded, its fence, semaphores, command buffers and buffer slices
+		uint32_t frameIndex = 0;
 		
 		// Helpers
 		void submit(
+				const vk::ArrayProxy<const vk::CommandBuffer> commandBuffers,
+				const vk::ArrayProxy<const vk::PipelineStageFlags> waitStages,
+				const vk::ArrayProxy<const vk::Semaphore> waitSemaphores,
+				const vk::ArrayProxy<const vk::Semaphore> signalSemaphores,
+				const vk::Fence signalFence,
+				const void* pNext = nullptr
+		) const;
+		
+		void submitCompute(
 				const vk::ArrayProxy<const vk::CommandBuffer> commandBuffers,
 				const vk::ArrayProxy<const vk::PipelineStageFlags> waitStages,
 				const vk::ArrayProxy<const vk::Semaphore> waitSemaphores,
@@ -197,11 +227,15 @@ namespace pe
 		
 		void waitFences(const vk::ArrayProxy<const vk::Fence> fences) const;
 		
+		// a set from the shared descriptor pool, counted for the memory report
+		vk::DescriptorSet allocateDescriptorSet(const vk::DescriptorSetAllocateInfo& allocateInfo) const;
+		
 		void submitAndWaitFence(
 				const vk::ArrayProxy<const vk::CommandBuffer> commandBuffers,
 				const vk::ArrayProxy<const vk::PipelineStageFlags> waitStages,
 				const vk::ArrayProxy<const vk::Semaphore> waitSemaphores,
-				const vk::ArrayProxy<const vk::Semaphore> signalSemaphores
+				const vk::ArrayProxy<const vk::Semaphore> signalSemaphores,
+				const void* pNext = nullptr
 		) const;
 
 #ifdef NOT_USED
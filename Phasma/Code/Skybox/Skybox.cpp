@@ -23,6 +23,7 @@ SOFTWARE.
 #include "PhasmaPch.h"
 #include "Skybox.h"
 #include "../Renderer/Pipeline.h"
+#include "../Renderer/UploadManager.h"
 #include "../GUI/GUI.h"
 #include "tinygltf/stb_image.h"
 #include "../Renderer/RenderApi.h"
@@ -44,7 +45,7 @@ namespace pe
 		allocateInfo.descriptorPool = *VulkanContext::Get()->descriptorPool;
 		allocateInfo.descriptorSetCount = 1;
 		allocateInfo.pSetLayouts = &Pipeline::getDescriptorSetLayoutSkybox();
-		descriptorSet = make_ref(VulkanContext::Get()->device->allocateDescriptorSets(allocateInfo).at(0));
+		descriptorSet = make_ref(VulkanContext::Get()->allocateDescriptorSet(allocateInfo));
 		
 		std::vector<vk::WriteDescriptorSet> textureWriteSets(1);
 		// texture sampler
@@ -81,7 +82,9 @@ namespace pe
 				vk::MemoryPropertyFlagBits::eDeviceLocal
 		);
 		
-		texture.transitionImageLayout(vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal);
+		// the faces are packed one after the other and uploaded as one
+		const size_t faceSize = static_cast<size_t>(imageSideSize) * static_cast<size_t>(imageSideSize) * 4;
+		std::vector<stbi_uc> faces(faceSize * texture.arrayLayers);
 		for (uint32_t i = 0; i < texture.arrayLayers; ++i)
 		{
 			// Texture Load
@@ -90,25 +93,14 @@ namespace pe
 			stbi_uc* pixels = stbi_load(paths[i].c_str(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
 			assert(imageSideSize == texWidth && imageSideSize == texHeight);
 			
-			const vk::DeviceSize imageSize = static_cast<size_t>(texWidth) * static_cast<size_t>(texHeight) * 4;
 			if (!pixels)
 				throw std::runtime_error("No pixel data loaded");
 			
-			Buffer staging;
-			staging.CreateBuffer(
-					imageSize, BufferUsage::TransferSrc, MemoryProperty::HostVisible
-			);
-			staging.Map();
-			staging.CopyData(pixels);
-			staging.Flush();
-			staging.Unmap();
-			
+			memcpy(faces.data() + i * faceSize, pixels, faceSize);
 			stbi_image_free(pixels);
-			
-			texture.copyBufferToImage(*staging.GetBufferVK(), i);
-			staging.Destroy();
 		}
-		texture.transitionImageLayout(vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal);
+		UploadManager::uploadImage(texture, faces.data(), faces.size());
+		UploadManager::flush();
 		
 		texture.viewType = make_ref(vk::ImageViewType::eCube);
 		texture.createImageView(vk::ImageAspectFlagBits::eColor);
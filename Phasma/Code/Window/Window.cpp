@@ -27,6 +27,7 @@ SOFTWARE.
 #include "../Renderer/Renderer.h"
 #include "../ECS/Context.h"
 #include "../Event/EventSystem.h"
+#include "../Core/Recorder.h"
 #include <iostream>
 
 namespace pe
@@ -81,15 +82,8 @@ namespace pe
 		
 		ImGuiIO& io = ImGui::GetIO();
 		
-		SDL_Event event;
-		while (SDL_PollEvent(&event))
+		const auto handleInput = [&io](const SDL_Event& event)
 		{
-			if (event.type == SDL_QUIT)
-			{
-				//FIRE_EVENT(Event::OnExit);
-				return false;
-			}
-			
 			if (event.type == SDL_MOUSEWHEEL)
 			{
 				if (event.wheel.x > 0) io.MouseWheelH += 1;
@@ -122,6 +116,20 @@ namespace pe
 				io.KeyAlt = ((SDL_GetModState() & KMOD_ALT) != 0);
 				io.KeySuper = ((SDL_GetModState() & KMOD_GUI) != 0);
 			}
+		};
+		
+		SDL_Event event;
+		while (SDL_PollEvent(&event))
+		{
+			if (event.type == SDL_QUIT)
+			{
+				//FIRE_EVENT(Event::OnExit);
+				return false;
+			}
+			
+			// a replay ignores the live input
+			if (!Recorder::Event(event))
+				handleInput(event);
 			
 			if (event.type == SDL_WINDOWEVENT && event.window.event == SDL_WINDOWEVENT_SIZE_CHANGED)
 			{
@@ -129,6 +137,9 @@ namespace pe
 			}
 		}
 		
+		for (auto& recorded : Recorder::Events())
+			handleInput(recorded);
+		
 		
 		if (SDL_GetMouseState(&x, &y) & SDL_BUTTON(SDL_BUTTON_RIGHT) && IsInsideRenderWindow(px, py))
 		{
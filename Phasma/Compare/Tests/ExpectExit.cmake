@@ -0,0 +1,6 @@
+# runs PhasmaCompare on two result files and fails when its exit code is not EXPECTED
+# cmake -DCOMPARE=<exe> -DBASELINE=<file> -DCURRENT=<file> -DEXPECTED=<code> -P ExpectExit.cmake
+execute_process(COMMAND "${COMPARE}" "${BASELINE}" "${CURRENT}" RESULT_VARIABLE RESULT)
+if (NOT RESULT STREQUAL EXPECTED)
+    message(FATAL_ERROR "PhasmaCompare exited with ${RESULT}, expected ${EXPECTED}")
+endif()
@@ -0,0 +1,350 @@
+/*
+Copyright (c) 2018-2021 Christos Karamoustos
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#include "rapidjson/document.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// a value that is in the baseline, the current file or both
+struct Entry
+{
+	std::string name;
+	std::string unit;
+	bool inBaseline = false;
+	bool inCurrent = false;
+	double baseline = 0.0;
+	double current = 0.0;
+	// the estimated standard deviation of a sample and the sample count, 0 when the value is not a series
+	double baselineSigma = 0.0;
+	double currentSigma = 0.0;
+	double baselineCount = 0.0;
+	double currentCount = 0.0;
+	// the smallest change that counts, in the unit of the entry
+	double relative = 0.0;
+	double floor = 0.0;
+};
+
+struct Options
+{
+	std::string metric = "p50";
+	double threshold = 5.0;
+	double minDelta = 0.05;
+	double minDeltaNs = 1.0;
+	double confidence = 3.0;
+	double memoryThreshold = 5.0;
+	double loadThreshold = 25.0;
+};
+
+static bool Load(const std::string& file, rapidjson::Document& document)
+{
+	std::ifstream stream(file);
+	if (!stream)
+	{
+		std::cerr << "Could not open " << file << std::endl;
+		return false;
+	}
+	std::stringstream text;
+	text << stream.rdbuf();
+	
+	document.Parse(text.str().c_str());
+	if (document.HasParseError() || !document.IsObject())
+	{
+		std::cerr << "Not a benchmark result: " << file << std::endl;
+		return false;
+	}
+	return true;
+}
+
+static Entry& Find(std::vector<Entry>& entries, const std::string& name)
+{
+	for (auto& entry : entries)
+	{
+		if (entry.name == name)
+			return entry;
+	}
+	Entry entry;
+	entry.name = name;
+	entries.push_back(entry);
+	return entries.back();
+}
+
+// the value of a member, a wrong type is wrong input and ends the comparison with exit code 2
+static double Number(const rapidjson::Value& value, const std::string& name)
+{
+	if (!value.IsNumber())
+		throw std::runtime_error(name + " is not a number");
+	return value.GetDouble();
+}
+
+static std::string String(const rapidjson::Value& value, const std::string& name)
+{
+	if (!value.IsString())
+		throw std::runtime_error(name + " is not a string");
+	return value.GetString();
+}
+
+// a timing series has min, mean, percentiles and max, see TimingStatistics
+static bool IsSeries(const rapidjson::Value& value, const Options& options)
+{
+	return value.IsObject() && value.HasMember(options.metric.c_str()) && value.HasMember("p95");
+}
+
+static void AddSeries(
+		std::vector<Entry>& entries, const std::string& name, const rapidjson::Value& series, double count,
+		const std::string& unit, bool baseline, const Options& options)
+{
+	// the kernels of PhasmaBench keep their own sample count
+	if (series.HasMember("samples"))
+		count = Number(series["samples"], name + ".samples");
+	
+	// the p50 to p95 distance of a normal distribution is 1.645 sigma
+	const double p50 = series.HasMember("p50") ? Number(series["p50"], name + ".p50") : 0.0;
+	const double sigma = std::max(Number(series["p95"], name + ".p95") - p50, 0.0) / 1.645;
+	const double value = Number(series[options.metric.c_str()], name + "." + options.metric);
+	
+	Entry& entry = Find(entries, name);
+	entry.unit = unit;
+	entry.relative = options.threshold;
+	// the kernels of PhasmaBench take ns per operation, a floor in ms would hide any of their regressions
+	entry.floor = unit == "ns" ? options.minDeltaNs : options.minDelta;
+	if (baseline)
+	{
+		entry.inBaseline = true;
+		entry.baseline = value;
+		entry.baselineSigma = sigma;
+		entry.baselineCount = count;
+	}
+	else
+	{
+		entry.inCurrent = true;
+		entry.current = value;
+		entry.currentSigma = sigma;
+		entry.currentCount = count;
+	}
+}
+
+static void AddValue(
+		std::vector<Entry>& entries, const std::string& name, double value, const std::string& unit, double relative,
+		double floor, bool baseline)
+{
+	Entry& entry = Find(entries, name);
+	entry.unit = unit;
+	entry.relative = relative;
+	entry.floor = floor;
+	(baseline ? entry.inBaseline : entry.inCurrent) = true;
+	(baseline ? entry.baseline : entry.current) = value;
+}
+
+// the series of a Benchmark file (frame, cpu, gpu) or a PhasmaBench file (kernels),
+// the memory peaks and the load times
+static void Gather(
+		std::vector<Entry>& entries, const rapidjson::Document& document, bool baseline, const Options& options)
+{
+	const std::string unit = document.HasMember("unit") ? String(document["unit"], "unit") : "ms";
+	const double frames = document.HasMember("frames") ? Number(document["frames"], "frames") : 0.0;
+	if (document.HasMember("device"))
+		String(document["device"], "device");
+	
+	for (auto& member : document.GetObject())
+	{
+		const std::string key = member.name.GetString();
+		const rapidjson::Value& value = member.value;
+		if (!value.IsObject())
+			continue;
+		
+		if (key == "memory")
+		{
+			for (auto& peak : value.GetObject())
+			{
+				const std::string name = key + "." + peak.name.GetString();
+				AddValue(entries, name, Number(peak.value, name) / (1024.0 * 1024.0), "MiB",
+				         options.memoryThreshold, 1.0, baseline);
+			}
+		}
+		else if (key == "loads")
+		{
+			for (auto& load : value.GetObject())
+			{
+				const std::string name = key + "." + load.name.GetString();
+				AddValue(entries, name, Number(load.value, name), "ms", options.loadThreshold, 5.0, baseline);
+			}
+		}
+		else if (IsSeries(value, options))
+			AddSeries(entries, key, value, frames, unit, baseline, options);
+		else
+		{
+			for (auto& series : value.GetObject())
+			{
+				if (IsSeries(series.value, options))
+				{
+					AddSeries(entries, key + "." + series.name.GetString(), series.value, frames, unit, baseline,
+					          options);
+				}
+			}
+		}
+	}
+}
+
+// the change a value needs to count, the largest of the relative threshold, the absolute floor and,
+// for a series, the confidence times the standard error of the difference of the two metrics
+static double Noise(const Entry& entry, const Options& options)
+{
+	double noise = std::max(entry.baseline * entry.relative / 100.0, entry.floor);
+	if (entry.baselineCount > 0.0 && entry.currentCount > 0.0)
+	{
+		// the standard error of the median is 1.2533 times the one of the mean, the percentiles are taken as it
+		const double factor = options.metric == "mean" ? 1.0 : 1.2533;
+		const double error = factor * std::sqrt(
+				entry.baselineSigma * entry.baselineSigma / entry.baselineCount +
+				entry.currentSigma * entry.currentSigma / entry.currentCount);
+		noise = std::max(noise, options.confidence * error);
+	}
+	return noise;
+}
+
+// Compares two result files of the Benchmark (--benchmark) or of PhasmaBench and prints a table of every value.
+// A value is a regression when it grew more than its noise, then the exit code is 1, 2 is for wrong input.
+// Options: --metric <min|mean|p50|p95|p99|max> (p50), --threshold <% of the series> (5),
+// --min-delta <ms> (0.05), --min-delta-ns <ns per operation of PhasmaBench> (1),
+// --confidence <standard errors> (3), --memory-threshold <%> (5), --load-threshold <%> (25)
+int main(int argc, char* argv[])
+{
+	Options options;
+	std::vector<std::string> files;
+	for (int i = 1; i < argc; i++)
+	{
+		const std::string arg(argv[i]);
+		const bool hasValue = i + 1 < argc;
+		try
+		{
+			if (arg == "--metric" && hasValue)
+				options.metric = argv[++i];
+			else if (arg == "--threshold" && hasValue)
+				options.threshold = std::stod(argv[++i]);
+			else if (arg == "--min-delta" && hasValue)
+				options.minDelta = std::stod(argv[++i]);
+			else if (arg == "--min-delta-ns" && hasValue)
+				options.minDeltaNs = std::stod(argv[++i]);
+			else if (arg == "--confidence" && hasValue)
+				options.confidence = std::stod(argv[++i]);
+			else if (arg == "--memory-threshold" && hasValue)
+				options.memoryThreshold = std::stod(argv[++i]);
+			else if (arg == "--load-threshold" && hasValue)
+				options.loadThreshold = std::stod(argv[++i]);
+			else
+				files.push_back(arg);
+		}
+		catch (const std::exception&)
+		{
+			std::cerr << "Not a number for " << arg << ": " << argv[i] << std::endl;
+			return 2;
+		}
+	}
+	
+	const std::vector<std::string> metrics {"min", "mean", "p50", "p95", "p99", "max"};
+	if (std::find(metrics.begin(), metrics.end(), options.metric) == metrics.end())
+	{
+		std::cerr << "Unknown metric: " << options.metric << std::endl;
+		return 2;
+	}
+	
+	if (files.size() != 2)
+	{
+		std::cerr << "Usage: PhasmaCompare <baseline.json> <current.json> [options]" << std::endl;
+		return 2;
+	}
+	
+	rapidjson::Document baseline;
+	rapidjson::Document current;
+	if (!Load(files[0], baseline) || !Load(files[1], current))
+		return 2;
+	
+	std::vector<Entry> entries;
+	for (size_t i = 0; i < files.size(); i++)
+	{
+		try
+		{
+			Gather(entries, i == 0 ? baseline : current, i == 0, options);
+		}
+		catch (const std::exception& e)
+		{
+			std::cerr << "Not a benchmark result: " << files[i] << ", " << e.what() << std::endl;
+			return 2;
+		}
+	}
+	
+	if (baseline.HasMember("device") && current.HasMember("device") &&
+	    std::string(baseline["device"].GetString()) != current["device"].GetString())
+	{
+		std::cerr << "Warning: the results come from different devices, " << baseline["device"].GetString()
+		          << " and " << current["device"].GetString() << std::endl;
+	}
+	
+	uint32_t regressions = 0;
+	uint32_t improvements = 0;
+	
+	printf("%-36s %12s %12s %12s %9s  %s\n", "name", "baseline", "current", "delta", "change", "status");
+	for (auto& entry : entries)
+	{
+		// a pass that did not run in either file
+		if (entry.baseline == 0.0 && entry.current == 0.0)
+			continue;
+		
+		const std::string name = entry.name + " (" + entry.unit + ")";
+		if (!entry.inCurrent || !entry.inBaseline)
+		{
+			const double value = entry.inBaseline ? entry.baseline : entry.current;
+			printf("%-36s %12.3f %12s %12s %9s  %s\n", name.c_str(), value, "-", "-", "-",
+			       entry.inBaseline ? "missing" : "new");
+			continue;
+		}
+		
+		const double delta = entry.current - entry.baseline;
+		const double noise = Noise(entry, options);
+		const char* status = "ok";
+		if (delta > noise)
+		{
+			status = "REGRESSED";
+			regressions++;
+		}
+		else if (-delta > noise)
+		{
+			status = "improved";
+			improvements++;
+		}
+		
+		const double change = entry.baseline > 0.0 ? delta / entry.baseline * 100.0 : 0.0;
+		printf("%-36s %12.3f %12.3f %+12.3f %+8.1f%%  %s\n", name.c_str(), entry.baseline, entry.current, delta,
+		       change, status);
+	}
+	
+	printf("\n%u regressions, %u improvements (%s)\n", regressions, improvements, options.metric.c_str());
+	return regressions > 0 ? 1 : 0;
+}
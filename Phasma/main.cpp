@@ -2,6 +2,13 @@
 #include "Code/Core/Timer.h"
 #include "Code/ECS/Context.h"
 #include "Code/Camera/Camera.h"
+#include "Code/Renderer/Light.h"
+#include "Code/Renderer/RenderApi.h"
+#include "Code/Renderer/Null/NullRenderer.h"
+#include "Code/Core/Benchmark.h"
+#include "Code/Core/Recorder.h"
+#include "Code/Core/FrameHistory.h"
+#include "Code/Core/Profiler.h"
 
 using namespace pe;
 
@@ -10,48 +17,107 @@ int main(int argc, char* argv[])
 	//freopen("log.txt", "w", stdout);
 	//freopen("errors.txt", "w", stderr);
 
+	// --null runs the cpu systems of the frames without a gpu, on host buffers and counted no-op commands
+	for (int i = 1; i < argc; i++)
+	{
+		if (std::string(argv[i]) == "--null")
+			g_Api = RenderApi::Null;
+	}
+
+	// --record <file> keeps the session, --replay <file> plays it back with a fixed time step
+	Recorder::Parse(argc, argv);
+	
+	// the benchmark renders at a fixed size in a hidden window
+	const bool benchmark = Benchmark::Parse(argc, argv);
+	const uint32_t windowFlags = benchmark ?
+			SDL_WINDOW_HIDDEN | SDL_WINDOW_VULKAN :
+			SDL_WINDOW_MAXIMIZED | SDL_WINDOW_RESIZABLE | SDL_WINDOW_SHOWN | SDL_WINDOW_VULKAN;
+
 	Window window;
 	Context context;
 
-	context.CreateSystem<Renderer>(&context, window.Create(&context));
+	if (PE_NULL)
+		context.CreateSystem<NullRenderer>();
+	else
+		context.CreateSystem<Renderer>(&context, window.Create(&context, windowFlags));
 	context.CreateSystem<CameraSystem>();
+	context.CreateSystem<LightSystem>();
 	context.InitSystems();
 
     Entity* mainEntity = context.CreateEntity();
     Camera* mainCamera = mainEntity->CreateComponent<Camera>();
     context.GetSystem<CameraSystem>()->AddComponent(mainCamera);
 
+	if (benchmark)
+		Benchmark::LoadScenes();
+
 	Timer interval;
 	interval.Start();
 
 	FrameTimer& frame_timer = FrameTimer::Instance();
 
+	PE_PROFILE_THREAD("Main");
+
 	while (true)
 	{
 		frame_timer.Start();
+		PE_PROFILE_FRAME();
 		
-		if (!window.ProcessEvents(frame_timer.delta))
-			break;
-		
-		if (!window.isMinimized())
+		if (PE_NULL)
+		{
+			if (!Benchmark::Step(*mainCamera))
+				break;
+			
+			context.UpdateSystems(Benchmark::Delta());
+			context.GetSystem<NullRenderer>()->Draw();
+		}
+		else
 		{
-			context.UpdateSystems(frame_timer.delta);
-			context.GetSystem<Renderer>()->Draw();
+			// in low latency mode the input is sampled as late as the gpu allows
+			if (GUI::low_latency && !benchmark && !window.isMinimized())
+				context.GetSystem<Renderer>()->WaitForFrame();
+			
+			if (!window.ProcessEvents(frame_timer.delta))
+				break;
+			
+			if (!window.isMinimized())
+			{
+				if (benchmark && !Benchmark::Step(*mainCamera))
+					break;
+				if (!benchmark && !Recorder::Step(*mainCamera))
+					break;
+				
+				const bool fixedStep = benchmark || Recorder::replaying;
+				context.UpdateSystems(fixedStep ? Benchmark::Delta() : frame_timer.delta);
+				context.GetSystem<Renderer>()->Draw();
+			}
 		}
 		
 		// Metrics every 0.75 sec
 		if (interval.Count() > 0.75) {
 			interval.Start();
-			GUI::cpuWaitingTime = SECONDS_TO_MILLISECONDS<float>(frame_timer.timestamps[0]);
+			GUI::cpuWaitingTime = SECONDS_TO_MILLISECONDS<float>(frame_timer.timestamps[StageFenceWait]);
 			GUI::updatesTime = SECONDS_TO_MILLISECONDS<float>(GUI::updatesTimeCount);
-			GUI::cpuTime = static_cast<float>(frame_timer.delta * 1000.0) - GUI::cpuWaitingTime;
+			// the sleep of the low latency mode is neither cpu work nor waiting for the gpu
+			GUI::cpuTime = static_cast<float>(frame_timer.delta * 1000.0) - GUI::cpuWaitingTime -
+			               SECONDS_TO_MILLISECONDS<float>(frame_timer.timestamps[StageLatencySleep]);
 			for (int i = 0; i < GUI::metrics.size(); i++)
-				GUI::stats[i] = GUI::metrics[i];
+				GUI::stats[i] = GUI::metricsAverage[i];
 		}
 		
-		frame_timer.Delay(1.0 / static_cast<double>(GUI::fps) - frame_timer.Count());
+		// the benchmark frame rate is uncapped
+		if (!benchmark)
+			frame_timer.Delay(1.0 / static_cast<double>(GUI::fps) - frame_timer.Count());
 		frame_timer.Tick();
+		FrameHistory::Push(frame_timer.delta);
+		
+		if (benchmark)
+			Benchmark::Record(frame_timer.delta);
 	}
 
+	if (benchmark)
+		Benchmark::Write();
+	Recorder::Write();
+
 	return 0;
 }
\ No newline at end of file